@@ -0,0 +1,93 @@
+/* -*- c++ -*- */
+/* 
+ * Copyright 2019 Leon Fernandez (zluudg).
+ * 
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ * 
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_ZLUUDGBEE_AUTOTUNER_H
+#define INCLUDED_ZLUUDGBEE_AUTOTUNER_H
+
+#include <zluudgbee/api.h>
+#include <gnuradio/block.h>
+#include <string>
+
+namespace gr {
+  namespace zluudgbee {
+
+    /*!
+     * \brief Tunes shr_sens, crappy_threshold and shift_threshold of a
+     * receiver for the most good frames per second.
+     * \ingroup zluudgbee
+     *
+     * \details
+     * Counts the good frames that come in on "pdu in". Every hold_time
+     * seconds the counts go into a hill_climber, and the settings to try
+     * next go out on "ctrl", to be connected to the "ctrl" port of the
+     * receiver. The search steps by the given step sizes and stays
+     * within max_steps steps of the start settings.
+     *
+     * A frame with "crc_ok" in its metadata counts as that says, which
+     * covers chdr2pdu with hw_crc. Otherwise, with has_fcs set, the
+     * frame is taken to end in its FCS and is checked here, as the
+     * frames of chdr2pdu without hw_crc, softrx and multirx are. Clear
+     * has_fcs behind softcrc in RX mode, which strips the FCS and only
+     * passes good frames, so every frame counts as good. Where bad
+     * frames are dropped before they get here, only the good ones are
+     * counted, which is all the search needs.
+     *
+     * With a replay_file, outcomes come from a recording instead of the
+     * frames on "pdu in", see replay_backend. log_file gets one line per
+     * hold period in the same format, so a session on the air can be
+     * replayed later.
+     */
+    class ZLUUDGBEE_API autotuner : virtual public gr::block
+    {
+     public:
+      typedef boost::shared_ptr<autotuner> sptr;
+
+      /*!
+       * \brief Return a shared_ptr to a new instance of zluudgbee::autotuner.
+       *
+       * To avoid accidental use of raw pointers, zluudgbee::autotuner's
+       * constructor is in a private implementation
+       * class. zluudgbee::autotuner::make is the public interface for
+       * creating new instances.
+       */
+      static sptr make(
+        double hold_time=2.0,
+        int shr_sens=20,
+        int crappy_threshold=8,
+        double shift_threshold=0.125,
+        int shr_sens_step=2,
+        int crappy_threshold_step=1,
+        double shift_threshold_step=0.0625,
+        int max_steps=4,
+        const std::string &replay_file="",
+        const std::string &log_file="",
+        bool has_fcs=true
+      );
+
+      //! Best settings found so far.
+      virtual int best_shr_sens() const = 0;
+      virtual int best_crappy_threshold() const = 0;
+      virtual double best_shift_threshold() const = 0;
+    };
+
+  } // namespace zluudgbee
+} // namespace gr
+
+#endif /* INCLUDED_ZLUUDGBEE_AUTOTUNER_H */
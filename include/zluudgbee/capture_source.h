@@ -0,0 +1,118 @@
+/* -*- c++ -*- */
+/* 
+ * Copyright 2019 Leon Fernandez (zluudg).
+ * 
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ * 
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_ZLUUDGBEE_CAPTURE_SOURCE_H
+#define INCLUDED_ZLUUDGBEE_CAPTURE_SOURCE_H
+
+#include <zluudgbee/api.h>
+#include <gnuradio/sync_block.h>
+
+namespace gr {
+  namespace zluudgbee {
+
+    /*!
+     * \brief Plays back an sc16 capture, e.g. one written by
+     * uhd_rfnoc_streamer_radio, for offline decoding as fast as the
+     * receivers downstream can go.
+     * \ingroup zluudgbee
+     *
+     * \details
+     * The capture is mapped rather than read, so samples go from the
+     * page cache straight into the output buffer without any read()
+     * calls. The mapping is hinted sequential, asked for huge pages and
+     * read ahead in windows, and the pages that have been played are
+     * let go again, which keeps hours long captures from filling memory.
+     *
+     * A sidecar index next to the capture, filename + ".idx" unless
+     * index_file names another, gives the timestamps and frame starts:
+     * \code
+     *   rate 4000000
+     *   time 0 1558443600.250000000000
+     *   time 91750400 1558443622.937600000000
+     *   frame 12800
+     * \endcode
+     * A time line is only needed where the stream was interrupted. The
+     * rate in the index wins over sample_rate. Timestamps go out as
+     * "rx_time" tags, like the UHD source sends them, on the first
+     * sample, at every interruption and after a seek, along with
+     * "rx_rate".
+     *
+     * For decoding in parallel, the capture is cut into num_chunks
+     * chunks of about the same length and the block only plays the one
+     * numbered chunk, starting overlap seconds before it so that the
+     * receiver has settled when the chunk proper begins. Set overlap to
+     * the longest frame or more. With frames in the index the chunks are
+     * cut at frame starts, and overlap only has to cover the receiver's
+     * lead-in. A frame that lies wholly inside the overlap is decoded by
+     * both workers. The first sample the chunk owns, past the overlap,
+     * carries a "chunk_owned" tag with its sample number in the capture,
+     * so whatever merges the workers' frames can drop the ones that end
+     * before it. The previous chunk has them.
+     *
+     * With repeat set the chunk plays over and over, otherwise the
+     * flowgraph is done at its end.
+     */
+    class ZLUUDGBEE_API capture_source : virtual public gr::sync_block
+    {
+     public:
+      typedef boost::shared_ptr<capture_source> sptr;
+
+      /*!
+       * \brief Return a shared_ptr to a new instance of zluudgbee::capture_source.
+       *
+       * To avoid accidental use of raw pointers, zluudgbee::capture_source's
+       * constructor is in a private implementation
+       * class. zluudgbee::capture_source::make is the public interface for
+       * creating new instances.
+       */
+      static sptr make(
+        const std::string &filename,
+        const std::string &index_file="",
+        double sample_rate=4e6,
+        int chunk=0,
+        int num_chunks=1,
+        double overlap=0.005,
+        bool repeat=false
+      );
+
+      /*!
+       * \brief Continues from offset seconds into the capture, counting
+       * from its first sample and including any gaps, within the chunk.
+       */
+      virtual void seek(double offset) = 0;
+
+      //! Seconds into the capture of the next sample to go out.
+      virtual double position() const = 0;
+
+      //! Seconds into the capture where the chunk starts and ends.
+      virtual double chunk_start() const = 0;
+      virtual double chunk_end() const = 0;
+
+      //! Seconds into the capture where the part the chunk owns starts, after the overlap.
+      virtual double chunk_owned_start() const = 0;
+
+      //! Samples in the chunk, overlap included.
+      virtual uint64_t chunk_samples() const = 0;
+    };
+
+  } // namespace zluudgbee
+} // namespace gr
+
+#endif /* INCLUDED_ZLUUDGBEE_CAPTURE_SOURCE_H */
@@ -31,10 +31,30 @@ namespace gr {
   namespace zluudgbee {
 
     /*!
-     * \brief Converts an incoming CHDR packet of 32-bit samples into
-     * a PDU. The PDU is represented by a PMT pair, one empty dict
-     * (no metadate/tags) and one uint8 vector where element 'n' is
-     * extracted from word 'n' in the incoming CHDR packet.
+     * \brief Converts incoming CHDR packets of 32-bit samples into
+     * PDUs. Each word carries one PDU byte plus the status flags set by
+     * the FPGA, which are used to cut a packet into its frames and to
+     * drop the padding between them. Every frame becomes a PMT pair of a
+     * metadata dict and a uint8 vector. The dict holds "confidence", the
+     * share of nibbles that were decoded with confidence, and
+     * "crappy_nibbles", the number of nibbles that were not.
+     *
+     * PDUs are published from a separate thread, fed from the receive
+     * thread through a bounded lock-free ring. When the ring is full
+     * either the newest or the oldest PDU is dropped.
+     *
+     * With hw_crc set the block takes the place of softcrc after a
+     * zluudgbeeCRC in RX mode, and "crc_ok" is added to the metadata of
+     * every frame it publishes. In flag mode (crc_mode 2) frames that
+     * failed the CRC there are dropped and the FCS is cut off the rest
+     * while they are being extracted. Frames without a verdict from the
+     * FPGA come from crc_mode 0, which has dropped the bad ones and cut
+     * the FCS off already, so they are published as they are.
+     *
+     * rx_cpus pins the receive thread to a CPU list like "2,3" or
+     * "8-11", and an rx_priority from 1 to 99 runs it SCHED_FIFO. Its
+     * buffers are allocated once it has been pinned, so they end up on
+     * the NUMA node of those CPUs. Empty and zero leave it to the OS.
      * \ingroup zluudgbee
      *
      */
@@ -59,8 +79,41 @@ namespace gr {
         const int block_select=-1,
         const int device_select=-1,
         const int mtu=2048,
-        const bool enable_eob_on_stop=true
+        const bool enable_eob_on_stop=true,
+        const int ring_depth=256,
+        const bool drop_oldest=false,
+        const bool hw_crc=false,
+        const std::string &rx_cpus="",
+        const int rx_priority=0
         );
+
+      //! Largest number of PDUs that were queued for publication at once.
+      virtual size_t ring_high_water() const = 0;
+
+      //! Number of PDUs dropped because the publication ring was full.
+      virtual uint64_t ring_drops() const = 0;
+
+      //! Number of frames dropped for a bad FCS, only counted with hw_crc.
+      virtual uint64_t crc_failures() const = 0;
+
+      //! Times the receive thread was preempted while handling bursts.
+      virtual uint64_t rx_preemptions() const = 0;
+
+      //! Times the receive thread turned up on a different CPU than for the last batch.
+      virtual uint64_t rx_migrations() const = 0;
+
+      //! Longest time the receive thread spent between two blocking recv() calls, in seconds.
+      virtual double rx_max_busy() const = 0;
+
+      //! Longest time the receive thread, woken by a burst, waited for a CPU, in seconds.
+      //! Linux with schedstats only, zero elsewhere.
+      virtual double rx_max_sched_latency() const = 0;
+
+      //! Overflows recv() reported, each one a gap of lost samples.
+      virtual uint64_t rx_overflows() const = 0;
+
+      //! Blocking recv() calls that timed out while the stream was running.
+      virtual uint64_t rx_timeouts() const = 0;
     };
   } // namespace zluudgbee
 } // namespace gr
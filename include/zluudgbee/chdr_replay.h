@@ -0,0 +1,105 @@
+/* -*- c++ -*- */
+/* 
+ * Copyright 2019 Leon Fernandez (zluudg).
+ * 
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ * 
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_ZLUUDGBEE_CHDR_REPLAY_H
+#define INCLUDED_ZLUUDGBEE_CHDR_REPLAY_H
+
+#include <zluudgbee/api.h>
+#include <gnuradio/block.h>
+
+namespace gr {
+  namespace zluudgbee {
+
+    /*!
+     * \brief chdr2pdu without a USRP: runs its receive path on recorded
+     * or synthetic CHDR bursts.
+     * \ingroup zluudgbee
+     *
+     * \details
+     * The bursts come from a stand-in for the USRP's rx_streamer and go
+     * through the same RX and publisher threads as in chdr2pdu, so the
+     * PDUs on "data" look just like the ones chdr2pdu would publish.
+     *
+     * filename is a recording of bursts as recv() returned them. It is
+     * mapped rather than read, so replaying long captures costs no more
+     * memory than short ones. Empty generates 64 bursts of
+     * frames_per_burst frames of frame_len bytes instead, random PSDUs
+     * with a valid FCS.
+     *
+     * items_per_sec paces the bursts at that CHDR item rate, zero plays
+     * them as fast as the receiver takes them. They are played loops
+     * times, zero repeats them until the flowgraph stops.
+     * overflow_every and timeout_every make every so many recv() calls
+     * fail with an overflow or a timeout instead, to check that the
+     * receiver carries on. The rest of the parameters are chdr2pdu's.
+     */
+    class ZLUUDGBEE_API chdr_replay : virtual public gr::block
+    {
+     public:
+      typedef boost::shared_ptr<chdr_replay> sptr;
+
+      /*!
+       * \brief Return a shared_ptr to a new instance of zluudgbee::chdr_replay.
+       *
+       * To avoid accidental use of raw pointers, zluudgbee::chdr_replay's
+       * constructor is in a private implementation
+       * class. zluudgbee::chdr_replay::make is the public interface for
+       * creating new instances.
+       */
+      static sptr make(
+        const std::string &filename="",
+        int frame_len=40,
+        int frames_per_burst=8,
+        double items_per_sec=0.0,
+        int loops=1,
+        int overflow_every=0,
+        int timeout_every=0,
+        int mtu=2048,
+        int ring_depth=256,
+        bool drop_oldest=false,
+        bool hw_crc=false
+      );
+
+      //! Bursts handed to the receiver so far.
+      virtual uint64_t bursts_sent() const = 0;
+
+      //! All loops have been played.
+      virtual bool finished() const = 0;
+
+      //! Largest number of PDUs that were queued for publication at once.
+      virtual size_t ring_high_water() const = 0;
+
+      //! Number of PDUs dropped because the publication ring was full.
+      virtual uint64_t ring_drops() const = 0;
+
+      //! Number of frames dropped for a bad FCS, only counted with hw_crc.
+      virtual uint64_t crc_failures() const = 0;
+
+      //! Overflows the receiver saw.
+      virtual uint64_t rx_overflows() const = 0;
+
+      //! Timeouts the receiver saw while the stream was running.
+      virtual uint64_t rx_timeouts() const = 0;
+    };
+
+  } // namespace zluudgbee
+} // namespace gr
+
+#endif /* INCLUDED_ZLUUDGBEE_CHDR_REPLAY_H */
@@ -0,0 +1,84 @@
+/* -*- c++ -*- */
+/* 
+ * Copyright 2019 Leon Fernandez (zluudg).
+ * 
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ * 
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_ZLUUDGBEE_COHERENTRX_H
+#define INCLUDED_ZLUUDGBEE_COHERENTRX_H
+
+#include <zluudgbee/api.h>
+#include <gnuradio/sync_block.h>
+
+namespace gr {
+  namespace zluudgbee {
+
+    /*!
+     * \brief Coherent soft-decision 802.15.4 receiver. Instead of hard
+     * chip decisions on phase differences, like zluudg_demapper, each
+     * nibble's worth of IQ samples is correlated against the 16 nibble
+     * waveforms oqpsk_mod sends, and the best match at the tracked
+     * carrier phase is taken. That holds up several dB further into the
+     * noise than the hard Hamming demapper.
+     *
+     * Input is complex baseband at samples_per_chip samples per chip,
+     * i.e. 2 Msps times that. Every PSDU is published on the "data"
+     * port, FCS included, with "confidence" and "crappy_nibbles" in the
+     * metadata like softrx does, and the confidence of every nibble in
+     * "nibble_confidence". A nibble's confidence goes from one, for a
+     * clean decision, down to zero for a tie, and nibbles below
+     * crappy_threshold count as crappy.
+     *
+     * detect_threshold sets how well the input has to match itself one
+     * nibble later for a preamble to be taken, between zero and one.
+     * \ingroup zluudgbee
+     *
+     */
+    class ZLUUDGBEE_API coherentrx : virtual public gr::sync_block
+    {
+     public:
+      typedef boost::shared_ptr<coherentrx> sptr;
+
+      /*!
+       * \brief Return a shared_ptr to a new instance of zluudgbee::coherentrx.
+       *
+       * To avoid accidental use of raw pointers, zluudgbee::coherentrx's
+       * constructor is in a private implementation
+       * class. zluudgbee::coherentrx::make is the public interface for
+       * creating new instances.
+       */
+      static sptr make(int samples_per_chip=2,
+                       double detect_threshold=0.1,
+                       double crappy_threshold=0.25);
+
+      virtual void set_detect_threshold(double threshold) = 0;
+      virtual void set_crappy_threshold(double threshold) = 0;
+
+      //! Preambles found so far, with or without a frame after them.
+      virtual uint64_t preambles() const = 0;
+
+      //! Preambles that were not followed by a good SFD and PHR.
+      virtual uint64_t lost_syncs() const = 0;
+
+      //! Frames published so far.
+      virtual uint64_t frames() const = 0;
+    };
+
+  } // namespace zluudgbee
+} // namespace gr
+
+#endif /* INCLUDED_ZLUUDGBEE_COHERENTRX_H */
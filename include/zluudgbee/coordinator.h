@@ -0,0 +1,91 @@
+/* -*- c++ -*- */
+/* 
+ * Copyright 2019 Leon Fernandez (zluudg).
+ * 
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ * 
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_ZLUUDGBEE_COORDINATOR_H
+#define INCLUDED_ZLUUDGBEE_COORDINATOR_H
+
+#include <zluudgbee/api.h>
+#include <gnuradio/block.h>
+
+namespace gr {
+  namespace zluudgbee {
+
+    /*!
+     * \brief PAN coordinator for a nonbeacon-enabled PAN with up to a few
+     * thousand end devices.
+     * \ingroup zluudgbee
+     *
+     * \details
+     * Takes the frames of softcrc, without FCS, on "pdu in" and answers
+     * on "pdu out" with frames ready for the transmitter, FCS included:
+     * ACKs, beacons in response to beacon requests, association
+     * responses and frames for devices. Devices that ask to associate
+     * get a short address, up to max_devices of them, after which the
+     * beacon stops permitting association and requests are rejected.
+     *
+     * PDUs on "data in" are queued for the device whose short address is
+     * "dst_addr" in the metadata, or whose extended address it is if
+     * "extended" is true, and sent when the device polls with a data
+     * request. Frames are retransmitted up to max_retries times
+     * ack_timeout_ms apart, and given up on after persistence_ms.
+     * Devices not heard from for device_timeout_ms are dropped, zero
+     * keeps them for good. Data frames from associated devices come out
+     * on "data out" with the MAC payload as the PDU and "src_addr" and
+     * "seq" in the metadata.
+     *
+     * Replaces dummycoord, which only answers beacon requests.
+     */
+    class ZLUUDGBEE_API coordinator : virtual public gr::block
+    {
+     public:
+      typedef boost::shared_ptr<coordinator> sptr;
+
+      /*!
+       * \brief Return a shared_ptr to a new instance of zluudgbee::coordinator.
+       *
+       * To avoid accidental use of raw pointers, zluudgbee::coordinator's
+       * constructor is in a private implementation
+       * class. zluudgbee::coordinator::make is the public interface for
+       * creating new instances.
+       */
+      static sptr make(
+        int pan_id=0xabcd,
+        int short_addr=0x0000,
+        long ext_addr=0x0000000000000001,
+        long epid=0x000000000000000a,
+        int max_devices=4096,
+        int ack_timeout_ms=10,
+        int max_retries=3,
+        int persistence_ms=7680,
+        int device_timeout_ms=0
+      );
+
+      //! Devices that are associated or waiting for their response.
+      virtual size_t devices() const = 0;
+      virtual size_t associated() const = 0;
+
+      //! Dict with the coordinator's counters.
+      virtual pmt::pmt_t stats() const = 0;
+    };
+
+  } // namespace zluudgbee
+} // namespace gr
+
+#endif /* INCLUDED_ZLUUDGBEE_COORDINATOR_H */
@@ -0,0 +1,103 @@
+/* -*- c++ -*- */
+/* 
+ * Copyright 2019 Leon Fernandez (zluudg).
+ * 
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ * 
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_ZLUUDGBEE_CRC16_H
+#define INCLUDED_ZLUUDGBEE_CRC16_H
+
+#include <zluudgbee/api.h>
+#include <cstddef>
+#include <stdint.h>
+
+namespace gr {
+  namespace zluudgbee {
+
+    /*!
+     * \brief CRC-16/KERMIT, the frame check sequence of IEEE 802.15.4.
+     * \ingroup zluudgbee
+     *
+     * \details
+     * Polynomial x^16 + x^12 + x^5 + 1, bit reflected, zero initial value
+     * and no final XOR. The FCS goes on air low byte first, so running the
+     * CRC over a frame including its FCS yields zero.
+     *
+     * The fastest implementation available on the running CPU is picked at
+     * runtime: PCLMULQDQ folding for long buffers where supported, and
+     * slice-by-8 otherwise. Short buffers always go through the plain
+     * table, where the setup cost of the others doesn't pay off.
+     *
+     * Can be used one-shot through compute() or incrementally:
+     * \code
+     *   crc16 crc;
+     *   crc.update(mhr, mhr_len).update(payload, payload_len);
+     *   uint16_t fcs = crc.value();
+     * \endcode
+     */
+    class ZLUUDGBEE_API crc16
+    {
+     public:
+      enum impl_t {
+        IMPL_AUTO = 0,
+        IMPL_BITWISE,
+        IMPL_TABLE,
+        IMPL_SLICE8,
+        IMPL_CLMUL
+      };
+
+      explicit crc16(uint16_t init = 0) : d_crc(init) {}
+
+      void reset(uint16_t init = 0) { d_crc = init; }
+
+      //! Feeds len more bytes into the CRC.
+      crc16 &update(const uint8_t *buf, size_t len)
+      {
+        d_crc = compute(buf, len, d_crc);
+        return *this;
+      }
+
+      //! Feeds a single byte into the CRC.
+      crc16 &update(uint8_t byte);
+
+      uint16_t value() const { return d_crc; }
+
+      //! CRC of buf, continuing from crc.
+      static uint16_t compute(const uint8_t *buf, size_t len, uint16_t crc = 0);
+
+      //! Same as compute(src, len, crc), copying src to dst on the way.
+      static uint16_t compute_copy(uint8_t *dst, const uint8_t *src, size_t len,
+                                   uint16_t crc = 0);
+
+      /*!
+       * Same as above with a specific implementation, mostly meant for
+       * testing and benchmarking. Falls back to IMPL_AUTO when the
+       * requested one isn't supported by the CPU.
+       */
+      static uint16_t compute(const uint8_t *buf, size_t len, uint16_t crc, impl_t impl);
+
+      //! Whether impl can run on this CPU.
+      static bool supported(impl_t impl);
+
+     private:
+      uint16_t d_crc;
+    };
+
+  } // namespace zluudgbee
+} // namespace gr
+
+#endif /* INCLUDED_ZLUUDGBEE_CRC16_H */
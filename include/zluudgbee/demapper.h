@@ -0,0 +1,61 @@
+/* -*- c++ -*- */
+/* 
+ * Copyright 2019 Leon Fernandez (zluudg).
+ * 
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ * 
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_ZLUUDGBEE_DEMAPPER_H
+#define INCLUDED_ZLUUDGBEE_DEMAPPER_H
+
+#include <zluudgbee/api.h>
+#include <gnuradio/sync_block.h>
+
+namespace gr {
+  namespace zluudgbee {
+
+    /*!
+     * \brief Host version of zluudg_demapper. Each input item is a word of
+     * 32 chips, oldest chip in the MSB, and comes out as the nibble of the
+     * closest chip sequence. Bits 7:4 of the output are set when even the
+     * closest sequence differs in crappy_threshold chips or more, which
+     * is how the FPGA marks the nibbles it is unsure of.
+     * \ingroup zluudgbee
+     *
+     */
+    class ZLUUDGBEE_API demapper : virtual public gr::sync_block
+    {
+     public:
+      typedef boost::shared_ptr<demapper> sptr;
+
+      /*!
+       * \brief Return a shared_ptr to a new instance of zluudgbee::demapper.
+       *
+       * To avoid accidental use of raw pointers, zluudgbee::demapper's
+       * constructor is in a private implementation
+       * class. zluudgbee::demapper::make is the public interface for
+       * creating new instances.
+       */
+      static sptr make(int crappy_threshold=8);
+
+      virtual void set_crappy_threshold(int threshold) = 0;
+      virtual int crappy_threshold() const = 0;
+    };
+
+  } // namespace zluudgbee
+} // namespace gr
+
+#endif /* INCLUDED_ZLUUDGBEE_DEMAPPER_H */
@@ -0,0 +1,78 @@
+/* -*- c++ -*- */
+/* 
+ * Copyright 2019 Leon Fernandez (zluudg).
+ * 
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ * 
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_ZLUUDGBEE_DEVICE_POPULATION_H
+#define INCLUDED_ZLUUDGBEE_DEVICE_POPULATION_H
+
+#include <zluudgbee/api.h>
+#include <gnuradio/block.h>
+
+namespace gr {
+  namespace zluudgbee {
+
+    /*!
+     * \brief Synthetic end devices for testing a coordinator without a
+     * radio.
+     * \ingroup zluudgbee
+     *
+     * \details
+     * Emulates the given number of end devices on a PAN. Each one
+     * associates with the coordinator, polls for its association
+     * response and then alternates data frames of payload_len bytes with
+     * data requests. Frames go out on "pdu out" without FCS, the way
+     * softcrc passes them on, at rate frames per second across all
+     * devices. Frames from the coordinator, FCS included, go into
+     * "pdu in", where the devices ACK them, dropping ack_loss of the
+     * ACKs to make the coordinator retransmit.
+     */
+    class ZLUUDGBEE_API device_population : virtual public gr::block
+    {
+     public:
+      typedef boost::shared_ptr<device_population> sptr;
+
+      /*!
+       * \brief Return a shared_ptr to a new instance of zluudgbee::device_population.
+       *
+       * To avoid accidental use of raw pointers, zluudgbee::device_population's
+       * constructor is in a private implementation
+       * class. zluudgbee::device_population::make is the public interface for
+       * creating new instances.
+       */
+      static sptr make(
+        int devices=1000,
+        int pan_id=0xabcd,
+        int coord_addr=0x0000,
+        double rate=10000.0,
+        int payload_len=32,
+        double ack_loss=0.0,
+        int seed=1
+      );
+
+      //! Devices that got a short address.
+      virtual size_t associated() const = 0;
+
+      //! Dict with the counters of the population.
+      virtual pmt::pmt_t stats() const = 0;
+    };
+
+  } // namespace zluudgbee
+} // namespace gr
+
+#endif /* INCLUDED_ZLUUDGBEE_DEVICE_POPULATION_H */
@@ -0,0 +1,325 @@
+/* -*- c++ -*- */
+/* 
+ * Copyright 2019 Leon Fernandez (zluudg).
+ * 
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ * 
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_ZLUUDGBEE_MAC_FRAME_H
+#define INCLUDED_ZLUUDGBEE_MAC_FRAME_H
+
+#include <pmt/pmt.h>
+#include <cstddef>
+#include <stdint.h>
+
+namespace gr {
+  namespace zluudgbee {
+
+    /*!
+     * \brief Read-only view of an IEEE 802.15.4 MAC frame.
+     * \ingroup zluudgbee
+     *
+     * \details
+     * Decodes the MAC header in place, right over the bytes of a PSDU or
+     * of the u8vector of a PDU, and never copies or allocates. Parsing
+     * only works out where the fields are, the accessors read them when
+     * asked. The view is only good for as long as the bytes it points to
+     * are.
+     *
+     * Handles the frame control, sequence number and addressing fields,
+     * including PAN ID compression, plus the auxiliary security header
+     * of 2006 frames. The payload excludes the MIC, and the FCS too if
+     * the view is told it is there. Every field is checked against the
+     * frame length. A frame that doesn't parse has a status other than
+     * MAC_OK, and then only frame_control() and sequence_number() can be
+     * trusted, and only if the frame is at least three bytes long.
+     *
+     * \code
+     *   mac_frame_view frame(pdu);
+     *   if (frame.valid() && frame.frame_type() == mac_frame_view::FRAME_COMMAND &&
+     *       frame.command_id() == mac_frame_view::CMD_BEACON_REQUEST)
+     *     send_beacon(frame.sequence_number());
+     * \endcode
+     */
+    class mac_frame_view
+    {
+     public:
+      enum status_t {
+        MAC_OK = 0,
+        MAC_NOT_A_PDU,           //!< not a pair with a u8vector in the cdr
+        MAC_TOO_SHORT,           //!< ends inside the header or the MIC
+        MAC_BAD_ADDRESSING,      //!< reserved address mode or bad PAN ID compression
+        MAC_BAD_VERSION,         //!< frame version 2 or later
+        MAC_BAD_SECURITY         //!< security on a 2003 frame
+      };
+
+      enum frame_type_t {
+        FRAME_BEACON = 0,
+        FRAME_DATA = 1,
+        FRAME_ACK = 2,
+        FRAME_COMMAND = 3
+      };
+
+      enum addr_mode_t {
+        ADDR_NONE = 0,
+        ADDR_RESERVED = 1,
+        ADDR_SHORT = 2,
+        ADDR_EXTENDED = 3
+      };
+
+      enum command_t {
+        CMD_ASSOCIATION_REQUEST = 0x01,
+        CMD_ASSOCIATION_RESPONSE = 0x02,
+        CMD_DISASSOCIATION = 0x03,
+        CMD_DATA_REQUEST = 0x04,
+        CMD_PAN_ID_CONFLICT = 0x05,
+        CMD_ORPHAN = 0x06,
+        CMD_BEACON_REQUEST = 0x07,
+        CMD_COORDINATOR_REALIGNMENT = 0x08,
+        CMD_GTS_REQUEST = 0x09
+      };
+
+      static const size_t FCS_LEN = 2;
+
+      mac_frame_view()
+      {
+        parse(0, 0, false);
+      }
+
+      //! View of the len bytes at psdu, which end with the FCS if has_fcs is set.
+      mac_frame_view(const uint8_t *psdu, size_t len, bool has_fcs = false)
+      {
+        parse(psdu, len, has_fcs);
+      }
+
+      //! View of the u8vector of a PDU, e.g. one published by softcrc.
+      explicit mac_frame_view(const pmt::pmt_t &pdu, bool has_fcs = false)
+      {
+        parse(pdu, has_fcs);
+      }
+
+      void parse(const uint8_t *psdu, size_t len, bool has_fcs = false);
+
+      void parse(const pmt::pmt_t &pdu, bool has_fcs = false)
+      {
+        if (pmt::is_pair(pdu) && pmt::is_blob(pmt::cdr(pdu))) {
+          const pmt::pmt_t blob = pmt::cdr(pdu);
+          parse((const uint8_t *) pmt::blob_data(blob), pmt::blob_length(blob), has_fcs);
+        }
+        else {
+          parse(0, 0, false);
+          d_status = MAC_NOT_A_PDU;
+        }
+      }
+
+      status_t status() const { return status_t(d_status); }
+      bool valid() const { return d_status == MAC_OK; }
+      static const char *status_name(status_t status);
+
+      //! The bytes the view is over, FCS included if it was there.
+      const uint8_t *data() const { return d_data; }
+      size_t size() const { return d_len; }
+
+      uint16_t frame_control() const { return d_fc; }
+      frame_type_t frame_type() const { return frame_type_t(d_fc & 0x07); }
+      bool security_enabled() const { return d_fc & 0x0008; }
+      bool frame_pending() const { return d_fc & 0x0010; }
+      bool ack_request() const { return d_fc & 0x0020; }
+      bool pan_id_compression() const { return d_fc & 0x0040; }
+      addr_mode_t dst_addr_mode() const { return addr_mode_t((d_fc >> 10) & 0x03); }
+      unsigned frame_version() const { return (d_fc >> 12) & 0x03; }
+      addr_mode_t src_addr_mode() const { return addr_mode_t((d_fc >> 14) & 0x03); }
+      uint8_t sequence_number() const { return d_len > 2 ? d_data[2] : 0; }
+
+      //! The PAN IDs and addresses read as zero when not in the frame.
+      uint16_t dst_pan_id() const { return read_le(d_dst_pan, d_dst_pan ? 2 : 0); }
+      uint64_t dst_addr() const { return read_le(d_dst_addr, addr_len(dst_addr_mode())); }
+      //! Same as dst_pan_id() when the PAN ID is compressed.
+      uint16_t src_pan_id() const { return read_le(d_src_pan, d_src_pan ? 2 : 0); }
+      uint64_t src_addr() const { return read_le(d_src_addr, addr_len(src_addr_mode())); }
+      bool has_dst() const { return d_dst_pan; }
+      bool has_src() const { return d_src_addr; }
+      bool is_broadcast() const
+      {
+        return dst_addr_mode() == ADDR_SHORT && dst_addr() == 0xFFFF;
+      }
+
+      //! Auxiliary security header fields, zero when security is off.
+      unsigned security_level() const { return d_aux ? d_data[d_aux] & 0x07 : 0; }
+      unsigned key_id_mode() const { return d_aux ? (d_data[d_aux] >> 3) & 0x03 : 0; }
+      uint32_t frame_counter() const { return read_le(d_aux ? d_aux + 1 : 0, 4); }
+      uint64_t key_source() const
+      {
+        return key_id_mode() > 1 ? read_le(d_aux + 5, key_id_len(key_id_mode()) - 1) : 0;
+      }
+      uint8_t key_index() const
+      {
+        return key_id_mode() ? d_data[d_aux + 4 + key_id_len(key_id_mode())] : 0;
+      }
+
+      //! Everything between the MAC header and the MIC.
+      size_t header_len() const { return d_payload; }
+      const uint8_t *payload() const { return d_data + d_payload; }
+      size_t payload_len() const { return d_payload_len; }
+      const uint8_t *mic() const { return payload() + d_payload_len; }
+      size_t mic_len() const { return d_mic; }
+
+      //! First payload byte of a command frame, -1 for other frames.
+      int command_id() const
+      {
+        return frame_type() == FRAME_COMMAND && d_payload_len ? d_data[d_payload] : -1;
+      }
+
+     private:
+      // Address fields are 0, -, 2 or 8 bytes, key identifiers 0, 1, 5 or 9
+      // and MICs 0, 4, 8 or 16 depending on the low bits of the level.
+      static unsigned addr_len(unsigned mode) { return (0x08020000u >> (8*mode)) & 0xFF; }
+      static unsigned key_id_len(unsigned mode) { return (0x09050100u >> (8*mode)) & 0xFF; }
+      static unsigned mic_len(unsigned level) { return (0x10080400u >> (8*(level & 0x03))) & 0xFF; }
+
+      const uint8_t *d_data;
+      size_t d_len;
+      size_t d_payload_len;
+      uint16_t d_fc;
+      // Offsets into the frame, zero for fields that aren't there
+      uint8_t d_dst_pan;
+      uint8_t d_dst_addr;
+      uint8_t d_src_pan;
+      uint8_t d_src_addr;
+      uint8_t d_aux;
+      uint8_t d_payload;
+      uint8_t d_mic;
+      uint8_t d_status;
+
+      uint64_t read_le(unsigned offset, unsigned len) const
+      {
+        uint64_t x = 0;
+        if (offset)
+          for (unsigned i = len; i-- > 0; )
+            x = (x << 8) | d_data[offset + i];
+        return x;
+      }
+    };
+
+    inline void
+    mac_frame_view::parse(const uint8_t *psdu, size_t len, bool has_fcs)
+    {
+      d_data = psdu;
+      d_len = len;
+      d_payload_len = 0;
+      d_fc = 0;
+      d_dst_pan = d_dst_addr = d_src_pan = d_src_addr = d_aux = d_payload = d_mic = 0;
+      d_status = MAC_TOO_SHORT;
+
+      // Frame control and sequence number, which is all an ACK has
+      const size_t end = has_fcs ? (len >= FCS_LEN ? len - FCS_LEN : 0) : len;
+      if (end < 3)
+        return;
+      d_fc = psdu[0] | (psdu[1] << 8);
+
+      if (frame_version() > 1) {
+        d_status = MAC_BAD_VERSION;
+        return;
+      }
+      const unsigned dst_mode = dst_addr_mode();
+      const unsigned src_mode = src_addr_mode();
+      if (dst_mode == ADDR_RESERVED || src_mode == ADDR_RESERVED ||
+          (pan_id_compression() && !(dst_mode && src_mode))) {
+        d_status = MAC_BAD_ADDRESSING;
+        return;
+      }
+      if (security_enabled() && frame_version() == 0) {
+        d_status = MAC_BAD_SECURITY;
+        return;
+      }
+
+      unsigned pos = 3;
+      unsigned dst_pan = 0, dst_addr = 0, src_pan = 0, src_addr = 0;
+      if (dst_mode) {
+        dst_pan = pos;
+        dst_addr = pos + 2;
+        pos += 2 + addr_len(dst_mode);
+      }
+      if (src_mode) {
+        if (pan_id_compression())
+          src_pan = dst_pan;
+        else {
+          src_pan = pos;
+          pos += 2;
+        }
+        src_addr = pos;
+        pos += addr_len(src_mode);
+      }
+
+      unsigned aux = 0, mic = 0;
+      if (security_enabled()) {
+        // Security control and frame counter come first
+        if (pos + 5 > end)
+          return;
+        aux = pos;
+        pos += 5 + key_id_len((psdu[aux] >> 3) & 0x03);
+        mic = mic_len(psdu[aux]);
+      }
+      if (pos + mic > end)
+        return;
+
+      d_dst_pan = dst_pan;
+      d_dst_addr = dst_addr;
+      d_src_pan = src_pan;
+      d_src_addr = src_addr;
+      d_aux = aux;
+      d_payload = pos;
+      d_mic = mic;
+      d_payload_len = end - pos - mic;
+      d_status = MAC_OK;
+    }
+
+    inline const char *
+    mac_frame_view::status_name(status_t status)
+    {
+      switch (status) {
+      case MAC_OK: return "ok";
+      case MAC_NOT_A_PDU: return "not a PDU";
+      case MAC_TOO_SHORT: return "too short";
+      case MAC_BAD_ADDRESSING: return "bad addressing";
+      case MAC_BAD_VERSION: return "unsupported frame version";
+      case MAC_BAD_SECURITY: return "unsupported security";
+      }
+      return "unknown";
+    }
+
+    /*!
+     * Parses n PDUs into views, returns how many came out valid. Parsing
+     * a whole batch first keeps the header decoding in one tight loop,
+     * which matters more than anything else here since the headers all
+     * have different lengths.
+     */
+    inline size_t
+    parse_mac_frames(const pmt::pmt_t *pdus, size_t n, mac_frame_view *views,
+                     bool has_fcs = false)
+    {
+      size_t ok = 0;
+      for (size_t i = 0; i < n; i++) {
+        views[i].parse(pdus[i], has_fcs);
+        ok += views[i].valid();
+      }
+      return ok;
+    }
+
+  } // namespace zluudgbee
+} // namespace gr
+
+#endif /* INCLUDED_ZLUUDGBEE_MAC_FRAME_H */
@@ -0,0 +1,177 @@
+/* -*- c++ -*- */
+/* 
+ * Copyright 2019 Leon Fernandez (zluudg).
+ * 
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ * 
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_ZLUUDGBEE_METRICS_H
+#define INCLUDED_ZLUUDGBEE_METRICS_H
+
+#include <zluudgbee/api.h>
+#include <gnuradio/high_res_timer.h>
+#include <pmt/pmt.h>
+#include <boost/shared_ptr.hpp>
+#include <atomic>
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+namespace gr {
+  namespace zluudgbee {
+
+    /*!
+     * \brief Latency histogram in nanoseconds with HDR-style buckets.
+     * Values below SUB_BUCKETS get a bucket each, above that every power
+     * of two is split into SUB_BUCKETS equal steps, so a value is known
+     * to within 1/SUB_BUCKETS of itself all the way up to an hour.
+     * Recording is a few relaxed atomic adds, reading while
+     * recording goes on gives a slightly torn but usable picture.
+     */
+    class ZLUUDGBEE_API latency_histogram
+    {
+     public:
+      static const int SUB_BITS = 3;
+      static const int SUB_BUCKETS = 1 << SUB_BITS;
+      static const int MAX_EXP = 41;                // largest power of two kept
+      static const int NBUCKETS = (MAX_EXP - SUB_BITS + 2) * SUB_BUCKETS;
+
+      latency_histogram();
+
+      void record(uint64_t ns)
+      {
+        d_buckets[bucket(ns)].fetch_add(1, std::memory_order_relaxed);
+        d_count.fetch_add(1, std::memory_order_relaxed);
+        d_sum.fetch_add(ns, std::memory_order_relaxed);
+        uint64_t max = d_max.load(std::memory_order_relaxed);
+        while (ns > max && !d_max.compare_exchange_weak(max, ns, std::memory_order_relaxed))
+          ;
+      }
+
+      uint64_t count() const { return d_count.load(std::memory_order_relaxed); }
+      uint64_t max() const { return d_max.load(std::memory_order_relaxed); }
+      double mean() const;
+
+      //! Smallest bucket value that at least fraction p of the samples are at or below.
+      uint64_t percentile(double p) const;
+
+      //! Bucket counts, bucket i starts at lower_bound(i).
+      std::vector<uint64_t> buckets() const;
+
+      static int bucket(uint64_t ns);
+      static uint64_t lower_bound(int bucket);
+
+     private:
+      std::atomic<uint64_t> d_buckets[NBUCKETS];
+      std::atomic<uint64_t> d_count;
+      std::atomic<uint64_t> d_sum;
+      std::atomic<uint64_t> d_max;
+    };
+
+    /*!
+     * \brief Counters and histograms of one stage, i.e. one block
+     * instance. Not every block fills in every field. handler_latency is
+     * the time spent on a frame (or a batch of them, for chdr2pdu),
+     * recv_wait the time spent blocked in recv() and sched_latency how
+     * long a thread woken by recv() then waited for a CPU.
+     */
+    struct ZLUUDGBEE_API stage_metrics
+    {
+      explicit stage_metrics(const std::string &stage_name);
+
+      const std::string name;
+      std::atomic<uint64_t> frames_in;
+      std::atomic<uint64_t> frames_out;
+      std::atomic<uint64_t> bytes_in;
+      std::atomic<uint64_t> bytes_out;
+      std::atomic<uint64_t> drops;
+      std::atomic<uint64_t> crc_failures;
+      latency_histogram handler_latency;
+      latency_histogram recv_wait;
+      latency_histogram sched_latency;
+
+      void add(std::atomic<uint64_t> &counter, uint64_t n = 1)
+      {
+        counter.fetch_add(n, std::memory_order_relaxed);
+      }
+    };
+
+    typedef boost::shared_ptr<stage_metrics> stage_metrics_sptr;
+
+    /*!
+     * \brief Process-wide registry of the stages. Blocks register a stage
+     * when they are made and drop out when they are destroyed.
+     *
+     * Collection is off unless the ZLUUDGBEE_METRICS environment variable
+     * is set, set_enabled(true) is called or a metrics_probe block is in
+     * use. While off, the blocks only test one flag per frame and never
+     * read the clock.
+     */
+    class ZLUUDGBEE_API metrics
+    {
+     public:
+      static bool enabled() { return s_enabled.load(std::memory_order_relaxed); }
+      static void set_enabled(bool enable);
+
+      //! The stage gets a number appended if name is already in use.
+      static stage_metrics_sptr register_stage(const std::string &name);
+
+      //! Stages whose blocks are still around, in registration order.
+      static std::vector<stage_metrics_sptr> stages();
+
+      /*!
+       * All stages as a dict of stage name to a dict of the counters and
+       * histogram summaries, see lib/metrics.cc for the keys.
+       */
+      static pmt::pmt_t to_pmt();
+
+      static uint64_t ticks_to_ns(gr::high_res_timer_type ticks);
+
+     private:
+      static std::atomic<bool> s_enabled;
+    };
+
+    /*!
+     * \brief Records the lifetime of the object into a histogram, if
+     * collection was on when it was made.
+     */
+    class scoped_latency
+    {
+     public:
+      explicit scoped_latency(latency_histogram &hist)
+        : d_hist(metrics::enabled() ? &hist : 0),
+          d_start(d_hist ? gr::high_res_timer_now() : 0)
+      {
+      }
+
+      ~scoped_latency()
+      {
+        if (d_hist)
+          d_hist->record(metrics::ticks_to_ns(gr::high_res_timer_now() - d_start));
+      }
+
+     private:
+      latency_histogram *d_hist;
+      const gr::high_res_timer_type d_start;
+
+      scoped_latency(const scoped_latency &);
+      scoped_latency &operator=(const scoped_latency &);
+    };
+
+  } // namespace zluudgbee
+} // namespace gr
+
+#endif /* INCLUDED_ZLUUDGBEE_METRICS_H */
@@ -0,0 +1,65 @@
+/* -*- c++ -*- */
+/* 
+ * Copyright 2019 Leon Fernandez (zluudg).
+ * 
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ * 
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_ZLUUDGBEE_METRICS_PROBE_H
+#define INCLUDED_ZLUUDGBEE_METRICS_PROBE_H
+
+#include <zluudgbee/api.h>
+#include <gnuradio/block.h>
+
+namespace gr {
+  namespace zluudgbee {
+
+    /*!
+     * \brief Message port access to the metrics registry (see
+     * zluudgbee/metrics.h). Every message on "get" is answered on
+     * "metrics" with a dict of all stages in the process: chdr2pdu,
+     * softcrc and dummycoord blocks, with their frame, byte, drop and
+     * CRC failure counters and latency histograms. A dict with an
+     * "enable" key turns collection on or off, anything else is just a
+     * request. Feed "get" from a Message Strobe for periodic reports.
+     *
+     * With enable set, collection is turned on when the block is made.
+     * \ingroup zluudgbee
+     *
+     */
+    class ZLUUDGBEE_API metrics_probe : virtual public gr::block
+    {
+     public:
+      typedef boost::shared_ptr<metrics_probe> sptr;
+
+      /*!
+       * \brief Return a shared_ptr to a new instance of zluudgbee::metrics_probe.
+       *
+       * To avoid accidental use of raw pointers, zluudgbee::metrics_probe's
+       * constructor is in a private implementation
+       * class. zluudgbee::metrics_probe::make is the public interface for
+       * creating new instances.
+       */
+      static sptr make(bool enable=true);
+
+      //! The same dict the "metrics" port publishes.
+      virtual pmt::pmt_t snapshot() const = 0;
+    };
+
+  } // namespace zluudgbee
+} // namespace gr
+
+#endif /* INCLUDED_ZLUUDGBEE_METRICS_PROBE_H */
@@ -0,0 +1,81 @@
+/* -*- c++ -*- */
+/* 
+ * Copyright 2019 Leon Fernandez (zluudg).
+ * 
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ * 
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_ZLUUDGBEE_MULTIRX_H
+#define INCLUDED_ZLUUDGBEE_MULTIRX_H
+
+#include <zluudgbee/api.h>
+#include <gnuradio/sync_block.h>
+
+namespace gr {
+  namespace zluudgbee {
+
+    /*!
+     * \brief Decodes every 802.15.4 channel in a wideband sc16 capture at
+     * once. A polyphase FFT channelizer cuts the capture into 5 MHz bins
+     * at 10 Msps and each bin that lands on a 2.4 GHz channel (11 to 26)
+     * gets its own softrx receiver model, run on a pool of nthreads
+     * threads. Frames from all channels come out of the "data" port in
+     * the order they ended, with the "channel" number added to the
+     * metadata of softrx.
+     *
+     * samp_rate has to be an even multiple of 5 MHz and center_freq on
+     * the 5 MHz channel raster, e.g. 100 Msps at 2445 MHz covers all
+     * sixteen channels. The bin at the Nyquist frequency is left out.
+     * nthreads of zero uses one thread per core. The receivers see five
+     * samples per chip, which wants a higher shift_threshold than softrx
+     * runs with at its usual rates.
+     * \ingroup zluudgbee
+     *
+     */
+    class ZLUUDGBEE_API multirx : virtual public gr::sync_block
+    {
+     public:
+      typedef boost::shared_ptr<multirx> sptr;
+
+      /*!
+       * \brief Return a shared_ptr to a new instance of zluudgbee::multirx.
+       *
+       * To avoid accidental use of raw pointers, zluudgbee::multirx's
+       * constructor is in a private implementation
+       * class. zluudgbee::multirx::make is the public interface for
+       * creating new instances.
+       */
+      static sptr make(
+        double samp_rate=100e6,
+        double center_freq=2445e6,
+        int nthreads=0,
+        double shift_threshold=0.5,
+        int shr_sens=20,
+        int crappy_threshold=8
+      );
+
+      virtual void set_shift_threshold(double threshold) = 0;
+      virtual void set_shr_sens(int sens) = 0;
+      virtual void set_crappy_threshold(int threshold) = 0;
+
+      //! Channel numbers being decoded, lowest first.
+      virtual std::vector<int> channels() const = 0;
+    };
+
+  } // namespace zluudgbee
+} // namespace gr
+
+#endif /* INCLUDED_ZLUUDGBEE_MULTIRX_H */
@@ -0,0 +1,67 @@
+/* -*- c++ -*- */
+/* 
+ * Copyright 2019 Leon Fernandez (zluudg).
+ * 
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ * 
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_ZLUUDGBEE_OQPSK_MOD_H
+#define INCLUDED_ZLUUDGBEE_OQPSK_MOD_H
+
+#include <zluudgbee/api.h>
+#include <gnuradio/sync_block.h>
+#include <string>
+
+namespace gr {
+  namespace zluudgbee {
+
+    /*!
+     * \brief Software transmitter for 802.15.4 at 2.4 GHz. Every PDU on
+     * "pdu in", a PSDU with its FCS such as softcrc puts out in TX mode,
+     * becomes one complete O-QPSK burst: preamble, SFD and PHR, chips
+     * with half-sine shaping and Q one chip behind I. At the default two
+     * samples per chip the bursts are the same as what the stock block
+     * chain in zluudgbee_software_phy.grc puts out, padding included.
+     *
+     * Bursts are built from precomputed per-nibble waveforms. If
+     * length_tag_name isn't empty, the first sample of every burst gets
+     * a tag with that key and the length of the burst.
+     * \ingroup zluudgbee
+     *
+     */
+    class ZLUUDGBEE_API oqpsk_mod : virtual public gr::sync_block
+    {
+     public:
+      typedef boost::shared_ptr<oqpsk_mod> sptr;
+
+      /*!
+       * \brief Return a shared_ptr to a new instance of zluudgbee::oqpsk_mod.
+       *
+       * To avoid accidental use of raw pointers, zluudgbee::oqpsk_mod's
+       * constructor is in a private implementation
+       * class. zluudgbee::oqpsk_mod::make is the public interface for
+       * creating new instances.
+       */
+      static sptr make(int samples_per_chip=2, const std::string &length_tag_name="");
+
+      //! Number of PDUs dropped for not fitting in a 127-byte PSDU.
+      virtual uint64_t oversized_frames() const = 0;
+    };
+
+  } // namespace zluudgbee
+} // namespace gr
+
+#endif /* INCLUDED_ZLUUDGBEE_OQPSK_MOD_H */
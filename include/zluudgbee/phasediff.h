@@ -0,0 +1,60 @@
+/* -*- c++ -*- */
+/* 
+ * Copyright 2019 Leon Fernandez (zluudg).
+ * 
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ * 
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_ZLUUDGBEE_PHASEDIFF_H
+#define INCLUDED_ZLUUDGBEE_PHASEDIFF_H
+
+#include <zluudgbee/api.h>
+#include <gnuradio/sync_decimator.h>
+
+namespace gr {
+  namespace zluudgbee {
+
+    /*!
+     * \brief Front end of the zluudgbeeRX demodulator on the host. Takes
+     * every decim-th sc16 sample and outputs the phase of that symbol
+     * times the conjugate of the previous one, computed the way
+     * zluudg_mult and zluudg_atan do it. zluudg_mult takes Q as the real
+     * part, so counterclockwise turns come out negative. The output is
+     * the 20-bit phase register, Q3.17 radians sign extended to 32 bits,
+     * and is bit-exact with the FPGA.
+     * \ingroup zluudgbee
+     *
+     */
+    class ZLUUDGBEE_API phasediff : virtual public gr::sync_decimator
+    {
+     public:
+      typedef boost::shared_ptr<phasediff> sptr;
+
+      /*!
+       * \brief Return a shared_ptr to a new instance of zluudgbee::phasediff.
+       *
+       * To avoid accidental use of raw pointers, zluudgbee::phasediff's
+       * constructor is in a private implementation
+       * class. zluudgbee::phasediff::make is the public interface for
+       * creating new instances.
+       */
+      static sptr make(int decim=1);
+    };
+
+  } // namespace zluudgbee
+} // namespace gr
+
+#endif /* INCLUDED_ZLUUDGBEE_PHASEDIFF_H */
@@ -0,0 +1,69 @@
+/* -*- c++ -*- */
+/* 
+ * Copyright 2019 Leon Fernandez (zluudg).
+ * 
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ * 
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_ZLUUDGBEE_SHRDETECTOR_H
+#define INCLUDED_ZLUUDGBEE_SHRDETECTOR_H
+
+#include <zluudgbee/api.h>
+#include <gnuradio/sync_block.h>
+
+namespace gr {
+  namespace zluudgbee {
+
+    /*!
+     * \brief Looks for the synchronization header in a stream of phase
+     * differences, one per chip, the way zluudg_detector does. The stream
+     * is passed through, and the item holding the last chip of the SFD
+     * gets a "shr" tag whose value is the number of chips that differed.
+     * A header is found when at most sens chips differ, same as
+     * SR_SHR_SENS. After a find, nothing is tagged for the next holdoff
+     * chips.
+     *
+     * Only the sign of each item is looked at, so int phases from
+     * phasediff and float ones both work.
+     * \ingroup zluudgbee
+     *
+     */
+    class ZLUUDGBEE_API shrdetector : virtual public gr::sync_block
+    {
+     public:
+      typedef boost::shared_ptr<shrdetector> sptr;
+
+      /*!
+       * \brief Return a shared_ptr to a new instance of zluudgbee::shrdetector.
+       *
+       * To avoid accidental use of raw pointers, zluudgbee::shrdetector's
+       * constructor is in a private implementation
+       * class. zluudgbee::shrdetector::make is the public interface for
+       * creating new instances.
+       */
+      static sptr make(int sens=20, int holdoff=192);
+
+      virtual void set_sens(int sens) = 0;
+      virtual void set_holdoff(int holdoff) = 0;
+
+      //! Number of headers tagged so far.
+      virtual uint64_t detections() const = 0;
+    };
+
+  } // namespace zluudgbee
+} // namespace gr
+
+#endif /* INCLUDED_ZLUUDGBEE_SHRDETECTOR_H */
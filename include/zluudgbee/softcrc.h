@@ -47,6 +47,12 @@ namespace gr {
        * creating new instances.
        */
       static sptr make(bool rx_mode=true);
+
+      /*!
+       * Number of frames dropped in TX mode because they would not fit in
+       * a 127-byte PSDU once the FCS is appended.
+       */
+      virtual uint64_t oversized_frames() const = 0;
     };
 
   } // namespace zluudgbee
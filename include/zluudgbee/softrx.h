@@ -0,0 +1,90 @@
+/* -*- c++ -*- */
+/* 
+ * Copyright 2019 Leon Fernandez (zluudg).
+ * 
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ * 
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_ZLUUDGBEE_SOFTRX_H
+#define INCLUDED_ZLUUDGBEE_SOFTRX_H
+
+#include <zluudgbee/api.h>
+#include <gnuradio/sync_block.h>
+
+namespace gr {
+  namespace zluudgbee {
+
+    /*!
+     * \brief Software version of the zluudgbeeRX RFNoC block. Runs a
+     * bit-exact, clock by clock model of zluudg_receiver.vhd on sc16
+     * samples, so recordings can be decoded and the receiver tuned
+     * without a USRP. Received frames are published on the "data" port
+     * the same way chdr2pdu publishes them, with the "confidence" and
+     * "crappy_nibbles" metadata.
+     *
+     * The settings take the same values as the arguments of the RFNoC
+     * block. clocks_per_sample is the number of FPGA clocks between input
+     * samples, e.g. 50 for a 200 MHz bus clock at 4 Msps. It only changes
+     * the backpressure timing, one is the fastest.
+     * \ingroup zluudgbee
+     *
+     */
+    class ZLUUDGBEE_API softrx : virtual public gr::sync_block
+    {
+     public:
+      typedef boost::shared_ptr<softrx> sptr;
+
+      /*!
+       * \brief Return a shared_ptr to a new instance of zluudgbee::softrx.
+       *
+       * To avoid accidental use of raw pointers, zluudgbee::softrx's
+       * constructor is in a private implementation
+       * class. zluudgbee::softrx::make is the public interface for
+       * creating new instances.
+       */
+      static sptr make(
+        int symsync_mode=0,
+        double shift_threshold=0.125,
+        int decim_rate=100,
+        int ma_line_depth=8,
+        int shr_sens=20,
+        int crappy_threshold=8,
+        int clocks_per_sample=1
+      );
+
+      virtual void set_symsync_mode(int mode) = 0;
+      virtual void set_shift_threshold(double threshold) = 0;
+      virtual void set_decim_rate(int rate) = 0;
+      virtual void set_ma_line_depth(int depth) = 0;
+      virtual void set_shr_sens(int sens) = 0;
+      virtual void set_crappy_threshold(int threshold) = 0;
+      virtual void set_clocks_per_sample(int clocks) = 0;
+
+      //! Writes a setting register as is, addresses as in noc_block_zluudgbeeRX.
+      virtual void set_register(int addr, uint32_t value) = 0;
+      virtual uint32_t get_register(int addr) const = 0;
+
+      //! Event counters, addresses as in noc_block_zluudgbeeRX.
+      virtual uint32_t get_readback(int addr) const = 0;
+
+      //! Number of FPGA clocks simulated so far.
+      virtual uint64_t clocks() const = 0;
+    };
+
+  } // namespace zluudgbee
+} // namespace gr
+
+#endif /* INCLUDED_ZLUUDGBEE_SOFTRX_H */
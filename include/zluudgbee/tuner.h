@@ -0,0 +1,162 @@
+/* -*- c++ -*- */
+/* 
+ * Copyright 2019 Leon Fernandez (zluudg).
+ * 
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ * 
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_ZLUUDGBEE_TUNER_H
+#define INCLUDED_ZLUUDGBEE_TUNER_H
+
+#include <zluudgbee/api.h>
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+namespace gr {
+  namespace zluudgbee {
+
+    /*!
+     * \brief The zluudgbeeRX settings that autotuner searches over.
+     * \ingroup zluudgbee
+     */
+    struct ZLUUDGBEE_API tuner_settings
+    {
+      int shr_sens;
+      int crappy_threshold;
+      double shift_threshold;
+
+      tuner_settings(int shr_sens = 20, int crappy_threshold = 8,
+                     double shift_threshold = 0.125)
+        : shr_sens(shr_sens), crappy_threshold(crappy_threshold),
+          shift_threshold(shift_threshold) {}
+
+      //! Clamps every setting into the range the FPGA accepts.
+      tuner_settings clamped() const;
+
+      bool operator==(const tuner_settings &other) const;
+      bool operator!=(const tuner_settings &other) const { return !(*this == other); }
+    };
+
+    /*!
+     * \brief What autotuner drives: something that takes settings and
+     * reports back how frames fared under them.
+     * \ingroup zluudgbee
+     */
+    class ZLUUDGBEE_API tuner_backend
+    {
+     public:
+      virtual ~tuner_backend() {}
+
+      //! Puts s in place, outcomes from here on count towards it.
+      virtual void apply(const tuner_settings &s) = 0;
+
+      //! Frames that passed and failed the CRC since the last call.
+      virtual void take_outcomes(uint64_t &good, uint64_t &bad) = 0;
+    };
+
+    /*!
+     * \brief Bounded hill climb over tuner_settings.
+     * \ingroup zluudgbee
+     *
+     * \details
+     * Coordinate search around the best settings so far, one step up or
+     * down in one setting at a time. A neighbour takes over when it gets
+     * more good frames per second, by more than one frame per hold
+     * period, or as many with fewer CRC failures. When no neighbour wins,
+     * the centre is measured again before the next round, so the search
+     * follows a noise floor that moves. No setting gets further than
+     * max_steps steps from where it started, nor outside what the FPGA
+     * accepts.
+     */
+    class ZLUUDGBEE_API hill_climber
+    {
+     public:
+      hill_climber(const tuner_settings &start, const tuner_settings &step, int max_steps);
+
+      //! Settings to hold for the next period.
+      const tuner_settings &current() const { return d_current; }
+
+      //! Best settings found so far.
+      const tuner_settings &best() const { return d_best; }
+
+      //! Outcome of holding current() for seconds, moves on to the next settings.
+      void report(uint64_t good, uint64_t bad, double seconds);
+
+     private:
+      static const int NMOVES = 6;       // up and down in each setting
+
+      tuner_settings d_start;
+      tuner_settings d_step;
+      int d_max_steps;
+
+      int d_center[3];                   // steps from d_start
+      int d_probe[3];
+      int d_move;                        // neighbour being probed, NMOVES measures the centre
+      double d_good_rate;                // of the centre
+      double d_bad_rate;
+      tuner_settings d_best;
+      tuner_settings d_current;
+
+      tuner_settings at(const int *pos) const;
+      void next_probe();
+    };
+
+    /*!
+     * \brief tuner_backend that replays recorded frame outcomes.
+     * \ingroup zluudgbee
+     *
+     * \details
+     * Stands in for the radio so autotuner can be run without a USRP.
+     * Recordings are text, one hold period per line:
+     * \code
+     *   # shr_sens crappy_threshold shift_threshold good bad
+     *   20 8 0.125 143 12
+     * \endcode
+     * which is also what autotuner writes to its log file. Settings that
+     * weren't recorded get the outcomes of the closest ones that were,
+     * and the periods of each setting are played back in a loop.
+     */
+    class ZLUUDGBEE_API replay_backend : public tuner_backend
+    {
+     public:
+      explicit replay_backend(const std::string &filename);
+      replay_backend() : d_active(0) {}
+
+      void add(const tuner_settings &s, uint64_t good, uint64_t bad);
+
+      void apply(const tuner_settings &s);
+      void take_outcomes(uint64_t &good, uint64_t &bad);
+
+      //! Settings the last outcomes were replayed from.
+      const tuner_settings &replayed() const;
+
+     private:
+      struct recording
+      {
+        tuner_settings settings;
+        std::vector<std::pair<uint64_t, uint64_t> > periods;
+        size_t next;
+      };
+
+      std::vector<recording> d_recordings;
+      size_t d_active;
+    };
+
+  } // namespace zluudgbee
+} // namespace gr
+
+#endif /* INCLUDED_ZLUUDGBEE_TUNER_H */
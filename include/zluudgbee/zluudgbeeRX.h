@@ -56,6 +56,23 @@ namespace gr {
         const int device_select=-1,
         const bool enable_eob_on_stop=true
         );
+
+      /*!
+       * Typed settings, forwarded to zluudgbeeRX_block_ctrl. Writing a
+       * value that is already set doesn't touch the device.
+       */
+      virtual void set_symsync_mode(int mode) = 0;
+      virtual void set_shift_threshold(double threshold) = 0;
+      virtual void set_decim_rate(int rate) = 0;
+      virtual void set_ma_line_depth(int depth) = 0;
+      virtual void set_shr_sens(int sens) = 0;
+      virtual void set_crappy_threshold(int threshold) = 0;
+
+      //! Event counters of the receiver, cleared when streaming starts.
+      virtual uint32_t frames_detected() = 0;
+      virtual uint32_t phr_rejects() = 0;
+      virtual uint32_t skipped_bursts() = 0;
+      virtual uint32_t almost_full_events() = 0;
     };
   } // namespace zluudgbee
 } // namespace gr
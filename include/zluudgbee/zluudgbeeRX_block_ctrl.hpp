@@ -37,8 +37,39 @@ public:
     UHD_RFNOC_BLOCK_OBJECT(zluudgbeeRX_block_ctrl)
 
     /*!
-     * Your block configuration here
-    */
+     * Typed access to the block arguments. Setters go through the same
+     * checks and register writes as set_arg(), but skip the write when
+     * the value is already set. Getters return what was last set,
+     * without a round trip to the device.
+     */
+    virtual void set_symsync_mode(const int mode) = 0;
+    virtual int get_symsync_mode() = 0;
+
+    //! Threshold as a fraction, written to the FPGA in Q2.17.
+    virtual void set_shift_threshold(const double threshold) = 0;
+    virtual double get_shift_threshold() = 0;
+
+    virtual void set_decim_rate(const int rate) = 0;
+    virtual int get_decim_rate() = 0;
+
+    virtual void set_ma_line_depth(const int depth) = 0;
+    virtual int get_ma_line_depth() = 0;
+
+    virtual void set_shr_sens(const int sens) = 0;
+    virtual int get_shr_sens() = 0;
+
+    virtual void set_crappy_threshold(const int threshold) = 0;
+    virtual int get_crappy_threshold() = 0;
+
+    /*!
+     * Event counters of the receiver, read back from the FPGA. They are
+     * 32 bits wide, wrap around and are cleared whenever streaming
+     * starts.
+     */
+    virtual uint32_t get_frames_detected() = 0;
+    virtual uint32_t get_phr_rejects() = 0;
+    virtual uint32_t get_skipped_bursts() = 0;
+    virtual uint32_t get_almost_full_events() = 0;
 }; /* class zluudgbeeRX_block_ctrl*/
 
 }} /* namespace uhd::rfnoc */
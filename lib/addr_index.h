@@ -0,0 +1,123 @@
+/* -*- c++ -*- */
+/* 
+ * Copyright 2019 Leon Fernandez (zluudg).
+ * 
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ * 
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_ZLUUDGBEE_ADDR_INDEX_H
+#define INCLUDED_ZLUUDGBEE_ADDR_INDEX_H
+
+#include <cstddef>
+#include <vector>
+#include <stdint.h>
+
+namespace gr {
+  namespace zluudgbee {
+
+    /*
+     * Fixed-size open addressing map from a MAC address, short or
+     * extended, to a 32-bit index. Linear probing over a power of two
+     * table that is at most half full, so lookups touch one or two
+     * cache lines. Erasing shifts the rest of the probe run back instead
+     * of leaving tombstones, which keeps the runs short no matter how
+     * many devices come and go. Never allocates after construction.
+     */
+    class addr_index
+    {
+     public:
+      static const uint32_t NONE = 0xFFFFFFFF;
+
+      explicit addr_index(size_t max_entries)
+        : d_bits(4), d_size(0), d_max(max_entries)
+      {
+        while ((size_t(1) << d_bits) < 2 * max_entries)
+          d_bits++;
+        d_mask = (size_t(1) << d_bits) - 1;
+        d_keys.resize(d_mask + 1);
+        d_values.assign(d_mask + 1, uint32_t(NONE));
+      }
+
+      uint32_t find(uint64_t key) const
+      {
+        for (size_t i = home(key); ; i = (i + 1) & d_mask) {
+          if (d_values[i] == NONE)
+            return NONE;
+          if (d_keys[i] == key)
+            return d_values[i];
+        }
+      }
+
+      // Adds or replaces, false when max_entries are in use already.
+      bool insert(uint64_t key, uint32_t value)
+      {
+        size_t i = home(key);
+        for (; d_values[i] != NONE; i = (i + 1) & d_mask) {
+          if (d_keys[i] == key) {
+            d_values[i] = value;
+            return true;
+          }
+        }
+        if (d_size == d_max)
+          return false;
+        d_keys[i] = key;
+        d_values[i] = value;
+        d_size++;
+        return true;
+      }
+
+      bool erase(uint64_t key)
+      {
+        size_t i = home(key);
+        for (; d_keys[i] != key || d_values[i] == NONE; i = (i + 1) & d_mask)
+          if (d_values[i] == NONE)
+            return false;
+
+        // Pull back every later entry of the run that may live in the hole
+        for (size_t j = (i + 1) & d_mask; d_values[j] != NONE; j = (j + 1) & d_mask) {
+          const size_t k = home(d_keys[j]);
+          if (((j - k) & d_mask) >= ((j - i) & d_mask)) {
+            d_keys[i] = d_keys[j];
+            d_values[i] = d_values[j];
+            i = j;
+          }
+        }
+        d_values[i] = NONE;
+        d_size--;
+        return true;
+      }
+
+      size_t size() const { return d_size; }
+
+     private:
+      size_t d_bits;
+      size_t d_mask;
+      size_t d_size;
+      const size_t d_max;
+      std::vector<uint64_t> d_keys;
+      std::vector<uint32_t> d_values;
+
+      // Fibonacci hashing, the top bits of the product are well mixed
+      size_t home(uint64_t key) const
+      {
+        return size_t((key * 0x9E3779B97F4A7C15ull) >> (64 - d_bits));
+      }
+    };
+
+  } // namespace zluudgbee
+} // namespace gr
+
+#endif /* INCLUDED_ZLUUDGBEE_ADDR_INDEX_H */
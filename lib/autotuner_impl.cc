@@ -0,0 +1,217 @@
+/* -*- c++ -*- */
+/* 
+ * Copyright 2019 Leon Fernandez (zluudg).
+ * 
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ * 
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <gnuradio/io_signature.h>
+#include <zluudgbee/crc16.h>
+#include <stdexcept>
+#include "autotuner_impl.h"
+#include "tuner_ctrl.h"
+
+namespace gr {
+  namespace zluudgbee {
+
+    autotuner::sptr
+    autotuner::make(double hold_time, int shr_sens, int crappy_threshold,
+                    double shift_threshold, int shr_sens_step,
+                    int crappy_threshold_step, double shift_threshold_step,
+                    int max_steps, const std::string &replay_file,
+                    const std::string &log_file, bool has_fcs)
+    {
+      return gnuradio::get_initial_sptr(
+        new autotuner_impl(hold_time, shr_sens, crappy_threshold, shift_threshold,
+                           shr_sens_step, crappy_threshold_step, shift_threshold_step,
+                           max_steps, replay_file, log_file, has_fcs)
+      );
+    }
+
+    /*
+     * The private constructor
+     */
+    autotuner_impl::autotuner_impl(double hold_time, int shr_sens, int crappy_threshold,
+                                   double shift_threshold, int shr_sens_step,
+                                   int crappy_threshold_step, double shift_threshold_step,
+                                   int max_steps, const std::string &replay_file,
+                                   const std::string &log_file, bool has_fcs)
+      : gr::block("autotuner",
+              gr::io_signature::make(0, 0, 0),
+              gr::io_signature::make(0, 0, 0)),
+        d_hold_time(hold_time),
+        d_has_fcs(has_fcs),
+        d_climber(tuner_settings(shr_sens, crappy_threshold, shift_threshold),
+                  tuner_settings(shr_sens_step, crappy_threshold_step, shift_threshold_step),
+                  max_steps),
+        d_backend(this),
+        d_good(0),
+        d_bad(0),
+        d_crc_ok_key(pmt::mp("crc_ok")),
+        d_in_port(pmt::mp("pdu in")),
+        d_ctrl_port(pmt::mp("ctrl"))
+    {
+      if (hold_time <= 0)
+        throw std::invalid_argument("autotuner: hold_time must be positive");
+
+      if (!replay_file.empty()) {
+        d_replay.reset(new replay_backend(replay_file));
+        d_backend = d_replay.get();
+      }
+      if (!log_file.empty()) {
+        d_log.open(log_file.c_str());
+        if (!d_log)
+          throw std::runtime_error("autotuner: can't open " + log_file);
+        d_log << "# shr_sens crappy_threshold shift_threshold good bad" << std::endl;
+      }
+
+      message_port_register_in(d_in_port);
+      set_msg_handler(d_in_port, boost::bind(&autotuner_impl::handle_pdu, this, _1));
+      message_port_register_out(d_ctrl_port);
+    }
+
+    /*
+     * Our virtual destructor.
+     */
+    autotuner_impl::~autotuner_impl()
+    {
+    }
+
+    int
+    autotuner_impl::best_shr_sens() const
+    {
+      gr::thread::scoped_lock guard(d_mutex);
+      return d_climber.best().shr_sens;
+    }
+
+    int
+    autotuner_impl::best_crappy_threshold() const
+    {
+      gr::thread::scoped_lock guard(d_mutex);
+      return d_climber.best().crappy_threshold;
+    }
+
+    double
+    autotuner_impl::best_shift_threshold() const
+    {
+      gr::thread::scoped_lock guard(d_mutex);
+      return d_climber.best().shift_threshold;
+    }
+
+    void
+    autotuner_impl::handle_pdu(pmt::pmt_t msg)
+    {
+      if (!pmt::is_pair(msg) || !pmt::is_u8vector(pmt::cdr(msg)))
+        return;
+
+      const pmt::pmt_t meta = pmt::car(msg);
+      const pmt::pmt_t crc_ok = pmt::is_dict(meta)
+        ? pmt::dict_ref(meta, d_crc_ok_key, pmt::PMT_NIL) : pmt::PMT_NIL;
+
+      bool good = true;
+      if (pmt::is_bool(crc_ok))
+        good = pmt::to_bool(crc_ok);
+      else if (d_has_fcs) {
+        // A good frame checks out to zero including its FCS
+        size_t len;
+        const uint8_t *data = pmt::u8vector_elements(pmt::cdr(msg), len);
+        good = len >= 2 && !crc16::compute(data, len);
+      }
+
+      gr::thread::scoped_lock guard(d_mutex);
+      if (good)
+        d_good++;
+      else
+        d_bad++;
+    }
+
+    void
+    autotuner_impl::apply(const tuner_settings &)
+    {
+      // Frames still in flight from the old settings get counted for the
+      // new ones, hold_time has to be long compared to the latency.
+      d_good = d_bad = 0;
+    }
+
+    void
+    autotuner_impl::take_outcomes(uint64_t &good, uint64_t &bad)
+    {
+      good = d_good;
+      bad = d_bad;
+      d_good = d_bad = 0;
+    }
+
+    void
+    autotuner_impl::try_settings(const tuner_settings &s)
+    {
+      d_backend->apply(s);
+      message_port_pub(d_ctrl_port, make_tuner_ctrl(s));
+    }
+
+    void
+    autotuner_impl::run()
+    {
+      const boost::posix_time::microseconds hold(long(d_hold_time * 1e6));
+      try {
+        while (true) {
+          boost::this_thread::sleep(hold);
+
+          gr::thread::scoped_lock guard(d_mutex);
+          const tuner_settings held = d_climber.current();
+          uint64_t good, bad;
+          d_backend->take_outcomes(good, bad);
+          if (d_log.is_open()) {
+            d_log << held.shr_sens << ' ' << held.crappy_threshold << ' '
+                  << held.shift_threshold << ' ' << good << ' ' << bad << std::endl;
+          }
+
+          d_climber.report(good, bad, d_hold_time);
+          try_settings(d_climber.current());
+        }
+      }
+      catch (boost::thread_interrupted &) {
+      }
+    }
+
+    bool
+    autotuner_impl::start()
+    {
+      {
+        gr::thread::scoped_lock guard(d_mutex);
+        try_settings(d_climber.current());
+      }
+      d_thread = boost::shared_ptr<gr::thread::thread>(
+        new gr::thread::thread(boost::bind(&autotuner_impl::run, this)));
+      return block::start();
+    }
+
+    bool
+    autotuner_impl::stop()
+    {
+      if (d_thread) {
+        d_thread->interrupt();
+        d_thread->join();
+        d_thread.reset();
+      }
+      return block::stop();
+    }
+
+  } /* namespace zluudgbee */
+} /* namespace gr */
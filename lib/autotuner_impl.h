@@ -0,0 +1,80 @@
+/* -*- c++ -*- */
+/* 
+ * Copyright 2019 Leon Fernandez (zluudg).
+ * 
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ * 
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_ZLUUDGBEE_AUTOTUNER_IMPL_H
+#define INCLUDED_ZLUUDGBEE_AUTOTUNER_IMPL_H
+
+#include <zluudgbee/autotuner.h>
+#include <zluudgbee/tuner.h>
+#include <gnuradio/thread/thread.h>
+#include <boost/scoped_ptr.hpp>
+#include <boost/shared_ptr.hpp>
+#include <fstream>
+
+namespace gr {
+  namespace zluudgbee {
+
+    class autotuner_impl : public autotuner, public tuner_backend
+    {
+     private:
+      const double d_hold_time;
+      const bool d_has_fcs;
+      hill_climber d_climber;
+      boost::scoped_ptr<replay_backend> d_replay;
+      tuner_backend *d_backend;
+      std::ofstream d_log;
+
+      mutable gr::thread::mutex d_mutex;
+      uint64_t d_good;
+      uint64_t d_bad;
+      boost::shared_ptr<gr::thread::thread> d_thread;
+
+      const pmt::pmt_t d_crc_ok_key;
+      const pmt::pmt_t d_in_port;
+      const pmt::pmt_t d_ctrl_port;
+
+      void handle_pdu(pmt::pmt_t msg);
+      void try_settings(const tuner_settings &s);
+      void run();
+
+     public:
+      autotuner_impl(double hold_time, int shr_sens, int crappy_threshold,
+                     double shift_threshold, int shr_sens_step,
+                     int crappy_threshold_step, double shift_threshold_step,
+                     int max_steps, const std::string &replay_file,
+                     const std::string &log_file, bool has_fcs);
+      ~autotuner_impl();
+
+      int best_shr_sens() const;
+      int best_crappy_threshold() const;
+      double best_shift_threshold() const;
+
+      // Outcomes from "pdu in", unless there's a replay file
+      void apply(const tuner_settings &s);
+      void take_outcomes(uint64_t &good, uint64_t &bad);
+
+      bool start();
+      bool stop();
+    };
+
+  } // namespace zluudgbee
+} // namespace gr
+
+#endif /* INCLUDED_ZLUUDGBEE_AUTOTUNER_IMPL_H */
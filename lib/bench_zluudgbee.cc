@@ -0,0 +1,1249 @@
+/* -*- c++ -*- */
+/* 
+ * Copyright 2019 Leon Fernandez (zluudg).
+ * 
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ * 
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/*
+ * Benchmarks of the host side: the kernels one by one, the message
+ * handlers of the blocks called directly, and whole flowgraphs fed with
+ * synthetic PDUs or IQ. Results go out as JSON so they can be compared
+ * between releases, a short summary goes to stderr.
+ *
+ *   bench-zluudgbee [-o results.json] [--filter crc16,flowgraph]
+ *                   [--min-time 0.5] [--frames 200] [--metrics] [--list]
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <zluudgbee/capture_source.h>
+#include <zluudgbee/chdr_replay.h>
+#include <zluudgbee/coherentrx.h>
+#include <zluudgbee/coordinator.h>
+#include <zluudgbee/crc16.h>
+#include <zluudgbee/dummycoord.h>
+#include <zluudgbee/mac_frame.h>
+#include <zluudgbee/metrics.h>
+#include <zluudgbee/softcrc.h>
+#include <zluudgbee/softrx.h>
+#include <gnuradio/high_res_timer.h>
+#include <gnuradio/io_signature.h>
+#include <gnuradio/sync_block.h>
+#include <gnuradio/top_block.h>
+#include <gnuradio/thread/thread.h>
+#include <boost/bind.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+#include <unistd.h>
+
+#include "addr_index.h"
+#include "capture_file.h"
+#include "chdr_unpack.h"
+#include "coherent_demod.h"
+#include "coord_engine.h"
+#include "correlate_kernel.h"
+#include "cpu_features.h"
+#include "demapper_kernel.h"
+#include "device_emulator.h"
+#include "mock_rx_streamer.h"
+#include "oqpsk_waveform.h"
+#include "phasediff_kernel.h"
+#include "rx_model.h"
+#include "shr_kernel.h"
+#include "timer_wheel.h"
+
+using namespace gr::zluudgbee;
+
+namespace {
+
+  struct result
+  {
+    std::string name;
+    std::string group;
+    uint64_t iterations;
+    double seconds;
+    double items;                // per iteration
+    double bytes;                // per iteration
+    std::vector<std::pair<std::string, double> > counters;
+  };
+
+  struct options
+  {
+    double min_time;
+    size_t frames;
+    bool metrics;
+    bool list;
+    std::vector<std::string> filters;
+    std::string out;
+  };
+
+  options opts;
+  std::vector<result> results;
+  volatile uint32_t sink;       // keeps return values alive
+
+  double
+  now()
+  {
+    return double(gr::high_res_timer_now()) / double(gr::high_res_timer_tps());
+  }
+
+  bool
+  selected(const std::string &name)
+  {
+    if (opts.list) {
+      std::cout << name << std::endl;
+      return false;
+    }
+    if (opts.filters.empty())
+      return true;
+    for (size_t i = 0; i < opts.filters.size(); i++)
+      if (name.find(opts.filters[i]) != std::string::npos)
+        return true;
+    return false;
+  }
+
+  void
+  report(const result &r)
+  {
+    const double per_iter = r.seconds / r.iterations;
+    std::fprintf(stderr, "%-40s %12.1f ns", r.name.c_str(), per_iter * 1e9);
+    if (r.items)
+      std::fprintf(stderr, " %10.2f Mitems/s", r.items / per_iter / 1e6);
+    if (r.bytes)
+      std::fprintf(stderr, " %10.1f MB/s", r.bytes / per_iter / 1e6);
+    std::fprintf(stderr, "\n");
+    results.push_back(r);
+  }
+
+  /*
+   * Runs fn in growing batches until a batch takes at least min_time,
+   * after one untimed call to warm up caches and the dispatchers.
+   */
+  template <typename F>
+  void
+  bench(const std::string &name, double items, double bytes, F fn)
+  {
+    if (!selected(name))
+      return;
+
+    fn();
+    uint64_t iters = 1;
+    double seconds;
+    for (;;) {
+      const double start = now();
+      for (uint64_t i = 0; i < iters; i++)
+        fn();
+      seconds = now() - start;
+      if (seconds >= opts.min_time)
+        break;
+      const double scale = seconds > 0 ? 1.2 * opts.min_time / seconds : 10.0;
+      iters = std::max(iters + 1, uint64_t(iters * std::min(scale, 10.0)));
+    }
+
+    result r;
+    r.name = name;
+    r.group = "kernel";
+    r.iterations = iters;
+    r.seconds = seconds;
+    r.items = items;
+    r.bytes = bytes;
+    report(r);
+  }
+
+  /*
+   * dummycoord reports every frame on stdout. With no buffer behind it
+   * cout drops the text right away, and restoring the buffer clears the
+   * error state again.
+   */
+  class quiet_cout
+  {
+   public:
+    quiet_cout() : d_buf(std::cout.rdbuf(0)) {}
+    ~quiet_cout() { std::cout.rdbuf(d_buf); }
+
+   private:
+    std::streambuf *d_buf;
+  };
+
+  std::vector<uint8_t>
+  random_bytes(size_t n, unsigned seed)
+  {
+    std::vector<uint8_t> v(n);
+    srand(seed);
+    for (size_t i = 0; i < n; i++)
+      v[i] = rand() & 0xFF;
+    return v;
+  }
+
+  // psdu_len byte PSDUs with a valid FCS, all different
+  std::vector<std::vector<uint8_t> >
+  make_psdus(size_t count, size_t psdu_len)
+  {
+    std::vector<std::vector<uint8_t> > psdus(count);
+    for (size_t f = 0; f < count; f++) {
+      psdus[f] = random_bytes(psdu_len - 2, unsigned(f + 1));
+      const uint16_t fcs = crc16::compute(&psdus[f][0], psdu_len - 2);
+      psdus[f].push_back(fcs & 0xFF);
+      psdus[f].push_back(fcs >> 8);
+    }
+    return psdus;
+  }
+
+  // Beacon request as it comes out of softcrc, without the FCS
+  std::vector<uint8_t>
+  beacon_request()
+  {
+    const uint8_t frame[] = { 0x03, 0x08, 0x2a, 0xff, 0xff, 0xff, 0xff, 0x07 };
+    return std::vector<uint8_t>(frame, frame + sizeof(frame));
+  }
+
+  pmt::pmt_t
+  make_pdu(const std::vector<uint8_t> &bytes)
+  {
+    return pmt::cons(pmt::make_dict(), pmt::init_u8vector(bytes.size(), &bytes[0]));
+  }
+
+  // A new empty file under /tmp, empty string if there is no room
+  std::string
+  temp_file()
+  {
+    char path[] = "/tmp/bench-zluudgbee-XXXXXX";
+    const int fd = mkstemp(path);
+    if (fd < 0)
+      return "";
+    close(fd);
+    return path;
+  }
+
+  /*
+   * Bursts of the given PSDUs as the USRP would deliver them to softrx:
+   * sc16 with I and Q swapped. The silence before each burst is long
+   * enough for the shift threshold averaging to settle, shorter gaps
+   * lose a few frames.
+   */
+  std::vector<sc16_t>
+  burst_train_sc16(const std::vector<std::vector<uint8_t> > &psdus, unsigned spc)
+  {
+    oqpsk_waveform wave(spc);
+    std::vector<sc16_t> out;
+    std::vector<gr_complex> burst;
+    for (size_t f = 0; f < psdus.size(); f++) {
+      out.resize(out.size() + 10000);
+      wave.start(&psdus[f][0], psdus[f].size());
+      burst.resize(wave.remaining());
+      wave.generate(&burst[0], burst.size());
+      for (size_t i = 0; i < burst.size(); i++)
+        out.push_back(sc16_t(int16_t(std::floor(burst[i].imag() * 8000.0f + 0.5f)),
+                             int16_t(std::floor(burst[i].real() * 8000.0f + 0.5f))));
+    }
+    out.resize(out.size() + 20000);
+    return out;
+  }
+
+  std::vector<gr_complex>
+  burst_train_fc32(const std::vector<std::vector<uint8_t> > &psdus, unsigned spc)
+  {
+    oqpsk_waveform wave(spc);
+    std::vector<gr_complex> out;
+    for (size_t f = 0; f < psdus.size(); f++) {
+      out.resize(out.size() + 500);
+      wave.start(&psdus[f][0], psdus[f].size());
+      const size_t offset = out.size();
+      out.resize(offset + wave.remaining());
+      wave.generate(&out[offset], wave.remaining());
+    }
+    out.resize(out.size() + 500);
+    return out;
+  }
+
+
+  /*************************************************************************
+   * Kernels
+   *************************************************************************/
+
+  void
+  bench_crc16()
+  {
+    const size_t lens[] = { 16, 127, 4096 };
+    const char *names[] = { "auto", "bitwise", "table", "slice8", "clmul" };
+    for (size_t l = 0; l < sizeof(lens) / sizeof(lens[0]); l++) {
+      const size_t len = lens[l];
+      const std::vector<uint8_t> buf = random_bytes(len, 1);
+      for (int impl = crc16::IMPL_AUTO; impl <= crc16::IMPL_CLMUL; impl++) {
+        if (!crc16::supported(crc16::impl_t(impl)))
+          continue;
+        std::ostringstream name;
+        name << "crc16/" << names[impl] << "/" << len;
+        bench(name.str(), len, len, [&]() {
+          sink = crc16::compute(&buf[0], len, 0, crc16::impl_t(impl));
+        });
+      }
+    }
+  }
+
+  void
+  bench_chdr()
+  {
+    const size_t nwords = 4096;
+    const std::vector<uint8_t> words = random_bytes(nwords * CHDR_ITEM_SIZE, 2);
+    std::vector<uint8_t> out(nwords);
+
+    bench("chdr/extract_bytes/4096", nwords, nwords * CHDR_ITEM_SIZE, [&]() {
+      chdr_extract_bytes(&words[0], nwords, &out[0]);
+    });
+    bench("chdr/extract_bytes_generic/4096", nwords, nwords * CHDR_ITEM_SIZE, [&]() {
+      chdr_extract_lane_generic(&words[0], nwords, CHDR_BYTE_LANE, &out[0]);
+    });
+    bench("chdr/extract_flags/4096", nwords, nwords * CHDR_ITEM_SIZE, [&]() {
+      chdr_extract_flags(&words[0], nwords, &out[0]);
+    });
+
+    // 4096 words worth of 60-byte frames
+    std::vector<uint8_t> flags(nwords, CHDR_FLAG_ACTIVE);
+    for (size_t i = 59; i < nwords; i += 60)
+      flags[i] |= CHDR_FLAG_ENDFRAME;
+    std::vector<chdr_frame> frames;
+    bench("chdr/split_frames/4096", nwords, nwords, [&]() {
+      frames.clear();
+      chdr_split_frames(&flags[0], nwords, frames);
+    });
+  }
+
+  // Sequential reads through a mapped capture, in the pieces a source
+  // block would hand out
+  void
+  bench_capture()
+  {
+    if (!selected("capture/copy/4M"))
+      return;
+    const size_t nsamples = 4 << 20;
+    const size_t piece = 8192;
+    const std::string path = temp_file();
+    if (path.empty())
+      return;
+    {
+      const std::vector<uint8_t> bytes = random_bytes(nsamples * capture_file::SAMPLE_SIZE, 3);
+      std::ofstream out(path.c_str(), std::ios::binary);
+      out.write((const char *) &bytes[0], bytes.size());
+    }
+
+    {
+      const capture_file capture(path, "", 4e6);
+      std::vector<int16_t> out(2 * piece);
+      bench("capture/copy/4M", nsamples, nsamples * capture_file::SAMPLE_SIZE, [&]() {
+        for (size_t i = 0; i < nsamples; i += piece)
+          std::memcpy(&out[0], capture.samples() + 2 * i, piece * capture_file::SAMPLE_SIZE);
+        sink = out[0];
+      });
+    }
+    std::remove(path.c_str());
+  }
+
+  void
+  bench_phy_kernels()
+  {
+    const size_t n = 4096;
+
+    std::vector<uint32_t> chips(n);
+    for (size_t i = 0; i < n; i++)
+      chips[i] = rx_demapper::CHIP_SEQUENCES[i & 15] ^ (1u << (i % 31));
+    std::vector<uint8_t> nibbles(n);
+    bench("demapper/demap_chips/4096", n, 4 * n, [&]() {
+      demap_chips(&chips[0], n, 8, &nibbles[0]);
+    });
+    bench("demapper/demap_chips_generic/4096", n, 4 * n, [&]() {
+      demap_chips_generic(&chips[0], n, 8, &nibbles[0]);
+    });
+
+    std::vector<int16_t> iq(2 * n + 2);
+    srand(3);
+    for (size_t i = 0; i < iq.size(); i++)
+      iq[i] = int16_t(rand() % 16384 - 8192);
+    std::vector<int32_t> phase(n);
+    bench("phasediff/sc16/4096", n, 4 * n, [&]() {
+      phasediff_sc16(&iq[2], &iq[0], n, &phase[0]);
+    });
+    bench("phasediff/sc16_generic/4096", n, 4 * n, [&]() {
+      phasediff_sc16_generic(&iq[2], &iq[0], n, &phase[0]);
+    });
+
+    std::vector<uint64_t> words((n + 63) / 64 + 1);
+    bench("shr/pack_chips/4096", n, 4 * n, [&]() {
+      shr_pack_chips(&phase[0], n, &words[0]);
+    });
+    bench("shr/pack_chips_generic/4096", n, 4 * n, [&]() {
+      shr_pack_chips_generic(&phase[0], n, &words[0]);
+    });
+    std::vector<shr_match> matches;
+    bench("shr/scan/4096", n - SHR_CHIPS, 0, [&]() {
+      matches.clear();
+      shr_scan(&words[0], SHR_CHIPS - 1, n - 1, 20, matches);
+    });
+
+    // One nibble against all 16 references, as coherent_demod does
+    const oqpsk_table_view &tables = oqpsk_nibble_tables(2);
+    std::vector<gr_complex> in(tables.fc32 + 5 * tables.len, tables.fc32 + 6 * tables.len);
+    gr_complex corr[16];
+    bench("correlate/refs/spc2", 16, 0, [&]() {
+      correlate_refs(&in[0], tables.fc32, tables.len, tables.len, 16, corr);
+    });
+    bench("correlate/refs_generic/spc2", 16, 0, [&]() {
+      correlate_refs_generic(&in[0], tables.fc32, tables.len, tables.len, 16, corr);
+    });
+
+    const std::vector<std::vector<uint8_t> > psdu = make_psdus(1, 127);
+    oqpsk_waveform wave(2);
+    wave.start(&psdu[0][0], psdu[0].size());
+    const size_t burst_len = wave.remaining();
+    std::vector<gr_complex> fc32(burst_len);
+    std::vector<sc16_t> sc16(burst_len);
+    bench("oqpsk/generate_fc32/127", burst_len, 0, [&]() {
+      wave.start(&psdu[0][0], psdu[0].size());
+      wave.generate(&fc32[0], burst_len);
+    });
+    bench("oqpsk/generate_sc16/127", burst_len, 0, [&]() {
+      wave.start(&psdu[0][0], psdu[0].size());
+      wave.generate(&sc16[0], burst_len);
+    });
+  }
+
+  void
+  bench_receivers()
+  {
+    const std::vector<std::vector<uint8_t> > psdus = make_psdus(4, 40);
+
+    const std::vector<sc16_t> sc16 = burst_train_sc16(psdus, 20);
+    rx_model model;
+    model.set_register(SR_DECIM_RATE, 20);
+    model.set_register(SR_SHIFT_THRESHOLD, 1 << 14);
+    std::vector<uint32_t> words;
+    std::vector<size_t> ends;
+    bench("rx_model/work/4x40", sc16.size(), 0, [&]() {
+      model.work((const int16_t *) &sc16[0], sc16.size());
+      words.clear();
+      ends.clear();
+      model.take_bursts(words, ends);
+    });
+
+    const std::vector<gr_complex> fc32 = burst_train_fc32(psdus, 2);
+    coherent_demod demod(2, 0.1f, 0.25f);
+    std::vector<coherent_demod::frame> frames;
+    bench("coherent_demod/work/4x40", fc32.size(), 0, [&]() {
+      frames.clear();
+      for (size_t i = 0; i < fc32.size(); i += 4096)
+        demod.work(&fc32[i], std::min<size_t>(4096, fc32.size() - i), frames);
+    });
+  }
+
+
+  /*************************************************************************
+   * PDUs and message handlers
+   *************************************************************************/
+
+  void
+  bench_pmt()
+  {
+    const pmt::pmt_t confidence = pmt::mp("confidence");
+    const pmt::pmt_t crappy = pmt::mp("crappy_nibbles");
+    const size_t lens[] = { 20, 127 };
+    for (size_t l = 0; l < 2; l++) {
+      const size_t len = lens[l];
+      const std::vector<uint8_t> bytes = random_bytes(len, 4);
+      std::ostringstream bare, meta;
+      bare << "pmt/pdu/" << len;
+      meta << "pmt/pdu_with_meta/" << len;
+
+      bench(bare.str(), 1, len, [&]() {
+        pmt::pmt_t pdu = make_pdu(bytes);
+        sink = pmt::blob_length(pmt::cdr(pdu));
+      });
+      // What chdr2pdu and softrx publish for every frame
+      bench(meta.str(), 1, len, [&]() {
+        pmt::pmt_t dict = pmt::make_dict();
+        dict = pmt::dict_add(dict, confidence, pmt::from_double(0.97));
+        dict = pmt::dict_add(dict, crappy, pmt::from_long(3));
+        pmt::pmt_t pdu = pmt::cons(dict, pmt::init_u8vector(len, &bytes[0]));
+        sink = pmt::blob_length(pmt::cdr(pdu));
+      });
+    }
+  }
+
+  /*
+   * dispatch_msg() runs the handler right away on this thread. Nothing
+   * is connected to the outputs, so publishing costs a lookup and no more.
+   */
+  void
+  bench_handlers()
+  {
+    const pmt::pmt_t in = pmt::mp("pdu in");
+
+    softcrc::sptr rx = softcrc::make(true);
+    const std::vector<std::vector<uint8_t> > psdu = make_psdus(1, 127);
+    const pmt::pmt_t rx_pdu = make_pdu(psdu[0]);
+    bench("mac/softcrc_rx/127", 1, 127, [&]() {
+      rx->dispatch_msg(in, rx_pdu);
+    });
+
+    softcrc::sptr tx = softcrc::make(false);
+    const pmt::pmt_t tx_pdu = make_pdu(random_bytes(125, 5));
+    bench("mac/softcrc_tx/125", 1, 125, [&]() {
+      tx->dispatch_msg(in, tx_pdu);
+    });
+
+    // A data frame with a compressed PAN ID and extended addresses
+    const uint8_t data[] = { 0x41, 0xcc, 0x05, 0xcd, 0xab,
+                             1, 2, 3, 4, 5, 6, 7, 8, 11, 12, 13, 14, 15, 16, 17, 18,
+                             'h', 'e', 'l', 'l', 'o' };
+    mac_frame_view view;
+    bench("mac/frame_view/parse", 1, sizeof(data), [&]() {
+      view.parse(data, sizeof(data));
+      sink = view.src_addr() + view.payload_len();
+    });
+
+    std::vector<pmt::pmt_t> batch;
+    for (size_t i = 0; i < 64; i++)
+      batch.push_back(i % 2 ? make_pdu(beacon_request())
+                            : make_pdu(std::vector<uint8_t>(data, data + sizeof(data))));
+    std::vector<mac_frame_view> views(batch.size());
+    bench("mac/frame_view/parse_pdus/64", batch.size(), 0, [&]() {
+      sink = parse_mac_frames(&batch[0], batch.size(), &views[0]);
+    });
+
+    // Parses the command frame and builds the beacon, minus its chatter
+    dummycoord::sptr coord = dummycoord::make();
+    const std::vector<uint8_t> request = beacon_request();
+    const pmt::pmt_t request_pdu = make_pdu(request);
+    quiet_cout quiet;
+    bench("mac/dummycoord_beacon_request", 1, request.size(), [&]() {
+      coord->dispatch_msg(in, request_pdu);
+    });
+
+    // Data frame to the coordinator's default address that wants an ACK
+    const uint8_t acked[] = { 0x61, 0x88, 0x11, 0xcd, 0xab, 0x01, 0x00, 0x34, 0x12, 'h', 'i' };
+    const pmt::pmt_t acked_pdu = make_pdu(std::vector<uint8_t>(acked, acked + sizeof(acked)));
+    bench("mac/dummycoord_ack", 1, sizeof(acked), [&]() {
+      coord->dispatch_msg(in, acked_pdu);
+    });
+  }
+
+
+  /*************************************************************************
+   * Coordinator
+   *************************************************************************/
+
+  // Hands the coordinator's frames back to the emulated devices.
+  class frame_loopback : public coord_engine::output
+  {
+   public:
+    frame_loopback() : d_n(0), d_delivered(0) {}
+
+    void transmit(const uint8_t *frame, size_t len)
+    {
+      if (d_n < MAX_FRAMES) {
+        std::memcpy(d_frames[d_n], frame, len);
+        d_lens[d_n++] = len;
+      }
+    }
+
+    void deliver(const mac_frame_view &frame) { d_delivered += frame.payload_len(); }
+
+    void flush(device_emulator &devices)
+    {
+      for (size_t i = 0; i < d_n; i++)
+        devices.receive(d_frames[i], d_lens[i]);
+      d_n = 0;
+    }
+
+   private:
+    static const size_t MAX_FRAMES = 16;
+    uint8_t d_frames[MAX_FRAMES][128];
+    size_t d_lens[MAX_FRAMES];
+    size_t d_n;
+    uint64_t d_delivered;
+  };
+
+  /*
+   * One frame from the device population through the coordinator and
+   * its answers back, with the clock moving a millisecond every 64
+   * frames and a frame queued for a device every fourth. Runs until
+   * every device has associated before timing, so this is the steady
+   * state of a full PAN, with 1% of the ACKs lost.
+   */
+  void
+  bench_coord_engine(size_t devices)
+  {
+    std::ostringstream name;
+    name << "coord/engine/" << devices;
+    if (!selected(name.str()))
+      return;
+
+    coord_config config;
+    config.max_devices = devices;
+    config.queue_frames = 2 * devices;
+    frame_loopback loopback;
+    coord_engine engine(config, loopback);
+    device_emulator population(devices, config.pan_id, config.short_addr, 32, 0.01);
+
+    uint8_t frame[device_emulator::MAX_FRAME];
+    const std::vector<uint8_t> payload = random_bytes(20, 7);
+    uint64_t ms = 0, n = 0;
+    auto step = [&]() {
+      const size_t len = population.next_frame(frame);
+      engine.handle(mac_frame_view(frame, len), ms);
+      loopback.flush(population);
+      if (++n % 4 == 0)
+        engine.send_indirect(1 + (n / 4) % devices, false, &payload[0], payload.size(), ms);
+      if (n % 64 == 0) {
+        engine.advance(++ms);
+        loopback.flush(population);
+      }
+    };
+
+    for (size_t i = 0; i < 20 * devices && population.associated() < devices; i++)
+      step();
+    bench(name.str(), 1, 0, step);
+  }
+
+  void
+  bench_coordinator()
+  {
+    bench_coord_engine(1000);
+    bench_coord_engine(10000);
+
+    // Lookups of present keys in a table as full as it gets
+    const size_t entries = 10000;
+    addr_index index(entries);
+    for (size_t i = 0; i < entries; i++)
+      index.insert(0x00124b0000000000ull + i * 7919, i);
+    size_t k = 0;
+    bench("coord/addr_index/find/10k", 1, 0, [&]() {
+      sink = index.find(0x00124b0000000000ull + (k++ % entries) * 7919);
+    });
+
+    // A timer armed and the wheel moved on by a tick, 10000 timers pending
+    std::vector<timer_wheel::timer> timers(entries + 1);
+    timer_wheel wheel;
+    for (size_t i = 0; i < entries; i++)
+      wheel.schedule(timers[i], 1000 + i * 37);
+    uint64_t tick = 0;
+    struct
+    {
+      void operator()(timer_wheel::timer &t) { sink = t.owner; }
+    } fire;
+    bench("coord/timer_wheel/schedule_advance", 1, 0, [&]() {
+      wheel.schedule(timers[entries], tick + 10);
+      wheel.advance(++tick, fire);
+    });
+  }
+
+
+  /*************************************************************************
+   * Flowgraphs
+   *************************************************************************/
+
+  // Counts the PDUs that make it to the end of a flowgraph.
+  class pdu_counter : public gr::block
+  {
+   public:
+    typedef boost::shared_ptr<pdu_counter> sptr;
+
+    static sptr make()
+    {
+      return gnuradio::get_initial_sptr(new pdu_counter());
+    }
+
+    void handle_pdu(pmt::pmt_t msg)
+    {
+      const size_t len = pmt::blob_length(pmt::cdr(msg));
+      gr::thread::scoped_lock lock(d_mutex);
+      d_count++;
+      d_bytes += len;
+      d_last = now();
+      d_cond.notify_all();
+    }
+
+    /*
+     * Waits until count PDUs have come in, or none have for idle seconds.
+     * Returns the number that did.
+     */
+    uint64_t wait_for(uint64_t count, double idle)
+    {
+      gr::thread::scoped_lock lock(d_mutex);
+      double last_seen = now();
+      uint64_t seen = d_count;
+      while (d_count < count) {
+        d_cond.timed_wait(lock, boost::posix_time::milliseconds(20));
+        if (d_count != seen) {
+          seen = d_count;
+          last_seen = now();
+        }
+        else if (now() - last_seen > idle)
+          break;
+      }
+      return d_count;
+    }
+
+    uint64_t count()
+    {
+      gr::thread::scoped_lock lock(d_mutex);
+      return d_count;
+    }
+
+    // Time from start to the last PDU, or to now if none came
+    double elapsed_since(double start)
+    {
+      gr::thread::scoped_lock lock(d_mutex);
+      return (d_count ? d_last : now()) - start;
+    }
+
+   private:
+    gr::thread::mutex d_mutex;
+    gr::thread::condition_variable d_cond;
+    uint64_t d_count;
+    uint64_t d_bytes;
+    double d_last;
+
+    pdu_counter()
+      : gr::block("bench_pdu_counter",
+                  gr::io_signature::make(0, 0, 0),
+                  gr::io_signature::make(0, 0, 0)),
+        d_count(0), d_bytes(0), d_last(0)
+    {
+      message_port_register_in(pmt::mp("pdus"));
+      set_msg_handler(pmt::mp("pdus"), boost::bind(&pdu_counter::handle_pdu, this, _1));
+    }
+  };
+
+  // Plays back a recording, repeated until total items have gone out.
+  template <typename T>
+  class loop_source : public gr::sync_block
+  {
+   public:
+    typedef boost::shared_ptr<loop_source> sptr;
+
+    static sptr make(const std::vector<T> &samples, uint64_t total)
+    {
+      return gnuradio::get_initial_sptr(new loop_source(samples, total));
+    }
+
+    int work(int noutput_items,
+             gr_vector_const_void_star &input_items,
+             gr_vector_void_star &output_items)
+    {
+      T *out = (T *) output_items[0];
+      if (d_sent == d_total)
+        return WORK_DONE;
+
+      const size_t n = std::min<uint64_t>(noutput_items, d_total - d_sent);
+      for (size_t i = 0; i < n; ) {
+        const size_t pos = (d_sent + i) % d_samples.size();
+        const size_t chunk = std::min(n - i, d_samples.size() - pos);
+        std::memcpy(out + i, &d_samples[pos], chunk * sizeof(T));
+        i += chunk;
+      }
+      d_sent += n;
+      return n;
+    }
+
+   private:
+    const std::vector<T> &d_samples;
+    const uint64_t d_total;
+    uint64_t d_sent;
+
+    loop_source(const std::vector<T> &samples, uint64_t total)
+      : gr::sync_block("bench_loop_source",
+                       gr::io_signature::make(0, 0, 0),
+                       gr::io_signature::make(1, 1, sizeof(T))),
+        d_samples(samples), d_total(total), d_sent(0)
+    {
+    }
+  };
+
+  void
+  add_stage_latencies(result &r)
+  {
+    if (!opts.metrics)
+      return;
+    const std::vector<stage_metrics_sptr> stages = metrics::stages();
+    for (size_t i = 0; i < stages.size(); i++) {
+      const latency_histogram &h = stages[i]->handler_latency;
+      if (!h.count())
+        continue;
+      // Block numbers change from run to run, the kind of block doesn't
+      std::string stage = stages[i]->name;
+      stage.erase(stage.find_last_not_of("0123456789_") + 1);
+      r.counters.push_back(std::make_pair(stage + ".handler_p50_ns", double(h.percentile(0.5))));
+      r.counters.push_back(std::make_pair(stage + ".handler_p99_ns", double(h.percentile(0.99))));
+    }
+  }
+
+  void
+  report_flowgraph(const std::string &name, double seconds, uint64_t sent,
+                   uint64_t received, double items, double bytes)
+  {
+    result r;
+    r.name = name;
+    r.group = "flowgraph";
+    r.iterations = 1;
+    r.seconds = seconds;
+    r.items = items;
+    r.bytes = bytes;
+    r.counters.push_back(std::make_pair("frames_sent", double(sent)));
+    r.counters.push_back(std::make_pair("frames_received", double(received)));
+    add_stage_latencies(r);
+    report(r);
+  }
+
+  /*
+   * Posts the PDUs straight into the first block's queue, keeping at most
+   * WINDOW in flight so the scheduler never has to drop any.
+   */
+  static const uint64_t WINDOW = 1024;
+
+  double
+  post_pdus(gr::basic_block_sptr first, const pmt::pmt_t &port,
+            const std::vector<pmt::pmt_t> &pdus, uint64_t count,
+            pdu_counter::sptr counter)
+  {
+    const double start = now();
+    for (uint64_t i = 0; i < count; i++) {
+      if (i >= WINDOW && counter->count() + WINDOW <= i)
+        counter->wait_for(i - WINDOW + 1, 1.0);
+      first->_post(port, pdus[i % pdus.size()]);
+    }
+    counter->wait_for(count, 1.0);
+    return counter->elapsed_since(start);
+  }
+
+  void
+  bench_pdu_flowgraphs()
+  {
+    const pmt::pmt_t in = pmt::mp("pdu in");
+    const pmt::pmt_t out = pmt::mp("pdu out");
+    const uint64_t count = 50 * opts.frames;
+
+    if (selected("flowgraph/softcrc_tx")) {
+      std::vector<pmt::pmt_t> pdus;
+      for (unsigned i = 0; i < 64; i++)
+        pdus.push_back(make_pdu(random_bytes(100, i)));
+
+      gr::top_block_sptr tb = gr::make_top_block("bench_softcrc_tx");
+      softcrc::sptr crc = softcrc::make(false);
+      pdu_counter::sptr counter = pdu_counter::make();
+      tb->msg_connect(crc, out, counter, pmt::mp("pdus"));
+      tb->start();
+      const double seconds = post_pdus(crc, in, pdus, count, counter);
+      tb->stop();
+      tb->wait();
+      report_flowgraph("flowgraph/softcrc_tx", seconds, count, counter->count(),
+                       double(counter->count()), 100.0 * counter->count());
+    }
+
+    if (selected("flowgraph/softcrc_dummycoord")) {
+      // Beacon requests with their FCS, each one is answered with a beacon
+      std::vector<uint8_t> request = beacon_request();
+      const uint16_t fcs = crc16::compute(&request[0], request.size());
+      request.push_back(fcs & 0xFF);
+      request.push_back(fcs >> 8);
+      std::vector<pmt::pmt_t> pdus(1, make_pdu(request));
+
+      gr::top_block_sptr tb = gr::make_top_block("bench_softcrc_dummycoord");
+      softcrc::sptr crc = softcrc::make(true);
+      dummycoord::sptr coord = dummycoord::make();
+      pdu_counter::sptr counter = pdu_counter::make();
+      tb->msg_connect(crc, out, coord, in);
+      tb->msg_connect(coord, out, counter, pmt::mp("pdus"));
+
+      double seconds;
+      {
+        quiet_cout quiet;
+        tb->start();
+        seconds = post_pdus(crc, in, pdus, count, counter);
+        tb->stop();
+        tb->wait();
+      }
+      report_flowgraph("flowgraph/softcrc_dummycoord", seconds, count, counter->count(),
+                       double(counter->count()), double(request.size() * counter->count()));
+    }
+
+    if (selected("flowgraph/coordinator")) {
+      // Data frames from a thousand devices, each one answered with an ACK
+      std::vector<pmt::pmt_t> pdus;
+      for (unsigned i = 0; i < 1024; i++) {
+        const uint8_t frame[] = { 0x61, 0x88, uint8_t(i), 0xcd, 0xab, 0x00, 0x00,
+                                  uint8_t(i + 1), uint8_t((i + 1) >> 8), 'h', 'i' };
+        pdus.push_back(make_pdu(std::vector<uint8_t>(frame, frame + sizeof(frame))));
+      }
+
+      gr::top_block_sptr tb = gr::make_top_block("bench_coordinator");
+      coordinator::sptr coord = coordinator::make();
+      pdu_counter::sptr counter = pdu_counter::make();
+      tb->msg_connect(coord, out, counter, pmt::mp("pdus"));
+      tb->start();
+      const double seconds = post_pdus(coord, in, pdus, count, counter);
+      tb->stop();
+      tb->wait();
+      report_flowgraph("flowgraph/coordinator", seconds, count, counter->count(),
+                       double(counter->count()), 11.0 * count);
+    }
+  }
+
+  /*
+   * chdr2pdu's receive path on replayed CHDR bursts into a counter. The
+   * time is taken from start() to the last PDU.
+   */
+  void
+  run_chdr_flowgraph(const std::string &name, const std::string &filename,
+                     double items_per_sec, uint64_t loops, uint64_t frames_per_loop,
+                     size_t psdu_len, int overflow_every = 0, int timeout_every = 0)
+  {
+    gr::top_block_sptr tb = gr::make_top_block("bench_chdr_replay");
+    chdr_replay::sptr replay = chdr_replay::make(filename, psdu_len, 8, items_per_sec,
+                                                 loops, overflow_every, timeout_every,
+                                                 2048, 4096);
+    pdu_counter::sptr counter = pdu_counter::make();
+    tb->msg_connect(replay, pmt::mp("data"), counter, pmt::mp("pdus"));
+
+    const uint64_t sent = loops * frames_per_loop;
+    const double start = now();
+    tb->start();
+    counter->wait_for(sent, 2.0);
+    const double seconds = counter->elapsed_since(start);
+    tb->stop();
+    tb->wait();
+    report_flowgraph("flowgraph/chdr2pdu/" + name, seconds, sent, counter->count(),
+                     double(sent * psdu_len), double(psdu_len * counter->count()));
+  }
+
+  void
+  bench_chdr_flowgraphs()
+  {
+    // chdr_replay's own bursts without a recording: 64 of 8 frames
+    const size_t psdu_len = 40;
+    const uint64_t frames_per_loop = 64 * 8;
+    const uint64_t loops = std::max<uint64_t>(1, 50 * opts.frames / frames_per_loop);
+
+    if (selected("flowgraph/chdr2pdu/asap"))
+      run_chdr_flowgraph("asap", "", 0.0, loops, frames_per_loop, psdu_len);
+
+    if (selected("flowgraph/chdr2pdu/faults"))
+      run_chdr_flowgraph("faults", "", 0.0, loops, frames_per_loop, psdu_len, 7, 11);
+
+    // At 2M items/s, 64 times what a 250 kb/s PHY delivers
+    if (selected("flowgraph/chdr2pdu/paced"))
+      run_chdr_flowgraph("paced", "", 2e6, 1, frames_per_loop, psdu_len);
+
+    if (selected("flowgraph/chdr2pdu/mmap")) {
+      const std::vector<std::vector<uint8_t> > psdus = make_psdus(frames_per_loop, psdu_len);
+      std::vector<std::vector<uint8_t> > bursts(frames_per_loop / 8);
+      for (size_t f = 0; f < psdus.size(); f++)
+        chdr_pack_frame(&psdus[f][0], psdu_len, false, bursts[f / 8]);
+
+      const std::string path = temp_file();
+      if (path.empty()) {
+        std::cerr << "flowgraph/chdr2pdu/mmap: can't create a recording" << std::endl;
+        return;
+      }
+      write_chdr_recording(path, bursts);
+      run_chdr_flowgraph("mmap", path, 0.0, loops, frames_per_loop, psdu_len);
+      std::remove(path.c_str());
+    }
+  }
+
+  /*
+   * IQ source, receiver, softcrc and a counter. The time is taken from
+   * start() to the last good frame, which includes the scheduler and the
+   * PDU handling on top of the receiver itself.
+   */
+  template <typename T>
+  void
+  run_phy_flowgraph(const std::string &name, gr::basic_block_sptr rx,
+                    const std::vector<T> &train, size_t frames_per_train,
+                    size_t psdu_len)
+  {
+    const uint64_t repeats = (opts.frames + frames_per_train - 1) / frames_per_train;
+    const uint64_t total = repeats * train.size();
+
+    gr::top_block_sptr tb = gr::make_top_block("bench_" + name);
+    typename loop_source<T>::sptr src = loop_source<T>::make(train, total);
+    softcrc::sptr crc = softcrc::make(true);
+    pdu_counter::sptr counter = pdu_counter::make();
+    tb->connect(src, 0, rx, 0);
+    tb->msg_connect(rx, pmt::mp("data"), crc, pmt::mp("pdu in"));
+    tb->msg_connect(crc, pmt::mp("pdu out"), counter, pmt::mp("pdus"));
+
+    const uint64_t sent = repeats * frames_per_train;
+    const double start = now();
+    tb->start();
+    counter->wait_for(sent, 2.0);
+    const double seconds = counter->elapsed_since(start);
+    tb->stop();
+    tb->wait();
+    report_flowgraph("flowgraph/" + name, seconds, sent, counter->count(),
+                     double(total), double((psdu_len - 2) * counter->count()));
+  }
+
+  /*
+   * The softrx flowgraph on a capture of the burst train with its frame
+   * starts indexed, played by one capture_source and by several
+   * working on chunks of it side by side, each into a softrx and
+   * softcrc of its own.
+   */
+  void
+  bench_capture_flowgraphs(const std::vector<sc16_t> &train, size_t frames_per_train,
+                           size_t psdu_len)
+  {
+    const uint64_t repeats = (opts.frames + frames_per_train - 1) / frames_per_train;
+    const uint64_t total = repeats * train.size();
+    const double rate = 4e6;
+
+    // Every burst comes after a long silence, which is where it starts
+    std::vector<uint64_t> train_starts;
+    for (size_t i = 1; i < train.size(); i++)
+      if ((train[i].real() || train[i].imag()) && !train[i - 1].real() && !train[i - 1].imag())
+        train_starts.push_back(i);
+
+    const std::string path = temp_file();
+    if (path.empty())
+      return;
+    std::vector<uint64_t> starts;
+    {
+      std::ofstream out(path.c_str(), std::ios::binary);
+      for (uint64_t r = 0; r < repeats; r++) {
+        out.write((const char *) &train[0], train.size() * sizeof(sc16_t));
+        for (size_t i = 0; i < train_starts.size(); i++)
+          starts.push_back(r * train.size() + train_starts[i]);
+      }
+    }
+    write_capture_index(path + ".idx", rate,
+                        std::vector<std::pair<uint64_t, capture_file::timestamp> >(), starts);
+
+    const int workers[] = { 1, 4 };
+    for (size_t w = 0; w < sizeof(workers) / sizeof(workers[0]); w++) {
+      gr::top_block_sptr tb = gr::make_top_block("bench_capture_softrx");
+      pdu_counter::sptr counter = pdu_counter::make();
+      for (int k = 0; k < workers[w]; k++) {
+        // The overlap is the silence before the first burst of a chunk
+        capture_source::sptr src = capture_source::make(path, "", rate, k, workers[w],
+                                                        10000 / rate);
+        softrx::sptr rx = softrx::make(0, 0.125, 20);
+        softcrc::sptr crc = softcrc::make(true);
+        tb->connect(src, 0, rx, 0);
+        tb->msg_connect(rx, pmt::mp("data"), crc, pmt::mp("pdu in"));
+        tb->msg_connect(crc, pmt::mp("pdu out"), counter, pmt::mp("pdus"));
+      }
+
+      const uint64_t sent = repeats * frames_per_train;
+      const double start = now();
+      tb->start();
+      counter->wait_for(sent, 2.0);
+      const double seconds = counter->elapsed_since(start);
+      tb->stop();
+      tb->wait();
+
+      std::ostringstream name;
+      name << "flowgraph/capture/softrx/" << workers[w];
+      report_flowgraph(name.str(), seconds, sent, counter->count(),
+                       double(total), double((psdu_len - 2) * counter->count()));
+    }
+
+    std::remove((path + ".idx").c_str());
+    std::remove(path.c_str());
+  }
+
+  void
+  bench_phy_flowgraphs()
+  {
+    const size_t frames_per_train = 10;
+    const size_t psdu_len = 40;
+    const std::vector<std::vector<uint8_t> > psdus = make_psdus(frames_per_train, psdu_len);
+
+    if (selected("flowgraph/softrx")) {
+      const std::vector<sc16_t> train = burst_train_sc16(psdus, 20);
+      run_phy_flowgraph("softrx", softrx::make(0, 0.125, 20), train,
+                        frames_per_train, psdu_len);
+    }
+
+    if (selected("flowgraph/coherentrx")) {
+      const std::vector<gr_complex> train = burst_train_fc32(psdus, 2);
+      run_phy_flowgraph("coherentrx", coherentrx::make(2), train,
+                        frames_per_train, psdu_len);
+    }
+
+    if (selected("flowgraph/capture/softrx"))
+      bench_capture_flowgraphs(burst_train_sc16(psdus, 20), frames_per_train, psdu_len);
+  }
+
+
+  /*************************************************************************
+   * Output
+   *************************************************************************/
+
+  std::string
+  quoted(const std::string &s)
+  {
+    std::string q = "\"";
+    for (size_t i = 0; i < s.size(); i++) {
+      if (s[i] == '"' || s[i] == '\\')
+        q += '\\';
+      q += s[i];
+    }
+    return q + "\"";
+  }
+
+  std::string
+  number(double x)
+  {
+    if (!std::isfinite(x))
+      return "null";
+    std::ostringstream s;
+    s.precision(12);
+    s << x;
+    return s.str();
+  }
+
+  void
+  write_json(std::ostream &os)
+  {
+    os << "{\n"
+       << "  \"suite\": \"zluudgbee\",\n"
+       << "  \"timestamp\": " << long(std::time(0)) << ",\n"
+       << "  \"min_time\": " << number(opts.min_time) << ",\n"
+       << "  \"cpu\": {"
+#ifdef ZLUUDGBEE_X86
+       << "\"sse2\": " << (cpu_has_sse2() ? "true" : "false")
+       << ", \"popcnt\": " << (cpu_has_popcnt() ? "true" : "false")
+       << ", \"pclmul\": " << (cpu_has_pclmul() ? "true" : "false")
+       << ", \"avx2\": " << (cpu_has_avx2() ? "true" : "false")
+       << ", \"fma\": " << (cpu_has_fma() ? "true" : "false")
+       << ", \"avx512_vpopcntdq\": " << (cpu_has_avx512_vpopcntdq() ? "true" : "false")
+#endif
+#ifdef ZLUUDGBEE_NEON
+       << "\"neon\": true"
+#endif
+       << "},\n"
+       << "  \"benchmarks\": [";
+
+    for (size_t i = 0; i < results.size(); i++) {
+      const result &r = results[i];
+      const double per_iter = r.seconds / r.iterations;
+      os << (i ? ",\n" : "\n")
+         << "    {\"name\": " << quoted(r.name)
+         << ", \"group\": " << quoted(r.group)
+         << ", \"iterations\": " << r.iterations
+         << ", \"seconds\": " << number(r.seconds)
+         << ", \"ns_per_iteration\": " << number(per_iter * 1e9);
+      if (r.items)
+        os << ", \"items_per_second\": " << number(r.items / per_iter);
+      if (r.bytes)
+        os << ", \"bytes_per_second\": " << number(r.bytes / per_iter);
+      for (size_t c = 0; c < r.counters.size(); c++)
+        os << ", " << quoted(r.counters[c].first) << ": " << number(r.counters[c].second);
+      os << "}";
+    }
+    os << "\n  ]\n}\n";
+  }
+
+  void
+  usage(const char *argv0)
+  {
+    std::cerr << "usage: " << argv0 << " [options]\n"
+              << "  -o FILE          write the JSON results to FILE instead of stdout\n"
+              << "  --filter A,B     only run benchmarks whose name contains A or B\n"
+              << "  --min-time SEC   time each kernel for at least SEC seconds (0.5)\n"
+              << "  --frames N       frames per flowgraph benchmark, x50 for PDU-only ones (200)\n"
+              << "  --metrics        collect block metrics, adds handler latencies to flowgraphs\n"
+              << "  --list           print the benchmark names and exit\n";
+  }
+
+} // namespace
+
+int
+main(int argc, char **argv)
+{
+  opts.min_time = 0.5;
+  opts.frames = 200;
+  opts.metrics = false;
+  opts.list = false;
+
+  for (int i = 1; i < argc; i++) {
+    const std::string arg = argv[i];
+    const bool has_value = i + 1 < argc;
+    if (arg == "-o" && has_value)
+      opts.out = argv[++i];
+    else if (arg == "--filter" && has_value) {
+      std::istringstream list(argv[++i]);
+      std::string f;
+      while (std::getline(list, f, ','))
+        if (!f.empty())
+          opts.filters.push_back(f);
+    }
+    else if (arg == "--min-time" && has_value)
+      opts.min_time = std::atof(argv[++i]);
+    else if (arg == "--frames" && has_value)
+      opts.frames = std::max(1, std::atoi(argv[++i]));
+    else if (arg == "--metrics")
+      opts.metrics = true;
+    else if (arg == "--list")
+      opts.list = true;
+    else {
+      usage(argv[0]);
+      return arg == "-h" || arg == "--help" ? 0 : 1;
+    }
+  }
+
+  metrics::set_enabled(opts.metrics);
+
+  bench_crc16();
+  bench_chdr();
+  bench_capture();
+  bench_phy_kernels();
+  bench_receivers();
+  bench_pmt();
+  bench_handlers();
+  bench_coordinator();
+  bench_pdu_flowgraphs();
+  bench_chdr_flowgraphs();
+  bench_phy_flowgraphs();
+
+  if (opts.list)
+    return 0;
+
+  if (opts.out.empty())
+    write_json(std::cout);
+  else {
+    std::ofstream file(opts.out.c_str());
+    write_json(file);
+    if (!file) {
+      std::cerr << "could not write " << opts.out << std::endl;
+      return 1;
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,270 @@
+/* -*- c++ -*- */
+/* 
+ * Copyright 2019 Leon Fernandez (zluudg).
+ * 
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ * 
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "capture_file.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+namespace gr {
+  namespace zluudgbee {
+
+    namespace {
+
+      // "1234.5678" into 1234 and 0.5678 without going through a double,
+      // which would lose the fraction at epoch times
+      bool
+      parse_time(const std::string &s, capture_file::timestamp &t)
+      {
+        const size_t dot = s.find('.');
+        const std::string whole = s.substr(0, dot);
+        char *end;
+        t.secs = std::strtoll(whole.c_str(), &end, 10);
+        if (whole.empty() || *end)
+          return false;
+        t.frac = 0.0;
+        if (dot != std::string::npos) {
+          const std::string frac = "0" + s.substr(dot);
+          t.frac = std::strtod(frac.c_str(), &end);
+          if (*end)
+            return false;
+          if (s[0] == '-' && t.frac > 0.0) {
+            t.secs--;
+            t.frac = 1.0 - t.frac;
+          }
+        }
+        return true;
+      }
+
+      bool
+      file_exists(const std::string &path)
+      {
+        std::ifstream f(path.c_str());
+        return f.good();
+      }
+
+    } // namespace
+
+    capture_file::capture_file(const std::string &path, const std::string &index_path,
+                               double sample_rate)
+      : d_file(path), d_size(d_file.size() / SAMPLE_SIZE), d_rate(sample_rate),
+        d_epoch(0)
+    {
+      if (!index_path.empty())
+        read_index(index_path);
+      else if (file_exists(path + ".idx"))
+        read_index(path + ".idx");
+
+      if (!(d_rate > 0.0))
+        throw std::runtime_error("capture_file: the sample rate of " + path
+                                 + " must be positive");
+      if (d_times.empty()) {
+        const time_entry zero = { 0, 0.0 };
+        d_times.push_back(zero);
+      }
+    }
+
+    void
+    capture_file::read_index(const std::string &path)
+    {
+      std::ifstream in(path.c_str());
+      if (!in)
+        throw std::runtime_error("capture_file: can't open index " + path);
+
+      std::vector<std::pair<uint64_t, timestamp> > times;
+      std::string line;
+      for (size_t n = 1; std::getline(in, line); n++) {
+        line = line.substr(0, line.find('#'));
+        std::istringstream fields(line);
+        std::string key, time;
+        if (!(fields >> key))
+          continue;
+
+        bool ok;
+        if (key == "rate")
+          ok = bool(fields >> d_rate);
+        else if (key == "frame") {
+          uint64_t sample;
+          ok = bool(fields >> sample);
+          if (ok)
+            d_frames.push_back(sample);
+        }
+        else if (key == "time") {
+          std::pair<uint64_t, timestamp> t;
+          ok = (fields >> t.first >> time) && parse_time(time, t.second);
+          if (ok)
+            times.push_back(t);
+        }
+        else
+          ok = false;
+
+        std::string rest;
+        if (!ok || fields >> rest) {
+          std::ostringstream msg;
+          msg << "capture_file: " << path << ":" << n << ": can't parse \"" << line << "\"";
+          throw std::runtime_error(msg.str());
+        }
+      }
+
+      std::sort(d_frames.begin(), d_frames.end());
+      if (!times.empty()) {
+        std::sort(times.begin(), times.end(),
+                  [](const std::pair<uint64_t, timestamp> &a,
+                     const std::pair<uint64_t, timestamp> &b) { return a.first < b.first; });
+        d_epoch = times[0].second.secs;
+        for (size_t i = 0; i < times.size(); i++) {
+          const time_entry e = { times[i].first,
+                                 double(times[i].second.secs - d_epoch) + times[i].second.frac };
+          d_times.push_back(e);
+        }
+      }
+      d_index_path = path;
+    }
+
+    size_t
+    capture_file::entry_for(uint64_t sample) const
+    {
+      size_t lo = 0, hi = d_times.size();
+      while (hi - lo > 1) {
+        const size_t mid = (lo + hi) / 2;
+        if (d_times[mid].sample <= sample)
+          lo = mid;
+        else
+          hi = mid;
+      }
+      return lo;
+    }
+
+    capture_file::timestamp
+    capture_file::time_at(uint64_t sample) const
+    {
+      const time_entry &e = d_times[entry_for(sample)];
+      const double offset = e.offset + double(int64_t(sample - e.sample)) / d_rate;
+      const double whole = std::floor(offset);
+      timestamp t;
+      t.secs = d_epoch + int64_t(whole);
+      t.frac = offset - whole;
+      return t;
+    }
+
+    double
+    capture_file::offset_at(uint64_t sample) const
+    {
+      const time_entry &e = d_times[entry_for(sample)];
+      const time_entry &first = d_times[entry_for(0)];
+      return e.offset + double(int64_t(sample - e.sample)) / d_rate
+        - (first.offset - double(first.sample) / d_rate);
+    }
+
+    uint64_t
+    capture_file::sample_at(double offset) const
+    {
+      const time_entry &first = d_times[entry_for(0)];
+      const double target = offset + first.offset - double(first.sample) / d_rate;
+
+      size_t i = 0;
+      while (i + 1 < d_times.size() && d_times[i + 1].offset <= target)
+        i++;
+
+      // Before the first time entry this runs backwards from it
+      const double ahead = std::ceil((target - d_times[i].offset) * d_rate - 1e-6);
+      const int64_t sample = std::max<int64_t>(0, int64_t(d_times[i].sample) + int64_t(ahead));
+      // Past the end of a segment means in the gap after it
+      if (i + 1 < d_times.size() && uint64_t(sample) > d_times[i + 1].sample)
+        return std::min(d_times[i + 1].sample, d_size);
+      return std::min(uint64_t(sample), d_size);
+    }
+
+    uint64_t
+    capture_file::next_timestamp(uint64_t sample) const
+    {
+      if (d_times[0].sample > sample)
+        return std::min(d_times[0].sample, d_size);
+      const size_t i = entry_for(sample) + 1;
+      return i < d_times.size() ? std::min(d_times[i].sample, d_size) : d_size;
+    }
+
+    std::vector<capture_file::chunk>
+    capture_file::split(size_t n, uint64_t overlap) const
+    {
+      n = std::max<size_t>(n, 1);
+      std::vector<uint64_t> bounds(n + 1, 0);
+      for (size_t k = 1; k < n; k++) {
+        uint64_t b = d_size / n * k + d_size % n * k / n;
+        if (!d_frames.empty()) {
+          const std::vector<uint64_t>::const_iterator next =
+            std::lower_bound(d_frames.begin(), d_frames.end(), b);
+          b = next == d_frames.end() ? d_size : std::min(*next, d_size);
+        }
+        bounds[k] = std::max(b, bounds[k - 1]);
+      }
+      bounds[n] = d_size;
+
+      std::vector<chunk> chunks(n);
+      for (size_t k = 0; k < n; k++) {
+        chunks[k].owned = bounds[k];
+        chunks[k].begin = k && bounds[k] > overlap ? bounds[k] - overlap : 0;
+        chunks[k].end = bounds[k + 1];
+      }
+      return chunks;
+    }
+
+    void
+    write_capture_index(const std::string &path, double sample_rate,
+                        const std::vector<std::pair<uint64_t, capture_file::timestamp> > &times,
+                        const std::vector<uint64_t> &frame_starts)
+    {
+      std::ofstream out(path.c_str());
+      if (!out)
+        throw std::runtime_error("can't create " + path);
+
+      char line[64];
+      std::snprintf(line, sizeof(line), "rate %.17g\n", sample_rate);
+      out << line;
+      for (size_t i = 0; i < times.size(); i++) {
+        // Twelve digits of fraction, rounding up into the next second
+        // rather than printing 1.000000000000
+        int64_t secs = times[i].second.secs;
+        double frac = std::floor(times[i].second.frac * 1e12 + 0.5);
+        if (frac >= 1e12) {
+          secs++;
+          frac = 0.0;
+        }
+        std::snprintf(line, sizeof(line), "time %llu %lld.%012.0f\n",
+                      (unsigned long long) times[i].first, (long long) secs, frac);
+        out << line;
+      }
+      for (size_t i = 0; i < frame_starts.size(); i++)
+        out << "frame " << frame_starts[i] << "\n";
+
+      if (!out.flush())
+        throw std::runtime_error("can't write " + path);
+    }
+
+  } /* namespace zluudgbee */
+} /* namespace gr */
@@ -0,0 +1,146 @@
+/* -*- c++ -*- */
+/* 
+ * Copyright 2019 Leon Fernandez (zluudg).
+ * 
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ * 
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_ZLUUDGBEE_CAPTURE_FILE_H
+#define INCLUDED_ZLUUDGBEE_CAPTURE_FILE_H
+
+#include <cstddef>
+#include <string>
+#include <utility>
+#include <vector>
+#include <stdint.h>
+#include "mapped_file.h"
+
+namespace gr {
+  namespace zluudgbee {
+
+    /*
+     * A raw sc16 capture, interleaved 16-bit I and Q in host byte order
+     * as the USRP streamer writes them, mapped rather than read.
+     *
+     * The sidecar index is a text file with one entry per line, # starts
+     * a comment:
+     *
+     *   rate <samples per second>
+     *   time <sample> <seconds>      timestamp of a sample, e.g. from rx_time
+     *   frame <sample>               a frame starts here
+     *
+     * Samples between two time entries are taken to be contiguous at the
+     * rate, so a time entry only has to be written where the stream was
+     * interrupted, after an overflow for instance. Without any, sample
+     * zero is at time zero. Times are kept as whole seconds plus a
+     * fraction, which stays exact at GPS epoch times where a double
+     * wouldn't. Throws std::runtime_error on a file that can't be read
+     * and on an index that doesn't parse.
+     */
+    class capture_file
+    {
+     public:
+      static const size_t SAMPLE_SIZE = 2 * sizeof(int16_t);
+
+      struct timestamp
+      {
+        int64_t secs;
+        double frac;                  // [0, 1)
+      };
+
+      // [begin, end) to process, of which [begin, owned) is overlap with
+      // the chunk before
+      struct chunk
+      {
+        uint64_t begin;
+        uint64_t owned;
+        uint64_t end;
+      };
+
+      /*
+       * An empty index_path looks for path + ".idx" and goes without an
+       * index if there is none. sample_rate is used unless the index has
+       * a rate of its own.
+       */
+      capture_file(const std::string &path, const std::string &index_path,
+                   double sample_rate);
+
+      const int16_t *samples() const
+      {
+        return reinterpret_cast<const int16_t *>(d_file.data());
+      }
+      uint64_t size() const { return d_size; }
+      double sample_rate() const { return d_rate; }
+      bool has_index() const { return !d_index_path.empty(); }
+      const std::vector<uint64_t> &frame_starts() const { return d_frames; }
+
+      timestamp time_at(uint64_t sample) const;
+      // Seconds since sample zero, gaps included.
+      double offset_at(uint64_t sample) const;
+      // First sample at or after offset seconds since sample zero.
+      uint64_t sample_at(double offset) const;
+      // First sample after sample with a time entry of its own, size() if none.
+      uint64_t next_timestamp(uint64_t sample) const;
+
+      /*
+       * Cuts the capture into n chunks of about the same length for
+       * workers running side by side. Each one starts overlap samples
+       * early so the receiver has settled by the time it gets to the
+       * part it owns. Known frame starts move the boundaries onto the
+       * next frame, so no frame is cut in two.
+       */
+      std::vector<chunk> split(size_t n, uint64_t overlap) const;
+
+      bool advise(uint64_t begin, uint64_t end, mapped_file::access_t access) const
+      {
+        return d_file.advise(begin * SAMPLE_SIZE, (end - begin) * SAMPLE_SIZE, access);
+      }
+
+     private:
+      struct time_entry
+      {
+        uint64_t sample;
+        double offset;                // seconds since d_epoch
+      };
+
+      mapped_file d_file;
+      uint64_t d_size;
+      double d_rate;
+      std::string d_index_path;
+      int64_t d_epoch;                // whole seconds of the first time entry
+      std::vector<time_entry> d_times;
+      std::vector<uint64_t> d_frames;
+
+      void read_index(const std::string &path);
+      size_t entry_for(uint64_t sample) const;
+
+      capture_file(const capture_file &);
+      capture_file &operator=(const capture_file &);
+    };
+
+    /*
+     * Writes an index for a capture in the format capture_file reads.
+     * times pairs sample numbers with their timestamps. Throws
+     * std::runtime_error.
+     */
+    void write_capture_index(const std::string &path, double sample_rate,
+                             const std::vector<std::pair<uint64_t, capture_file::timestamp> > &times,
+                             const std::vector<uint64_t> &frame_starts);
+
+  } // namespace zluudgbee
+} // namespace gr
+
+#endif /* INCLUDED_ZLUUDGBEE_CAPTURE_FILE_H */
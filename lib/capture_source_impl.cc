@@ -0,0 +1,187 @@
+/* -*- c++ -*- */
+/* 
+ * Copyright 2019 Leon Fernandez (zluudg).
+ * 
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ * 
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <gnuradio/io_signature.h>
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include "capture_source_impl.h"
+
+namespace gr {
+  namespace zluudgbee {
+
+    capture_source::sptr
+    capture_source::make(const std::string &filename, const std::string &index_file,
+                         double sample_rate, int chunk, int num_chunks, double overlap,
+                         bool repeat)
+    {
+      return gnuradio::get_initial_sptr(
+        new capture_source_impl(filename, index_file, sample_rate, chunk, num_chunks,
+                                overlap, repeat)
+      );
+    }
+
+    /*
+     * The private constructor
+     */
+    capture_source_impl::capture_source_impl(const std::string &filename,
+                                             const std::string &index_file,
+                                             double sample_rate, int chunk,
+                                             int num_chunks, double overlap, bool repeat)
+      : gr::sync_block("capture_source",
+              gr::io_signature::make(0, 0, 0),
+              gr::io_signature::make(1, 1, capture_file::SAMPLE_SIZE)),
+        d_file(filename, index_file, sample_rate),
+        d_repeat(repeat),
+        d_time_key(pmt::mp("rx_time")),
+        d_rate_key(pmt::mp("rx_rate")),
+        d_owned_key(pmt::mp("chunk_owned"))
+    {
+      if (num_chunks < 1 || chunk < 0 || chunk >= num_chunks)
+        throw std::invalid_argument("capture_source: chunk must be between 0 and num_chunks - 1");
+      if (overlap < 0)
+        throw std::invalid_argument("capture_source: overlap can't be negative");
+
+      const capture_file::chunk c =
+        d_file.split(num_chunks, uint64_t(overlap * d_file.sample_rate() + 0.5))[chunk];
+      d_begin = c.begin;
+      d_owned = c.owned;
+      d_end = c.end;
+
+      // Huge pages only take on file mappings where the kernel supports
+      // them for read-only files, elsewhere this does nothing
+      d_file.advise(d_begin, d_end, mapped_file::ACCESS_SEQUENTIAL);
+      d_file.advise(d_begin, d_end, mapped_file::ACCESS_HUGEPAGE);
+      go_to(d_begin);
+    }
+
+    /*
+     * Our virtual destructor.
+     */
+    capture_source_impl::~capture_source_impl()
+    {
+    }
+
+    // Called with d_mutex held, or before the flowgraph runs
+    void
+    capture_source_impl::go_to(uint64_t sample)
+    {
+      d_pos = sample;
+      d_window = sample;
+      d_file.advise(sample, std::min(sample + 2 * WINDOW, d_end), mapped_file::ACCESS_WILLNEED);
+      d_tag_time = true;
+      d_next_time = d_file.next_timestamp(sample);
+    }
+
+    void
+    capture_source_impl::tag_time(uint64_t offset, uint64_t sample)
+    {
+      const capture_file::timestamp t = d_file.time_at(sample);
+      add_item_tag(0, offset, d_time_key,
+                   pmt::make_tuple(pmt::from_uint64(t.secs), pmt::from_double(t.frac)));
+      add_item_tag(0, offset, d_rate_key, pmt::from_double(d_file.sample_rate()));
+    }
+
+    void
+    capture_source_impl::seek(double offset)
+    {
+      const uint64_t sample = std::min(std::max(d_file.sample_at(offset), d_begin), d_end);
+      gr::thread::scoped_lock guard(d_mutex);
+      go_to(sample);
+    }
+
+    double
+    capture_source_impl::position() const
+    {
+      gr::thread::scoped_lock guard(d_mutex);
+      return d_file.offset_at(d_pos);
+    }
+
+    double
+    capture_source_impl::chunk_start() const
+    {
+      return d_file.offset_at(d_begin);
+    }
+
+    double
+    capture_source_impl::chunk_end() const
+    {
+      return d_file.offset_at(d_end);
+    }
+
+    double
+    capture_source_impl::chunk_owned_start() const
+    {
+      return d_file.offset_at(d_owned);
+    }
+
+    uint64_t
+    capture_source_impl::chunk_samples() const
+    {
+      return d_end - d_begin;
+    }
+
+    int
+    capture_source_impl::work(int noutput_items,
+        gr_vector_const_void_star &input_items,
+        gr_vector_void_star &output_items)
+    {
+      uint8_t *out = (uint8_t *) output_items[0];
+      gr::thread::scoped_lock guard(d_mutex);
+
+      if (d_pos == d_end) {
+        if (!d_repeat || d_begin == d_end)
+          return WORK_DONE;
+        go_to(d_begin);
+      }
+
+      const uint64_t n = std::min<uint64_t>(noutput_items, d_end - d_pos);
+      if (d_tag_time) {
+        tag_time(nitems_written(0), d_pos);
+        d_tag_time = false;
+      }
+      for (; d_next_time < d_pos + n; d_next_time = d_file.next_timestamp(d_next_time))
+        tag_time(nitems_written(0) + (d_next_time - d_pos), d_next_time);
+      if (d_owned >= d_pos && d_owned < d_pos + n)
+        add_item_tag(0, nitems_written(0) + (d_owned - d_pos), d_owned_key,
+                     pmt::from_uint64(d_owned));
+
+      std::memcpy(out, d_file.samples() + 2 * d_pos, n * capture_file::SAMPLE_SIZE);
+      d_pos += n;
+
+      // Once playback is a window further on, the window before is let go
+      // and the one after the current one is read ahead
+      while (d_pos - d_window >= WINDOW) {
+        d_file.advise(d_window, d_window + WINDOW, mapped_file::ACCESS_DONTNEED);
+        d_window += WINDOW;
+        if (d_window + WINDOW < d_end)
+          d_file.advise(d_window + WINDOW, std::min(d_window + 2 * WINDOW, d_end),
+                        mapped_file::ACCESS_WILLNEED);
+      }
+
+      return n;
+    }
+
+  } /* namespace zluudgbee */
+} /* namespace gr */
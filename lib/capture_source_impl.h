@@ -0,0 +1,76 @@
+/* -*- c++ -*- */
+/* 
+ * Copyright 2019 Leon Fernandez (zluudg).
+ * 
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ * 
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_ZLUUDGBEE_CAPTURE_SOURCE_IMPL_H
+#define INCLUDED_ZLUUDGBEE_CAPTURE_SOURCE_IMPL_H
+
+#include <zluudgbee/capture_source.h>
+#include <gnuradio/thread/thread.h>
+#include "capture_file.h"
+
+namespace gr {
+  namespace zluudgbee {
+
+    class capture_source_impl : public capture_source
+    {
+     private:
+      // Read ahead and released in windows of this many samples, 32 MiB
+      static const uint64_t WINDOW = uint64_t(8) << 20;
+
+      const capture_file d_file;
+      const bool d_repeat;
+      uint64_t d_begin;
+      uint64_t d_owned;               // first sample past the overlap
+      uint64_t d_end;
+      uint64_t d_pos;
+      uint64_t d_window;              // start of the window being played
+      bool d_tag_time;                // rx_time is due on the next sample
+      uint64_t d_next_time;           // next sample with a time entry
+      mutable gr::thread::mutex d_mutex;
+
+      const pmt::pmt_t d_time_key;
+      const pmt::pmt_t d_rate_key;
+      const pmt::pmt_t d_owned_key;
+
+      void go_to(uint64_t sample);
+      void tag_time(uint64_t offset, uint64_t sample);
+
+     public:
+      capture_source_impl(const std::string &filename, const std::string &index_file,
+                          double sample_rate, int chunk, int num_chunks, double overlap,
+                          bool repeat);
+      ~capture_source_impl();
+
+      void seek(double offset);
+      double position() const;
+      double chunk_start() const;
+      double chunk_end() const;
+      double chunk_owned_start() const;
+      uint64_t chunk_samples() const;
+
+      int work(int noutput_items,
+         gr_vector_const_void_star &input_items,
+         gr_vector_void_star &output_items);
+    };
+
+  } // namespace zluudgbee
+} // namespace gr
+
+#endif /* INCLUDED_ZLUUDGBEE_CAPTURE_SOURCE_IMPL_H */
@@ -26,9 +26,11 @@
 #include <gnuradio/gr_complex.h>
 #include <pmt/pmt.h>
 #include "chdr2pdu_impl.h"
+#include <stdexcept>
 
 namespace gr {
   namespace zluudgbee {
+
     chdr2pdu::sptr
     chdr2pdu::make(
         const gr::ettus::device3::sptr &dev,
@@ -38,9 +40,18 @@ namespace gr {
         const int block_select,
         const int device_select,
         const int mtu,
-        const bool enable_eob_on_stop
+        const bool enable_eob_on_stop,
+        const int ring_depth,
+        const bool drop_oldest,
+        const bool hw_crc,
+        const std::string &rx_cpus,
+        const int rx_priority
     )
     {
+      // Checked before the receiver sizes its ring and buffers from them
+      if (mtu <= 0 || ring_depth <= 0)
+        throw std::invalid_argument("chdr2pdu: mtu and ring_depth must be positive");
+
       return gnuradio::get_initial_sptr(
         new chdr2pdu_impl(
             dev,
@@ -50,7 +61,12 @@ namespace gr {
             block_select,
             device_select,
             mtu,
-            enable_eob_on_stop
+            enable_eob_on_stop,
+            ring_depth,
+            drop_oldest,
+            hw_crc,
+            rx_cpus,
+            rx_priority
         )
       );
     }
@@ -79,7 +95,12 @@ namespace gr {
          const int block_select,
          const int device_select,
          const int mtu,
-         const bool enable_eob_on_stop
+         const bool enable_eob_on_stop,
+         const int ring_depth,
+         const bool drop_oldest,
+         const bool hw_crc,
+         const std::string &rx_cpus,
+         const int rx_priority
     )
       : gr::ettus::rfnoc_block("chdr2pdu"),
         gr::ettus::rfnoc_block_impl(
@@ -87,12 +108,12 @@ namespace gr {
             gr::ettus::rfnoc_block_impl::make_block_id(block_name,  block_select, device_select),
             tx_stream_args, rx_stream_args, enable_eob_on_stop
             ),
-        d_started(false),
-        d_finished(false)
+        d_receiver(mtu, hw_crc, ring_depth, drop_oldest, rx_cpus, rx_priority,
+                   metrics::register_stage(str(boost::format("chdr2pdu%d") % unique_id())),
+                   d_logger)
     {
-      d_rxbuf.resize(mtu,0);
       message_port_register_out(pmt::mp("data"));
-      start_rxthread(this, pmt::mp("data"));
+      d_receiver.start(this, pmt::mp("data"));
       set_output_signature(io_signature::make(0, 0, 0));
     }
 
@@ -101,7 +122,7 @@ namespace gr {
      */
     chdr2pdu_impl::~chdr2pdu_impl()
     {
-      stop_rxthread();
+      d_receiver.shutdown();
     }
 
     bool chdr2pdu_impl::start()
@@ -113,6 +134,7 @@ namespace gr {
 
       // If the topology changed, we need to clear the old streamers
       if (_rx.streamers.size() != noutputs) {
+        d_receiver.detach();
         _rx.streamers.clear();
       }
       if (_tx.streamers.size() != ninputs) {
@@ -167,61 +189,85 @@ namespace gr {
         for (size_t i = 0; i < _rx.streamers.size(); i++) {
           _rx.streamers[i]->issue_stream_cmd(stream_cmd);
         }
+
+        // Wake the RX thread up
+        d_receiver.attach(_rx.streamers[0]);
       }
 
       return true;
     }
 
-    void
-    chdr2pdu_impl::run()
+    /*
+     * The RX thread is the only one calling recv(), so this doesn't flush
+     * the streamer the way rfnoc_block_impl::stop() does. It takes the
+     * streamer away from the RX thread and stops the stream. The EOB
+     * packet zluudgbeeRX sends once its input has ended gets a pending
+     * recv() back out, and the thread then waits for the next start().
+     */
+    bool chdr2pdu_impl::stop()
     {
-      while(!d_finished) {
-        if( _rx.streamers.size() != 1 )
-        {
-          std::cout << "Waiting for stream to become available." << std::endl ;
-          sleep(1);
-          continue;
-        }
-        const int result = _rx.streamers[0]->recv(
-            &d_rxbuf[0],
-            d_rxbuf.size(),
-            _rx.metadata, 0.1, true
-        );
-
-        if (result < 0)
-          throw std::runtime_error("chdr2pdu_impl, bad read!");
-
-        if( result > 0 )
-        {
-          std::vector<uint8_t> bytebuf; // extract one byte from every word in d_rxbuf into bytebuf
-          for (int i = 0; i < result; i++) {
-            bytebuf.push_back((uint8_t) d_rxbuf[i*4+2]); // offset of two needed for some reason
-          }
-          pmt::pmt_t vector = pmt::init_u8vector(result, &bytebuf[0]);
-          pmt::pmt_t pdu = pmt::cons(pmt::make_dict(), vector);
-          d_blk->message_port_pub(d_port, pdu);
-        }
+      boost::recursive_mutex::scoped_lock lock(d_mutex);
+      d_receiver.detach();
+
+      ::uhd::stream_cmd_t stream_cmd(::uhd::stream_cmd_t::STREAM_MODE_STOP_CONTINUOUS);
+      for (size_t i = 0; i < _rx.streamers.size(); i++) {
+        _rx.streamers[i]->issue_stream_cmd(stream_cmd);
       }
+      return true;
+    }
+
+    size_t
+    chdr2pdu_impl::ring_high_water() const
+    {
+      return d_receiver.ring_high_water();
     }
 
-    void
-    chdr2pdu_impl::stop_rxthread()
+    uint64_t
+    chdr2pdu_impl::ring_drops() const
     {
-      d_finished = true;
+      return d_receiver.ring_drops();
+    }
 
-      if (d_started) {
-        d_thread.interrupt();
-        d_thread.join();
-      }
+    uint64_t
+    chdr2pdu_impl::crc_failures() const
+    {
+      return d_receiver.crc_failures();
+    }
+
+    uint64_t
+    chdr2pdu_impl::rx_preemptions() const
+    {
+      return d_receiver.rx_preemptions();
+    }
+
+    uint64_t
+    chdr2pdu_impl::rx_migrations() const
+    {
+      return d_receiver.rx_migrations();
+    }
+
+    double
+    chdr2pdu_impl::rx_max_busy() const
+    {
+      return d_receiver.rx_max_busy();
+    }
+
+    double
+    chdr2pdu_impl::rx_max_sched_latency() const
+    {
+      return d_receiver.rx_max_sched_latency();
+    }
+
+    uint64_t
+    chdr2pdu_impl::rx_overflows() const
+    {
+      return d_receiver.rx_overflows();
     }
 
-    void
-    chdr2pdu_impl::start_rxthread(basic_block *blk, pmt::pmt_t port)
+    uint64_t
+    chdr2pdu_impl::rx_timeouts() const
     {
-      d_blk = blk;
-      d_port = port;
-      d_thread = gr::thread::thread(boost::bind(&chdr2pdu_impl::run, this));
-      d_started = true;
+      return d_receiver.rx_timeouts();
     }
 
   } /* namespace zluudgbee */
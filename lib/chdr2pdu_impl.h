@@ -23,6 +23,7 @@
 
 #include <zluudgbee/chdr2pdu.h>
 #include <ettus/rfnoc_block_impl.h>
+#include "chdr_receiver.h"
 
 namespace gr {
   namespace zluudgbee {
@@ -44,23 +45,29 @@ namespace gr {
         const int block_select,
         const int device_select,
         const int mtu,
-        const bool enable_eob_on_stop
+        const bool enable_eob_on_stop,
+        const int ring_depth,
+        const bool drop_oldest,
+        const bool hw_crc,
+        const std::string &rx_cpus,
+        const int rx_priority
       );
       bool start();
+      bool stop();
       ~chdr2pdu_impl();
 
-     private:
-      bool d_started;
-      bool d_finished;
-      std::vector<uint8_t> d_rxbuf;
-      gr::thread::thread d_thread;
-
-      pmt::pmt_t d_port;
-      basic_block *d_blk;
+      size_t ring_high_water() const;
+      uint64_t ring_drops() const;
+      uint64_t crc_failures() const;
+      uint64_t rx_preemptions() const;
+      uint64_t rx_migrations() const;
+      double rx_max_busy() const;
+      double rx_max_sched_latency() const;
+      uint64_t rx_overflows() const;
+      uint64_t rx_timeouts() const;
 
-      void run();
-      void start_rxthread(basic_block *blk, pmt::pmt_t rxport);
-      void stop_rxthread();
+     private:
+      chdr_receiver d_receiver;
     };
 
   } // namespace zluudgbee
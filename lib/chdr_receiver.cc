@@ -0,0 +1,350 @@
+/* -*- c++ -*- */
+/* 
+ * Copyright 2019 Leon Fernandez (zluudg).
+ * 
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ * 
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <pmt/pmt.h>
+#include <boost/bind.hpp>
+#include <stdexcept>
+#include "chdr_receiver.h"
+#include "thread_placement.h"
+
+namespace gr {
+  namespace zluudgbee {
+    const double chdr_receiver::RECV_TIMEOUT = 0.1;
+
+    chdr_receiver::chdr_receiver(size_t mtu, bool hw_crc, size_t ring_depth, bool drop_oldest,
+                                 const std::string &rx_cpus, int rx_priority,
+                                 const stage_metrics_sptr &metrics, gr::logger_ptr logger)
+      : d_started(false),
+        d_finished(false),
+        d_mtu(mtu),
+        d_hw_crc(hw_crc),
+        d_crc_failures(0),
+        d_rx_overflows(0),
+        d_rx_timeouts(0),
+        d_rx_cpus(parse_cpu_list(rx_cpus)),
+        d_rx_priority(rx_priority),
+        d_rx_preemptions(0),
+        d_rx_migrations(0),
+        d_rx_max_busy(0),
+        d_rx_max_sched_latency(0),
+        d_metrics(metrics),
+        d_logger(logger),
+        d_confidence_key(pmt::mp("confidence")),
+        d_crappy_key(pmt::mp("crappy_nibbles")),
+        d_crc_ok_key(pmt::mp("crc_ok")),
+        d_ring(ring_depth, drop_oldest ? spsc_ring<pmt::pmt_t>::DROP_OLDEST
+                                       : spsc_ring<pmt::pmt_t>::DROP_NEWEST),
+        d_pub_waiting(false),
+        d_blk(0)
+    {
+      if (rx_priority < 0 || rx_priority > 99)
+        throw std::invalid_argument("chdr2pdu: rx_priority must be between 0 and 99");
+
+      d_frames.reserve(MAX_BATCH);
+      d_burst_len.resize(MAX_BATCH, 0);
+    }
+
+    chdr_receiver::~chdr_receiver()
+    {
+      shutdown();
+    }
+
+    void
+    chdr_receiver::attach(const ::uhd::rx_streamer::sptr &stream)
+    {
+      gr::thread::scoped_lock lock(d_rx_mutex);
+      d_rx_stream = stream;
+      d_rx_cond.notify_one();
+    }
+
+    void
+    chdr_receiver::detach()
+    {
+      gr::thread::scoped_lock lock(d_rx_mutex);
+      d_rx_stream.reset();
+    }
+
+    ::uhd::rx_streamer::sptr
+    chdr_receiver::wait_for_stream()
+    {
+      gr::thread::scoped_lock lock(d_rx_mutex);
+      while (!d_rx_stream && !d_finished)
+        d_rx_cond.wait(lock);
+      return d_rx_stream;
+    }
+
+    void
+    chdr_receiver::place_rxthread()
+    {
+      const std::string problems = place_current_thread(d_rx_cpus, d_rx_priority);
+      if (!problems.empty())
+        GR_LOG_WARN(d_logger, "RX thread: " + problems);
+
+      // Everything the RX thread touches per burst is allocated up front:
+      // one recv() region and one PDU slot per burst in a batch. It's
+      // done here, after pinning, so that first touch puts the pages on
+      // the NUMA node the thread runs on.
+      d_rxbuf.resize(MAX_BATCH * d_mtu * CHDR_ITEM_SIZE, 0);
+      d_pdubuf.resize(MAX_BATCH * d_mtu, 0);
+      d_flagbuf.resize(MAX_BATCH * d_mtu, 0);
+    }
+
+    /*
+     * The streamer recovers from an overflow on its own, the samples in
+     * between are lost. A timeout only counts when recv() was meant to
+     * block, not when draining a batch runs out of bursts.
+     */
+    void
+    chdr_receiver::count_rx_error(bool blocking)
+    {
+      switch (d_rx_md.error_code) {
+      case ::uhd::rx_metadata_t::ERROR_CODE_OVERFLOW:
+        d_rx_overflows.fetch_add(1, std::memory_order_relaxed);
+        break;
+      case ::uhd::rx_metadata_t::ERROR_CODE_TIMEOUT:
+        if (blocking)
+          d_rx_timeouts.fetch_add(1, std::memory_order_relaxed);
+        break;
+      default:
+        break;
+      }
+    }
+
+    void
+    chdr_receiver::run()
+    {
+      place_rxthread();
+      const run_delay_clock run_delay;
+      int last_cpu = current_thread_sched_stats().cpu;
+
+      while (!d_finished) {
+        // The copy keeps the streamer alive through recv() even if attach()
+        // replaces it in the meantime.
+        ::uhd::rx_streamer::sptr stream = wait_for_stream();
+        if (!stream)
+          break;
+
+        // Block for the first burst, then drain whatever else is already
+        // waiting so that back-to-back bursts are handed off together.
+        size_t nbursts = 0;
+        const bool timed = metrics::enabled();
+        const gr::high_res_timer_type waiting = timed ? gr::high_res_timer_now() : 0;
+        const uint64_t delayed = run_delay.now();
+        size_t result = stream->recv(
+            &d_rxbuf[0],
+            d_mtu,
+            d_rx_md, RECV_TIMEOUT, true
+        );
+        if (!result) {
+          count_rx_error(true);
+          continue;
+        }
+
+        // Whatever the thread spent on the runqueue during the blocking
+        // recv() is, short of a preemption in the transport's own code,
+        // the wait for a CPU after the burst woke it up.
+        const gr::high_res_timer_type woke = gr::high_res_timer_now();
+        const thread_sched_stats handling = current_thread_sched_stats();
+        const uint64_t sched_latency = run_delay.now() - delayed;
+        if (sched_latency > d_rx_max_sched_latency.load(std::memory_order_relaxed))
+          d_rx_max_sched_latency.store(sched_latency, std::memory_order_relaxed);
+        if (timed) {
+          d_metrics->recv_wait.record(metrics::ticks_to_ns(woke - waiting));
+          d_metrics->sched_latency.record(sched_latency);
+        }
+
+        while (result > 0) {
+          d_burst_len[nbursts++] = result;
+          if (nbursts == MAX_BATCH)
+            break;
+          result = stream->recv(
+              &d_rxbuf[nbursts * d_mtu * CHDR_ITEM_SIZE],
+              d_mtu,
+              d_rx_md, 0.0, true
+          );
+        }
+        if (!result)
+          count_rx_error(false);
+
+        publish_batch(nbursts);
+
+        // Preemptions and migrations from the wake-up on, so time spent
+        // blocked in recv() doesn't count
+        const thread_sched_stats now = current_thread_sched_stats();
+        d_rx_preemptions.fetch_add(now.involuntary_switches - handling.involuntary_switches,
+                                   std::memory_order_relaxed);
+        if (now.cpu != last_cpu)
+          d_rx_migrations.fetch_add(1, std::memory_order_relaxed);
+        last_cpu = now.cpu;
+
+        const gr::high_res_timer_type busy = gr::high_res_timer_now() - woke;
+        if (busy > d_rx_max_busy.load(std::memory_order_relaxed))
+          d_rx_max_busy.store(busy, std::memory_order_relaxed);
+      }
+    }
+
+    void
+    chdr_receiver::publish_batch(size_t nbursts)
+    {
+      scoped_latency timer(d_metrics->handler_latency);
+      const uint64_t drops = d_ring.drops();
+      uint64_t bytes_in = 0, frames_out = 0, bytes_out = 0, crc_failures = 0;
+
+      d_frames.clear();
+      for (size_t b = 0; b < nbursts; b++) {
+        bytes_in += d_burst_len[b];
+        const uint8_t *words = &d_rxbuf[b * d_mtu * CHDR_ITEM_SIZE];
+        uint8_t *bytes = &d_pdubuf[b * d_mtu];
+        uint8_t *flags = &d_flagbuf[b * d_mtu];
+        chdr_extract_bytes(words, d_burst_len[b], bytes);
+        chdr_extract_flags(words, d_burst_len[b], flags);
+
+        // Frame offsets are made relative to the start of the PDU pool so
+        // that the frames of the whole batch can be published in one pass.
+        const size_t first = d_frames.size();
+        chdr_split_frames(flags, d_burst_len[b], d_frames);
+        for (size_t f = first; f < d_frames.size(); f++)
+          d_frames[f].offset += b * d_mtu;
+      }
+
+      // The PMT has to own its storage, so building it is the one copy
+      // (and allocation) per PDU that remains. Padding never gets that far.
+      // PDUs are handed to the publisher thread rather than published from
+      // here, so slow message handlers downstream can't hold up recv().
+      for (size_t f = 0; f < d_frames.size(); f++) {
+        const chdr_frame &frame = d_frames[f];
+        size_t len = frame.len;
+        // Flag mode (crc_mode 2) leaves the FCS on and the verdict in
+        // the flags. Frames without a verdict come from crc_mode 0,
+        // which already dropped the bad ones and cut the FCS off.
+        if (d_hw_crc && frame.crc_checked) {
+          if (len < FCS_LEN || frame.corrupted) {
+            d_crc_failures.fetch_add(1, std::memory_order_relaxed);
+            crc_failures++;
+            continue;
+          }
+          len -= FCS_LEN;
+        }
+
+        pmt::pmt_t meta = pmt::make_dict();
+        meta = pmt::dict_add(meta, d_confidence_key, pmt::from_double(frame.confidence()));
+        meta = pmt::dict_add(meta, d_crappy_key, pmt::from_long(frame.crappy_nibbles));
+        if (d_hw_crc)
+          meta = pmt::dict_add(meta, d_crc_ok_key, pmt::PMT_T);
+        pmt::pmt_t vector = pmt::init_u8vector(len, &d_pdubuf[frame.offset]);
+        pmt::pmt_t pdu = pmt::cons(meta, vector);
+        if (d_ring.push(pdu)) {
+          frames_out++;
+          bytes_out += len;
+        }
+      }
+
+      if (metrics::enabled()) {
+        d_metrics->add(d_metrics->frames_in, d_frames.size());
+        d_metrics->add(d_metrics->bytes_in, bytes_in);
+        d_metrics->add(d_metrics->frames_out, frames_out);
+        d_metrics->add(d_metrics->bytes_out, bytes_out);
+        d_metrics->add(d_metrics->crc_failures, crc_failures);
+        d_metrics->add(d_metrics->drops, d_ring.drops() - drops);
+      }
+
+      // Only take the lock if the publisher went to sleep on an empty ring.
+      // The fence pairs with the one in publish(), so either we see it
+      // waiting or it sees the new PDUs.
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      if (d_pub_waiting.load(std::memory_order_relaxed)) {
+        gr::thread::scoped_lock lock(d_pub_mutex);
+        d_pub_cond.notify_one();
+      }
+    }
+
+    void
+    chdr_receiver::publish()
+    {
+      pmt::pmt_t pdu;
+      while (!d_finished) {
+        if (d_ring.pop(pdu)) {
+          d_blk->message_port_pub(d_port, pdu);
+          continue;
+        }
+
+        gr::thread::scoped_lock lock(d_pub_mutex);
+        d_pub_waiting.store(true, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        while (d_ring.empty() && !d_finished)
+          d_pub_cond.wait(lock);
+        d_pub_waiting.store(false, std::memory_order_relaxed);
+      }
+    }
+
+    double
+    chdr_receiver::rx_max_busy() const
+    {
+      return double(d_rx_max_busy.load(std::memory_order_relaxed)) / gr::high_res_timer_tps();
+    }
+
+    double
+    chdr_receiver::rx_max_sched_latency() const
+    {
+      return d_rx_max_sched_latency.load(std::memory_order_relaxed) * 1e-9;
+    }
+
+    void
+    chdr_receiver::start(basic_block *blk, const pmt::pmt_t &port)
+    {
+      d_blk = blk;
+      d_port = port;
+      d_pub_thread = gr::thread::thread(boost::bind(&chdr_receiver::publish, this));
+      d_thread = gr::thread::thread(boost::bind(&chdr_receiver::run, this));
+      d_started = true;
+    }
+
+    void
+    chdr_receiver::shutdown()
+    {
+      {
+        gr::thread::scoped_lock lock(d_rx_mutex);
+        d_finished = true;
+        d_rx_cond.notify_one();
+      }
+
+      if (d_started) {
+        // recv() can't be interrupted. A pending one returns with the
+        // EOB packet that follows a stop of the stream, or after
+        // RECV_TIMEOUT if none comes, and run() checks d_finished
+        // before the next one.
+        d_thread.interrupt();
+        d_thread.join();
+
+        {
+          gr::thread::scoped_lock lock(d_pub_mutex);
+          d_pub_cond.notify_one();
+        }
+        d_pub_thread.join();
+        d_started = false;
+      }
+    }
+
+  } /* namespace zluudgbee */
+} /* namespace gr */
@@ -0,0 +1,146 @@
+/* -*- c++ -*- */
+/* 
+ * Copyright 2019 Leon Fernandez (zluudg).
+ * 
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ * 
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_ZLUUDGBEE_CHDR_RECEIVER_H
+#define INCLUDED_ZLUUDGBEE_CHDR_RECEIVER_H
+
+#include <gnuradio/basic_block.h>
+#include <gnuradio/high_res_timer.h>
+#include <gnuradio/logger.h>
+#include <gnuradio/thread/thread.h>
+#include <uhd/stream.hpp>
+#include <zluudgbee/metrics.h>
+#include <atomic>
+#include <string>
+#include <vector>
+#include "chdr_unpack.h"
+#include "spsc_ring.h"
+
+namespace gr {
+  namespace zluudgbee {
+
+    /*
+     * The receive side of chdr2pdu, which only needs an rx_streamer and
+     * a block to publish from, so it runs just as well on a
+     * mock_rx_streamer as on a USRP.
+     *
+     * The RX thread blocks in recv(), cuts the bursts into frames and
+     * hands the PDUs to a publisher thread through a bounded lock-free
+     * ring. Both threads are started by start() and run until shutdown()
+     * or destruction. In between, attach() gives the RX thread a streamer
+     * to receive from and detach() takes it away again. Overflows and
+     * timeouts reported by recv() are counted, and receiving goes on.
+     */
+    class chdr_receiver
+    {
+     public:
+      chdr_receiver(size_t mtu, bool hw_crc, size_t ring_depth, bool drop_oldest,
+                    const std::string &rx_cpus, int rx_priority,
+                    const stage_metrics_sptr &metrics, gr::logger_ptr logger);
+      ~chdr_receiver();
+
+      // PDUs go out on port of blk, which has to outlive the threads.
+      void start(basic_block *blk, const pmt::pmt_t &port);
+      void shutdown();
+
+      void attach(const ::uhd::rx_streamer::sptr &stream);
+      void detach();
+
+      size_t ring_high_water() const { return d_ring.high_water(); }
+      uint64_t ring_drops() const { return d_ring.drops(); }
+      uint64_t crc_failures() const { return d_crc_failures.load(std::memory_order_relaxed); }
+      uint64_t rx_preemptions() const { return d_rx_preemptions.load(std::memory_order_relaxed); }
+      uint64_t rx_migrations() const { return d_rx_migrations.load(std::memory_order_relaxed); }
+      double rx_max_busy() const;
+      double rx_max_sched_latency() const;
+      uint64_t rx_overflows() const { return d_rx_overflows.load(std::memory_order_relaxed); }
+      uint64_t rx_timeouts() const { return d_rx_timeouts.load(std::memory_order_relaxed); }
+
+     private:
+      // Maximum number of bursts collected from the streamer before they
+      // are published in one go.
+      static const size_t MAX_BATCH = 32;
+      static const size_t FCS_LEN = 2;
+      // A stopped zluudgbeeRX ends its stream with an EOB packet, which
+      // gets a pending recv() back out. This is only how long the RX thread
+      // takes to notice detach() or shutdown() when none comes, as with a
+      // stream that is never stopped or an FPGA image without it.
+      static const double RECV_TIMEOUT;
+
+      bool d_started;
+      std::atomic<bool> d_finished;
+      const size_t d_mtu;
+      const bool d_hw_crc;
+      std::atomic<uint64_t> d_crc_failures;
+      std::atomic<uint64_t> d_rx_overflows;
+      std::atomic<uint64_t> d_rx_timeouts;
+
+      // Placement of the RX thread and what the scheduler did to it
+      const std::vector<int> d_rx_cpus;
+      const int d_rx_priority;
+      std::atomic<uint64_t> d_rx_preemptions;
+      std::atomic<uint64_t> d_rx_migrations;
+      std::atomic<gr::high_res_timer_type> d_rx_max_busy;
+      std::atomic<uint64_t> d_rx_max_sched_latency;    // ns
+
+      // Allocated by the RX thread, see run()
+      std::vector<uint8_t> d_rxbuf;      // MAX_BATCH recv() regions of d_mtu items
+      std::vector<uint8_t> d_pdubuf;     // MAX_BATCH extracted PDUs of up to d_mtu bytes
+      std::vector<uint8_t> d_flagbuf;    // flag lane of every extracted PDU byte
+      std::vector<size_t> d_burst_len;   // items received per burst in the current batch
+      std::vector<chdr_frame> d_frames;  // frames found in the current batch
+
+      const stage_metrics_sptr d_metrics;
+      const gr::logger_ptr d_logger;
+
+      const pmt::pmt_t d_confidence_key;
+      const pmt::pmt_t d_crappy_key;
+      const pmt::pmt_t d_crc_ok_key;
+
+      // Hand-off between attach()/detach() and the RX thread. d_rx_stream
+      // is what run() receives from, null while detached.
+      gr::thread::mutex d_rx_mutex;
+      gr::thread::condition_variable d_rx_cond;
+      ::uhd::rx_streamer::sptr d_rx_stream;
+      ::uhd::rx_metadata_t d_rx_md;
+
+      // Hand-off between the RX thread and the publisher thread
+      spsc_ring<pmt::pmt_t> d_ring;
+      gr::thread::thread d_pub_thread;
+      gr::thread::mutex d_pub_mutex;
+      gr::thread::condition_variable d_pub_cond;
+      std::atomic<bool> d_pub_waiting;
+      gr::thread::thread d_thread;
+
+      pmt::pmt_t d_port;
+      basic_block *d_blk;
+
+      ::uhd::rx_streamer::sptr wait_for_stream();
+      void place_rxthread();
+      void count_rx_error(bool blocking);
+      void run();
+      void publish_batch(size_t nbursts);
+      void publish();
+    };
+
+  } // namespace zluudgbee
+} // namespace gr
+
+#endif /* INCLUDED_ZLUUDGBEE_CHDR_RECEIVER_H */
@@ -0,0 +1,194 @@
+/* -*- c++ -*- */
+/* 
+ * Copyright 2019 Leon Fernandez (zluudg).
+ * 
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ * 
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <gnuradio/io_signature.h>
+#include <zluudgbee/crc16.h>
+#include <boost/format.hpp>
+#include <stdexcept>
+#include "chdr_replay_impl.h"
+
+namespace gr {
+  namespace zluudgbee {
+
+    namespace {
+
+      const size_t SYNTHETIC_BURSTS = 64;
+
+      mock_rx_streamer::options
+      make_options(double items_per_sec, int loops, int overflow_every, int timeout_every)
+      {
+        mock_rx_streamer::options opts;
+        opts.items_per_sec = items_per_sec > 0 ? items_per_sec : 0.0;
+        opts.loops = loops > 0 ? loops : 0;
+        opts.overflow_every = overflow_every > 0 ? overflow_every : 0;
+        opts.timeout_every = timeout_every > 0 ? timeout_every : 0;
+        return opts;
+      }
+
+      // Bursts of frames with random PSDUs and a valid FCS, as zluudgbeeRX
+      // would deliver them
+      std::vector<std::vector<uint8_t> >
+      synthetic_bursts(size_t frame_len, size_t frames_per_burst, bool crc_checked)
+      {
+        std::vector<std::vector<uint8_t> > bursts(SYNTHETIC_BURSTS);
+        std::vector<uint8_t> psdu(frame_len);
+        uint32_t rng = 1;
+        for (size_t b = 0; b < bursts.size(); b++) {
+          for (size_t f = 0; f < frames_per_burst; f++) {
+            for (size_t i = 0; i + 2 < frame_len; i++) {
+              rng ^= rng << 13;
+              rng ^= rng >> 17;
+              rng ^= rng << 5;
+              psdu[i] = rng;
+            }
+            const uint16_t fcs = crc16::compute(&psdu[0], frame_len - 2);
+            psdu[frame_len - 2] = fcs & 0xFF;
+            psdu[frame_len - 1] = fcs >> 8;
+            chdr_pack_frame(&psdu[0], frame_len, crc_checked, bursts[b]);
+          }
+        }
+        return bursts;
+      }
+
+    } // namespace
+
+    chdr_replay::sptr
+    chdr_replay::make(const std::string &filename, int frame_len, int frames_per_burst,
+                      double items_per_sec, int loops, int overflow_every,
+                      int timeout_every, int mtu, int ring_depth, bool drop_oldest,
+                      bool hw_crc)
+    {
+      // Checked before the receiver sizes its ring and buffers from them
+      if (mtu <= 0 || ring_depth <= 0)
+        throw std::invalid_argument("chdr_replay: mtu and ring_depth must be positive");
+
+      return gnuradio::get_initial_sptr(
+        new chdr_replay_impl(filename, frame_len, frames_per_burst, items_per_sec, loops,
+                             overflow_every, timeout_every, mtu, ring_depth, drop_oldest,
+                             hw_crc)
+      );
+    }
+
+    /*
+     * The private constructor
+     */
+    chdr_replay_impl::chdr_replay_impl(const std::string &filename, int frame_len,
+                                       int frames_per_burst, double items_per_sec,
+                                       int loops, int overflow_every, int timeout_every,
+                                       int mtu, int ring_depth, bool drop_oldest,
+                                       bool hw_crc)
+      : gr::block("chdr_replay",
+              gr::io_signature::make(0, 0, 0),
+              gr::io_signature::make(0, 0, 0)),
+        d_receiver(mtu, hw_crc, ring_depth, drop_oldest, "", 0,
+                   metrics::register_stage(str(boost::format("chdr_replay%d") % unique_id())),
+                   d_logger)
+    {
+      const mock_rx_streamer::options opts =
+        make_options(items_per_sec, loops, overflow_every, timeout_every);
+      if (filename.empty()) {
+        if (frame_len < 3 || frame_len > mtu || frames_per_burst <= 0)
+          throw std::invalid_argument("chdr_replay: frame_len must be between 3 and mtu "
+                                      "and frames_per_burst positive");
+        d_stream.reset(new mock_rx_streamer(
+          synthetic_bursts(frame_len, frames_per_burst, hw_crc), opts));
+      }
+      else
+        d_stream.reset(new mock_rx_streamer(filename, opts));
+
+      message_port_register_out(pmt::mp("data"));
+      d_receiver.start(this, pmt::mp("data"));
+    }
+
+    /*
+     * Our virtual destructor.
+     */
+    chdr_replay_impl::~chdr_replay_impl()
+    {
+      d_receiver.shutdown();
+    }
+
+    bool
+    chdr_replay_impl::start()
+    {
+      ::uhd::stream_cmd_t stream_cmd(::uhd::stream_cmd_t::STREAM_MODE_START_CONTINUOUS);
+      stream_cmd.stream_now = true;
+      d_stream->issue_stream_cmd(stream_cmd);
+      d_receiver.attach(d_stream);
+      return block::start();
+    }
+
+    bool
+    chdr_replay_impl::stop()
+    {
+      d_receiver.detach();
+      d_stream->issue_stream_cmd(
+        ::uhd::stream_cmd_t(::uhd::stream_cmd_t::STREAM_MODE_STOP_CONTINUOUS));
+      return block::stop();
+    }
+
+    uint64_t
+    chdr_replay_impl::bursts_sent() const
+    {
+      return d_stream->bursts_sent();
+    }
+
+    bool
+    chdr_replay_impl::finished() const
+    {
+      return d_stream->finished();
+    }
+
+    size_t
+    chdr_replay_impl::ring_high_water() const
+    {
+      return d_receiver.ring_high_water();
+    }
+
+    uint64_t
+    chdr_replay_impl::ring_drops() const
+    {
+      return d_receiver.ring_drops();
+    }
+
+    uint64_t
+    chdr_replay_impl::crc_failures() const
+    {
+      return d_receiver.crc_failures();
+    }
+
+    uint64_t
+    chdr_replay_impl::rx_overflows() const
+    {
+      return d_receiver.rx_overflows();
+    }
+
+    uint64_t
+    chdr_replay_impl::rx_timeouts() const
+    {
+      return d_receiver.rx_timeouts();
+    }
+
+  } /* namespace zluudgbee */
+} /* namespace gr */
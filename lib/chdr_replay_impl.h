@@ -0,0 +1,59 @@
+/* -*- c++ -*- */
+/* 
+ * Copyright 2019 Leon Fernandez (zluudg).
+ * 
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ * 
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_ZLUUDGBEE_CHDR_REPLAY_IMPL_H
+#define INCLUDED_ZLUUDGBEE_CHDR_REPLAY_IMPL_H
+
+#include <zluudgbee/chdr_replay.h>
+#include "chdr_receiver.h"
+#include "mock_rx_streamer.h"
+
+namespace gr {
+  namespace zluudgbee {
+
+    class chdr_replay_impl : public chdr_replay
+    {
+     private:
+      mock_rx_streamer::sptr d_stream;
+      chdr_receiver d_receiver;
+
+     public:
+      chdr_replay_impl(const std::string &filename, int frame_len, int frames_per_burst,
+                       double items_per_sec, int loops, int overflow_every,
+                       int timeout_every, int mtu, int ring_depth, bool drop_oldest,
+                       bool hw_crc);
+      ~chdr_replay_impl();
+
+      uint64_t bursts_sent() const;
+      bool finished() const;
+      size_t ring_high_water() const;
+      uint64_t ring_drops() const;
+      uint64_t crc_failures() const;
+      uint64_t rx_overflows() const;
+      uint64_t rx_timeouts() const;
+
+      bool start();
+      bool stop();
+    };
+
+  } // namespace zluudgbee
+} // namespace gr
+
+#endif /* INCLUDED_ZLUUDGBEE_CHDR_REPLAY_IMPL_H */
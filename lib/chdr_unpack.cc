@@ -0,0 +1,197 @@
+/* -*- c++ -*- */
+/* 
+ * Copyright 2019 Leon Fernandez (zluudg).
+ * 
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ * 
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "chdr_unpack.h"
+#include "cpu_features.h"
+
+#ifdef ZLUUDGBEE_X86
+#include <immintrin.h>
+#endif
+#ifdef ZLUUDGBEE_NEON
+#include <arm_neon.h>
+#endif
+
+namespace gr {
+  namespace zluudgbee {
+
+    void
+    chdr_extract_lane_generic(const uint8_t *in, size_t nwords, size_t lane, uint8_t *out)
+    {
+      for (size_t i = 0; i < nwords; i++)
+        out[i] = in[i*CHDR_ITEM_SIZE + lane];
+    }
+
+#ifdef ZLUUDGBEE_X86
+    ZLUUDGBEE_TARGET("sse2")
+    static size_t
+    extract_sse2(const uint8_t *in, size_t nwords, size_t lane, uint8_t *out)
+    {
+      // 16 words in, 16 bytes out. Moving the lane down to bits 7:0 of each
+      // 32-bit element lets the saturating packs do the narrowing for us.
+      const __m128i mask = _mm_set1_epi32(0xFF);
+      const __m128i count = _mm_cvtsi32_si128(int(8*lane));
+      size_t i = 0;
+      for (; i + 16 <= nwords; i += 16) {
+        const __m128i *p = (const __m128i *) (in + i*CHDR_ITEM_SIZE);
+        __m128i a = _mm_and_si128(_mm_srl_epi32(_mm_loadu_si128(p + 0), count), mask);
+        __m128i b = _mm_and_si128(_mm_srl_epi32(_mm_loadu_si128(p + 1), count), mask);
+        __m128i c = _mm_and_si128(_mm_srl_epi32(_mm_loadu_si128(p + 2), count), mask);
+        __m128i d = _mm_and_si128(_mm_srl_epi32(_mm_loadu_si128(p + 3), count), mask);
+        __m128i ab = _mm_packs_epi32(a, b);
+        __m128i cd = _mm_packs_epi32(c, d);
+        _mm_storeu_si128((__m128i *) (out + i), _mm_packus_epi16(ab, cd));
+      }
+      return i;
+    }
+
+    ZLUUDGBEE_TARGET("avx2")
+    static size_t
+    extract_avx2(const uint8_t *in, size_t nwords, size_t lane, uint8_t *out)
+    {
+      // Same trick as the SSE2 version, but the packs work per 128-bit lane
+      // so the result has to be put back in order with a cross-lane permute.
+      const __m256i mask = _mm256_set1_epi32(0xFF);
+      const __m128i count = _mm_cvtsi32_si128(int(8*lane));
+      const __m256i order = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+      size_t i = 0;
+      for (; i + 32 <= nwords; i += 32) {
+        const __m256i *p = (const __m256i *) (in + i*CHDR_ITEM_SIZE);
+        __m256i a = _mm256_and_si256(_mm256_srl_epi32(_mm256_loadu_si256(p + 0), count), mask);
+        __m256i b = _mm256_and_si256(_mm256_srl_epi32(_mm256_loadu_si256(p + 1), count), mask);
+        __m256i c = _mm256_and_si256(_mm256_srl_epi32(_mm256_loadu_si256(p + 2), count), mask);
+        __m256i d = _mm256_and_si256(_mm256_srl_epi32(_mm256_loadu_si256(p + 3), count), mask);
+        __m256i ab = _mm256_packs_epi32(a, b);
+        __m256i cd = _mm256_packs_epi32(c, d);
+        __m256i abcd = _mm256_packus_epi16(ab, cd);
+        _mm256_storeu_si256((__m256i *) (out + i), _mm256_permutevar8x32_epi32(abcd, order));
+      }
+      return i;
+    }
+#endif
+
+#ifdef ZLUUDGBEE_NEON
+    static size_t
+    extract_neon(const uint8_t *in, size_t nwords, size_t lane, uint8_t *out)
+    {
+      // vld4 de-interleaves the four byte lanes for us.
+      size_t i = 0;
+      for (; i + 16 <= nwords; i += 16) {
+        uint8x16x4_t v = vld4q_u8(in + i*CHDR_ITEM_SIZE);
+        vst1q_u8(out + i, v.val[lane]);
+      }
+      return i;
+    }
+#endif
+
+    typedef size_t (*extract_fn)(const uint8_t *, size_t, size_t, uint8_t *);
+
+    static size_t
+    extract_none(const uint8_t *, size_t, size_t, uint8_t *)
+    {
+      return 0;
+    }
+
+    static extract_fn
+    pick_extract()
+    {
+#ifdef ZLUUDGBEE_X86
+      if (cpu_has_avx2())
+        return extract_avx2;
+      if (cpu_has_sse2())
+        return extract_sse2;
+#endif
+#ifdef ZLUUDGBEE_NEON
+      return extract_neon;
+#endif
+      return extract_none;
+    }
+
+    static void
+    extract_lane(const uint8_t *in, size_t nwords, size_t lane, uint8_t *out)
+    {
+      static const extract_fn simd = pick_extract();
+      size_t done = simd(in, nwords, lane, out);
+      chdr_extract_lane_generic(in + done*CHDR_ITEM_SIZE, nwords - done, lane, out + done);
+    }
+
+    void
+    chdr_extract_bytes(const uint8_t *in, size_t nwords, uint8_t *out)
+    {
+      extract_lane(in, nwords, CHDR_BYTE_LANE, out);
+    }
+
+    void
+    chdr_extract_flags(const uint8_t *in, size_t nwords, uint8_t *out)
+    {
+      extract_lane(in, nwords, CHDR_FLAG_LANE, out);
+    }
+
+    void
+    chdr_split_frames(const uint8_t *flags, size_t nwords,
+                      std::vector<chdr_frame> &frames)
+    {
+      chdr_frame frame = {0, 0, 0, false, false};
+      bool any_flags = false;
+
+      for (size_t i = 0; i < nwords; i++) {
+        const uint8_t f = flags[i];
+        any_flags |= (f != 0);
+
+        if (!(f & CHDR_FLAG_ACTIVE)) {
+          // Padding, closes whatever frame was open.
+          if (frame.len)
+            frames.push_back(frame);
+          frame.len = 0;
+          continue;
+        }
+
+        if (!frame.len) {
+          frame.offset = i;
+          frame.crappy_nibbles = 0;
+          frame.corrupted = false;
+          frame.crc_checked = false;
+        }
+        frame.len++;
+        frame.crappy_nibbles += !!(f & CHDR_FLAG_CRAP1) + !!(f & CHDR_FLAG_CRAP2);
+        frame.corrupted |= !!(f & CHDR_FLAG_CORRUPTED);
+        frame.crc_checked |= !!(f & CHDR_FLAG_CRC_CHECKED);
+
+        if (f & CHDR_FLAG_ENDFRAME) {
+          frames.push_back(frame);
+          frame.len = 0;
+        }
+      }
+
+      if (frame.len)
+        frames.push_back(frame);
+
+      if (!any_flags && nwords) {
+        chdr_frame legacy = {0, nwords, 0, false, false};
+        frames.push_back(legacy);
+      }
+    }
+
+  } // namespace zluudgbee
+} // namespace gr
+
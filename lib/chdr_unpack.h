@@ -0,0 +1,108 @@
+/* -*- c++ -*- */
+/* 
+ * Copyright 2019 Leon Fernandez (zluudg).
+ * 
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ * 
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_ZLUUDGBEE_CHDR_UNPACK_H
+#define INCLUDED_ZLUUDGBEE_CHDR_UNPACK_H
+
+#include <cstddef>
+#include <vector>
+#include <stdint.h>
+
+namespace gr {
+  namespace zluudgbee {
+
+    /*
+     * Every 32-bit word coming out of the receiver carries one PDU byte in
+     * bits 7:0. With the sc16 host format the word ends up in host memory as
+     * [I_lo, I_hi, Q_lo, Q_hi], which is why the payload byte sits at byte
+     * offset two of every item.
+     */
+    static const size_t CHDR_ITEM_SIZE = 4;
+    static const size_t CHDR_BYTE_LANE = 2;
+
+    /*
+     * Bits 15:8 of the word (see zluudg_constants.vhd) hold the status flags
+     * set by zluudg_packager and zluudg_crc16ccitt. They end up in the byte
+     * right after the payload byte.
+     */
+    static const size_t CHDR_FLAG_LANE = 3;
+    static const uint8_t CHDR_FLAG_ACTIVE    = 0x01;
+    static const uint8_t CHDR_FLAG_CRAP1     = 0x02;
+    static const uint8_t CHDR_FLAG_CRAP2     = 0x04;
+    static const uint8_t CHDR_FLAG_ENDFRAME  = 0x08;
+    static const uint8_t CHDR_FLAG_CORRUPTED = 0x10;
+    static const uint8_t CHDR_FLAG_CRC_CHECKED = 0x20;
+    // The word zluudgbeeRX sends in a packet of its own once its input
+    // stream has ended, so that recv() returns with end_of_burst. It is
+    // not ACTIVE and gets dropped as padding.
+    static const uint8_t CHDR_FLAG_EOB = 0x40;
+
+    /*
+     * Gathers the payload byte lane of nwords received items into out,
+     * which must hold nwords bytes. Neither needs to be aligned. On x86
+     * the lane is shifted down to bits 7:0 of every word and narrowed
+     * with saturating packs, 16 words at a time with SSE2 and 32 with
+     * AVX2; on ARM vld4 de-interleaves the lanes of 16 words.
+     */
+    void chdr_extract_bytes(const uint8_t *in, size_t nwords, uint8_t *out);
+
+    // Same as above for the flag lane.
+    void chdr_extract_flags(const uint8_t *in, size_t nwords, uint8_t *out);
+
+    /*
+     * One byte per item, any lane. Also picks up the last nwords % 16
+     * (or % 32) words the vector loops leave over.
+     */
+    void chdr_extract_lane_generic(const uint8_t *in, size_t nwords, size_t lane, uint8_t *out);
+
+    /*
+     * One frame found inside a burst. offset and len are in words, which
+     * is the same as bytes once the payload lane has been extracted.
+     */
+    struct chdr_frame
+    {
+      size_t offset;
+      size_t len;
+      size_t crappy_nibbles;
+      bool corrupted;
+      bool crc_checked;      // by zluudgbeeCRC, corrupted is its verdict then
+
+      // Share of the frame's nibbles that were decoded with confidence.
+      double confidence() const
+      {
+        return len ? 1.0 - double(crappy_nibbles) / double(2*len) : 0.0;
+      }
+    };
+
+    /*
+     * Cuts a burst into frames using its flag lane. A frame is a run of
+     * ACTIVE words that ends after an ENDFRAME word, at the first padding
+     * word or at the end of the burst. Bursts without a single flag bit set
+     * come from bitstreams that predate the flags and are returned as one
+     * frame. Frames are appended to frames, which is not cleared.
+     */
+    void chdr_split_frames(const uint8_t *flags, size_t nwords,
+                           std::vector<chdr_frame> &frames);
+
+  } // namespace zluudgbee
+} // namespace gr
+
+#endif /* INCLUDED_ZLUUDGBEE_CHDR_UNPACK_H */
+
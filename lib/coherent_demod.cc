@@ -0,0 +1,295 @@
+/* -*- c++ -*- */
+/* 
+ * Copyright 2019 Leon Fernandez (zluudg).
+ * 
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ * 
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "coherent_demod.h"
+#include "correlate_kernel.h"
+#include <algorithm>
+#include <cmath>
+
+namespace gr {
+  namespace zluudgbee {
+
+    static const size_t RESUM = 4096;            // slides before the sums are redone
+    static const unsigned MAX_PREAMBLE = 12;     // zero nibbles before giving up on the SFD
+    static const double PHASE_GAIN = 0.5;
+    static const double FREQ_GAIN = 0.05;
+
+    static double
+    wrap(double phase)
+    {
+      return phase - 2 * M_PI * std::floor((phase + M_PI) / (2 * M_PI));
+    }
+
+    coherent_demod::coherent_demod(unsigned samples_per_chip, float detect_threshold,
+                                   float crappy_threshold)
+      : d_tables(oqpsk_nibble_tables(samples_per_chip ? samples_per_chip : 1)),
+        d_nibble_len(OQPSK_CHIPS_PER_NIBBLE * d_tables.spc),
+        d_window(2 * d_nibble_len),
+        d_detect_threshold(detect_threshold),
+        d_crappy_threshold(crappy_threshold),
+        d_pos(0),
+        d_state(S_SEARCH),
+        d_sums_valid(false),
+        d_sums_age(0),
+        d_e0(0),
+        d_e1(0),
+        d_phase(0),
+        d_freq(0),
+        d_rot(d_tables.len),
+        d_scratch(d_tables.len),
+        d_count(0),
+        d_phr(0),
+        d_preambles(0),
+        d_lost_syncs(0)
+    {
+      set_freq(0);
+    }
+
+    size_t
+    coherent_demod::needed() const
+    {
+      switch (d_state) {
+      case S_SEARCH:
+        return d_window + d_nibble_len + 1;
+      case S_ALIGN:
+        return d_nibble_len + d_tables.len;
+      default:
+        return d_tables.len + 1;                 // one more for the late check
+      }
+    }
+
+    void
+    coherent_demod::set_freq(double freq)
+    {
+      d_freq = freq;
+      const gr_complexd step = std::polar(1.0, -freq);
+      gr_complexd r(1, 0);
+      for (size_t i = 0; i < d_rot.size(); i++, r *= step)
+        d_rot[i] = gr_complex(r);
+    }
+
+    /*
+     * P is the sum of x[k] * conj(x[k+L]) over the W samples from d_pos,
+     * e0 and e1 the energy of the two stretches. Inside the preamble the
+     * samples repeat every nibble, so |P|^2 gets close to e0 * e1, and
+     * P turns by the carrier offset over one nibble.
+     */
+    void
+    coherent_demod::search()
+    {
+      const size_t L = d_nibble_len;
+      const size_t W = d_window;
+      const gr_complex *x = &d_buf[d_pos];
+
+      if (!d_sums_valid || d_sums_age >= RESUM) {
+        d_p = 0;
+        d_e0 = d_e1 = 0;
+        for (size_t k = 0; k < W; k++) {
+          d_p += gr_complexd(x[k]) * std::conj(gr_complexd(x[k + L]));
+          d_e0 += std::norm(x[k]);
+          d_e1 += std::norm(x[k + L]);
+        }
+        d_sums_valid = true;
+        d_sums_age = 0;
+      }
+
+      const double den = d_e0 * d_e1;
+      if (den > 0 && std::norm(d_p) >= d_detect_threshold * den) {
+        d_preambles++;
+        set_freq(-std::arg(d_p) / L);
+        // A preamble that just got detected goes on past W at least
+        d_pos += W;
+        d_state = S_ALIGN;
+        d_sums_valid = false;
+        return;
+      }
+
+      d_p += gr_complexd(x[W]) * std::conj(gr_complexd(x[W + L]))
+           - gr_complexd(x[0]) * std::conj(gr_complexd(x[L]));
+      d_e0 += std::norm(x[W]) - std::norm(x[0]);
+      d_e1 += std::norm(x[W + L]) - std::norm(x[L]);
+      d_pos++;
+      d_sums_age++;
+    }
+
+    // Finds the nibble boundary within the next nibble's worth of samples
+    void
+    coherent_demod::align()
+    {
+      float best = -1;
+      size_t best_pos = d_pos;
+      gr_complex best_corr;
+      for (size_t t = d_pos; t < d_pos + d_nibble_len; t++) {
+        gr_complex c;
+        for (size_t i = 0; i < d_tables.len; i++)
+          d_scratch[i] = d_buf[t + i] * d_rot[i];
+        correlate_refs(&d_scratch[0], d_tables.fc32, d_tables.len, d_tables.len, 1, &c);
+        if (std::norm(c) > best) {
+          best = std::norm(c);
+          best_pos = t;
+          best_corr = c;
+        }
+      }
+      d_pos = best_pos;
+      d_phase = std::arg(best_corr);
+      d_state = S_PREAMBLE;
+      d_count = 0;
+    }
+
+    unsigned
+    coherent_demod::demod_nibble(float &confidence)
+    {
+      const size_t len = d_tables.len;
+      for (size_t i = 0; i < len; i++)
+        d_scratch[i] = d_buf[d_pos + i] * d_rot[i];
+      correlate_refs(&d_scratch[0], d_tables.fc32, len, len, 16, d_corr);
+
+      const gr_complex back = std::polar(1.0f, float(-d_phase));
+      unsigned best = 0;
+      float best_re = -HUGE_VALF, second_re = -HUGE_VALF;
+      for (unsigned n = 0; n < 16; n++) {
+        const float re = (d_corr[n] * back).real();
+        if (re > best_re) {
+          second_re = best_re;
+          best_re = re;
+          best = n;
+        }
+        else if (re > second_re)
+          second_re = re;
+      }
+      const float mag = std::abs(d_corr[best]);
+      confidence = mag > 0 ? std::max(0.0f, std::min(1.0f, (best_re - second_re) / mag)) : 0.0f;
+
+      // Early/late against the winner, a sample is all the timing can move
+      int shift = 0;
+      if (d_tables.spc > 1) {
+        const gr_complex *ref = d_tables.fc32 + best * len;
+        gr_complex early, late;
+        for (size_t i = 0; i < len; i++)
+          d_scratch[i] = d_buf[d_pos - 1 + i] * d_rot[i];
+        correlate_refs(&d_scratch[0], ref, len, len, 1, &early);
+        for (size_t i = 0; i < len; i++)
+          d_scratch[i] = d_buf[d_pos + 1 + i] * d_rot[i];
+        correlate_refs(&d_scratch[0], ref, len, len, 1, &late);
+        if (std::abs(late) > mag && std::abs(late) >= std::abs(early))
+          shift = 1;
+        else if (std::abs(early) > mag)
+          shift = -1;
+      }
+
+      const double err = std::arg(d_corr[best] * back);
+      set_freq(d_freq + FREQ_GAIN * err / d_nibble_len);
+      d_phase = wrap(d_phase + PHASE_GAIN * err + d_freq * (int(d_nibble_len) + shift));
+      d_pos += d_nibble_len + shift;
+      return best;
+    }
+
+    void
+    coherent_demod::lose_sync()
+    {
+      d_lost_syncs++;
+      d_state = S_SEARCH;
+      d_sums_valid = false;
+    }
+
+    void
+    coherent_demod::next_nibble(unsigned nibble, float confidence, std::vector<frame> &frames)
+    {
+      switch (d_state) {
+      case S_PREAMBLE:
+        if (nibble == (SFD & 0x0F))
+          d_state = S_SFD;
+        else if (nibble || ++d_count > MAX_PREAMBLE)
+          lose_sync();
+        break;
+
+      case S_SFD:
+        if (nibble == (SFD >> 4)) {
+          d_state = S_PHR;
+          d_count = 0;
+          d_phr = 0;
+        }
+        else
+          lose_sync();
+        break;
+
+      case S_PHR:
+        d_phr |= nibble << (4 * d_count);
+        if (++d_count < 2)
+          break;
+        // Bit 7 is reserved
+        if (!(d_phr & 0x7F)) {
+          lose_sync();
+          break;
+        }
+        d_frame.psdu.assign(d_phr & 0x7F, 0);
+        d_frame.confidence.clear();
+        d_frame.crappy_nibbles = 0;
+        d_count = 0;
+        d_state = S_PSDU;
+        break;
+
+      case S_PSDU:
+        d_frame.psdu[d_count / 2] |= nibble << (4 * (d_count & 1));
+        d_frame.confidence.push_back(confidence);
+        if (confidence < d_crappy_threshold)
+          d_frame.crappy_nibbles++;
+        if (++d_count == 2 * d_frame.psdu.size()) {
+          frames.push_back(d_frame);
+          d_state = S_SEARCH;
+          d_sums_valid = false;
+        }
+        break;
+
+      default:
+        break;
+      }
+    }
+
+    void
+    coherent_demod::work(const gr_complex *in, size_t n, std::vector<frame> &frames)
+    {
+      // Everything before d_pos is done with, except the sample the
+      // early check looks at
+      if (d_pos > 1) {
+        d_buf.erase(d_buf.begin(), d_buf.begin() + (d_pos - 1));
+        d_pos = 1;
+      }
+      d_buf.insert(d_buf.end(), in, in + n);
+
+      while (d_buf.size() - d_pos >= needed()) {
+        if (d_state == S_SEARCH)
+          search();
+        else if (d_state == S_ALIGN)
+          align();
+        else {
+          float confidence;
+          const unsigned nibble = demod_nibble(confidence);
+          next_nibble(nibble, confidence, frames);
+        }
+      }
+    }
+
+  } // namespace zluudgbee
+} // namespace gr
@@ -0,0 +1,124 @@
+/* -*- c++ -*- */
+/* 
+ * Copyright 2019 Leon Fernandez (zluudg).
+ * 
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ * 
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_ZLUUDGBEE_COHERENT_DEMOD_H
+#define INCLUDED_ZLUUDGBEE_COHERENT_DEMOD_H
+
+#include "oqpsk_tables.h"
+#include <cstddef>
+#include <vector>
+#include <stdint.h>
+
+namespace gr {
+  namespace zluudgbee {
+
+    /*
+     * Soft-decision receiver for the bursts oqpsk_waveform sends. Where
+     * zluudg_demapper takes the sign of every phase difference and counts
+     * chip errors, this correlates each nibble's worth of IQ samples
+     * against the 16 oqpsk_tables waveforms and takes the largest real
+     * part at the tracked carrier phase, which is the maximum likelihood
+     * pick in white noise.
+     *
+     * The preamble is found by correlating the input with itself one
+     * nibble later, which needs neither timing nor phase. That also
+     * gives the frequency offset, up to a quarter turn per nibble, and
+     * the nibble boundaries come from the best match against the zero
+     * nibble. From there on a second order loop follows the phase and an
+     * early/late check moves the timing by a sample when it drifts.
+     */
+    class coherent_demod
+    {
+     public:
+      struct frame
+      {
+        std::vector<uint8_t> psdu;
+        std::vector<float> confidence;   // per nibble, low nibble first
+        size_t crappy_nibbles;           // nibbles below crappy_threshold
+      };
+
+      coherent_demod(unsigned samples_per_chip, float detect_threshold, float crappy_threshold);
+
+      /*
+       * Preamble detection threshold, the squared normalized correlation
+       * of the input with itself a nibble later. Noise alone stays around
+       * 1/(64 * samples_per_chip), a clean preamble gets close to one.
+       */
+      void set_detect_threshold(float threshold) { d_detect_threshold = threshold; }
+
+      /*
+       * A nibble's confidence is how far ahead of the runner-up the
+       * decision was, relative to the size of the best correlation:
+       * one for a clean nibble, zero for a coin toss.
+       */
+      void set_crappy_threshold(float threshold) { d_crappy_threshold = threshold; }
+
+      // Runs n more samples through, finished frames are appended to frames.
+      void work(const gr_complex *in, size_t n, std::vector<frame> &frames);
+
+      uint64_t preambles() const { return d_preambles; }
+      uint64_t lost_syncs() const { return d_lost_syncs; }
+
+     private:
+      enum state_t { S_SEARCH, S_ALIGN, S_PREAMBLE, S_SFD, S_PHR, S_PSDU };
+      static const uint8_t SFD = 0xA7;
+
+      const oqpsk_table_view &d_tables;
+      const size_t d_nibble_len;         // L, the nibble spacing
+      const size_t d_window;             // W, length of the self correlation
+      float d_detect_threshold;
+      float d_crappy_threshold;
+
+      std::vector<gr_complex> d_buf;     // input not done with yet
+      size_t d_pos;                      // next sample to look at, in d_buf
+      state_t d_state;
+
+      // Self correlation sums at d_pos, see search()
+      bool d_sums_valid;
+      size_t d_sums_age;
+      gr_complexd d_p;
+      double d_e0, d_e1;
+
+      double d_phase;                    // carrier phase at the start of the nibble
+      double d_freq;                     // radians per sample
+      std::vector<gr_complex> d_rot;     // e^(-j d_freq i)
+      std::vector<gr_complex> d_scratch;
+      gr_complex d_corr[16];
+
+      unsigned d_count;                  // nibbles seen in the current state
+      unsigned d_phr;
+      frame d_frame;
+
+      uint64_t d_preambles;
+      uint64_t d_lost_syncs;
+
+      size_t needed() const;
+      void search();
+      void align();
+      void set_freq(double freq);
+      unsigned demod_nibble(float &confidence);
+      void lose_sync();
+      void next_nibble(unsigned nibble, float confidence, std::vector<frame> &frames);
+    };
+
+  } // namespace zluudgbee
+} // namespace gr
+
+#endif /* INCLUDED_ZLUUDGBEE_COHERENT_DEMOD_H */
@@ -0,0 +1,132 @@
+/* -*- c++ -*- */
+/* 
+ * Copyright 2019 Leon Fernandez (zluudg).
+ * 
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ * 
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <gnuradio/io_signature.h>
+#include <stdexcept>
+#include "coherentrx_impl.h"
+
+namespace gr {
+  namespace zluudgbee {
+
+    coherentrx::sptr
+    coherentrx::make(int samples_per_chip, double detect_threshold, double crappy_threshold)
+    {
+      return gnuradio::get_initial_sptr(
+        new coherentrx_impl(samples_per_chip, detect_threshold, crappy_threshold)
+      );
+    }
+
+    /*
+     * The private constructor
+     */
+    coherentrx_impl::coherentrx_impl(int samples_per_chip, double detect_threshold,
+                                     double crappy_threshold)
+      : gr::sync_block("coherentrx",
+              gr::io_signature::make(1, 1, sizeof(gr_complex)),
+              gr::io_signature::make(0, 0, 0)),
+        d_demod(samples_per_chip > 0 ? samples_per_chip : 1, detect_threshold, crappy_threshold),
+        d_published(0),
+        d_port(pmt::mp("data")),
+        d_confidence_key(pmt::mp("confidence")),
+        d_crappy_key(pmt::mp("crappy_nibbles")),
+        d_nibble_confidence_key(pmt::mp("nibble_confidence"))
+    {
+      if (samples_per_chip < 1)
+        throw std::invalid_argument("coherentrx: samples_per_chip must be at least 1");
+
+      message_port_register_out(d_port);
+    }
+
+    /*
+     * Our virtual destructor.
+     */
+    coherentrx_impl::~coherentrx_impl()
+    {
+    }
+
+    void
+    coherentrx_impl::set_detect_threshold(double threshold)
+    {
+      gr::thread::scoped_lock guard(d_setlock);
+      d_demod.set_detect_threshold(threshold);
+    }
+
+    void
+    coherentrx_impl::set_crappy_threshold(double threshold)
+    {
+      gr::thread::scoped_lock guard(d_setlock);
+      d_demod.set_crappy_threshold(threshold);
+    }
+
+    uint64_t
+    coherentrx_impl::preambles() const
+    {
+      return d_demod.preambles();
+    }
+
+    uint64_t
+    coherentrx_impl::lost_syncs() const
+    {
+      return d_demod.lost_syncs();
+    }
+
+    uint64_t
+    coherentrx_impl::frames() const
+    {
+      return d_published;
+    }
+
+    int
+    coherentrx_impl::work(int noutput_items,
+        gr_vector_const_void_star &input_items,
+        gr_vector_void_star &output_items)
+    {
+      const gr_complex *in = (const gr_complex *) input_items[0];
+
+      d_frames.clear();
+      {
+        gr::thread::scoped_lock guard(d_setlock);
+        d_demod.work(in, noutput_items, d_frames);
+      }
+
+      for (size_t f = 0; f < d_frames.size(); f++) {
+        const coherent_demod::frame &frame = d_frames[f];
+        const size_t nibbles = frame.confidence.size();
+        pmt::pmt_t meta = pmt::make_dict();
+        meta = pmt::dict_add(meta, d_confidence_key,
+                             pmt::from_double(1.0 - double(frame.crappy_nibbles) / double(nibbles)));
+        meta = pmt::dict_add(meta, d_crappy_key, pmt::from_long(frame.crappy_nibbles));
+        meta = pmt::dict_add(meta, d_nibble_confidence_key,
+                             pmt::init_f32vector(nibbles, &frame.confidence[0]));
+        pmt::pmt_t vector = pmt::init_u8vector(frame.psdu.size(), &frame.psdu[0]);
+        message_port_pub(d_port, pmt::cons(meta, vector));
+        d_published++;
+      }
+
+      // Tell runtime system how many output items we produced.
+      return noutput_items;
+    }
+
+  } /* namespace zluudgbee */
+} /* namespace gr */
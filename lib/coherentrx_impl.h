@@ -0,0 +1,60 @@
+/* -*- c++ -*- */
+/* 
+ * Copyright 2019 Leon Fernandez (zluudg).
+ * 
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ * 
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_ZLUUDGBEE_COHERENTRX_IMPL_H
+#define INCLUDED_ZLUUDGBEE_COHERENTRX_IMPL_H
+
+#include <zluudgbee/coherentrx.h>
+#include "coherent_demod.h"
+
+namespace gr {
+  namespace zluudgbee {
+
+    class coherentrx_impl : public coherentrx
+    {
+     private:
+      coherent_demod d_demod;
+      std::vector<coherent_demod::frame> d_frames;
+      uint64_t d_published;
+
+      const pmt::pmt_t d_port;
+      const pmt::pmt_t d_confidence_key;
+      const pmt::pmt_t d_crappy_key;
+      const pmt::pmt_t d_nibble_confidence_key;
+
+     public:
+      coherentrx_impl(int samples_per_chip, double detect_threshold, double crappy_threshold);
+      ~coherentrx_impl();
+
+      void set_detect_threshold(double threshold);
+      void set_crappy_threshold(double threshold);
+      uint64_t preambles() const;
+      uint64_t lost_syncs() const;
+      uint64_t frames() const;
+
+      int work(int noutput_items,
+         gr_vector_const_void_star &input_items,
+         gr_vector_void_star &output_items);
+    };
+
+  } // namespace zluudgbee
+} // namespace gr
+
+#endif /* INCLUDED_ZLUUDGBEE_COHERENTRX_IMPL_H */
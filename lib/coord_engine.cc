@@ -0,0 +1,621 @@
+/* -*- c++ -*- */
+/* 
+ * Copyright 2019 Leon Fernandez (zluudg).
+ * 
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ * 
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "coord_engine.h"
+#include <zluudgbee/crc16.h>
+#include <algorithm>
+#include <cstring>
+
+namespace gr {
+  namespace zluudgbee {
+
+    namespace {
+
+      // Short addresses 0xFFFE (none) and 0xFFFF (broadcast) are reserved,
+      // and the coordinator keeps one for itself
+      const size_t MAX_SHORT_ADDRS = 0xFFFC;
+
+      const size_t ACK_LEN = 5;
+      const size_t ASSOC_RESPONSE_LEN = 25;
+      const size_t DATA_HEADER_LEN = 9;
+
+      const uint8_t FC_PENDING = 0x10;
+
+      void
+      put_le(uint8_t *p, uint64_t x, int len)
+      {
+        for (int i = 0; i < len; i++)
+          p[i] = (x >> (8*i)) & 0xFF;
+      }
+
+      // Immediate ACKs for every sequence number, with and without frame pending
+      struct ack_frames
+      {
+        uint8_t frame[2][256][ACK_LEN];
+
+        ack_frames()
+        {
+          for (int pending = 0; pending < 2; pending++) {
+            for (int seq = 0; seq < 256; seq++) {
+              uint8_t *ack = frame[pending][seq];
+              ack[0] = mac_frame_view::FRAME_ACK | (pending ? FC_PENDING : 0);
+              ack[1] = 0x00;
+              ack[2] = seq;
+              put_le(ack + 3, crc16::compute(ack, 3), 2);
+            }
+          }
+        }
+      };
+
+      const ack_frames &
+      acks()
+      {
+        static const ack_frames table;
+        return table;
+      }
+
+    } // namespace
+
+    coord_engine::coord_engine(const coord_config &config, output &out)
+      : d_config(config), d_out(out),
+        d_devices(std::min(std::max(config.max_devices, size_t(1)), MAX_SHORT_ADDRS)),
+        d_by_ext(d_devices.size()), d_by_short(d_devices.size()),
+        d_associated(0),
+        d_frames(std::max(config.queue_frames, size_t(1))),
+        d_free_frame(0), d_free_frames(d_frames.size()),
+        d_dsn(0), d_bsn(0)
+    {
+      std::memset(&d_stats, 0, sizeof(d_stats));
+      std::fill(d_ack_owner, d_ack_owner + 256, uint32_t(NONE));
+
+      // Short addresses follow the table slots, skipping our own
+      d_free_devices.reserve(d_devices.size());
+      for (uint32_t i = d_devices.size(); i-- > 0; ) {
+        device &d = d_devices[i];
+        d.short_addr = i + 1 >= d_config.short_addr && d_config.short_addr ? i + 2 : i + 1;
+        d.state = DEV_FREE;
+        d.ack_timer.owner = d.expiry_timer.owner = d.aging_timer.owner = i;
+        d.ack_timer.kind = TIMER_ACK;
+        d.expiry_timer.kind = TIMER_EXPIRY;
+        d.aging_timer.kind = TIMER_AGING;
+        d_free_devices.push_back(i);
+      }
+
+      for (uint32_t i = 0; i < d_frames.size(); i++)
+        d_frames[i].next = i + 1 < d_frames.size() ? i + 1 : uint32_t(NONE);
+
+      build_beacon_template();
+    }
+
+    void
+    coord_engine::handle(const mac_frame_view &frame, uint64_t now)
+    {
+      d_stats.frames_in++;
+      if (!frame.valid())
+        return;
+
+      // ACKs carry nothing but the sequence number of what they ACK
+      if (frame.frame_type() == mac_frame_view::FRAME_ACK) {
+        on_ack(frame.sequence_number());
+        return;
+      }
+      if (!for_us(frame)) {
+        d_stats.not_for_us++;
+        return;
+      }
+
+      const uint32_t dev = find_source(frame);
+      if (dev != NONE)
+        d_devices[dev].last_heard = now;
+
+      const int command = frame.command_id();
+      if (frame.ack_request() && !frame.is_broadcast()) {
+        // Frame pending tells a polling device to stay awake for its data
+        const bool pending = command == mac_frame_view::CMD_DATA_REQUEST && dev != NONE &&
+                             (d_devices[dev].queue_head != NONE ||
+                              d_devices[dev].inflight != NONE);
+        send_ack(frame.sequence_number(), pending);
+      }
+
+      switch (frame.frame_type()) {
+      case mac_frame_view::FRAME_DATA:
+        if (dev != NONE && d_devices[dev].state == DEV_ASSOCIATED) {
+          d_stats.data_frames++;
+          d_out.deliver(frame);
+        }
+        else
+          d_stats.unknown_device++;
+        break;
+      case mac_frame_view::FRAME_COMMAND:
+        switch (command) {
+        case mac_frame_view::CMD_BEACON_REQUEST:
+          send_beacon();
+          break;
+        case mac_frame_view::CMD_ASSOCIATION_REQUEST:
+          associate(frame, dev, now);
+          break;
+        case mac_frame_view::CMD_DATA_REQUEST:
+          d_stats.data_requests++;
+          if (dev != NONE)
+            data_request(dev, now);
+          else
+            d_stats.unknown_device++;
+          break;
+        case mac_frame_view::CMD_DISASSOCIATION:
+          if (dev != NONE) {
+            d_stats.disassociations++;
+            remove_device(dev);
+          }
+          break;
+        default:
+          break;
+        }
+        break;
+      default: // Beacons from other coordinators
+        break;
+      }
+    }
+
+    bool
+    coord_engine::send_indirect(uint64_t dst, bool extended, const uint8_t *payload,
+                                size_t len, uint64_t now)
+    {
+      if (len > MAX_DATA_PAYLOAD)
+        return false;
+      const uint32_t dev = extended ? d_by_ext.find(dst) : d_by_short.find(dst);
+      if (dev == NONE || d_devices[dev].state != DEV_ASSOCIATED) {
+        d_stats.unknown_device++;
+        return false;
+      }
+      const uint32_t slot = alloc_frame();
+      if (slot == NONE) {
+        d_stats.queue_full++;
+        return false;
+      }
+
+      // Data, ACK request, PAN ID compression, short addresses both ways
+      frame_slot &f = d_frames[slot];
+      f.data[0] = 0x61;
+      f.data[1] = 0x88;
+      f.data[2] = 0;
+      put_le(f.data + 3, d_config.pan_id, 2);
+      put_le(f.data + 5, d_devices[dev].short_addr, 2);
+      put_le(f.data + 7, d_config.short_addr, 2);
+      if (len)
+        std::memcpy(f.data + DATA_HEADER_LEN, payload, len);
+      f.len = DATA_HEADER_LEN + len;
+      f.assoc_response = false;
+      enqueue(dev, slot, now);
+      return true;
+    }
+
+    void
+    coord_engine::advance(uint64_t now)
+    {
+      timer_fired fire(*this, now);
+      d_timers.advance(now, fire);
+    }
+
+    /*
+     * Frames to our short or extended address, or to the broadcast
+     * address, on our PAN or the broadcast PAN. Frames without a
+     * destination are for the PAN coordinator when they come from within
+     * our PAN.
+     */
+    bool
+    coord_engine::for_us(const mac_frame_view &frame) const
+    {
+      if (frame.dst_addr_mode() == mac_frame_view::ADDR_NONE)
+        return frame.src_pan_id() == d_config.pan_id;
+      if (frame.dst_pan_id() != d_config.pan_id && frame.dst_pan_id() != 0xFFFF)
+        return false;
+      if (frame.dst_addr_mode() == mac_frame_view::ADDR_SHORT)
+        return frame.is_broadcast() || frame.dst_addr() == d_config.short_addr;
+      return frame.dst_addr() == d_config.ext_addr;
+    }
+
+    uint32_t
+    coord_engine::find_source(const mac_frame_view &frame) const
+    {
+      switch (frame.src_addr_mode()) {
+      case mac_frame_view::ADDR_SHORT:
+        return d_by_short.find(frame.src_addr());
+      case mac_frame_view::ADDR_EXTENDED:
+        return d_by_ext.find(frame.src_addr());
+      default:
+        return NONE;
+      }
+    }
+
+    void
+    coord_engine::associate(const mac_frame_view &frame, uint32_t dev, uint64_t now)
+    {
+      if (frame.src_addr_mode() != mac_frame_view::ADDR_EXTENDED)
+        return;
+
+      if (dev != NONE) {
+        // A repeated request while the response is queued needs nothing,
+        // a device that lost its association gets its address again
+        if (d_devices[dev].state != DEV_ASSOCIATED)
+          return;
+        d_devices[dev].state = DEV_ASSOCIATING;
+        d_associated--;
+      }
+      else {
+        dev = new_device(frame.src_addr(), now);
+        if (dev == NONE) {
+          // Nowhere to queue a response, so the rejection goes out directly
+          uint8_t reject[MAX_FRAME];
+          const size_t len = build_assoc_response(reject, frame.src_addr(), 0xFFFF,
+                                                  ASSOC_PAN_AT_CAPACITY);
+          reject[2] = next_dsn();
+          d_stats.rejections++;
+          transmit(reject, len);
+          return;
+        }
+      }
+
+      const uint32_t slot = alloc_frame();
+      if (slot == NONE) {
+        d_stats.queue_full++;
+        remove_device(dev);
+        return;
+      }
+      frame_slot &f = d_frames[slot];
+      f.len = build_assoc_response(f.data, frame.src_addr(), d_devices[dev].short_addr,
+                                   ASSOC_SUCCESS);
+      f.assoc_response = true;
+      enqueue(dev, slot, now);
+    }
+
+    void
+    coord_engine::data_request(uint32_t dev, uint64_t now)
+    {
+      // A frame in flight is retransmitted when its ACK times out
+      if (d_devices[dev].inflight == NONE && d_devices[dev].queue_head != NONE)
+        send_next(dev, now);
+    }
+
+    uint32_t
+    coord_engine::new_device(uint64_t ext_addr, uint64_t now)
+    {
+      if (d_free_devices.empty())
+        return NONE;
+      const uint32_t dev = d_free_devices.back();
+      d_free_devices.pop_back();
+
+      device &d = d_devices[dev];
+      d.ext_addr = ext_addr;
+      d.last_heard = now;
+      d.state = DEV_ASSOCIATING;
+      d.queue_head = d.queue_tail = d.inflight = NONE;
+      d.retries = 0;
+      d_by_ext.insert(ext_addr, dev);
+      d_by_short.insert(d.short_addr, dev);
+      if (d_config.device_timeout_ms)
+        d_timers.schedule(d.aging_timer, now + d_config.device_timeout_ms);
+      return dev;
+    }
+
+    void
+    coord_engine::remove_device(uint32_t dev)
+    {
+      device &d = d_devices[dev];
+      d_timers.cancel(d.ack_timer);
+      d_timers.cancel(d.expiry_timer);
+      d_timers.cancel(d.aging_timer);
+      if (d.inflight != NONE)
+        release_inflight(dev);
+      while (d.queue_head != NONE) {
+        const uint32_t slot = d.queue_head;
+        d.queue_head = d_frames[slot].next;
+        free_frame(slot);
+      }
+      d.queue_tail = NONE;
+
+      d_by_ext.erase(d.ext_addr);
+      d_by_short.erase(d.short_addr);
+      if (d.state == DEV_ASSOCIATED)
+        d_associated--;
+      d.state = DEV_FREE;
+      d_free_devices.push_back(dev);
+    }
+
+    uint32_t
+    coord_engine::alloc_frame()
+    {
+      const uint32_t slot = d_free_frame;
+      if (slot != NONE) {
+        d_free_frame = d_frames[slot].next;
+        d_free_frames--;
+      }
+      return slot;
+    }
+
+    void
+    coord_engine::free_frame(uint32_t slot)
+    {
+      d_frames[slot].next = d_free_frame;
+      d_free_frame = slot;
+      d_free_frames++;
+    }
+
+    void
+    coord_engine::enqueue(uint32_t dev, uint32_t slot, uint64_t now)
+    {
+      device &d = d_devices[dev];
+      frame_slot &f = d_frames[slot];
+      f.expires = now + d_config.persistence_ms;
+      f.next = NONE;
+      if (d.queue_head == NONE) {
+        d.queue_head = d.queue_tail = slot;
+        d_timers.schedule(d.expiry_timer, f.expires);
+      }
+      else {
+        d_frames[d.queue_tail].next = slot;
+        d.queue_tail = slot;
+      }
+    }
+
+    void
+    coord_engine::send_next(uint32_t dev, uint64_t now)
+    {
+      device &d = d_devices[dev];
+      const uint32_t slot = d.queue_head;
+      d.queue_head = d_frames[slot].next;
+      if (d.queue_head == NONE) {
+        d.queue_tail = NONE;
+        d_timers.cancel(d.expiry_timer);
+      }
+      else
+        d_timers.schedule(d.expiry_timer, d_frames[d.queue_head].expires);
+
+      frame_slot &f = d_frames[slot];
+      d.inflight = slot;
+      d.retries = 0;
+      d.dsn = next_dsn();
+      d_ack_owner[d.dsn] = dev;
+      f.data[2] = d.dsn;
+      if (d.queue_head != NONE)
+        f.data[0] |= FC_PENDING;
+      else
+        f.data[0] &= ~FC_PENDING;
+
+      d_stats.indirect_sent++;
+      transmit(f.data, f.len);
+      d_timers.schedule(d.ack_timer, now + d_config.ack_timeout_ms);
+    }
+
+    void
+    coord_engine::release_inflight(uint32_t dev)
+    {
+      device &d = d_devices[dev];
+      if (d_ack_owner[d.dsn] == dev)
+        d_ack_owner[d.dsn] = NONE;
+      d_timers.cancel(d.ack_timer);
+      free_frame(d.inflight);
+      d.inflight = NONE;
+    }
+
+    /*
+     * ACKs are only matched by sequence number, so a DSN stays reserved
+     * for as long as its frame is in flight. With fewer than 256 frames
+     * in flight the search ends quickly, beyond that the oldest owner
+     * loses its ACKs and runs out of retries.
+     */
+    uint8_t
+    coord_engine::next_dsn()
+    {
+      for (int i = 0; i < 256 && d_ack_owner[d_dsn] != NONE; i++)
+        d_dsn++;
+      return d_dsn++;
+    }
+
+    void
+    coord_engine::on_timer(timer_wheel::timer &t, uint64_t now)
+    {
+      switch (t.kind) {
+      case TIMER_ACK:
+        ack_timeout(t.owner, now);
+        break;
+      case TIMER_EXPIRY:
+        expire_frames(t.owner, now);
+        break;
+      case TIMER_AGING:
+        check_age(t.owner, now);
+        break;
+      }
+    }
+
+    void
+    coord_engine::on_ack(uint8_t seq)
+    {
+      const uint32_t dev = d_ack_owner[seq];
+      if (dev == NONE)
+        return;
+      device &d = d_devices[dev];
+      if (d.inflight == NONE || d.dsn != seq)
+        return;
+
+      if (d_frames[d.inflight].assoc_response && d.state == DEV_ASSOCIATING) {
+        d.state = DEV_ASSOCIATED;
+        d_associated++;
+        d_stats.associations++;
+      }
+      release_inflight(dev);
+    }
+
+    void
+    coord_engine::ack_timeout(uint32_t dev, uint64_t now)
+    {
+      device &d = d_devices[dev];
+      if (d.inflight == NONE)
+        return;
+
+      if (d.retries >= d_config.max_retries) {
+        d_stats.tx_failures++;
+        const bool assoc_response = d_frames[d.inflight].assoc_response;
+        release_inflight(dev);
+        if (assoc_response && d.state == DEV_ASSOCIATING)
+          remove_device(dev);
+        return;
+      }
+
+      d.retries++;
+      d_stats.retransmissions++;
+      transmit(d_frames[d.inflight].data, d_frames[d.inflight].len);
+      d_timers.schedule(d.ack_timer, now + d_config.ack_timeout_ms);
+    }
+
+    void
+    coord_engine::expire_frames(uint32_t dev, uint64_t now)
+    {
+      device &d = d_devices[dev];
+      while (d.queue_head != NONE && d_frames[d.queue_head].expires <= now) {
+        const uint32_t slot = d.queue_head;
+        d.queue_head = d_frames[slot].next;
+        d_stats.expired++;
+
+        // A device that never came back for its address is forgotten
+        if (d_frames[slot].assoc_response && d.state == DEV_ASSOCIATING) {
+          free_frame(slot);
+          remove_device(dev);
+          return;
+        }
+        free_frame(slot);
+      }
+
+      if (d.queue_head == NONE)
+        d.queue_tail = NONE;
+      else
+        d_timers.schedule(d.expiry_timer, d_frames[d.queue_head].expires);
+    }
+
+    // last_heard moves on without touching the timer, which is only
+    // pushed back once it finds the device has been heard from since
+    void
+    coord_engine::check_age(uint32_t dev, uint64_t now)
+    {
+      device &d = d_devices[dev];
+      const uint64_t deadline = d.last_heard + d_config.device_timeout_ms;
+      if (deadline <= now) {
+        d_stats.aged_out++;
+        remove_device(dev);
+      }
+      else
+        d_timers.schedule(d.aging_timer, deadline);
+    }
+
+    // Command, ACK request, PAN ID compression, extended addresses both ways
+    size_t
+    coord_engine::build_assoc_response(uint8_t *frame, uint64_t dst, uint16_t short_addr,
+                                       uint8_t status) const
+    {
+      frame[0] = 0x63;
+      frame[1] = 0xCC;
+      frame[2] = 0;
+      put_le(frame + 3, d_config.pan_id, 2);
+      put_le(frame + 5, dst, 8);
+      put_le(frame + 13, d_config.ext_addr, 8);
+      frame[21] = mac_frame_view::CMD_ASSOCIATION_RESPONSE;
+      put_le(frame + 22, short_addr, 2);
+      frame[24] = status;
+      return ASSOC_RESPONSE_LEN;
+    }
+
+    void
+    coord_engine::build_beacon_template()
+    {
+      std::vector<uint8_t> &beacon = d_beacon;
+      beacon.clear();
+
+      // Beacon with a short source address and no destination
+      beacon.push_back(0x00);
+      beacon.push_back(0x80);
+      beacon.push_back(0x00); // BSN, patched in per beacon
+      beacon.push_back(d_config.pan_id & 0xFF);
+      beacon.push_back((d_config.pan_id >> 8) & 0xFF);
+      beacon.push_back(d_config.short_addr & 0xFF);
+      beacon.push_back((d_config.short_addr >> 8) & 0xFF);
+
+      // Superframe specification, nonbeacon-enabled PAN coordinator that
+      // permits association
+      beacon.push_back(0xFF);
+      beacon.push_back(0xCF);
+
+      // No GTS and no pending addresses
+      beacon.push_back(0x00);
+      beacon.push_back(0x00);
+
+      // ZigBee beacon payload, router and end device capacity set
+      beacon.push_back(0x00);
+      beacon.push_back(0x20);
+      beacon.push_back(0x84);
+      for (int i = 0; i < 8; i++)
+        beacon.push_back((d_config.epid >> (8*i)) & 0xFF);
+      beacon.push_back(0xFF);
+      beacon.push_back(0xFF);
+      beacon.push_back(0xFF);
+      beacon.push_back(0x00);
+
+      beacon.resize(beacon.size() + FCS_LEN);
+    }
+
+    void
+    coord_engine::send_beacon()
+    {
+      static const size_t SUPERFRAME_HI = 8;
+      static const size_t CAPACITY = 13;
+
+      uint8_t beacon[MAX_FRAME];
+      const size_t len = d_beacon.size() - FCS_LEN;
+      std::memcpy(beacon, &d_beacon[0], len);
+      beacon[2] = d_bsn++;
+
+      // Joining devices look elsewhere once we are full
+      if (d_free_devices.empty()) {
+        beacon[SUPERFRAME_HI] &= ~0x80;
+        beacon[CAPACITY] &= ~0x84;
+      }
+      d_stats.beacons_sent++;
+      transmit(beacon, len);
+    }
+
+    void
+    coord_engine::send_ack(uint8_t seq, bool frame_pending)
+    {
+      d_stats.acks_sent++;
+      d_out.transmit(acks().frame[frame_pending][seq], ACK_LEN);
+    }
+
+    // Appends the FCS, frame must have room for it
+    void
+    coord_engine::transmit(uint8_t *frame, size_t len)
+    {
+      put_le(frame + len, crc16::compute(frame, len), FCS_LEN);
+      d_out.transmit(frame, len + FCS_LEN);
+    }
+
+  } /* namespace zluudgbee */
+} /* namespace gr */
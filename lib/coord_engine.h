@@ -0,0 +1,236 @@
+/* -*- c++ -*- */
+/* 
+ * Copyright 2019 Leon Fernandez (zluudg).
+ * 
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ * 
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_ZLUUDGBEE_COORD_ENGINE_H
+#define INCLUDED_ZLUUDGBEE_COORD_ENGINE_H
+
+#include <zluudgbee/mac_frame.h>
+#include "addr_index.h"
+#include "timer_wheel.h"
+#include <cstddef>
+#include <vector>
+#include <stdint.h>
+
+namespace gr {
+  namespace zluudgbee {
+
+    struct coord_config
+    {
+      uint16_t pan_id;
+      uint16_t short_addr;
+      uint64_t ext_addr;
+      uint64_t epid;                  // ZigBee extended PAN ID in the beacon
+      size_t max_devices;
+      size_t queue_frames;            // indirect frames, all devices together
+      unsigned ack_timeout_ms;
+      unsigned max_retries;           // macMaxFrameRetries
+      unsigned persistence_ms;        // macTransactionPersistenceTime
+      unsigned device_timeout_ms;     // forget silent devices, zero never does
+
+      coord_config()
+        : pan_id(0xabcd), short_addr(0x0000), ext_addr(1), epid(0xa),
+          max_devices(4096), queue_frames(8192), ack_timeout_ms(10),
+          max_retries(3), persistence_ms(7680), device_timeout_ms(0)
+      {
+      }
+    };
+
+    /*
+     * The MAC of a PAN coordinator in a nonbeacon-enabled PAN, without
+     * any radio or threads attached. It gets frames through handle(),
+     * sends through an output and keeps time only through the now
+     * argument, in milliseconds, so it runs just as well on recorded or
+     * simulated traffic as behind a receiver.
+     *
+     * Answers beacon requests and associates devices, handing out short
+     * addresses. Frames for devices, association responses included, are
+     * held in per-device queues until the device polls with a data
+     * request, and retransmitted until ACKed or out of retries. Queued
+     * frames expire after persistence_ms, and devices that are silent
+     * for device_timeout_ms are dropped.
+     *
+     * Devices sit in a fixed table indexed by both of their addresses.
+     * Retransmissions and expiries run off a timer wheel, and frames live
+     * in a preallocated pool, so the work per frame doesn't grow with the
+     * number of devices and nothing is allocated after construction.
+     */
+    class coord_engine
+    {
+     public:
+      class output
+      {
+       public:
+        virtual ~output() {}
+        // A frame to send, FCS included.
+        virtual void transmit(const uint8_t *frame, size_t len) = 0;
+        // A data frame from an associated device.
+        virtual void deliver(const mac_frame_view &frame) = 0;
+      };
+
+      struct counters
+      {
+        uint64_t frames_in;
+        uint64_t not_for_us;
+        uint64_t acks_sent;
+        uint64_t beacons_sent;
+        uint64_t associations;        // ACKed association responses
+        uint64_t rejections;          // PAN at capacity
+        uint64_t disassociations;
+        uint64_t data_requests;
+        uint64_t data_frames;
+        uint64_t indirect_sent;       // first attempts
+        uint64_t retransmissions;
+        uint64_t tx_failures;         // out of retries
+        uint64_t expired;             // never polled for
+        uint64_t aged_out;
+        uint64_t queue_full;
+        uint64_t unknown_device;
+      };
+
+      // Payload of a data frame to a device, MHR and FCS take the rest
+      static const size_t MAX_DATA_PAYLOAD = 127 - 9 - 2;
+
+      coord_engine(const coord_config &config, output &out);
+
+      // A frame without FCS, as it comes out of softcrc.
+      void handle(const mac_frame_view &frame, uint64_t now);
+
+      /*
+       * Queues a data frame for an associated device, addressed by its
+       * short address or, when extended is set, its extended one. Returns
+       * false if there is no such device, the payload is too long or the
+       * queue is full.
+       */
+      bool send_indirect(uint64_t dst, bool extended, const uint8_t *payload,
+                         size_t len, uint64_t now);
+
+      // Runs the timers that are due by now.
+      void advance(uint64_t now);
+
+      size_t devices() const { return d_by_ext.size(); }
+      size_t associated() const { return d_associated; }
+      size_t queued_frames() const { return d_config.queue_frames - d_free_frames; }
+      const counters &stats() const { return d_stats; }
+      const coord_config &config() const { return d_config; }
+
+     private:
+      static const uint32_t NONE = addr_index::NONE;
+      static const size_t FCS_LEN = 2;
+      static const size_t MAX_FRAME = 127;
+
+      enum device_state { DEV_FREE, DEV_ASSOCIATING, DEV_ASSOCIATED };
+      enum timer_kind { TIMER_ACK, TIMER_EXPIRY, TIMER_AGING };
+
+      enum assoc_status {
+        ASSOC_SUCCESS = 0x00,
+        ASSOC_PAN_AT_CAPACITY = 0x01
+      };
+
+      struct device
+      {
+        uint64_t ext_addr;
+        uint64_t last_heard;
+        uint16_t short_addr;
+        uint8_t state;
+        uint8_t dsn;                  // of the frame in flight
+        uint8_t retries;
+        uint32_t queue_head;          // frame pool indices
+        uint32_t queue_tail;
+        uint32_t inflight;
+        timer_wheel::timer ack_timer;
+        timer_wheel::timer expiry_timer;
+        timer_wheel::timer aging_timer;
+      };
+
+      struct frame_slot
+      {
+        uint64_t expires;
+        uint32_t next;
+        uint8_t len;                  // without FCS
+        bool assoc_response;
+        uint8_t data[MAX_FRAME];
+      };
+
+      // Calls back into the engine for every timer the wheel fires
+      struct timer_fired
+      {
+        coord_engine &engine;
+        const uint64_t now;
+        timer_fired(coord_engine &e, uint64_t n) : engine(e), now(n) {}
+        void operator()(timer_wheel::timer &t) { engine.on_timer(t, now); }
+      };
+
+      const coord_config d_config;
+      output &d_out;
+      counters d_stats;
+
+      std::vector<device> d_devices;
+      std::vector<uint32_t> d_free_devices;
+      addr_index d_by_ext;
+      addr_index d_by_short;
+      size_t d_associated;
+
+      std::vector<frame_slot> d_frames;
+      uint32_t d_free_frame;
+      size_t d_free_frames;
+
+      timer_wheel d_timers;
+      uint32_t d_ack_owner[256];      // device awaiting an ACK, by DSN
+      uint8_t d_dsn;
+      uint8_t d_bsn;
+      std::vector<uint8_t> d_beacon;  // room for the FCS at the end
+
+      bool for_us(const mac_frame_view &frame) const;
+      uint32_t find_source(const mac_frame_view &frame) const;
+
+      void associate(const mac_frame_view &frame, uint32_t dev, uint64_t now);
+      void data_request(uint32_t dev, uint64_t now);
+
+      uint32_t new_device(uint64_t ext_addr, uint64_t now);
+      void remove_device(uint32_t dev);
+
+      uint32_t alloc_frame();
+      void free_frame(uint32_t frame);
+      void enqueue(uint32_t dev, uint32_t frame, uint64_t now);
+      void send_next(uint32_t dev, uint64_t now);
+      void release_inflight(uint32_t dev);
+      uint8_t next_dsn();
+
+      void on_timer(timer_wheel::timer &t, uint64_t now);
+      void on_ack(uint8_t seq);
+      void ack_timeout(uint32_t dev, uint64_t now);
+      void expire_frames(uint32_t dev, uint64_t now);
+      void check_age(uint32_t dev, uint64_t now);
+
+      size_t build_assoc_response(uint8_t *frame, uint64_t dst, uint16_t short_addr,
+                                  uint8_t status) const;
+      void build_beacon_template();
+      void send_beacon();
+      void send_ack(uint8_t seq, bool frame_pending);
+      void transmit(uint8_t *frame, size_t len);
+
+      coord_engine(const coord_engine &);
+      coord_engine &operator=(const coord_engine &);
+    };
+
+  } // namespace zluudgbee
+} // namespace gr
+
+#endif /* INCLUDED_ZLUUDGBEE_COORD_ENGINE_H */
@@ -0,0 +1,251 @@
+/* -*- c++ -*- */
+/* 
+ * Copyright 2019 Leon Fernandez (zluudg).
+ * 
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ * 
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <gnuradio/io_signature.h>
+#include <boost/format.hpp>
+#include <stdexcept>
+#include "coordinator_impl.h"
+
+namespace gr {
+  namespace zluudgbee {
+
+    coordinator::sptr
+    coordinator::make(int pan_id, int short_addr, long ext_addr, long epid,
+                      int max_devices, int ack_timeout_ms, int max_retries,
+                      int persistence_ms, int device_timeout_ms)
+    {
+      if (max_devices <= 0 || ack_timeout_ms <= 0 || max_retries < 0 ||
+          persistence_ms <= 0 || device_timeout_ms < 0)
+        throw std::invalid_argument("coordinator: bad device limit or timeout");
+
+      coord_config config;
+      config.pan_id = pan_id;
+      config.short_addr = short_addr;
+      config.ext_addr = ext_addr;
+      config.epid = epid;
+      config.max_devices = max_devices;
+      config.queue_frames = 2 * max_devices;
+      config.ack_timeout_ms = ack_timeout_ms;
+      config.max_retries = max_retries;
+      config.persistence_ms = persistence_ms;
+      config.device_timeout_ms = device_timeout_ms;
+      return gnuradio::get_initial_sptr(new coordinator_impl(config));
+    }
+
+    /*
+     * The private constructor
+     */
+    coordinator_impl::coordinator_impl(const coord_config &config)
+      : gr::block("coordinator",
+              gr::io_signature::make(0, 0, 0),
+              gr::io_signature::make(0, 0, 0)),
+        d_engine(config, *this),
+        d_epoch(gr::high_res_timer_now()),
+        d_pdu_out_port(pmt::mp("pdu out")),
+        d_data_out_port(pmt::mp("data out")),
+        d_dst_key(pmt::mp("dst_addr")),
+        d_extended_key(pmt::mp("extended")),
+        d_src_key(pmt::mp("src_addr")),
+        d_seq_key(pmt::mp("seq")),
+        d_meta(pmt::make_dict())
+    {
+      message_port_register_in(pmt::mp("pdu in"));
+      set_msg_handler(pmt::mp("pdu in"), boost::bind(&coordinator_impl::handle_pdu, this, _1));
+      message_port_register_in(pmt::mp("data in"));
+      set_msg_handler(pmt::mp("data in"), boost::bind(&coordinator_impl::handle_data, this, _1));
+      message_port_register_out(d_pdu_out_port);
+      message_port_register_out(d_data_out_port);
+
+      d_metrics = metrics::register_stage(str(boost::format("coordinator%d") % unique_id()));
+    }
+
+    /*
+     * Our virtual destructor.
+     */
+    coordinator_impl::~coordinator_impl()
+    {
+    }
+
+    uint64_t
+    coordinator_impl::now_ms() const
+    {
+      // Whole seconds first: multiplying the raw ticks by 1000 would
+      // overflow after about 106 days with a nanosecond clock.
+      const gr::high_res_timer_type ticks = gr::high_res_timer_now() - d_epoch;
+      const gr::high_res_timer_type tps = gr::high_res_timer_tps();
+      return uint64_t(ticks / tps) * 1000 + uint64_t(ticks % tps) * 1000 / tps;
+    }
+
+    size_t
+    coordinator_impl::devices() const
+    {
+      gr::thread::scoped_lock guard(d_mutex);
+      return d_engine.devices();
+    }
+
+    size_t
+    coordinator_impl::associated() const
+    {
+      gr::thread::scoped_lock guard(d_mutex);
+      return d_engine.associated();
+    }
+
+    pmt::pmt_t
+    coordinator_impl::stats() const
+    {
+      coord_engine::counters s;
+      size_t devices, associated, queued;
+      {
+        gr::thread::scoped_lock guard(d_mutex);
+        s = d_engine.stats();
+        devices = d_engine.devices();
+        associated = d_engine.associated();
+        queued = d_engine.queued_frames();
+      }
+
+      pmt::pmt_t d = pmt::make_dict();
+      d = pmt::dict_add(d, pmt::mp("devices"), pmt::from_uint64(devices));
+      d = pmt::dict_add(d, pmt::mp("associated"), pmt::from_uint64(associated));
+      d = pmt::dict_add(d, pmt::mp("queued_frames"), pmt::from_uint64(queued));
+      d = pmt::dict_add(d, pmt::mp("frames_in"), pmt::from_uint64(s.frames_in));
+      d = pmt::dict_add(d, pmt::mp("not_for_us"), pmt::from_uint64(s.not_for_us));
+      d = pmt::dict_add(d, pmt::mp("acks_sent"), pmt::from_uint64(s.acks_sent));
+      d = pmt::dict_add(d, pmt::mp("beacons_sent"), pmt::from_uint64(s.beacons_sent));
+      d = pmt::dict_add(d, pmt::mp("associations"), pmt::from_uint64(s.associations));
+      d = pmt::dict_add(d, pmt::mp("rejections"), pmt::from_uint64(s.rejections));
+      d = pmt::dict_add(d, pmt::mp("disassociations"), pmt::from_uint64(s.disassociations));
+      d = pmt::dict_add(d, pmt::mp("data_requests"), pmt::from_uint64(s.data_requests));
+      d = pmt::dict_add(d, pmt::mp("data_frames"), pmt::from_uint64(s.data_frames));
+      d = pmt::dict_add(d, pmt::mp("indirect_sent"), pmt::from_uint64(s.indirect_sent));
+      d = pmt::dict_add(d, pmt::mp("retransmissions"), pmt::from_uint64(s.retransmissions));
+      d = pmt::dict_add(d, pmt::mp("tx_failures"), pmt::from_uint64(s.tx_failures));
+      d = pmt::dict_add(d, pmt::mp("expired"), pmt::from_uint64(s.expired));
+      d = pmt::dict_add(d, pmt::mp("aged_out"), pmt::from_uint64(s.aged_out));
+      d = pmt::dict_add(d, pmt::mp("queue_full"), pmt::from_uint64(s.queue_full));
+      d = pmt::dict_add(d, pmt::mp("unknown_device"), pmt::from_uint64(s.unknown_device));
+      return d;
+    }
+
+    void
+    coordinator_impl::handle_pdu(pmt::pmt_t msg)
+    {
+      scoped_latency timer(d_metrics->handler_latency);
+      const mac_frame_view frame(msg);
+      if (metrics::enabled()) {
+        d_metrics->add(d_metrics->frames_in);
+        d_metrics->add(d_metrics->bytes_in, frame.size());
+        if (!frame.valid())
+          d_metrics->add(d_metrics->drops);
+      }
+
+      gr::thread::scoped_lock guard(d_mutex);
+      d_engine.handle(frame, now_ms());
+    }
+
+    void
+    coordinator_impl::handle_data(pmt::pmt_t msg)
+    {
+      if (!pmt::is_pair(msg) || !pmt::is_u8vector(pmt::cdr(msg)))
+        return;
+      const pmt::pmt_t meta = pmt::car(msg);
+      const pmt::pmt_t dst = pmt::is_dict(meta) ? pmt::dict_ref(meta, d_dst_key, pmt::PMT_NIL)
+                                                : pmt::PMT_NIL;
+      if (!pmt::is_integer(dst) && !pmt::is_uint64(dst)) {
+        if (metrics::enabled())
+          d_metrics->add(d_metrics->drops);
+        return;
+      }
+      const uint64_t addr = pmt::is_uint64(dst) ? pmt::to_uint64(dst) : pmt::to_long(dst);
+      const bool extended = pmt::to_bool(pmt::dict_ref(meta, d_extended_key, pmt::PMT_F));
+
+      size_t len;
+      const uint8_t *payload = pmt::u8vector_elements(pmt::cdr(msg), len);
+
+      bool queued;
+      {
+        gr::thread::scoped_lock guard(d_mutex);
+        queued = d_engine.send_indirect(addr, extended, payload, len, now_ms());
+      }
+      if (!queued && metrics::enabled())
+        d_metrics->add(d_metrics->drops);
+    }
+
+    void
+    coordinator_impl::transmit(const uint8_t *frame, size_t len)
+    {
+      message_port_pub(d_pdu_out_port, pmt::cons(d_meta, pmt::init_u8vector(len, frame)));
+      if (metrics::enabled()) {
+        d_metrics->add(d_metrics->frames_out);
+        d_metrics->add(d_metrics->bytes_out, len);
+      }
+    }
+
+    void
+    coordinator_impl::deliver(const mac_frame_view &frame)
+    {
+      pmt::pmt_t meta = pmt::make_dict();
+      meta = pmt::dict_add(meta, d_src_key, pmt::from_uint64(frame.src_addr()));
+      meta = pmt::dict_add(meta, d_seq_key, pmt::from_long(frame.sequence_number()));
+      message_port_pub(d_data_out_port,
+                       pmt::cons(meta, pmt::init_u8vector(frame.payload_len(), frame.payload())));
+    }
+
+    // Retransmissions and expiries only need millisecond resolution
+    void
+    coordinator_impl::run()
+    {
+      const boost::posix_time::milliseconds tick(1);
+      try {
+        while (true) {
+          boost::this_thread::sleep(tick);
+
+          gr::thread::scoped_lock guard(d_mutex);
+          d_engine.advance(now_ms());
+        }
+      }
+      catch (boost::thread_interrupted &) {
+      }
+    }
+
+    bool
+    coordinator_impl::start()
+    {
+      d_thread = boost::shared_ptr<gr::thread::thread>(
+        new gr::thread::thread(boost::bind(&coordinator_impl::run, this)));
+      return block::start();
+    }
+
+    bool
+    coordinator_impl::stop()
+    {
+      if (d_thread) {
+        d_thread->interrupt();
+        d_thread->join();
+        d_thread.reset();
+      }
+      return block::stop();
+    }
+
+  } /* namespace zluudgbee */
+} /* namespace gr */
@@ -0,0 +1,75 @@
+/* -*- c++ -*- */
+/* 
+ * Copyright 2019 Leon Fernandez (zluudg).
+ * 
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ * 
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_ZLUUDGBEE_COORDINATOR_IMPL_H
+#define INCLUDED_ZLUUDGBEE_COORDINATOR_IMPL_H
+
+#include <zluudgbee/coordinator.h>
+#include <zluudgbee/metrics.h>
+#include <gnuradio/high_res_timer.h>
+#include <gnuradio/thread/thread.h>
+#include <boost/shared_ptr.hpp>
+#include "coord_engine.h"
+
+namespace gr {
+  namespace zluudgbee {
+
+    class coordinator_impl : public coordinator, public coord_engine::output
+    {
+     private:
+      mutable gr::thread::mutex d_mutex;
+      coord_engine d_engine;
+      const gr::high_res_timer_type d_epoch;
+      boost::shared_ptr<gr::thread::thread> d_thread;
+      stage_metrics_sptr d_metrics;
+
+      const pmt::pmt_t d_pdu_out_port;
+      const pmt::pmt_t d_data_out_port;
+      const pmt::pmt_t d_dst_key;
+      const pmt::pmt_t d_extended_key;
+      const pmt::pmt_t d_src_key;
+      const pmt::pmt_t d_seq_key;
+      const pmt::pmt_t d_meta;
+
+      uint64_t now_ms() const;
+      void handle_pdu(pmt::pmt_t msg);
+      void handle_data(pmt::pmt_t msg);
+      void run();
+
+     public:
+      coordinator_impl(const coord_config &config);
+      ~coordinator_impl();
+
+      size_t devices() const;
+      size_t associated() const;
+      pmt::pmt_t stats() const;
+
+      // Called by the engine with d_mutex held
+      void transmit(const uint8_t *frame, size_t len);
+      void deliver(const mac_frame_view &frame);
+
+      bool start();
+      bool stop();
+    };
+
+  } // namespace zluudgbee
+} // namespace gr
+
+#endif /* INCLUDED_ZLUUDGBEE_COORDINATOR_IMPL_H */
@@ -0,0 +1,179 @@
+/* -*- c++ -*- */
+/* 
+ * Copyright 2019 Leon Fernandez (zluudg).
+ * 
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ * 
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "correlate_kernel.h"
+#include "cpu_features.h"
+
+#ifdef ZLUUDGBEE_X86
+#include <immintrin.h>
+#endif
+#ifdef ZLUUDGBEE_NEON
+#include <arm_neon.h>
+#endif
+
+namespace gr {
+  namespace zluudgbee {
+
+    static const size_t GROUP = 4;        // references per pass over the input
+
+    static inline gr_complex
+    correlate_one(const gr_complex *in, const gr_complex *ref, size_t first, size_t len)
+    {
+      float re = 0, im = 0;
+      for (size_t i = first; i < len; i++) {
+        re += in[i].real() * ref[i].real() + in[i].imag() * ref[i].imag();
+        im += in[i].imag() * ref[i].real() - in[i].real() * ref[i].imag();
+      }
+      return gr_complex(re, im);
+    }
+
+    void
+    correlate_refs_generic(const gr_complex *in, const gr_complex *refs, size_t len,
+                           size_t stride, size_t nrefs, gr_complex *out)
+    {
+      for (size_t k = 0; k < nrefs; k++)
+        out[k] = correlate_one(in, refs + k*stride, 0, len);
+    }
+
+    /*
+     * The SIMD versions keep two sums per reference: in * ref, which adds
+     * up to the real part, and in * ref with I and Q of ref swapped, whose
+     * odd lanes minus its even lanes are the imaginary part. The samples
+     * the vectors don't cover are done by correlate_one.
+     */
+#ifdef ZLUUDGBEE_X86
+    ZLUUDGBEE_TARGET("avx2,fma")
+    static inline gr_complex
+    reduce_avx2(__m256 re, __m256 im)
+    {
+      const __m256 sign = _mm256_setr_ps(-1, 1, -1, 1, -1, 1, -1, 1);
+      __m256 v = _mm256_hadd_ps(re, _mm256_mul_ps(im, sign));
+      v = _mm256_hadd_ps(v, v);
+      const __m128 s = _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+      return gr_complex(_mm_cvtss_f32(s), _mm_cvtss_f32(_mm_shuffle_ps(s, s, 1)));
+    }
+
+    ZLUUDGBEE_TARGET("avx2,fma")
+    static size_t
+    correlate_avx2(const gr_complex *in, const gr_complex *refs, size_t len,
+                   size_t stride, size_t nrefs, gr_complex *out)
+    {
+      const float *x = (const float *) in;
+      const size_t n = len & ~size_t(3);
+      size_t k = 0;
+      for (; k + GROUP <= nrefs; k += GROUP) {
+        const float *r[GROUP];
+        __m256 re[GROUP], im[GROUP];
+        for (size_t g = 0; g < GROUP; g++) {
+          r[g] = (const float *) (refs + (k + g)*stride);
+          re[g] = _mm256_setzero_ps();
+          im[g] = _mm256_setzero_ps();
+        }
+        for (size_t i = 0; i < n; i += 4) {
+          const __m256 a = _mm256_loadu_ps(x + 2*i);
+          for (size_t g = 0; g < GROUP; g++) {
+            const __m256 b = _mm256_loadu_ps(r[g] + 2*i);
+            re[g] = _mm256_fmadd_ps(a, b, re[g]);
+            im[g] = _mm256_fmadd_ps(a, _mm256_permute_ps(b, 0xB1), im[g]);
+          }
+        }
+        for (size_t g = 0; g < GROUP; g++)
+          out[k + g] = reduce_avx2(re[g], im[g]) + correlate_one(in, refs + (k + g)*stride, n, len);
+      }
+      return k;
+    }
+#endif
+
+#ifdef ZLUUDGBEE_NEON
+    static size_t
+    correlate_neon(const gr_complex *in, const gr_complex *refs, size_t len,
+                   size_t stride, size_t nrefs, gr_complex *out)
+    {
+      const float *x = (const float *) in;
+      const size_t n = len & ~size_t(1);
+      const float sign_init[4] = { -1, 1, -1, 1 };
+      const float32x4_t sign = vld1q_f32(sign_init);
+      size_t k = 0;
+      for (; k + GROUP <= nrefs; k += GROUP) {
+        const float *r[GROUP];
+        float32x4_t re[GROUP], im[GROUP];
+        for (size_t g = 0; g < GROUP; g++) {
+          r[g] = (const float *) (refs + (k + g)*stride);
+          re[g] = vdupq_n_f32(0);
+          im[g] = vdupq_n_f32(0);
+        }
+        for (size_t i = 0; i < n; i += 2) {
+          const float32x4_t a = vld1q_f32(x + 2*i);
+          for (size_t g = 0; g < GROUP; g++) {
+            const float32x4_t b = vld1q_f32(r[g] + 2*i);
+            re[g] = vmlaq_f32(re[g], a, b);
+            im[g] = vmlaq_f32(im[g], a, vrev64q_f32(b));
+          }
+        }
+        for (size_t g = 0; g < GROUP; g++) {
+          float s_re[4], s_im[4];
+          vst1q_f32(s_re, re[g]);
+          vst1q_f32(s_im, vmulq_f32(im[g], sign));
+          out[k + g] = gr_complex(s_re[0] + s_re[1] + s_re[2] + s_re[3],
+                                  s_im[0] + s_im[1] + s_im[2] + s_im[3])
+            + correlate_one(in, refs + (k + g)*stride, n, len);
+        }
+      }
+      return k;
+    }
+#endif
+
+    typedef size_t (*correlate_fn)(const gr_complex *, const gr_complex *, size_t,
+                                   size_t, size_t, gr_complex *);
+
+    static size_t
+    correlate_none(const gr_complex *, const gr_complex *, size_t, size_t, size_t, gr_complex *)
+    {
+      return 0;
+    }
+
+    static correlate_fn
+    pick_correlate()
+    {
+#ifdef ZLUUDGBEE_X86
+      if (cpu_has_avx2() && cpu_has_fma())
+        return correlate_avx2;
+#endif
+#ifdef ZLUUDGBEE_NEON
+      return correlate_neon;
+#endif
+      return correlate_none;
+    }
+
+    void
+    correlate_refs(const gr_complex *in, const gr_complex *refs, size_t len,
+                   size_t stride, size_t nrefs, gr_complex *out)
+    {
+      static const correlate_fn simd = pick_correlate();
+      const size_t done = simd(in, refs, len, stride, nrefs, out);
+      correlate_refs_generic(in, refs + done*stride, len, stride, nrefs - done, out + done);
+    }
+
+  } // namespace zluudgbee
+} // namespace gr
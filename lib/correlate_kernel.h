@@ -0,0 +1,48 @@
+/* -*- c++ -*- */
+/* 
+ * Copyright 2019 Leon Fernandez (zluudg).
+ * 
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ * 
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_ZLUUDGBEE_CORRELATE_KERNEL_H
+#define INCLUDED_ZLUUDGBEE_CORRELATE_KERNEL_H
+
+#include <gnuradio/gr_complex.h>
+#include <cstddef>
+
+namespace gr {
+  namespace zluudgbee {
+
+    /*
+     * Matched filter bank: out[k] is the sum over i < len of in[i] *
+     * conj(refs[k*stride + i]), for k < nrefs. With the oqpsk_tables
+     * waveforms as refs that is one correlation per nibble. The AVX2+FMA
+     * and NEON paths load each input vector once for four references.
+     * They sum in a different order than the scalar loop, so results
+     * can differ in the last bits.
+     */
+    void correlate_refs(const gr_complex *in, const gr_complex *refs, size_t len,
+                        size_t stride, size_t nrefs, gr_complex *out);
+
+    // One reference at a time. Also does the last nrefs % 4 references.
+    void correlate_refs_generic(const gr_complex *in, const gr_complex *refs, size_t len,
+                                size_t stride, size_t nrefs, gr_complex *out);
+
+  } // namespace zluudgbee
+} // namespace gr
+
+#endif /* INCLUDED_ZLUUDGBEE_CORRELATE_KERNEL_H */
@@ -0,0 +1,101 @@
+/* -*- c++ -*- */
+/* 
+ * Copyright 2019 Leon Fernandez (zluudg).
+ * 
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ * 
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_ZLUUDGBEE_CPU_FEATURES_H
+#define INCLUDED_ZLUUDGBEE_CPU_FEATURES_H
+
+/*
+ * Small helpers for picking a SIMD implementation at runtime. The x86
+ * kernels are compiled with per-function target attributes so that the
+ * library itself can still be built for a baseline CPU.
+ */
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define ZLUUDGBEE_X86 1
+#define ZLUUDGBEE_TARGET(isa) __attribute__((target(isa)))
+#endif
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define ZLUUDGBEE_NEON 1
+#endif
+
+namespace gr {
+  namespace zluudgbee {
+
+    inline bool cpu_has_sse2()
+    {
+#ifdef ZLUUDGBEE_X86
+      return __builtin_cpu_supports("sse2");
+#else
+      return false;
+#endif
+    }
+
+    inline bool cpu_has_popcnt()
+    {
+#ifdef ZLUUDGBEE_X86
+      return __builtin_cpu_supports("popcnt");
+#else
+      return false;
+#endif
+    }
+
+    inline bool cpu_has_pclmul()
+    {
+#ifdef ZLUUDGBEE_X86
+      return __builtin_cpu_supports("pclmul");
+#else
+      return false;
+#endif
+    }
+
+    inline bool cpu_has_avx2()
+    {
+#ifdef ZLUUDGBEE_X86
+      return __builtin_cpu_supports("avx2");
+#else
+      return false;
+#endif
+    }
+
+    inline bool cpu_has_fma()
+    {
+#ifdef ZLUUDGBEE_X86
+      return __builtin_cpu_supports("fma");
+#else
+      return false;
+#endif
+    }
+
+    inline bool cpu_has_avx512_vpopcntdq()
+    {
+#ifdef ZLUUDGBEE_X86
+      return __builtin_cpu_supports("avx512f") &&
+             __builtin_cpu_supports("avx512vpopcntdq");
+#else
+      return false;
+#endif
+    }
+
+  } // namespace zluudgbee
+} // namespace gr
+
+#endif /* INCLUDED_ZLUUDGBEE_CPU_FEATURES_H */
+
@@ -0,0 +1,301 @@
+/* -*- c++ -*- */
+/* 
+ * Copyright 2019 Leon Fernandez (zluudg).
+ * 
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ * 
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <zluudgbee/crc16.h>
+#include "cpu_features.h"
+#include <cstring>
+
+#ifdef ZLUUDGBEE_X86
+#include <immintrin.h>
+#endif
+
+namespace gr {
+  namespace zluudgbee {
+
+    // 0x1021 bit reflected
+    static const uint16_t POLY_REFLECTED = 0x8408;
+    static const uint32_t POLY_NORMAL = 0x11021;
+
+    /*
+     * tab[k][b] is the CRC state after feeding byte b followed by k zero
+     * bytes into a zero state. tab[0] is the usual byte-at-a-time table,
+     * the others are what slice-by-8 needs.
+     */
+    struct crc16_tables
+    {
+      uint16_t tab[8][256];
+
+      crc16_tables()
+      {
+        for (int b = 0; b < 256; b++) {
+          uint16_t crc = b;
+          for (int k = 0; k < 8; k++)
+            crc = (crc & 1) ? (crc >> 1) ^ POLY_REFLECTED : crc >> 1;
+          tab[0][b] = crc;
+        }
+        for (int k = 1; k < 8; k++)
+          for (int b = 0; b < 256; b++)
+            tab[k][b] = (tab[k-1][b] >> 8) ^ tab[0][tab[k-1][b] & 0xFF];
+      }
+    };
+
+    static const crc16_tables &
+    tables()
+    {
+      static const crc16_tables t;
+      return t;
+    }
+
+    static uint16_t
+    crc_bitwise(const uint8_t *buf, size_t len, uint16_t crc)
+    {
+      for (size_t i = 0; i < len; i++) {
+        crc ^= buf[i];
+        for (int k = 0; k < 8; k++)
+          crc = (crc & 1) ? (crc >> 1) ^ POLY_REFLECTED : crc >> 1;
+      }
+      return crc;
+    }
+
+    static uint16_t
+    crc_table(const uint8_t *buf, size_t len, uint16_t crc)
+    {
+      const uint16_t *t = tables().tab[0];
+      for (size_t i = 0; i < len; i++)
+        crc = (crc >> 8) ^ t[(crc ^ buf[i]) & 0xFF];
+      return crc;
+    }
+
+    static uint16_t
+    crc_slice8(const uint8_t *buf, size_t len, uint16_t crc)
+    {
+      // Eight independent lookups per 8 bytes instead of a chain of eight
+      // dependent ones. Bytes are picked individually so this doesn't care
+      // about endianness.
+      const crc16_tables &t = tables();
+      for (; len >= 8; buf += 8, len -= 8) {
+        crc ^= buf[0] | (buf[1] << 8);
+        crc = t.tab[7][crc & 0xFF] ^ t.tab[6][crc >> 8] ^
+              t.tab[5][buf[2]] ^ t.tab[4][buf[3]] ^
+              t.tab[3][buf[4]] ^ t.tab[2][buf[5]] ^
+              t.tab[1][buf[6]] ^ t.tab[0][buf[7]];
+      }
+      return crc_table(buf, len, crc);
+    }
+
+    // Slice-by-8 that also copies, for frames that are assembled and
+    // checked in one go. The 8-byte memcpy is a single load and store.
+    static uint16_t
+    crc_slice8_copy(uint8_t *dst, const uint8_t *buf, size_t len, uint16_t crc)
+    {
+      const crc16_tables &t = tables();
+      for (; len >= 8; dst += 8, buf += 8, len -= 8) {
+        std::memcpy(dst, buf, 8);
+        crc ^= buf[0] | (buf[1] << 8);
+        crc = t.tab[7][crc & 0xFF] ^ t.tab[6][crc >> 8] ^
+              t.tab[5][buf[2]] ^ t.tab[4][buf[3]] ^
+              t.tab[3][buf[4]] ^ t.tab[2][buf[5]] ^
+              t.tab[1][buf[6]] ^ t.tab[0][buf[7]];
+      }
+      for (size_t i = 0; i < len; i++) {
+        dst[i] = buf[i];
+        crc = (crc >> 8) ^ t.tab[0][(crc ^ buf[i]) & 0xFF];
+      }
+      return crc;
+    }
+
+#ifdef ZLUUDGBEE_X86
+    /*
+     * Folding with carry-less multiplies, see Intel's "Fast CRC Computation
+     * for Generic Polynomials Using PCLMULQDQ Instruction".
+     *
+     * With the reflected bit order, bit p of a 128-bit register holds the
+     * coefficient of x^(127-p), so the low quadword is the high half H and
+     * the high quadword the low half L. Moving a 128-bit remainder D bits
+     * further down the message means multiplying it by x^D:
+     *
+     *   (H*x^64 + L) * x^D = H * x^(D+64) + L * x^D   (mod P)
+     *
+     * Both products are at most 64+16 bits long, so they fit in 128 bits
+     * and can be xored into the data D bits further on. The remainder is
+     * never reduced below 128 bits while folding; the last 16 bytes go
+     * through the table, which does the final reduction.
+     */
+    struct crc16_fold_consts
+    {
+      uint64_t k128_h, k128_l;
+      uint64_t k512_h, k512_l;
+
+      crc16_fold_consts()
+        : k128_h(fold_const(128 + 64)), k128_l(fold_const(128)),
+          k512_h(fold_const(512 + 64)), k512_l(fold_const(512))
+      {}
+
+      /*
+       * x^n mod P in the register layout above. The product of two
+       * reflected 64-bit operands comes out one bit short of the 128-bit
+       * layout, which is compensated by using x^(n-1) instead of x^n.
+       */
+      static uint64_t fold_const(unsigned n)
+      {
+        uint32_t r = 1;
+        for (unsigned i = 0; i < n - 1; i++) {
+          r <<= 1;
+          if (r & 0x10000)
+            r ^= POLY_NORMAL;
+        }
+        uint64_t k = 0;
+        for (int j = 0; j < 16; j++)
+          if (r & (1u << j))
+            k |= uint64_t(1) << (63 - j);
+        return k;
+      }
+    };
+
+    static const crc16_fold_consts &
+    fold_consts()
+    {
+      static const crc16_fold_consts k;
+      return k;
+    }
+
+    ZLUUDGBEE_TARGET("pclmul,sse2")
+    static inline __m128i
+    fold(__m128i x, __m128i k, __m128i next)
+    {
+      __m128i h = _mm_clmulepi64_si128(x, k, 0x00);
+      __m128i l = _mm_clmulepi64_si128(x, k, 0x11);
+      return _mm_xor_si128(_mm_xor_si128(h, l), next);
+    }
+
+    // Needs at least 64 bytes.
+    ZLUUDGBEE_TARGET("pclmul,sse2")
+    static uint16_t
+    crc_clmul(const uint8_t *buf, size_t len, uint16_t crc)
+    {
+      const crc16_fold_consts &c = fold_consts();
+      const __m128i k128 = _mm_set_epi64x(c.k128_l, c.k128_h);
+      const __m128i k512 = _mm_set_epi64x(c.k512_l, c.k512_h);
+      const __m128i *p = (const __m128i *) buf;
+
+      // Four independent streams hide the multiplier latency. The running
+      // CRC goes into the first two bytes of the message.
+      __m128i x0 = _mm_xor_si128(_mm_loadu_si128(p + 0), _mm_cvtsi32_si128(crc));
+      __m128i x1 = _mm_loadu_si128(p + 1);
+      __m128i x2 = _mm_loadu_si128(p + 2);
+      __m128i x3 = _mm_loadu_si128(p + 3);
+      p += 4;
+      len -= 64;
+
+      for (; len >= 64; p += 4, len -= 64) {
+        x0 = fold(x0, k512, _mm_loadu_si128(p + 0));
+        x1 = fold(x1, k512, _mm_loadu_si128(p + 1));
+        x2 = fold(x2, k512, _mm_loadu_si128(p + 2));
+        x3 = fold(x3, k512, _mm_loadu_si128(p + 3));
+      }
+
+      x0 = fold(x0, k128, x1);
+      x0 = fold(x0, k128, x2);
+      x0 = fold(x0, k128, x3);
+      for (; len >= 16; p++, len -= 16)
+        x0 = fold(x0, k128, _mm_loadu_si128(p));
+
+      uint8_t rem[16];
+      _mm_storeu_si128((__m128i *) rem, x0);
+      crc = crc_table(rem, 16, 0);
+      return crc_table((const uint8_t *) p, len, crc);
+    }
+#endif
+
+    static const size_t SLICE8_MIN_LEN = 16;
+    static const size_t CLMUL_MIN_LEN = 64;
+
+    static bool
+    use_clmul()
+    {
+      static const bool clmul = cpu_has_pclmul() && cpu_has_sse2();
+      return clmul;
+    }
+
+    crc16 &
+    crc16::update(uint8_t byte)
+    {
+      d_crc = (d_crc >> 8) ^ tables().tab[0][(d_crc ^ byte) & 0xFF];
+      return *this;
+    }
+
+    uint16_t
+    crc16::compute(const uint8_t *buf, size_t len, uint16_t crc)
+    {
+#ifdef ZLUUDGBEE_X86
+      if (len >= CLMUL_MIN_LEN && use_clmul())
+        return crc_clmul(buf, len, crc);
+#endif
+      if (len >= SLICE8_MIN_LEN)
+        return crc_slice8(buf, len, crc);
+      return crc_table(buf, len, crc);
+    }
+
+    uint16_t
+    crc16::compute_copy(uint8_t *dst, const uint8_t *src, size_t len, uint16_t crc)
+    {
+      return crc_slice8_copy(dst, src, len, crc);
+    }
+
+    uint16_t
+    crc16::compute(const uint8_t *buf, size_t len, uint16_t crc, impl_t impl)
+    {
+      switch (supported(impl) ? impl : IMPL_AUTO) {
+        case IMPL_BITWISE:
+          return crc_bitwise(buf, len, crc);
+        case IMPL_TABLE:
+          return crc_table(buf, len, crc);
+        case IMPL_SLICE8:
+          return crc_slice8(buf, len, crc);
+#ifdef ZLUUDGBEE_X86
+        case IMPL_CLMUL:
+          if (len >= CLMUL_MIN_LEN)
+            return crc_clmul(buf, len, crc);
+          return crc_slice8(buf, len, crc);
+#endif
+        default:
+          return compute(buf, len, crc);
+      }
+    }
+
+    bool
+    crc16::supported(impl_t impl)
+    {
+      if (impl == IMPL_CLMUL) {
+#ifdef ZLUUDGBEE_X86
+        return use_clmul();
+#else
+        return false;
+#endif
+      }
+      return true;
+    }
+
+  } // namespace zluudgbee
+} // namespace gr
@@ -0,0 +1,71 @@
+/* -*- c++ -*- */
+/* 
+ * Copyright 2019 Leon Fernandez (zluudg).
+ * 
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ * 
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <gnuradio/io_signature.h>
+#include "demapper_impl.h"
+#include "demapper_kernel.h"
+
+namespace gr {
+  namespace zluudgbee {
+
+    demapper::sptr
+    demapper::make(int crappy_threshold)
+    {
+      return gnuradio::get_initial_sptr(new demapper_impl(crappy_threshold));
+    }
+
+    /*
+     * The private constructor
+     */
+    demapper_impl::demapper_impl(int crappy_threshold)
+      : gr::sync_block("demapper",
+              gr::io_signature::make(1, 1, sizeof(uint32_t)),
+              gr::io_signature::make(1, 1, sizeof(uint8_t))),
+        d_crappy_threshold(crappy_threshold)
+    {
+    }
+
+    /*
+     * Our virtual destructor.
+     */
+    demapper_impl::~demapper_impl()
+    {
+    }
+
+    int
+    demapper_impl::work(int noutput_items,
+        gr_vector_const_void_star &input_items,
+        gr_vector_void_star &output_items)
+    {
+      const uint32_t *in = (const uint32_t *) input_items[0];
+      uint8_t *out = (uint8_t *) output_items[0];
+
+      demap_chips(in, noutput_items, uint32_t(d_crappy_threshold), out);
+
+      // Tell runtime system how many output items we produced.
+      return noutput_items;
+    }
+
+  } /* namespace zluudgbee */
+} /* namespace gr */
@@ -0,0 +1,49 @@
+/* -*- c++ -*- */
+/* 
+ * Copyright 2019 Leon Fernandez (zluudg).
+ * 
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ * 
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_ZLUUDGBEE_DEMAPPER_IMPL_H
+#define INCLUDED_ZLUUDGBEE_DEMAPPER_IMPL_H
+
+#include <zluudgbee/demapper.h>
+
+namespace gr {
+  namespace zluudgbee {
+
+    class demapper_impl : public demapper
+    {
+     private:
+      int d_crappy_threshold;
+
+     public:
+      demapper_impl(int crappy_threshold);
+      ~demapper_impl();
+
+      void set_crappy_threshold(int threshold) { d_crappy_threshold = threshold; }
+      int crappy_threshold() const { return d_crappy_threshold; }
+
+      int work(int noutput_items,
+         gr_vector_const_void_star &input_items,
+         gr_vector_void_star &output_items);
+    };
+
+  } // namespace zluudgbee
+} // namespace gr
+
+#endif /* INCLUDED_ZLUUDGBEE_DEMAPPER_IMPL_H */
@@ -0,0 +1,242 @@
+/* -*- c++ -*- */
+/* 
+ * Copyright 2019 Leon Fernandez (zluudg).
+ * 
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ * 
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "demapper_kernel.h"
+#include "cpu_features.h"
+#include "rx_model.h"
+
+#ifdef ZLUUDGBEE_X86
+#include <immintrin.h>
+#endif
+#ifdef ZLUUDGBEE_NEON
+#include <arm_neon.h>
+#endif
+
+namespace gr {
+  namespace zluudgbee {
+
+    static const int NSEQ = rx_demapper::NSEQ;
+    static const int GROUP = NSEQ / 4;     // sequences per first-level comparator
+    static const uint8_t CRAPPY = 0xF0;
+
+    void
+    demap_chips_generic(const uint32_t *chips, size_t n, uint32_t crappy_threshold, uint8_t *out)
+    {
+      for (size_t i = 0; i < n; i++) {
+        const uint32_t w = chips[i] & rx_demapper::CORR_MASK;
+        unsigned best = ~0u;
+        unsigned nibble = 0;
+
+        // Within a group the later sequence wins a tie, between groups
+        // the earlier group does.
+        for (int g = 0; g < NSEQ; g += GROUP) {
+          unsigned group_best = ~0u;
+          unsigned group_nibble = 0;
+          for (int j = g; j < g + GROUP; j++) {
+            const unsigned s = __builtin_popcount(w ^ (rx_demapper::CHIP_SEQUENCES[j] & rx_demapper::CORR_MASK));
+            if (s <= group_best) {
+              group_best = s;
+              group_nibble = j;
+            }
+          }
+          if (group_best < best) {
+            best = group_best;
+            nibble = group_nibble;
+          }
+        }
+
+        out[i] = nibble | (best < crappy_threshold ? 0 : CRAPPY);
+      }
+    }
+
+    /*
+     * The SIMD versions put one word in each 32-bit lane and walk the
+     * sequences in the same order as the scalar loop, so the ties come out
+     * the same.
+     */
+#ifdef ZLUUDGBEE_X86
+    ZLUUDGBEE_TARGET("avx2")
+    static inline __m256i
+    popcount32_avx2(__m256i v)
+    {
+      // Nibble lookup, then the four byte counts of each lane are summed
+      const __m256i lut = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+                                           0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+      const __m256i low = _mm256_set1_epi8(0x0F);
+      const __m256i cnt = _mm256_add_epi8(
+          _mm256_shuffle_epi8(lut, _mm256_and_si256(v, low)),
+          _mm256_shuffle_epi8(lut, _mm256_and_si256(_mm256_srli_epi16(v, 4), low)));
+      return _mm256_madd_epi16(_mm256_maddubs_epi16(cnt, _mm256_set1_epi8(1)),
+                               _mm256_set1_epi16(1));
+    }
+
+    ZLUUDGBEE_TARGET("avx2")
+    static size_t
+    demap_avx2(const uint32_t *chips, size_t n, uint32_t crappy_threshold, uint8_t *out)
+    {
+      const __m256i mask = _mm256_set1_epi32(rx_demapper::CORR_MASK);
+      const __m256i ones = _mm256_set1_epi32(-1);
+      const __m256i threshold = _mm256_set1_epi32(crappy_threshold < 32 ? crappy_threshold : 32);
+      const __m256i crappy = _mm256_set1_epi32(CRAPPY);
+      // Byte 0 of every lane to the bottom, then the two halves together
+      const __m256i narrow = _mm256_setr_epi8(0, 4, 8, 12, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+                                              0, 4, 8, 12, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+      const __m256i order = _mm256_setr_epi32(0, 4, 1, 1, 1, 1, 1, 1);
+      size_t i = 0;
+      for (; i + 8 <= n; i += 8) {
+        const __m256i w = _mm256_and_si256(_mm256_loadu_si256((const __m256i *) (chips + i)), mask);
+        __m256i best = _mm256_set1_epi32(0x7F);
+        __m256i nibble = _mm256_setzero_si256();
+
+        for (int g = 0; g < NSEQ; g += GROUP) {
+          __m256i group_best = _mm256_set1_epi32(0x7F);
+          __m256i group_nibble = _mm256_setzero_si256();
+          for (int j = g; j < g + GROUP; j++) {
+            const __m256i seq = _mm256_set1_epi32(rx_demapper::CHIP_SEQUENCES[j]);
+            const __m256i s = popcount32_avx2(_mm256_and_si256(_mm256_xor_si256(w, seq), mask));
+            const __m256i le = _mm256_xor_si256(_mm256_cmpgt_epi32(s, group_best), ones);
+            group_nibble = _mm256_blendv_epi8(group_nibble, _mm256_set1_epi32(j), le);
+            group_best = _mm256_min_epi32(group_best, s);
+          }
+          const __m256i lt = _mm256_cmpgt_epi32(best, group_best);
+          nibble = _mm256_blendv_epi8(nibble, group_nibble, lt);
+          best = _mm256_min_epi32(best, group_best);
+        }
+
+        const __m256i good = _mm256_cmpgt_epi32(threshold, best);
+        const __m256i v = _mm256_or_si256(nibble, _mm256_andnot_si256(good, crappy));
+        const __m256i packed = _mm256_permutevar8x32_epi32(_mm256_shuffle_epi8(v, narrow), order);
+        _mm_storel_epi64((__m128i *) (out + i), _mm256_castsi256_si128(packed));
+      }
+      return i;
+    }
+
+    ZLUUDGBEE_TARGET("avx512f,avx512vpopcntdq")
+    static size_t
+    demap_avx512(const uint32_t *chips, size_t n, uint32_t crappy_threshold, uint8_t *out)
+    {
+      const __m512i mask = _mm512_set1_epi32(rx_demapper::CORR_MASK);
+      const __m512i threshold = _mm512_set1_epi32(crappy_threshold);
+      const __m512i crappy = _mm512_set1_epi32(CRAPPY);
+      size_t i = 0;
+      for (; i + 16 <= n; i += 16) {
+        const __m512i w = _mm512_and_si512(_mm512_loadu_si512(chips + i), mask);
+        __m512i best = _mm512_set1_epi32(0x7F);
+        __m512i nibble = _mm512_setzero_si512();
+
+        for (int g = 0; g < NSEQ; g += GROUP) {
+          __m512i group_best = _mm512_set1_epi32(0x7F);
+          __m512i group_nibble = _mm512_setzero_si512();
+          for (int j = g; j < g + GROUP; j++) {
+            const __m512i seq = _mm512_set1_epi32(rx_demapper::CHIP_SEQUENCES[j]);
+            const __m512i s = _mm512_popcnt_epi32(_mm512_and_si512(_mm512_xor_si512(w, seq), mask));
+            const __mmask16 le = _mm512_cmple_epu32_mask(s, group_best);
+            group_nibble = _mm512_mask_mov_epi32(group_nibble, le, _mm512_set1_epi32(j));
+            group_best = _mm512_min_epu32(group_best, s);
+          }
+          const __mmask16 lt = _mm512_cmplt_epu32_mask(group_best, best);
+          nibble = _mm512_mask_mov_epi32(nibble, lt, group_nibble);
+          best = _mm512_min_epu32(best, group_best);
+        }
+
+        const __mmask16 bad = _mm512_cmpge_epu32_mask(best, threshold);
+        const __m512i v = _mm512_mask_or_epi32(nibble, bad, nibble, crappy);
+        _mm_storeu_si128((__m128i *) (out + i), _mm512_cvtepi32_epi8(v));
+      }
+      return i;
+    }
+#endif
+
+#ifdef ZLUUDGBEE_NEON
+    static inline void
+    demap4_neon(uint32x4_t w, uint32x4_t &best, uint32x4_t &nibble)
+    {
+      best = vdupq_n_u32(0x7F);
+      nibble = vdupq_n_u32(0);
+      for (int g = 0; g < NSEQ; g += GROUP) {
+        uint32x4_t group_best = vdupq_n_u32(0x7F);
+        uint32x4_t group_nibble = vdupq_n_u32(0);
+        for (int j = g; j < g + GROUP; j++) {
+          const uint32x4_t x = vandq_u32(veorq_u32(w, vdupq_n_u32(rx_demapper::CHIP_SEQUENCES[j])),
+                                         vdupq_n_u32(rx_demapper::CORR_MASK));
+          const uint32x4_t s = vpaddlq_u16(vpaddlq_u8(vcntq_u8(vreinterpretq_u8_u32(x))));
+          group_nibble = vbslq_u32(vcleq_u32(s, group_best), vdupq_n_u32(j), group_nibble);
+          group_best = vminq_u32(group_best, s);
+        }
+        nibble = vbslq_u32(vcltq_u32(group_best, best), group_nibble, nibble);
+        best = vminq_u32(best, group_best);
+      }
+    }
+
+    static size_t
+    demap_neon(const uint32_t *chips, size_t n, uint32_t crappy_threshold, uint8_t *out)
+    {
+      const uint32x4_t threshold = vdupq_n_u32(crappy_threshold);
+      const uint32x4_t crappy = vdupq_n_u32(CRAPPY);
+      size_t i = 0;
+      for (; i + 8 <= n; i += 8) {
+        uint32x4_t best_lo, nibble_lo, best_hi, nibble_hi;
+        demap4_neon(vld1q_u32(chips + i), best_lo, nibble_lo);
+        demap4_neon(vld1q_u32(chips + i + 4), best_hi, nibble_hi);
+        const uint32x4_t lo = vorrq_u32(nibble_lo, vandq_u32(vcgeq_u32(best_lo, threshold), crappy));
+        const uint32x4_t hi = vorrq_u32(nibble_hi, vandq_u32(vcgeq_u32(best_hi, threshold), crappy));
+        vst1_u8(out + i, vmovn_u16(vcombine_u16(vmovn_u32(lo), vmovn_u32(hi))));
+      }
+      return i;
+    }
+#endif
+
+    typedef size_t (*demap_fn)(const uint32_t *, size_t, uint32_t, uint8_t *);
+
+    static size_t
+    demap_none(const uint32_t *, size_t, uint32_t, uint8_t *)
+    {
+      return 0;
+    }
+
+    static demap_fn
+    pick_demap()
+    {
+#ifdef ZLUUDGBEE_X86
+      if (cpu_has_avx512_vpopcntdq())
+        return demap_avx512;
+      if (cpu_has_avx2())
+        return demap_avx2;
+#endif
+#ifdef ZLUUDGBEE_NEON
+      return demap_neon;
+#endif
+      return demap_none;
+    }
+
+    void
+    demap_chips(const uint32_t *chips, size_t n, uint32_t crappy_threshold, uint8_t *out)
+    {
+      static const demap_fn simd = pick_demap();
+      size_t done = simd(chips, n, crappy_threshold, out);
+      demap_chips_generic(chips + done, n - done, crappy_threshold, out + done);
+    }
+
+  } // namespace zluudgbee
+} // namespace gr
@@ -0,0 +1,52 @@
+/* -*- c++ -*- */
+/* 
+ * Copyright 2019 Leon Fernandez (zluudg).
+ * 
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ * 
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_ZLUUDGBEE_DEMAPPER_KERNEL_H
+#define INCLUDED_ZLUUDGBEE_DEMAPPER_KERNEL_H
+
+#include <cstddef>
+#include <stdint.h>
+
+namespace gr {
+  namespace zluudgbee {
+
+    /*
+     * zluudg_demapper over whole buffers. Each 32-chip word is scored
+     * against the 16 chip sequences by the Hamming distance of chips 30:0,
+     * and out[i] gets the nibble of the closest one. Ties are broken like
+     * the VHDL comparator tree does. Bits 7:4 are set when the lowest
+     * score isn't below crappy_threshold, same as the nibble that goes to
+     * zluudg_packager.
+     *
+     * The vector paths keep one word per 32-bit lane and visit the
+     * sequences in the same order as the comparator tree, so they break
+     * ties the same way. AVX-512 VPOPCNTDQ does 16 words at a time. AVX2
+     * does 8 and counts bits with a nibble lookup table. NEON does 8 with
+     * vcnt.
+     */
+    void demap_chips(const uint32_t *chips, size_t n, uint32_t crappy_threshold, uint8_t *out);
+
+    // One word at a time, with __builtin_popcount for the distances.
+    void demap_chips_generic(const uint32_t *chips, size_t n, uint32_t crappy_threshold, uint8_t *out);
+
+  } // namespace zluudgbee
+} // namespace gr
+
+#endif /* INCLUDED_ZLUUDGBEE_DEMAPPER_KERNEL_H */
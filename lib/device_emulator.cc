@@ -0,0 +1,245 @@
+/* -*- c++ -*- */
+/* 
+ * Copyright 2019 Leon Fernandez (zluudg).
+ * 
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ * 
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "device_emulator.h"
+#include <zluudgbee/crc16.h>
+#include <zluudgbee/mac_frame.h>
+#include <cstring>
+
+namespace gr {
+  namespace zluudgbee {
+
+    namespace {
+
+      const uint32_t NONE = 0xFFFFFFFF;
+      const unsigned MAX_POLLS = 4;
+
+      void
+      put_le(uint8_t *p, uint64_t x, int len)
+      {
+        for (int i = 0; i < len; i++)
+          p[i] = (x >> (8*i)) & 0xFF;
+      }
+
+    } // namespace
+
+    device_emulator::device_emulator(size_t devices, uint16_t pan_id, uint16_t coord_short,
+                                     size_t payload_len, double ack_loss,
+                                     uint64_t ext_base, uint32_t seed)
+      : d_devices(devices), d_by_short(0x10000, NONE),
+        d_pan_id(pan_id), d_coord_short(coord_short),
+        d_payload_len(payload_len < MAX_FRAME - 11 ? payload_len : MAX_FRAME - 11),
+        d_ack_loss(ack_loss <= 0.0 ? 0 : ack_loss >= 1.0 ? 0xFFFFFFFF
+                   : uint32_t(ack_loss * 4294967296.0)),
+        d_ext_base(ext_base), d_rng(seed ? seed : 1), d_next(0), d_associated(0),
+        d_beacon_requested(false)
+    {
+      std::memset(&d_stats, 0, sizeof(d_stats));
+      for (size_t i = 0; i < d_devices.size(); i++) {
+        d_devices[i].short_addr = 0xFFFE;
+        d_devices[i].state = IDLE;
+        d_devices[i].seq = i;
+        d_devices[i].polls = 0;
+        d_devices[i].poll_next = false;
+      }
+    }
+
+    size_t
+    device_emulator::next_frame(uint8_t *buf)
+    {
+      d_stats.frames_out++;
+
+      if (!d_acks.empty()) {
+        buf[0] = mac_frame_view::FRAME_ACK;
+        buf[1] = 0x00;
+        buf[2] = d_acks.back();
+        d_acks.pop_back();
+        d_stats.acks_sent++;
+        return 3;
+      }
+
+      // Someone scans first, the coordinator's answer is just counted
+      if (!d_beacon_requested) {
+        d_beacon_requested = true;
+        buf[0] = mac_frame_view::FRAME_COMMAND;
+        buf[1] = 0x08;
+        buf[2] = 0;
+        put_le(buf + 3, 0xFFFF, 2);
+        put_le(buf + 5, 0xFFFF, 2);
+        buf[7] = mac_frame_view::CMD_BEACON_REQUEST;
+        return 8;
+      }
+
+      if (d_devices.empty())
+        return 0;
+      const uint32_t dev = d_next;
+      d_next = d_next + 1 < d_devices.size() ? d_next + 1 : 0;
+
+      device &d = d_devices[dev];
+      switch (d.state) {
+      case IDLE:
+        d.state = REQUESTED;
+        d.polls = 0;
+        return assoc_request(buf, dev);
+      case REQUESTED:
+        if (++d.polls > MAX_POLLS)
+          d.state = IDLE;
+        return data_request(buf, dev);
+      default:
+        d.poll_next = !d.poll_next;
+        return d.poll_next ? data_request(buf, dev) : data_frame(buf, dev);
+      }
+    }
+
+    void
+    device_emulator::receive(const uint8_t *frame, size_t len)
+    {
+      d_stats.frames_in++;
+      if (len < 2 + mac_frame_view::FCS_LEN ||
+          crc16::compute(frame, len) != 0) {
+        d_stats.bad_fcs++;
+        return;
+      }
+
+      const mac_frame_view view(frame, len, true);
+      if (!view.valid())
+        return;
+
+      uint32_t dev = NONE;
+      switch (view.dst_addr_mode()) {
+      case mac_frame_view::ADDR_EXTENDED:
+        if (view.dst_addr() - d_ext_base < d_devices.size())
+          dev = view.dst_addr() - d_ext_base;
+        break;
+      case mac_frame_view::ADDR_SHORT:
+        dev = d_by_short[view.dst_addr()];
+        break;
+      default:
+        break;
+      }
+
+      if (view.frame_type() == mac_frame_view::FRAME_BEACON) {
+        d_stats.beacons++;
+        return;
+      }
+      if (dev == NONE || view.frame_type() == mac_frame_view::FRAME_ACK)
+        return;
+
+      if (view.ack_request()) {
+        if (d_ack_loss && random() < d_ack_loss)
+          d_stats.acks_dropped++;
+        else
+          d_acks.push_back(view.sequence_number());
+      }
+
+      device &d = d_devices[dev];
+      if (view.command_id() == mac_frame_view::CMD_ASSOCIATION_RESPONSE &&
+          view.payload_len() >= 4) {
+        // Retransmissions of a response that was already taken change nothing
+        if (d.state != REQUESTED)
+          return;
+        const uint8_t *p = view.payload();
+        if (p[3] == 0x00) {
+          d.short_addr = p[1] | (p[2] << 8);
+          d.state = ASSOCIATED;
+          d_by_short[d.short_addr] = dev;
+          d_associated++;
+          d_stats.associated++;
+        }
+        else {
+          d.state = IDLE;
+          d_stats.rejected++;
+        }
+      }
+      else if (view.frame_type() == mac_frame_view::FRAME_DATA)
+        d_stats.data_received++;
+    }
+
+    // xorshift32, plenty for picking which ACKs get lost
+    uint32_t
+    device_emulator::random()
+    {
+      d_rng ^= d_rng << 13;
+      d_rng ^= d_rng >> 17;
+      d_rng ^= d_rng << 5;
+      return d_rng;
+    }
+
+    // Command, ACK request, short coordinator address, extended source
+    // on the broadcast PAN
+    size_t
+    device_emulator::assoc_request(uint8_t *buf, uint32_t dev)
+    {
+      d_stats.assoc_requests++;
+      buf[0] = 0x23;
+      buf[1] = 0xC8;
+      buf[2] = d_devices[dev].seq++;
+      put_le(buf + 3, d_pan_id, 2);
+      put_le(buf + 5, d_coord_short, 2);
+      put_le(buf + 7, 0xFFFF, 2);
+      put_le(buf + 9, d_ext_base + dev, 8);
+      buf[17] = mac_frame_view::CMD_ASSOCIATION_REQUEST;
+      buf[18] = 0x80; // allocate address
+      return 19;
+    }
+
+    // Polls from the extended address until there is a short one
+    size_t
+    device_emulator::data_request(uint8_t *buf, uint32_t dev)
+    {
+      d_stats.data_requests++;
+      const device &d = d_devices[dev];
+      buf[0] = 0x63;
+      buf[2] = d_devices[dev].seq++;
+      put_le(buf + 3, d_pan_id, 2);
+      put_le(buf + 5, d_coord_short, 2);
+      if (d.state == ASSOCIATED) {
+        buf[1] = 0x88;
+        put_le(buf + 7, d.short_addr, 2);
+        buf[9] = mac_frame_view::CMD_DATA_REQUEST;
+        return 10;
+      }
+      buf[1] = 0xC8;
+      put_le(buf + 7, d_ext_base + dev, 8);
+      buf[15] = mac_frame_view::CMD_DATA_REQUEST;
+      return 16;
+    }
+
+    size_t
+    device_emulator::data_frame(uint8_t *buf, uint32_t dev)
+    {
+      d_stats.data_frames++;
+      buf[0] = 0x61;
+      buf[1] = 0x88;
+      buf[2] = d_devices[dev].seq++;
+      put_le(buf + 3, d_pan_id, 2);
+      put_le(buf + 5, d_coord_short, 2);
+      put_le(buf + 7, d_devices[dev].short_addr, 2);
+      for (size_t i = 0; i < d_payload_len; i++)
+        buf[9 + i] = random();
+      return 9 + d_payload_len;
+    }
+
+  } /* namespace zluudgbee */
+} /* namespace gr */
@@ -0,0 +1,116 @@
+/* -*- c++ -*- */
+/* 
+ * Copyright 2019 Leon Fernandez (zluudg).
+ * 
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ * 
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_ZLUUDGBEE_DEVICE_EMULATOR_H
+#define INCLUDED_ZLUUDGBEE_DEVICE_EMULATOR_H
+
+#include <cstddef>
+#include <vector>
+#include <stdint.h>
+
+namespace gr {
+  namespace zluudgbee {
+
+    /*
+     * A population of end devices joining a PAN and talking to its
+     * coordinator, for driving a coordinator without a radio. Devices
+     * take turns: each call to next_frame() gives the next frame of the
+     * next device, an association request, a data request polling for
+     * the response, then data frames alternating with polls once it has
+     * a short address. Devices that poll a few times without an answer
+     * ask again. Frames from the coordinator go into receive(),
+     * which ACKs what asks for it and moves devices along. ACKs can be
+     * dropped at random to exercise retransmissions.
+     *
+     * Device i has extended address ext_base + i, so nothing needs
+     * looking up on the way back.
+     */
+    class device_emulator
+    {
+     public:
+      struct counters
+      {
+        uint64_t frames_out;
+        uint64_t frames_in;
+        uint64_t assoc_requests;
+        uint64_t data_requests;
+        uint64_t data_frames;
+        uint64_t acks_sent;
+        uint64_t acks_dropped;
+        uint64_t associated;
+        uint64_t rejected;
+        uint64_t data_received;
+        uint64_t beacons;
+        uint64_t bad_fcs;
+      };
+
+      static const size_t MAX_FRAME = 127;
+
+      device_emulator(size_t devices, uint16_t pan_id, uint16_t coord_short,
+                      size_t payload_len = 32, double ack_loss = 0.0,
+                      uint64_t ext_base = 0x00124b0000000000ull, uint32_t seed = 1);
+
+      // Writes the next frame to buf without FCS and returns its length.
+      size_t next_frame(uint8_t *buf);
+      // A frame from the coordinator, FCS included.
+      void receive(const uint8_t *frame, size_t len);
+
+      size_t size() const { return d_devices.size(); }
+      size_t associated() const { return d_associated; }
+      const counters &stats() const { return d_stats; }
+
+     private:
+      enum state_t { IDLE, REQUESTED, ASSOCIATED };
+
+      struct device
+      {
+        uint16_t short_addr;
+        uint8_t state;
+        uint8_t seq;
+        uint8_t polls;                // unanswered, while REQUESTED
+        bool poll_next;
+      };
+
+      std::vector<device> d_devices;
+      std::vector<uint32_t> d_by_short;
+      const uint16_t d_pan_id;
+      const uint16_t d_coord_short;
+      const size_t d_payload_len;
+      const uint32_t d_ack_loss;      // out of 2^32
+      const uint64_t d_ext_base;
+      uint32_t d_rng;
+      size_t d_next;
+      size_t d_associated;
+      bool d_beacon_requested;
+      counters d_stats;
+
+      // ACKs owed to the coordinator, sent before anything else
+      std::vector<uint8_t> d_acks;
+
+      uint32_t random();
+      size_t assoc_request(uint8_t *buf, uint32_t dev);
+      size_t data_request(uint8_t *buf, uint32_t dev);
+      size_t data_frame(uint8_t *buf, uint32_t dev);
+    };
+
+  } // namespace zluudgbee
+} // namespace gr
+
+#endif /* INCLUDED_ZLUUDGBEE_DEVICE_EMULATOR_H */
@@ -0,0 +1,164 @@
+/* -*- c++ -*- */
+/* 
+ * Copyright 2019 Leon Fernandez (zluudg).
+ * 
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ * 
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <gnuradio/io_signature.h>
+#include <stdexcept>
+#include "device_population_impl.h"
+
+namespace gr {
+  namespace zluudgbee {
+
+    device_population::sptr
+    device_population::make(int devices, int pan_id, int coord_addr, double rate,
+                            int payload_len, double ack_loss, int seed)
+    {
+      return gnuradio::get_initial_sptr(
+        new device_population_impl(devices, pan_id, coord_addr, rate, payload_len,
+                                   ack_loss, seed)
+      );
+    }
+
+    /*
+     * The private constructor
+     */
+    device_population_impl::device_population_impl(int devices, int pan_id, int coord_addr,
+                                                   double rate, int payload_len,
+                                                   double ack_loss, int seed)
+      : gr::block("device_population",
+              gr::io_signature::make(0, 0, 0),
+              gr::io_signature::make(0, 0, 0)),
+        d_rate(rate),
+        d_emulator(devices > 0 ? devices : 0, pan_id, coord_addr,
+                   payload_len > 0 ? payload_len : 0, ack_loss,
+                   0x00124b0000000000ull, seed),
+        d_out_port(pmt::mp("pdu out")),
+        d_meta(pmt::make_dict())
+    {
+      if (devices <= 0 || rate <= 0)
+        throw std::invalid_argument("device_population: devices and rate must be positive");
+
+      message_port_register_in(pmt::mp("pdu in"));
+      set_msg_handler(pmt::mp("pdu in"), boost::bind(&device_population_impl::handle_pdu, this, _1));
+      message_port_register_out(d_out_port);
+    }
+
+    /*
+     * Our virtual destructor.
+     */
+    device_population_impl::~device_population_impl()
+    {
+    }
+
+    size_t
+    device_population_impl::associated() const
+    {
+      gr::thread::scoped_lock guard(d_mutex);
+      return d_emulator.associated();
+    }
+
+    pmt::pmt_t
+    device_population_impl::stats() const
+    {
+      device_emulator::counters s;
+      {
+        gr::thread::scoped_lock guard(d_mutex);
+        s = d_emulator.stats();
+      }
+
+      pmt::pmt_t d = pmt::make_dict();
+      d = pmt::dict_add(d, pmt::mp("frames_out"), pmt::from_uint64(s.frames_out));
+      d = pmt::dict_add(d, pmt::mp("frames_in"), pmt::from_uint64(s.frames_in));
+      d = pmt::dict_add(d, pmt::mp("assoc_requests"), pmt::from_uint64(s.assoc_requests));
+      d = pmt::dict_add(d, pmt::mp("data_requests"), pmt::from_uint64(s.data_requests));
+      d = pmt::dict_add(d, pmt::mp("data_frames"), pmt::from_uint64(s.data_frames));
+      d = pmt::dict_add(d, pmt::mp("acks_sent"), pmt::from_uint64(s.acks_sent));
+      d = pmt::dict_add(d, pmt::mp("acks_dropped"), pmt::from_uint64(s.acks_dropped));
+      d = pmt::dict_add(d, pmt::mp("associated"), pmt::from_uint64(s.associated));
+      d = pmt::dict_add(d, pmt::mp("rejected"), pmt::from_uint64(s.rejected));
+      d = pmt::dict_add(d, pmt::mp("data_received"), pmt::from_uint64(s.data_received));
+      d = pmt::dict_add(d, pmt::mp("beacons"), pmt::from_uint64(s.beacons));
+      d = pmt::dict_add(d, pmt::mp("bad_fcs"), pmt::from_uint64(s.bad_fcs));
+      return d;
+    }
+
+    void
+    device_population_impl::handle_pdu(pmt::pmt_t msg)
+    {
+      if (!pmt::is_pair(msg) || !pmt::is_u8vector(pmt::cdr(msg)))
+        return;
+      size_t len;
+      const uint8_t *frame = pmt::u8vector_elements(pmt::cdr(msg), len);
+
+      gr::thread::scoped_lock guard(d_mutex);
+      d_emulator.receive(frame, len);
+    }
+
+    // Sends a millisecond's worth of frames at a time, carrying the
+    // fraction of a frame over to the next tick
+    void
+    device_population_impl::run()
+    {
+      const boost::posix_time::milliseconds tick(1);
+      const double per_tick = d_rate / 1000.0;
+      double owed = 0.0;
+      uint8_t frame[device_emulator::MAX_FRAME];
+      try {
+        while (true) {
+          boost::this_thread::sleep(tick);
+
+          for (owed += per_tick; owed >= 1.0; owed -= 1.0) {
+            size_t len;
+            {
+              gr::thread::scoped_lock guard(d_mutex);
+              len = d_emulator.next_frame(frame);
+            }
+            message_port_pub(d_out_port, pmt::cons(d_meta, pmt::init_u8vector(len, frame)));
+          }
+        }
+      }
+      catch (boost::thread_interrupted &) {
+      }
+    }
+
+    bool
+    device_population_impl::start()
+    {
+      d_thread = boost::shared_ptr<gr::thread::thread>(
+        new gr::thread::thread(boost::bind(&device_population_impl::run, this)));
+      return block::start();
+    }
+
+    bool
+    device_population_impl::stop()
+    {
+      if (d_thread) {
+        d_thread->interrupt();
+        d_thread->join();
+        d_thread.reset();
+      }
+      return block::stop();
+    }
+
+  } /* namespace zluudgbee */
+} /* namespace gr */
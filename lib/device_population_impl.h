@@ -0,0 +1,61 @@
+/* -*- c++ -*- */
+/* 
+ * Copyright 2019 Leon Fernandez (zluudg).
+ * 
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ * 
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_ZLUUDGBEE_DEVICE_POPULATION_IMPL_H
+#define INCLUDED_ZLUUDGBEE_DEVICE_POPULATION_IMPL_H
+
+#include <zluudgbee/device_population.h>
+#include <gnuradio/thread/thread.h>
+#include <boost/shared_ptr.hpp>
+#include "device_emulator.h"
+
+namespace gr {
+  namespace zluudgbee {
+
+    class device_population_impl : public device_population
+    {
+     private:
+      const double d_rate;
+      mutable gr::thread::mutex d_mutex;
+      device_emulator d_emulator;
+      boost::shared_ptr<gr::thread::thread> d_thread;
+
+      const pmt::pmt_t d_out_port;
+      const pmt::pmt_t d_meta;
+
+      void handle_pdu(pmt::pmt_t msg);
+      void run();
+
+     public:
+      device_population_impl(int devices, int pan_id, int coord_addr, double rate,
+                             int payload_len, double ack_loss, int seed);
+      ~device_population_impl();
+
+      size_t associated() const;
+      pmt::pmt_t stats() const;
+
+      bool start();
+      bool stop();
+    };
+
+  } // namespace zluudgbee
+} // namespace gr
+
+#endif /* INCLUDED_ZLUUDGBEE_DEVICE_POPULATION_IMPL_H */
@@ -25,6 +25,10 @@
 #include <zluudgbee/dummycoord.h>
 #include <gnuradio/io_signature.h>
 #include <gnuradio/block_detail.h>
+#include <zluudgbee/mac_frame.h>
+#include <zluudgbee/metrics.h>
+#include <boost/format.hpp>
+#include "mac_templates.h"
 
 #include <iostream>
 #include <iomanip>
@@ -40,12 +44,17 @@ public:
     _pan_id(pan_id),
     _src_addr(src_addr),
     _short_addr_mode(short_addr_mode),
-    _epid(epid) {
+    _epid(epid),
+    _out_port(pmt::mp("pdu out")),
+    _meta(pmt::make_dict()),
+    _beacon(beacon_template(), BSN_OFFSET) {
 
 	  message_port_register_in(pmt::mp("pdu in"));
 	  set_msg_handler(pmt::mp("pdu in"), boost::bind(&dummycoord_impl::handle_pdu, this, _1));
 
-  	message_port_register_out(pmt::mp("pdu out"));
+  	message_port_register_out(_out_port);
+
+    _metrics = metrics::register_stage(str(boost::format("dummycoord%d") % unique_id()));
   }
 
   ~dummycoord_impl() {
@@ -53,143 +62,170 @@ public:
   }
 
   void handle_pdu(pmt::pmt_t msg) {
-	  pmt::pmt_t blob;
-
-	  if(pmt::is_pair(msg)) {
-		  blob = pmt::cdr(msg);
-	  } else {
-		  assert(false);
-	  }
-    size_t pdu_len = pmt::blob_length(blob);
-
-    uint8_t *pdu_ptr = (uint8_t *) pmt::blob_data(blob);
-    uint8_t frame_type = pdu_ptr[0] & FRAME_TYPE_MASK;
-
-    if (frame_type == BEACON_FRAME) {
-      handle_beacon_frame(blob);
-    }
-    else if (frame_type == DATA_FRAME) {
-      handle_data_frame(blob);
+    scoped_latency timer(_metrics->handler_latency);
+    const mac_frame_view frame(msg);
+    if (metrics::enabled()) {
+      _metrics->add(_metrics->frames_in);
+      _metrics->add(_metrics->bytes_in, frame.size());
     }
-    else if (frame_type == ACK_FRAME) {
-      handle_ack_frame(blob);
-    }
-    else if (frame_type == COMMAND_FRAME) {
-      handle_command_frame(blob);
+
+    if (!frame.valid()) {
+      if (metrics::enabled())
+        _metrics->add(_metrics->drops);
+      std::cout << "Malformed frame (" << mac_frame_view::status_name(frame.status())
+                << ")! Dropping frame..." << std::endl;
+      return;
     }
-    else // Some other frame type
+
+    // The ACK has the tightest deadline, so it goes out before anything else
+    if (frame.ack_request() && frame.frame_type() != mac_frame_view::FRAME_ACK &&
+        !frame.is_broadcast() && addressed_to_us(frame))
+      send_ack(frame.sequence_number());
+
+    switch (frame.frame_type()) {
+    case mac_frame_view::FRAME_BEACON:
+      handle_beacon_frame(frame);
+      break;
+    case mac_frame_view::FRAME_DATA:
+      handle_data_frame(frame);
+      break;
+    case mac_frame_view::FRAME_ACK:
+      handle_ack_frame(frame);
+      break;
+    case mac_frame_view::FRAME_COMMAND:
+      handle_command_frame(frame);
+      break;
+    default: // Some other frame type
+      if (metrics::enabled())
+        _metrics->add(_metrics->drops);
       std::cout << "Unrecognized frame type! Dropping frame..." << std::endl;
-    return;
+    }
   }
 
 
 private:
-  static const uint8_t FRAME_TYPE_MASK = 0x07;
-  static const uint8_t BEACON_FRAME = 0x00;
-  static const uint8_t DATA_FRAME = 0x01;
-  static const uint8_t ACK_FRAME = 0x02;
-  static const uint8_t COMMAND_FRAME = 0x03;
-  static const uint8_t BEACON_REQ_CMD = 0x07;
-
-  char _macBsn = 1;
+  static const size_t BSN_OFFSET = 2;
+
+  uint8_t _macBsn = 1;
   int _pan_id;
   long _src_addr;
   bool _short_addr_mode;
   long _epid;
+  const pmt::pmt_t _out_port;
+  const pmt::pmt_t _meta;
+  stage_metrics_sptr _metrics;
+
+  // The beacon only depends on the configuration, apart from the BSN
+  // and the FCS, which are patched in per beacon
+  const patched_frame _beacon;
+
+  /*
+   * Frames to our address, or to the broadcast address, on our PAN or
+   * the broadcast PAN. Frames without a destination are for the PAN
+   * coordinator, which is us, when they come from within our PAN.
+   */
+  bool addressed_to_us(const mac_frame_view &frame) const {
+    if (frame.dst_addr_mode() == mac_frame_view::ADDR_NONE)
+      return frame.src_pan_id() == (uint16_t) _pan_id;
+
+    if (frame.dst_pan_id() != (uint16_t) _pan_id && frame.dst_pan_id() != 0xFFFF)
+      return false;
+    if (frame.dst_addr_mode() == mac_frame_view::ADDR_SHORT)
+      return frame.is_broadcast() ||
+             (_short_addr_mode && frame.dst_addr() == (uint16_t) _src_addr);
+    return !_short_addr_mode && frame.dst_addr() == (uint64_t) _src_addr;
+  }
 
-  void handle_beacon_frame(pmt::pmt_t blob) {
+  void handle_beacon_frame(const mac_frame_view &frame) {
     std::cout << "Beacon frame received! But no handler has been implemented..." << std::endl;
   }
 
-  void handle_data_frame(pmt::pmt_t blob) {
+  void handle_data_frame(const mac_frame_view &frame) {
     std::cout << "Data frame received! But no handler has been implemented..." << std::endl;
   }
 
-  void handle_ack_frame(pmt::pmt_t blob) {
+  void handle_ack_frame(const mac_frame_view &frame) {
     std::cout << "ACK frame received! But no handler has been implemented..." << std::endl;
   }
 
-  void handle_command_frame(pmt::pmt_t blob) {
+  void handle_command_frame(const mac_frame_view &frame) {
     std::cout << "Command frame received! Attempting to handle..." << std::endl;
 
-    uint8_t *pdu_ptr = (uint8_t *) pmt::blob_data(blob);
-    uint8_t command_type = pdu_ptr[7];
+    if (frame.command_id() == mac_frame_view::CMD_BEACON_REQUEST) {
+      send_beacon();
+    }
+    else {
+      if (metrics::enabled())
+        _metrics->add(_metrics->drops);
+      std::cout << "Command " << frame.command_id()
+                << " not handled! Dropping frame..." << std::endl;
+    }
+  }
 
-    if (command_type = BEACON_REQ_CMD) {
-      std::vector<uint8_t> beacon;
-      int short_addr_mode_lim = (_short_addr_mode) ? 2 : 8;
+  std::vector<uint8_t> beacon_template() const {
+    std::vector<uint8_t> beacon;
+    int short_addr_mode_lim = (_short_addr_mode) ? 2 : 8;
 
-      // MHR field for beacons according to 802.15.4
-      beacon.push_back(0x00);
-      if (_short_addr_mode)
-        beacon.push_back(0x80); // Short addressing mode
-      else
-        beacon.push_back(0xc0); // Long addressing mode
+    // MHR field for beacons according to 802.15.4
+    beacon.push_back(0x00);
+    if (_short_addr_mode)
+      beacon.push_back(0x80); // Short addressing mode
+    else
+      beacon.push_back(0xc0); // Long addressing mode
 
-      // Sequence number field according to 802.15.4
-      beacon.push_back(_macBsn);
-      _macBsn++;
+    // Sequence number field according to 802.15.4, patched in per beacon
+    beacon.push_back(0x00);
 
-      // Source addressing fields, no destination needed for beacons
-      beacon.push_back((uint8_t) _pan_id & 0xFF);
-      beacon.push_back((uint8_t) (_pan_id >> 8) & 0xFF);
-      for (int i=0; i<short_addr_mode_lim; i++)
-        beacon.push_back((uint8_t) (_src_addr >> i*8) & 0xFF);
+    // Source addressing fields, no destination needed for beacons
+    beacon.push_back((uint8_t) _pan_id & 0xFF);
+    beacon.push_back((uint8_t) (_pan_id >> 8) & 0xFF);
+    for (int i=0; i<short_addr_mode_lim; i++)
+      beacon.push_back((uint8_t) (_src_addr >> i*8) & 0xFF);
 
-      // Superframe specification, TODO look into purpose of Final CAP slot field
-      beacon.push_back(0xFF); 
-      beacon.push_back(0xCF); 
+    // Superframe specification, TODO look into purpose of Final CAP slot field
+    beacon.push_back(0xFF); 
+    beacon.push_back(0xCF); 
 
-      // Guaranteed time slot configuration (there will be no guaranteed time slots)
-      beacon.push_back(0x00);
+    // Guaranteed time slot configuration (there will be no guaranteed time slots)
+    beacon.push_back(0x00);
 
-      // Pending address field, I have no idea what this field is for TODO find out
-      beacon.push_back(0x00);
+    // Pending address field, I have no idea what this field is for TODO find out
+    beacon.push_back(0x00);
 
-      // Zigbee specific beacon field
-      beacon.push_back(0x00); // protocol ID
-      beacon.push_back(0x20); // Stack profile TODO find out more
-      beacon.push_back(0x84); // Stack profile TODO find out more
-      for (int i=0; i<8; i++)
-        beacon.push_back((uint8_t) (_epid >> i*8) & 0xFF); // extended PAN ID
+    // Zigbee specific beacon field
+    beacon.push_back(0x00); // protocol ID
+    beacon.push_back(0x20); // Stack profile TODO find out more
+    beacon.push_back(0x84); // Stack profile TODO find out more
+    for (int i=0; i<8; i++)
+      beacon.push_back((uint8_t) (_epid >> i*8) & 0xFF); // extended PAN ID
 
-      beacon.push_back(0xFF); // TX offset TODO find out more
-      beacon.push_back(0xFF); // TX offset TODO find out more
-      beacon.push_back(0xFF); // TX offset TODO find out more
+    beacon.push_back(0xFF); // TX offset TODO find out more
+    beacon.push_back(0xFF); // TX offset TODO find out more
+    beacon.push_back(0xFF); // TX offset TODO find out more
 
-      beacon.push_back(0x00); // Update ID TODO find out more
+    beacon.push_back(0x00); // Update ID TODO find out more
 
-      pub_output(beacon);
-    }
+    return beacon;
+  }
+
+  void send_beacon() {
+    const size_t len = _beacon.size();
+    pmt::pmt_t vector = pmt::init_u8vector(len, _beacon.frame());
+    size_t out_len;
+    _beacon.patch(pmt::u8vector_writable_elements(vector, out_len), _macBsn++);
+    publish(vector, len);
   }
 
-  void pub_output(std::vector<uint8_t>& bytes) {
-      int len = (int) bytes.size();
-      uint16_t crc = crc16(&bytes[0], len);
-      bytes.push_back(crc & 0xFF);
-      bytes.push_back((crc >> 8) & 0xFF);
-      len = (int) bytes.size();
-      pmt::pmt_t vector = pmt::init_u8vector(len, &bytes[0]);
-      pmt::pmt_t pdu = pmt::cons(pmt::make_dict(), vector);
-      message_port_pub(pmt::mp("pdu out"), pdu);
+  void send_ack(uint8_t seq) {
+    publish(pmt::init_u8vector(IMM_ACK_LEN, immediate_ack(seq)), IMM_ACK_LEN);
   }
 
-  uint16_t crc16(uint8_t *buf, int len) {
-	  uint16_t crc = 0;
-
-	  for(int i = 0; i < len; i++) {
-		  for(int k = 0; k < 8; k++) {
-			  int input_bit = (!!(buf[i] & (1 << k)) ^ (crc & 1));
-			  crc = crc >> 1;
-			  if(input_bit) {
-				  crc ^= (1 << 15);
-				  crc ^= (1 << 10);
-				  crc ^= (1 <<  3);
-			  }
-		  }
-	  }
-
-	  return crc;
+  void publish(const pmt::pmt_t &vector, size_t len) {
+    message_port_pub(_out_port, pmt::cons(_meta, vector));
+    if (metrics::enabled()) {
+      _metrics->add(_metrics->frames_out);
+      _metrics->add(_metrics->bytes_out, len);
+    }
   }
 
 };
@@ -0,0 +1,94 @@
+/* -*- c++ -*- */
+/* 
+ * Copyright 2019 Leon Fernandez (zluudg).
+ * 
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ * 
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "mac_templates.h"
+#include <zluudgbee/crc16.h>
+#include <zluudgbee/mac_frame.h>
+
+namespace gr {
+  namespace zluudgbee {
+
+    patched_frame::patched_frame(const std::vector<uint8_t> &mpdu, size_t offset)
+      : d_frame(mpdu), d_offset(offset)
+    {
+      d_frame[d_offset] = 0;
+      d_fcs = crc16::compute(&d_frame[0], d_frame.size());
+      d_frame.push_back(d_fcs & 0xFF);
+      d_frame.push_back((d_fcs >> 8) & 0xFF);
+
+      std::vector<uint8_t> probe(mpdu.size(), 0);
+      uint16_t bit_delta[8];
+      for (int k = 0; k < 8; k++) {
+        probe[d_offset] = 1 << k;
+        bit_delta[k] = crc16::compute(&probe[0], probe.size());
+      }
+      for (int value = 0; value < 256; value++) {
+        d_fcs_delta[value] = 0;
+        for (int k = 0; k < 8; k++)
+          if (value & (1 << k))
+            d_fcs_delta[value] ^= bit_delta[k];
+      }
+    }
+
+    void
+    patched_frame::patch(uint8_t *frame, uint8_t value) const
+    {
+      const size_t len = d_frame.size();
+      const uint16_t fcs = d_fcs ^ d_fcs_delta[value];
+      frame[d_offset] = value;
+      frame[len - FCS_LEN] = fcs & 0xFF;
+      frame[len - FCS_LEN + 1] = (fcs >> 8) & 0xFF;
+    }
+
+    namespace {
+
+      struct ack_frames
+      {
+        uint8_t frame[256][IMM_ACK_LEN];
+
+        ack_frames()
+        {
+          for (int seq = 0; seq < 256; seq++) {
+            uint8_t *ack = frame[seq];
+            ack[0] = mac_frame_view::FRAME_ACK;
+            ack[1] = 0x00;
+            ack[2] = seq;
+            const uint16_t crc = crc16::compute(ack, IMM_ACK_LEN - patched_frame::FCS_LEN);
+            ack[3] = crc & 0xFF;
+            ack[4] = (crc >> 8) & 0xFF;
+          }
+        }
+      };
+
+    } // namespace
+
+    const uint8_t *
+    immediate_ack(uint8_t seq)
+    {
+      static const ack_frames table;
+      return table.frame[seq];
+    }
+
+  } /* namespace zluudgbee */
+} /* namespace gr */
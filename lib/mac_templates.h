@@ -0,0 +1,68 @@
+/* -*- c++ -*- */
+/* 
+ * Copyright 2019 Leon Fernandez (zluudg).
+ * 
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ * 
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_ZLUUDGBEE_MAC_TEMPLATES_H
+#define INCLUDED_ZLUUDGBEE_MAC_TEMPLATES_H
+
+#include <cstddef>
+#include <vector>
+#include <stdint.h>
+
+namespace gr {
+  namespace zluudgbee {
+
+    /*
+     * A frame that only changes in one byte from one transmission to the
+     * next, like a beacon in its BSN. It is kept with that byte at zero,
+     * and the FCS of every other value follows from the CRC being linear:
+     * the bits that change when the byte goes from 0 to b are the CRC of
+     * b at that offset in an all-zero frame of the same length.
+     */
+    class patched_frame
+    {
+     public:
+      static const size_t FCS_LEN = 2;
+
+      // mpdu comes without FCS
+      patched_frame(const std::vector<uint8_t> &mpdu, size_t offset);
+
+      // With zero at the offset and the FCS appended
+      const uint8_t *frame() const { return &d_frame[0]; }
+      size_t size() const { return d_frame.size(); }
+
+      // Sets the byte at the offset of a copy of frame() and fixes its FCS
+      void patch(uint8_t *frame, uint8_t value) const;
+
+     private:
+      std::vector<uint8_t> d_frame;
+      size_t d_offset;
+      uint16_t d_fcs;
+      uint16_t d_fcs_delta[256];
+    };
+
+    static const size_t IMM_ACK_LEN = 5;
+
+    // The immediate ACK without frame pending for seq, FCS included
+    const uint8_t *immediate_ack(uint8_t seq);
+
+  } // namespace zluudgbee
+} // namespace gr
+
+#endif /* INCLUDED_ZLUUDGBEE_MAC_TEMPLATES_H */
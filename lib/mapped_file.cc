@@ -0,0 +1,129 @@
+/* -*- c++ -*- */
+/* 
+ * Copyright 2019 Leon Fernandez (zluudg).
+ * 
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ * 
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "mapped_file.h"
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace gr {
+  namespace zluudgbee {
+
+    mapped_file::mapped_file(const std::string &path)
+      : d_data(0), d_size(0)
+    {
+      open(path);
+    }
+
+    mapped_file::~mapped_file()
+    {
+      close();
+    }
+
+    void
+    mapped_file::open(const std::string &path)
+    {
+      close();
+
+      const int fd = ::open(path.c_str(), O_RDONLY);
+      if (fd < 0)
+        throw std::runtime_error("can't open " + path + ": " + std::strerror(errno));
+
+      struct stat st;
+      if (fstat(fd, &st) < 0) {
+        const int err = errno;
+        ::close(fd);
+        throw std::runtime_error("can't stat " + path + ": " + std::strerror(err));
+      }
+
+      // An empty file can't be mapped, but it is a perfectly good empty view
+      if (st.st_size > 0) {
+        void *p = mmap(0, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (p == MAP_FAILED) {
+          const int err = errno;
+          ::close(fd);
+          throw std::runtime_error("can't map " + path + ": " + std::strerror(err));
+        }
+        madvise(p, st.st_size, MADV_SEQUENTIAL);
+        d_data = static_cast<const uint8_t *>(p);
+        d_size = st.st_size;
+      }
+
+      // The mapping keeps the file referenced on its own
+      ::close(fd);
+      d_path = path;
+    }
+
+    void
+    mapped_file::close()
+    {
+      if (d_data)
+        munmap(const_cast<uint8_t *>(d_data), d_size);
+      d_data = 0;
+      d_size = 0;
+      d_path.clear();
+    }
+
+    bool
+    mapped_file::advise(size_t offset, size_t len, access_t access) const
+    {
+      if (!d_data || offset >= d_size)
+        return false;
+      if (len > d_size - offset)
+        len = d_size - offset;
+
+      const size_t page = sysconf(_SC_PAGESIZE);
+      const size_t begin = offset & ~(page - 1);
+      len += offset - begin;
+
+      int advice;
+      switch (access) {
+      case ACCESS_SEQUENTIAL:
+        advice = MADV_SEQUENTIAL;
+        break;
+      case ACCESS_WILLNEED:
+        advice = MADV_WILLNEED;
+        break;
+      case ACCESS_DONTNEED:
+        advice = MADV_DONTNEED;
+        break;
+      case ACCESS_HUGEPAGE:
+#ifdef MADV_HUGEPAGE
+        advice = MADV_HUGEPAGE;
+        break;
+#else
+        return false;
+#endif
+      default:
+        return false;
+      }
+      return madvise(const_cast<uint8_t *>(d_data) + begin, len, advice) == 0;
+    }
+
+  } /* namespace zluudgbee */
+} /* namespace gr */
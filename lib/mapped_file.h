@@ -0,0 +1,78 @@
+/* -*- c++ -*- */
+/* 
+ * Copyright 2019 Leon Fernandez (zluudg).
+ * 
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ * 
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_ZLUUDGBEE_MAPPED_FILE_H
+#define INCLUDED_ZLUUDGBEE_MAPPED_FILE_H
+
+#include <cstddef>
+#include <string>
+#include <stdint.h>
+
+namespace gr {
+  namespace zluudgbee {
+
+    /*
+     * A whole file mapped read-only into memory. Pages are read in by the
+     * kernel as they are touched, so opening a recording of any size is
+     * cheap and replaying it costs no read() calls or copies into user
+     * buffers. Throws std::runtime_error if the file can't be mapped.
+     */
+    class mapped_file
+    {
+     public:
+      // How a range is going to be read, see madvise(2)
+      enum access_t {
+        ACCESS_SEQUENTIAL,            // aggressive readahead, the default
+        ACCESS_WILLNEED,              // start reading it in now
+        ACCESS_DONTNEED,              // done with it, let the pages go
+        ACCESS_HUGEPAGE               // back it with huge pages if the kernel can
+      };
+
+      mapped_file() : d_data(0), d_size(0) {}
+      explicit mapped_file(const std::string &path);
+      ~mapped_file();
+
+      void open(const std::string &path);
+      void close();
+
+      const uint8_t *data() const { return d_data; }
+      size_t size() const { return d_size; }
+      const std::string &path() const { return d_path; }
+
+      /*
+       * Hints the kernel about len bytes from offset, widened to whole
+       * pages and clipped to the file. Only a hint: returns false if the
+       * kernel wouldn't take it, which changes nothing but speed.
+       */
+      bool advise(size_t offset, size_t len, access_t access) const;
+
+     private:
+      const uint8_t *d_data;
+      size_t d_size;
+      std::string d_path;
+
+      mapped_file(const mapped_file &);
+      mapped_file &operator=(const mapped_file &);
+    };
+
+  } // namespace zluudgbee
+} // namespace gr
+
+#endif /* INCLUDED_ZLUUDGBEE_MAPPED_FILE_H */
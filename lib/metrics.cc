@@ -0,0 +1,234 @@
+/* -*- c++ -*- */
+/* 
+ * Copyright 2019 Leon Fernandez (zluudg).
+ * 
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ * 
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <zluudgbee/metrics.h>
+#include <gnuradio/thread/thread.h>
+#include <boost/format.hpp>
+#include <boost/weak_ptr.hpp>
+#include <cstdlib>
+
+namespace gr {
+  namespace zluudgbee {
+
+    latency_histogram::latency_histogram()
+      : d_count(0),
+        d_sum(0),
+        d_max(0)
+    {
+      for (int i = 0; i < NBUCKETS; i++)
+        d_buckets[i].store(0, std::memory_order_relaxed);
+    }
+
+    int
+    latency_histogram::bucket(uint64_t ns)
+    {
+      if (ns < uint64_t(SUB_BUCKETS))
+        return int(ns);
+      int e = 63 - __builtin_clzll(ns);
+      if (e > MAX_EXP)
+        return NBUCKETS - 1;
+      const int m = int(ns >> (e - SUB_BITS)) & (SUB_BUCKETS - 1);
+      return (e - SUB_BITS + 1) * SUB_BUCKETS + m;
+    }
+
+    uint64_t
+    latency_histogram::lower_bound(int bucket)
+    {
+      if (bucket < SUB_BUCKETS)
+        return bucket;
+      const int e = bucket / SUB_BUCKETS + SUB_BITS - 1;
+      const uint64_t m = bucket % SUB_BUCKETS;
+      return (SUB_BUCKETS + m) << (e - SUB_BITS);
+    }
+
+    double
+    latency_histogram::mean() const
+    {
+      const uint64_t n = count();
+      return n ? double(d_sum.load(std::memory_order_relaxed)) / n : 0.0;
+    }
+
+    uint64_t
+    latency_histogram::percentile(double p) const
+    {
+      const std::vector<uint64_t> counts = buckets();
+      uint64_t total = 0;
+      for (int i = 0; i < NBUCKETS; i++)
+        total += counts[i];
+      if (!total)
+        return 0;
+
+      const uint64_t wanted = uint64_t(p * total + 0.5);
+      uint64_t seen = 0;
+      for (int i = 0; i < NBUCKETS; i++) {
+        seen += counts[i];
+        if (seen && seen >= wanted)
+          return lower_bound(i);
+      }
+      return lower_bound(NBUCKETS - 1);
+    }
+
+    std::vector<uint64_t>
+    latency_histogram::buckets() const
+    {
+      std::vector<uint64_t> counts(NBUCKETS);
+      for (int i = 0; i < NBUCKETS; i++)
+        counts[i] = d_buckets[i].load(std::memory_order_relaxed);
+      return counts;
+    }
+
+    stage_metrics::stage_metrics(const std::string &stage_name)
+      : name(stage_name),
+        frames_in(0),
+        frames_out(0),
+        bytes_in(0),
+        bytes_out(0),
+        drops(0),
+        crc_failures(0)
+    {
+    }
+
+    std::atomic<bool> metrics::s_enabled(std::getenv("ZLUUDGBEE_METRICS") != NULL);
+
+    // Registration is rare, so a lock is fine there
+    static gr::thread::mutex &
+    registry_mutex()
+    {
+      static gr::thread::mutex mutex;
+      return mutex;
+    }
+
+    static std::vector<boost::weak_ptr<stage_metrics> > &
+    registry()
+    {
+      static std::vector<boost::weak_ptr<stage_metrics> > stages;
+      return stages;
+    }
+
+    // Forgets blocks that are gone, call with the lock held
+    static void
+    prune(std::vector<stage_metrics_sptr> *live)
+    {
+      std::vector<boost::weak_ptr<stage_metrics> > &stages = registry();
+      size_t kept = 0;
+      for (size_t i = 0; i < stages.size(); i++) {
+        stage_metrics_sptr stage = stages[i].lock();
+        if (!stage)
+          continue;
+        if (live)
+          live->push_back(stage);
+        stages[kept++] = stages[i];
+      }
+      stages.resize(kept);
+    }
+
+    void
+    metrics::set_enabled(bool enable)
+    {
+      s_enabled.store(enable, std::memory_order_relaxed);
+    }
+
+    stage_metrics_sptr
+    metrics::register_stage(const std::string &name)
+    {
+      gr::thread::scoped_lock guard(registry_mutex());
+      std::vector<stage_metrics_sptr> live;
+      prune(&live);
+
+      std::string unique = name;
+      for (int n = 1; ; n++) {
+        bool taken = false;
+        for (size_t i = 0; i < live.size() && !taken; i++)
+          taken = live[i]->name == unique;
+        if (!taken)
+          break;
+        unique = str(boost::format("%s_%d") % name % n);
+      }
+
+      stage_metrics_sptr stage(new stage_metrics(unique));
+      registry().push_back(stage);
+      return stage;
+    }
+
+    std::vector<stage_metrics_sptr>
+    metrics::stages()
+    {
+      gr::thread::scoped_lock guard(registry_mutex());
+      std::vector<stage_metrics_sptr> live;
+      prune(&live);
+      return live;
+    }
+
+    uint64_t
+    metrics::ticks_to_ns(gr::high_res_timer_type ticks)
+    {
+      static const double scale = 1e9 / gr::high_res_timer_tps();
+      return ticks > 0 ? uint64_t(ticks * scale) : 0;
+    }
+
+    static pmt::pmt_t
+    counter(const std::atomic<uint64_t> &c)
+    {
+      return pmt::from_uint64(c.load(std::memory_order_relaxed));
+    }
+
+    static pmt::pmt_t
+    histogram_to_pmt(const latency_histogram &h)
+    {
+      const std::vector<uint64_t> buckets = h.buckets();
+      pmt::pmt_t d = pmt::make_dict();
+      d = pmt::dict_add(d, pmt::mp("count"), pmt::from_uint64(h.count()));
+      d = pmt::dict_add(d, pmt::mp("mean_ns"), pmt::from_double(h.mean()));
+      d = pmt::dict_add(d, pmt::mp("p50_ns"), pmt::from_uint64(h.percentile(0.50)));
+      d = pmt::dict_add(d, pmt::mp("p90_ns"), pmt::from_uint64(h.percentile(0.90)));
+      d = pmt::dict_add(d, pmt::mp("p99_ns"), pmt::from_uint64(h.percentile(0.99)));
+      d = pmt::dict_add(d, pmt::mp("max_ns"), pmt::from_uint64(h.max()));
+      d = pmt::dict_add(d, pmt::mp("buckets"), pmt::init_u64vector(buckets.size(), &buckets[0]));
+      return d;
+    }
+
+    pmt::pmt_t
+    metrics::to_pmt()
+    {
+      const std::vector<stage_metrics_sptr> live = stages();
+      pmt::pmt_t all = pmt::make_dict();
+      for (size_t i = 0; i < live.size(); i++) {
+        const stage_metrics &s = *live[i];
+        pmt::pmt_t d = pmt::make_dict();
+        d = pmt::dict_add(d, pmt::mp("frames_in"), counter(s.frames_in));
+        d = pmt::dict_add(d, pmt::mp("frames_out"), counter(s.frames_out));
+        d = pmt::dict_add(d, pmt::mp("bytes_in"), counter(s.bytes_in));
+        d = pmt::dict_add(d, pmt::mp("bytes_out"), counter(s.bytes_out));
+        d = pmt::dict_add(d, pmt::mp("drops"), counter(s.drops));
+        d = pmt::dict_add(d, pmt::mp("crc_failures"), counter(s.crc_failures));
+        d = pmt::dict_add(d, pmt::mp("handler_latency"), histogram_to_pmt(s.handler_latency));
+        d = pmt::dict_add(d, pmt::mp("recv_wait"), histogram_to_pmt(s.recv_wait));
+        d = pmt::dict_add(d, pmt::mp("sched_latency"), histogram_to_pmt(s.sched_latency));
+        all = pmt::dict_add(all, pmt::mp(s.name), d);
+      }
+      return all;
+    }
+
+  } // namespace zluudgbee
+} // namespace gr
@@ -0,0 +1,92 @@
+/* -*- c++ -*- */
+/* 
+ * Copyright 2019 Leon Fernandez (zluudg).
+ * 
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ * 
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <gnuradio/io_signature.h>
+#include <zluudgbee/metrics.h>
+#include <boost/bind.hpp>
+#include <stdexcept>
+#include "metrics_probe_impl.h"
+
+namespace gr {
+  namespace zluudgbee {
+
+    metrics_probe::sptr
+    metrics_probe::make(bool enable)
+    {
+      return gnuradio::get_initial_sptr(
+        new metrics_probe_impl(enable)
+      );
+    }
+
+    /*
+     * The private constructor
+     */
+    metrics_probe_impl::metrics_probe_impl(bool enable)
+      : gr::block("metrics_probe",
+              gr::io_signature::make(0, 0, 0),
+              gr::io_signature::make(0, 0, 0)),
+        d_port(pmt::mp("metrics")),
+        d_enable_key(pmt::mp("enable"))
+    {
+      if (enable)
+        metrics::set_enabled(true);
+
+      message_port_register_out(d_port);
+      message_port_register_in(pmt::mp("get"));
+      set_msg_handler(pmt::mp("get"), boost::bind(&metrics_probe_impl::handle_get, this, _1));
+    }
+
+    /*
+     * Our virtual destructor.
+     */
+    metrics_probe_impl::~metrics_probe_impl()
+    {
+    }
+
+    pmt::pmt_t
+    metrics_probe_impl::snapshot() const
+    {
+      return metrics::to_pmt();
+    }
+
+    void
+    metrics_probe_impl::handle_get(pmt::pmt_t msg)
+    {
+      // Anything but a dict with a boolean "enable" is just a request.
+      // PDUs pass is_dict() too, and then trip up dict_ref().
+      if (pmt::is_dict(msg)) {
+        try {
+          const pmt::pmt_t enable = pmt::dict_ref(msg, d_enable_key, pmt::PMT_NIL);
+          if (pmt::is_bool(enable))
+            metrics::set_enabled(pmt::to_bool(enable));
+        }
+        catch (std::exception &) {
+        }
+      }
+
+      message_port_pub(d_port, snapshot());
+    }
+
+  } /* namespace zluudgbee */
+} /* namespace gr */
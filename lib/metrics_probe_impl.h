@@ -0,0 +1,47 @@
+/* -*- c++ -*- */
+/* 
+ * Copyright 2019 Leon Fernandez (zluudg).
+ * 
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ * 
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_ZLUUDGBEE_METRICS_PROBE_IMPL_H
+#define INCLUDED_ZLUUDGBEE_METRICS_PROBE_IMPL_H
+
+#include <zluudgbee/metrics_probe.h>
+
+namespace gr {
+  namespace zluudgbee {
+
+    class metrics_probe_impl : public metrics_probe
+    {
+     private:
+      const pmt::pmt_t d_port;
+      const pmt::pmt_t d_enable_key;
+
+      void handle_get(pmt::pmt_t msg);
+
+     public:
+      metrics_probe_impl(bool enable);
+      ~metrics_probe_impl();
+
+      pmt::pmt_t snapshot() const;
+    };
+
+  } // namespace zluudgbee
+} // namespace gr
+
+#endif /* INCLUDED_ZLUUDGBEE_METRICS_PROBE_IMPL_H */
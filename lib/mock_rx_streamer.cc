@@ -0,0 +1,305 @@
+/* -*- c++ -*- */
+/* 
+ * Copyright 2019 Leon Fernandez (zluudg).
+ * 
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ * 
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "mock_rx_streamer.h"
+#include "chdr_unpack.h"
+#include <zluudgbee/crc16.h>
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+namespace gr {
+  namespace zluudgbee {
+
+    namespace {
+
+      const char RECORDING_MAGIC[8] = { 'Z', 'G', 'C', 'H', 'D', 'R', '0', '1' };
+      const size_t LEN_SIZE = 4;
+
+    } // namespace
+
+    void
+    chdr_pack_frame(const uint8_t *psdu, size_t len, bool crc_checked,
+                    std::vector<uint8_t> &items)
+    {
+      const size_t start = items.size();
+      items.resize(start + len * CHDR_ITEM_SIZE, 0);
+      uint8_t *item = &items[start];
+      for (size_t i = 0; i < len; i++, item += CHDR_ITEM_SIZE) {
+        item[CHDR_BYTE_LANE] = psdu[i];
+        item[CHDR_FLAG_LANE] = CHDR_FLAG_ACTIVE;
+      }
+      if (len) {
+        uint8_t &last = items[items.size() - CHDR_ITEM_SIZE + CHDR_FLAG_LANE];
+        last |= CHDR_FLAG_ENDFRAME;
+        if (crc_checked) {
+          last |= CHDR_FLAG_CRC_CHECKED;
+          if (len < 2 || crc16::compute(psdu, len))
+            last |= CHDR_FLAG_CORRUPTED;
+        }
+      }
+    }
+
+    void
+    write_chdr_recording(const std::string &path,
+                         const std::vector<std::vector<uint8_t> > &bursts)
+    {
+      std::ofstream out(path.c_str(), std::ios::binary);
+      if (!out)
+        throw std::runtime_error("can't create " + path);
+      out.write(RECORDING_MAGIC, sizeof(RECORDING_MAGIC));
+      for (size_t b = 0; b < bursts.size(); b++) {
+        const uint32_t nitems = bursts[b].size() / CHDR_ITEM_SIZE;
+        const char len[LEN_SIZE] = { char(nitems), char(nitems >> 8),
+                                     char(nitems >> 16), char(nitems >> 24) };
+        out.write(len, LEN_SIZE);
+        out.write((const char *) bursts[b].data(), nitems * CHDR_ITEM_SIZE);
+      }
+      if (!out.flush())
+        throw std::runtime_error("can't write " + path);
+    }
+
+    mock_rx_streamer::mock_rx_streamer(const std::vector<std::vector<uint8_t> > &bursts,
+                                       const options &opts)
+      : d_opts(opts), d_max_burst(0), d_streaming(false), d_eob_pending(false), d_next(0), d_offset(0),
+        d_loop(0), d_calls(0), d_bursts_sent(0), d_items_sent(0), d_overflows(0),
+        d_timeouts(0), d_epoch(0)
+    {
+      // One copy of all of them, so the caller's bursts can go away
+      for (size_t b = 0; b < bursts.size(); b++)
+        d_owned.insert(d_owned.end(), bursts[b].begin(),
+                       bursts[b].begin() + bursts[b].size() / CHDR_ITEM_SIZE * CHDR_ITEM_SIZE);
+      size_t offset = 0;
+      for (size_t b = 0; b < bursts.size(); b++) {
+        const size_t len = bursts[b].size() / CHDR_ITEM_SIZE;
+        if (!len)
+          continue;
+        burst x = { &d_owned[offset], len };
+        d_bursts.push_back(x);
+        d_max_burst = std::max(d_max_burst, len);
+        offset += len * CHDR_ITEM_SIZE;
+      }
+    }
+
+    mock_rx_streamer::mock_rx_streamer(const std::string &recording, const options &opts)
+      : d_opts(opts), d_file(recording), d_max_burst(0), d_streaming(false), d_eob_pending(false), d_next(0),
+        d_offset(0), d_loop(0), d_calls(0), d_bursts_sent(0), d_items_sent(0),
+        d_overflows(0), d_timeouts(0), d_epoch(0)
+    {
+      index_bursts(d_file.data(), d_file.size());
+    }
+
+    mock_rx_streamer::~mock_rx_streamer()
+    {
+    }
+
+    // Only the length words are read, the items stay on disk until played
+    void
+    mock_rx_streamer::index_bursts(const uint8_t *data, size_t size)
+    {
+      if (size < sizeof(RECORDING_MAGIC) ||
+          std::memcmp(data, RECORDING_MAGIC, sizeof(RECORDING_MAGIC)))
+        throw std::runtime_error("not a CHDR recording: " + d_file.path());
+
+      size_t pos = sizeof(RECORDING_MAGIC);
+      while (pos + LEN_SIZE <= size) {
+        const size_t len = data[pos] | (data[pos + 1] << 8) | (data[pos + 2] << 16) |
+                           (size_t(data[pos + 3]) << 24);
+        pos += LEN_SIZE;
+        if (len > (size - pos) / CHDR_ITEM_SIZE)
+          throw std::runtime_error("truncated CHDR recording: " + d_file.path());
+        if (len) {
+          burst x = { data + pos, len };
+          d_bursts.push_back(x);
+          d_max_burst = std::max(d_max_burst, len);
+        }
+        pos += len * CHDR_ITEM_SIZE;
+      }
+    }
+
+    size_t
+    mock_rx_streamer::recv(const buffs_type &buffs, const size_t nsamps_per_buff,
+                           ::uhd::rx_metadata_t &metadata, const double timeout,
+                           const bool)
+    {
+      metadata.reset();
+      gr::thread::scoped_lock lock(d_mutex);
+
+      if (d_eob_pending && nsamps_per_buff)
+        return send_eob(buffs[0], metadata);
+      if (!d_streaming || played_out() || !nsamps_per_buff) {
+        if (wait(lock, timeout) && d_eob_pending && nsamps_per_buff)
+          return send_eob(buffs[0], metadata);
+        metadata.error_code = ::uhd::rx_metadata_t::ERROR_CODE_TIMEOUT;
+        return 0;
+      }
+
+      d_calls++;
+      if (d_opts.overflow_every && d_calls % d_opts.overflow_every == 0) {
+        d_overflows++;
+        metadata.error_code = ::uhd::rx_metadata_t::ERROR_CODE_OVERFLOW;
+        return 0;
+      }
+      if (d_opts.timeout_every && d_calls % d_opts.timeout_every == 0) {
+        d_timeouts++;
+        metadata.error_code = ::uhd::rx_metadata_t::ERROR_CODE_TIMEOUT;
+        return 0;
+      }
+
+      if (d_opts.items_per_sec > 0.0) {
+        const double due = double(d_items_sent) / d_opts.items_per_sec -
+                           double(gr::high_res_timer_now() - d_epoch) / gr::high_res_timer_tps();
+        // Only a stop wakes these up early
+        if (due > timeout) {
+          if (wait(lock, timeout))
+            return send_eob(buffs[0], metadata);
+          metadata.error_code = ::uhd::rx_metadata_t::ERROR_CODE_TIMEOUT;
+          return 0;
+        }
+        if (due > 0.0 && wait(lock, due))
+          return send_eob(buffs[0], metadata);
+      }
+
+      const burst &b = d_bursts[d_next];
+      const size_t n = std::min(b.len - d_offset, nsamps_per_buff);
+      std::memcpy(buffs[0], b.items + d_offset * CHDR_ITEM_SIZE, n * CHDR_ITEM_SIZE);
+      metadata.start_of_burst = d_offset == 0;
+      d_offset += n;
+      d_items_sent += n;
+
+      if (d_offset == b.len) {
+        metadata.end_of_burst = true;
+        d_bursts_sent++;
+        d_offset = 0;
+        if (++d_next == d_bursts.size()) {
+          d_next = 0;
+          d_loop++;
+        }
+      }
+      else
+        metadata.more_fragments = true;
+      return n;
+    }
+
+    void
+    mock_rx_streamer::issue_stream_cmd(const ::uhd::stream_cmd_t &stream_cmd)
+    {
+      gr::thread::scoped_lock lock(d_mutex);
+      switch (stream_cmd.stream_mode) {
+      case ::uhd::stream_cmd_t::STREAM_MODE_START_CONTINUOUS:
+        // Pacing picks up from here rather than catching up on the pause
+        if (d_opts.items_per_sec > 0.0)
+          d_epoch = gr::high_res_timer_now() -
+                    gr::high_res_timer_type(double(d_items_sent) / d_opts.items_per_sec *
+                                            gr::high_res_timer_tps());
+        d_streaming = true;
+        break;
+      case ::uhd::stream_cmd_t::STREAM_MODE_STOP_CONTINUOUS:
+        d_eob_pending = d_eob_pending || d_streaming;
+        d_streaming = false;
+        break;
+      default:
+        throw std::invalid_argument("mock_rx_streamer: only continuous streaming is supported");
+      }
+      d_cond.notify_all();
+    }
+
+    uint64_t
+    mock_rx_streamer::bursts_sent() const
+    {
+      gr::thread::scoped_lock lock(d_mutex);
+      return d_bursts_sent;
+    }
+
+    uint64_t
+    mock_rx_streamer::items_sent() const
+    {
+      gr::thread::scoped_lock lock(d_mutex);
+      return d_items_sent;
+    }
+
+    uint64_t
+    mock_rx_streamer::overflows() const
+    {
+      gr::thread::scoped_lock lock(d_mutex);
+      return d_overflows;
+    }
+
+    uint64_t
+    mock_rx_streamer::timeouts() const
+    {
+      gr::thread::scoped_lock lock(d_mutex);
+      return d_timeouts;
+    }
+
+    bool
+    mock_rx_streamer::finished() const
+    {
+      gr::thread::scoped_lock lock(d_mutex);
+      return played_out();
+    }
+
+    bool
+    mock_rx_streamer::played_out() const
+    {
+      return d_bursts.empty() || (d_opts.loops && d_loop >= d_opts.loops);
+    }
+
+    /*
+     * The burst zluudgbeeRX sends once its input stream has ended: a
+     * single padding item flagged EOB.
+     */
+    size_t
+    mock_rx_streamer::send_eob(void *buff, ::uhd::rx_metadata_t &metadata)
+    {
+      d_eob_pending = false;
+      uint8_t *item = static_cast<uint8_t *>(buff);
+      std::memset(item, 0, CHDR_ITEM_SIZE);
+      item[CHDR_FLAG_LANE] = CHDR_FLAG_EOB;
+      metadata.start_of_burst = true;
+      metadata.end_of_burst = true;
+      return 1;
+    }
+
+    /*
+     * Sleeps for up to seconds or until a stream command comes in, which
+     * makes it return true.
+     */
+    bool
+    mock_rx_streamer::wait(gr::thread::scoped_lock &lock, double seconds)
+    {
+      if (seconds <= 0.0)
+        return false;
+      const bool streaming = d_streaming;
+      const boost::system_time until = boost::get_system_time() +
+        boost::posix_time::microseconds(long(seconds * 1e6));
+      while (d_streaming == streaming)
+        if (!d_cond.timed_wait(lock, until))
+          return false;
+      return true;
+    }
+
+  } /* namespace zluudgbee */
+} /* namespace gr */
@@ -0,0 +1,145 @@
+/* -*- c++ -*- */
+/* 
+ * Copyright 2019 Leon Fernandez (zluudg).
+ * 
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ * 
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_ZLUUDGBEE_MOCK_RX_STREAMER_H
+#define INCLUDED_ZLUUDGBEE_MOCK_RX_STREAMER_H
+
+#include <uhd/stream.hpp>
+#include <gnuradio/high_res_timer.h>
+#include <gnuradio/thread/thread.h>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include "mapped_file.h"
+
+namespace gr {
+  namespace zluudgbee {
+
+    /*
+     * Appends the items the FPGA sends for one frame: a PSDU byte in the
+     * payload lane and ACTIVE in the flag lane of every item, ENDFRAME on
+     * the last one. With crc_checked the last item also carries the
+     * verdict of zluudgbeeCRC in flag mode, which is taken from the FCS.
+     */
+    void chdr_pack_frame(const uint8_t *psdu, size_t len, bool crc_checked,
+                         std::vector<uint8_t> &items);
+
+    /*
+     * Recordings hold bursts the way recv() delivered them: the magic
+     * "ZGCHDR01", then for each burst its length in items as a 32-bit
+     * little-endian word followed by the items, CHDR_ITEM_SIZE bytes each.
+     * Throws std::runtime_error.
+     */
+    void write_chdr_recording(const std::string &path,
+                              const std::vector<std::vector<uint8_t> > &bursts);
+
+    /*
+     * Stands in for the rx_streamer of a USRP, so everything behind it
+     * runs without hardware. Plays bursts of CHDR items from memory or
+     * from a recording, which is mapped rather than read. Each recv()
+     * returns at most one burst, split over several calls if it doesn't
+     * fit, and sets end_of_burst on the last piece.
+     *
+     * Nothing is returned before STREAM_MODE_START_CONTINUOUS. After a
+     * STREAM_MODE_STOP_CONTINUOUS, recv() returns the burst zluudgbeeRX
+     * ends its stream with, one item flagged CHDR_FLAG_EOB, and a recv()
+     * that is waiting gets it straight away. With
+     * items_per_sec set, bursts are only handed out once they are due at
+     * that rate, otherwise as fast as recv() is called. Every
+     * overflow_every-th and timeout_every-th call fails with that error
+     * code instead of returning a burst. Once the bursts have been played
+     * loops times, recv() only times out.
+     */
+    class mock_rx_streamer : public ::uhd::rx_streamer
+    {
+     public:
+      typedef boost::shared_ptr<mock_rx_streamer> sptr;
+
+      struct options
+      {
+        double items_per_sec;         // zero doesn't pace
+        uint64_t loops;               // zero loops forever
+        uint64_t overflow_every;      // in recv() calls, zero never
+        uint64_t timeout_every;
+
+        options()
+          : items_per_sec(0.0), loops(1), overflow_every(0), timeout_every(0)
+        {
+        }
+      };
+
+      mock_rx_streamer(const std::vector<std::vector<uint8_t> > &bursts,
+                       const options &opts);
+      mock_rx_streamer(const std::string &recording, const options &opts);
+      ~mock_rx_streamer();
+
+      size_t get_num_channels() const { return 1; }
+      size_t get_max_num_samps() const { return d_max_burst; }
+      size_t recv(const buffs_type &buffs, const size_t nsamps_per_buff,
+                  ::uhd::rx_metadata_t &metadata, const double timeout = 0.1,
+                  const bool one_packet = false);
+      void issue_stream_cmd(const ::uhd::stream_cmd_t &stream_cmd);
+
+      size_t bursts() const { return d_bursts.size(); }
+      uint64_t bursts_sent() const;
+      uint64_t items_sent() const;
+      uint64_t overflows() const;
+      uint64_t timeouts() const;
+      //! All loops have been played.
+      bool finished() const;
+
+     private:
+      struct burst
+      {
+        const uint8_t *items;
+        size_t len;
+      };
+
+      const options d_opts;
+      std::vector<uint8_t> d_owned;
+      mapped_file d_file;
+      std::vector<burst> d_bursts;
+      size_t d_max_burst;
+
+      mutable gr::thread::mutex d_mutex;
+      gr::thread::condition_variable d_cond;
+      bool d_streaming;
+      bool d_eob_pending;             // stopped, the EOB burst is next
+      size_t d_next;                  // burst
+      size_t d_offset;                // items of it already returned
+      uint64_t d_loop;
+      uint64_t d_calls;
+      uint64_t d_bursts_sent;
+      uint64_t d_items_sent;
+      uint64_t d_overflows;
+      uint64_t d_timeouts;
+      gr::high_res_timer_type d_epoch;  // when item zero was due
+
+      void index_bursts(const uint8_t *data, size_t size);
+      bool played_out() const;
+      bool wait(gr::thread::scoped_lock &lock, double seconds);
+      size_t send_eob(void *buff, ::uhd::rx_metadata_t &metadata);
+    };
+
+  } // namespace zluudgbee
+} // namespace gr
+
+#endif /* INCLUDED_ZLUUDGBEE_MOCK_RX_STREAMER_H */
@@ -0,0 +1,289 @@
+/* -*- c++ -*- */
+/* 
+ * Copyright 2019 Leon Fernandez (zluudg).
+ * 
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ * 
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <gnuradio/io_signature.h>
+#include <gnuradio/filter/firdes.h>
+#include <boost/bind.hpp>
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include "multirx_impl.h"
+#include "tuner_ctrl.h"
+
+namespace gr {
+  namespace zluudgbee {
+
+    static const double CHANNEL_SPACING = 5e6;
+    static const double CHANNEL_11 = 2405e6;
+    static const int FIRST_CHANNEL = 11;
+    static const int LAST_CHANNEL = 26;
+    static const double CHIP_RATE = 2e6;
+
+    multirx::sptr
+    multirx::make(double samp_rate, double center_freq, int nthreads,
+                  double shift_threshold, int shr_sens, int crappy_threshold)
+    {
+      return gnuradio::get_initial_sptr(
+        new multirx_impl(samp_rate, center_freq, nthreads,
+                         shift_threshold, shr_sens, crappy_threshold)
+      );
+    }
+
+    static unsigned
+    bins_for(double samp_rate)
+    {
+      const double nchans = std::floor(samp_rate / CHANNEL_SPACING + 0.5);
+      if (nchans < 2 || std::fmod(nchans, 2.0) != 0.0 ||
+          std::fabs(nchans * CHANNEL_SPACING - samp_rate) > 1.0)
+        throw std::invalid_argument("multirx: samp_rate must be an even multiple of 5 MHz");
+      return unsigned(nchans);
+    }
+
+    /*
+     * Passband up to 1.5 MHz, which is where the first null of the O-QPSK
+     * spectrum is, and down by 60 dB from 3.5 MHz, before the main lobe
+     * of the next channel starts.
+     */
+    static std::vector<float>
+    prototype(double samp_rate)
+    {
+      return gr::filter::firdes::low_pass_2(1.0, samp_rate, 2.5e6, 2e6, 60.0,
+                                            gr::filter::firdes::WIN_BLACKMAN_hARRIS);
+    }
+
+    static inline int16_t
+    to_sc16(float x)
+    {
+      x = std::floor(x + 0.5f);
+      return int16_t(x > 32767.0f ? 32767.0f : (x < -32768.0f ? -32768.0f : x));
+    }
+
+    /*
+     * The private constructor
+     */
+    multirx_impl::multirx_impl(double samp_rate, double center_freq, int nthreads,
+                               double shift_threshold, int shr_sens, int crappy_threshold)
+      : gr::sync_block("multirx",
+              gr::io_signature::make(1, 1, 2*sizeof(int16_t)),
+              gr::io_signature::make(0, 0, 0)),
+        d_pool(nthreads),
+        d_channelizer(bins_for(samp_rate), prototype(samp_rate), d_pool.size()),
+        d_bins(d_channelizer.nchans()),
+        d_nbin(0),
+        d_slice_task(boost::bind(&multirx_impl::run_slice, this, _1)),
+        d_channel_task(boost::bind(&multirx_impl::run_channel, this, _1)),
+        d_port(pmt::mp("data")),
+        d_confidence_key(pmt::mp("confidence")),
+        d_crappy_key(pmt::mp("crappy_nibbles")),
+        d_channel_key(pmt::mp("channel"))
+    {
+      const double offset = (center_freq - CHANNEL_11) / CHANNEL_SPACING;
+      if (std::fabs(offset - std::floor(offset + 0.5)) > 1e-6)
+        throw std::invalid_argument("multirx: center_freq must be on the 5 MHz channel raster");
+
+      // Bin outputs come at twice the spacing, the decimator does the rest
+      const double chan_rate = 2 * samp_rate / d_channelizer.nchans();
+      const int decim_rate = int(std::floor(chan_rate / CHIP_RATE + 0.5));
+
+      const int nchans = d_channelizer.nchans();
+      for (int k = -nchans/2 + 1; k < nchans/2; k++) {
+        const int channel = FIRST_CHANNEL + int(std::floor(offset + 0.5)) + k;
+        if (channel < FIRST_CHANNEL || channel > LAST_CHANNEL)
+          continue;
+
+        multirx_channel *c = new multirx_channel;
+        c->channel = channel;
+        c->bin = k < 0 ? k + nchans : k;
+        c->model.set_register(SR_SYMSYNC_MODE, 0);
+        c->model.set_register(SR_DECIM_RATE, decim_rate);
+        c->model.set_register(SR_MA_LINE_DEPTH, 8);
+        d_channels.push_back(c);
+      }
+      if (d_channels.empty())
+        throw std::invalid_argument("multirx: no 802.15.4 channel in the captured band");
+
+      set_shift_threshold(shift_threshold);
+      set_shr_sens(shr_sens);
+      set_crappy_threshold(crappy_threshold);
+
+      message_port_register_out(d_port);
+      message_port_register_in(pmt::mp("ctrl"));
+      set_msg_handler(pmt::mp("ctrl"), boost::bind(&multirx_impl::handle_ctrl, this, _1));
+    }
+
+    /*
+     * Our virtual destructor.
+     */
+    multirx_impl::~multirx_impl()
+    {
+      for (size_t i = 0; i < d_channels.size(); i++)
+        delete d_channels[i];
+    }
+
+    void
+    multirx_impl::set_register(int addr, uint32_t value)
+    {
+      gr::thread::scoped_lock guard(d_setlock);
+      for (size_t i = 0; i < d_channels.size(); i++)
+        d_channels[i]->model.set_register(addr, value);
+    }
+
+    void
+    multirx_impl::set_shift_threshold(double threshold)
+    {
+      // Q2.17, same as softrx
+      set_register(SR_SHIFT_THRESHOLD, uint32_t(int32_t(std::floor(threshold * 131072.0 + 0.5))));
+    }
+
+    void
+    multirx_impl::set_shr_sens(int sens)
+    {
+      set_register(SR_SHR_SENS, sens);
+    }
+
+    void
+    multirx_impl::set_crappy_threshold(int threshold)
+    {
+      set_register(SR_CRAPPY_THRESHOLD, threshold);
+    }
+
+    void
+    multirx_impl::handle_ctrl(pmt::pmt_t msg)
+    {
+      handle_tuner_ctrl(*this, msg);
+    }
+
+    std::vector<int>
+    multirx_impl::channels() const
+    {
+      std::vector<int> channels;
+      for (size_t i = 0; i < d_channels.size(); i++)
+        channels.push_back(d_channels[i]->channel);
+      return channels;
+    }
+
+    // Channelizer outputs are independent of each other, so every thread takes a range
+    void
+    multirx_impl::run_slice(size_t i)
+    {
+      const size_t nslices = d_pool.size();
+      d_channelizer.compute(d_nbin * i / nslices, d_nbin * (i + 1) / nslices, i, d_bins);
+    }
+
+    /*
+     * One channel's share of a work() call, run on the pool. Only the
+     * channel's own state is written, the PDUs wait in it until work()
+     * has them all.
+     */
+    void
+    multirx_impl::run_channel(size_t i)
+    {
+      multirx_channel &c = *d_channels[i];
+      const std::vector<gr_complex> &bin = d_bins[c.bin];
+      const size_t n = d_nbin;
+      if (!n)
+        return;
+
+      c.iq.resize(2*n);
+      for (size_t j = 0; j < n; j++) {
+        c.iq[2*j] = to_sc16(bin[j].real());
+        c.iq[2*j + 1] = to_sc16(bin[j].imag());
+      }
+      c.model.work(&c.iq[0], n);
+
+      if (!c.model.take_bursts(c.words, c.ends, c.end_clocks))
+        return;
+
+      const size_t nwords = c.words.size();
+      c.bytes.resize(nwords);
+      c.flags.resize(nwords);
+      for (size_t j = 0; j < nwords; j++) {
+        c.bytes[j] = c.words[j] & 0xFF;
+        c.flags[j] = (c.words[j] >> 8) & 0xFF;
+      }
+
+      size_t start = 0;
+      for (size_t b = 0; b < c.ends.size(); b++) {
+        c.frames.clear();
+        chdr_split_frames(&c.flags[start], c.ends[b] - start, c.frames);
+        for (size_t f = 0; f < c.frames.size(); f++) {
+          const chdr_frame &frame = c.frames[f];
+          pmt::pmt_t meta = pmt::make_dict();
+          meta = pmt::dict_add(meta, d_confidence_key, pmt::from_double(frame.confidence()));
+          meta = pmt::dict_add(meta, d_crappy_key, pmt::from_long(frame.crappy_nibbles));
+          meta = pmt::dict_add(meta, d_channel_key, pmt::from_long(c.channel));
+          multirx_pdu pdu;
+          pdu.clock = c.end_clocks[b];
+          pdu.channel = c.channel;
+          pdu.msg = pmt::cons(meta, pmt::init_u8vector(frame.len, &c.bytes[start + frame.offset]));
+          c.pdus.push_back(pdu);
+        }
+        start = c.ends[b];
+      }
+    }
+
+    static bool
+    ends_before(const multirx_pdu &a, const multirx_pdu &b)
+    {
+      return a.clock < b.clock || (a.clock == b.clock && a.channel < b.channel);
+    }
+
+    int
+    multirx_impl::work(int noutput_items,
+        gr_vector_const_void_star &input_items,
+        gr_vector_void_star &output_items)
+    {
+      const int16_t *in = (const int16_t *) input_items[0];
+
+      {
+        gr::thread::scoped_lock guard(d_setlock);
+
+        d_nbin = d_channelizer.push(in, noutput_items);
+        for (size_t k = 0; k < d_bins.size(); k++)
+          d_bins[k].resize(d_nbin);
+        d_pool.run(d_pool.size(), d_slice_task);
+        d_channelizer.pop();
+
+        d_pool.run(d_channels.size(), d_channel_task);
+
+        // Every model has seen the same samples, so their clocks line up
+        d_pdus.clear();
+        for (size_t i = 0; i < d_channels.size(); i++) {
+          std::vector<multirx_pdu> &pdus = d_channels[i]->pdus;
+          d_pdus.insert(d_pdus.end(), pdus.begin(), pdus.end());
+          pdus.clear();
+        }
+      }
+
+      std::sort(d_pdus.begin(), d_pdus.end(), ends_before);
+      for (size_t i = 0; i < d_pdus.size(); i++)
+        message_port_pub(d_port, d_pdus[i].msg);
+      d_pdus.clear();
+
+      // Tell runtime system how many output items we produced.
+      return noutput_items;
+    }
+
+  } /* namespace zluudgbee */
+} /* namespace gr */
@@ -0,0 +1,98 @@
+/* -*- c++ -*- */
+/* 
+ * Copyright 2019 Leon Fernandez (zluudg).
+ * 
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ * 
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_ZLUUDGBEE_MULTIRX_IMPL_H
+#define INCLUDED_ZLUUDGBEE_MULTIRX_IMPL_H
+
+#include <zluudgbee/multirx.h>
+#include "chdr_unpack.h"
+#include "pfb_channelizer.h"
+#include "rx_model.h"
+#include "worker_pool.h"
+
+namespace gr {
+  namespace zluudgbee {
+
+    // A frame on its way out, with the clock its burst ended on
+    struct multirx_pdu
+    {
+      uint64_t clock;
+      int channel;
+      pmt::pmt_t msg;
+    };
+
+    // One channel, only ever touched by one task at a time
+    struct multirx_channel
+    {
+      int channel;
+      unsigned bin;
+      rx_model model;
+
+      std::vector<int16_t> iq;
+      std::vector<uint32_t> words;
+      std::vector<size_t> ends;
+      std::vector<uint64_t> end_clocks;
+      std::vector<uint8_t> bytes;
+      std::vector<uint8_t> flags;
+      std::vector<chdr_frame> frames;
+      std::vector<multirx_pdu> pdus;
+    };
+
+    class multirx_impl : public multirx
+    {
+     private:
+      worker_pool d_pool;
+      pfb_channelizer d_channelizer;
+      std::vector<std::vector<gr_complex> > d_bins;
+      size_t d_nbin;                     // samples per bin this work() call
+      std::vector<multirx_channel *> d_channels;
+      std::vector<multirx_pdu> d_pdus;
+      const worker_pool::task_t d_slice_task;
+      const worker_pool::task_t d_channel_task;
+
+      const pmt::pmt_t d_port;
+      const pmt::pmt_t d_confidence_key;
+      const pmt::pmt_t d_crappy_key;
+      const pmt::pmt_t d_channel_key;
+
+      void run_slice(size_t i);
+      void run_channel(size_t i);
+      void set_register(int addr, uint32_t value);
+      void handle_ctrl(pmt::pmt_t msg);
+
+     public:
+      multirx_impl(double samp_rate, double center_freq, int nthreads,
+                   double shift_threshold, int shr_sens, int crappy_threshold);
+      ~multirx_impl();
+
+      void set_shift_threshold(double threshold);
+      void set_shr_sens(int sens);
+      void set_crappy_threshold(int threshold);
+      std::vector<int> channels() const;
+
+      int work(int noutput_items,
+         gr_vector_const_void_star &input_items,
+         gr_vector_void_star &output_items);
+    };
+
+  } // namespace zluudgbee
+} // namespace gr
+
+#endif /* INCLUDED_ZLUUDGBEE_MULTIRX_IMPL_H */
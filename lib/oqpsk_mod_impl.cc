@@ -0,0 +1,104 @@
+/* -*- c++ -*- */
+/* 
+ * Copyright 2019 Leon Fernandez (zluudg).
+ * 
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ * 
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <gnuradio/io_signature.h>
+#include <boost/format.hpp>
+#include <stdexcept>
+#include "oqpsk_mod_impl.h"
+
+namespace gr {
+  namespace zluudgbee {
+
+    oqpsk_mod::sptr
+    oqpsk_mod::make(int samples_per_chip, const std::string &length_tag_name)
+    {
+      return gnuradio::get_initial_sptr(
+        new oqpsk_mod_impl(samples_per_chip, length_tag_name)
+      );
+    }
+
+    /*
+     * The private constructor
+     */
+    oqpsk_mod_impl::oqpsk_mod_impl(int samples_per_chip, const std::string &length_tag_name)
+      : gr::sync_block("oqpsk_mod",
+              gr::io_signature::make(0, 0, 0),
+              gr::io_signature::make(1, 1, sizeof(gr_complex))),
+        d_waveform(samples_per_chip > 0 ? samples_per_chip : 1),
+        d_oversized_frames(0),
+        d_port(pmt::mp("pdu in")),
+        d_length_key(length_tag_name.empty() ? pmt::PMT_NIL : pmt::mp(length_tag_name))
+    {
+      if (samples_per_chip < 1)
+        throw std::invalid_argument("oqpsk_mod: samples_per_chip must be at least 1");
+
+      // No handler, work() takes the PDUs off the queue itself
+      message_port_register_in(d_port);
+    }
+
+    /*
+     * Our virtual destructor.
+     */
+    oqpsk_mod_impl::~oqpsk_mod_impl()
+    {
+    }
+
+    uint64_t
+    oqpsk_mod_impl::oversized_frames() const
+    {
+      return d_oversized_frames;
+    }
+
+    int
+    oqpsk_mod_impl::work(int noutput_items,
+        gr_vector_const_void_star &input_items,
+        gr_vector_void_star &output_items)
+    {
+      gr_complex *out = (gr_complex *) output_items[0];
+
+      if (!d_waveform.remaining()) {
+        // Same as pdu_to_tagged_stream, the timeout keeps stop() responsive
+        pmt::pmt_t msg(delete_head_blocking(d_port, 100));
+        if (msg.get() == NULL || !pmt::is_pair(msg))
+          return 0;
+
+        const pmt::pmt_t blob = pmt::cdr(msg);
+        const size_t len = pmt::blob_length(blob);
+        if (len > oqpsk_waveform::MAX_PSDU_LEN) {
+          d_oversized_frames++;
+          GR_LOG_WARN(d_logger, str(boost::format("dropping %d byte PSDU, the PHR only goes to %d")
+                                    % len % oqpsk_waveform::MAX_PSDU_LEN));
+          return 0;
+        }
+
+        d_waveform.start((const uint8_t *) pmt::blob_data(blob), len);
+        if (!pmt::is_null(d_length_key))
+          add_item_tag(0, nitems_written(0), d_length_key, pmt::from_long(d_waveform.remaining()));
+      }
+
+      return d_waveform.generate(out, noutput_items);
+    }
+
+  } /* namespace zluudgbee */
+} /* namespace gr */
@@ -0,0 +1,53 @@
+/* -*- c++ -*- */
+/* 
+ * Copyright 2019 Leon Fernandez (zluudg).
+ * 
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ * 
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_ZLUUDGBEE_OQPSK_MOD_IMPL_H
+#define INCLUDED_ZLUUDGBEE_OQPSK_MOD_IMPL_H
+
+#include <zluudgbee/oqpsk_mod.h>
+#include "oqpsk_waveform.h"
+
+namespace gr {
+  namespace zluudgbee {
+
+    class oqpsk_mod_impl : public oqpsk_mod
+    {
+     private:
+      oqpsk_waveform d_waveform;
+      uint64_t d_oversized_frames;
+
+      const pmt::pmt_t d_port;
+      const pmt::pmt_t d_length_key;     // PMT_NIL for no tags
+
+     public:
+      oqpsk_mod_impl(int samples_per_chip, const std::string &length_tag_name);
+      ~oqpsk_mod_impl();
+
+      uint64_t oversized_frames() const;
+
+      int work(int noutput_items,
+         gr_vector_const_void_star &input_items,
+         gr_vector_void_star &output_items);
+    };
+
+  } // namespace zluudgbee
+} // namespace gr
+
+#endif /* INCLUDED_ZLUUDGBEE_OQPSK_MOD_IMPL_H */
@@ -0,0 +1,123 @@
+/* -*- c++ -*- */
+/* 
+ * Copyright 2019 Leon Fernandez (zluudg).
+ * 
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ * 
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "oqpsk_tables.h"
+#include "rx_model.h"
+#include <gnuradio/thread/thread.h>
+#include <map>
+#include <vector>
+
+namespace gr {
+  namespace zluudgbee {
+
+    // The receiver and the transmitter have to agree on the chips
+    constexpr bool
+    demapper_agrees(unsigned nibble = 0)
+    {
+      return nibble >= 16 ||
+        (oqpsk_demapper_sequence(OQPSK_CHIP_SEQUENCES[nibble]) == rx_demapper::CHIP_SEQUENCES[nibble]
+         && demapper_agrees(nibble + 1));
+    }
+    static_assert(demapper_agrees(), "OQPSK_CHIP_SEQUENCES don't match chip_sequences in zluudg_demapper.vhd");
+
+    template <unsigned SPC>
+    static oqpsk_table_view
+    compiled()
+    {
+      const oqpsk_table_view v = {
+        SPC,
+        oqpsk_tables<SPC>::LEN,
+        reinterpret_cast<const gr_complex *>(oqpsk_tables<SPC>::FC32.nibble),
+        reinterpret_cast<const sc16_t *>(oqpsk_tables<SPC>::SC16.nibble)
+      };
+      return v;
+    }
+
+    // 4 MS/s (2 per chip) is what the radio runs at, the rest are the
+    // usual decimations of it.
+    static const oqpsk_table_view COMPILED[] = {
+      compiled<1>(),
+      compiled<2>(),
+      compiled<4>(),
+      compiled<5>(),
+      compiled<8>(),
+      compiled<10>()
+    };
+    static const size_t NCOMPILED = sizeof(COMPILED) / sizeof(COMPILED[0]);
+
+    struct built_tables
+    {
+      std::vector<gr_complex> fc32;
+      std::vector<sc16_t> sc16;
+      oqpsk_table_view view;
+    };
+
+    static void
+    build(unsigned spc, built_tables &t)
+    {
+      const size_t len = (OQPSK_CHIPS_PER_NIBBLE + 1) * spc;
+      t.fc32.resize(16 * len);
+      t.sc16.resize(16 * len);
+      for (unsigned nibble = 0; nibble < 16; nibble++) {
+        for (size_t s = 0; s < len; s++) {
+          const double i = oqpsk_sample(nibble, spc, s, 0);
+          const double q = oqpsk_sample(nibble, spc, s, 1);
+          t.fc32[nibble * len + s] = gr_complex(i, q);
+          t.sc16[nibble * len + s] = sc16_t(oqpsk_to_sc16(i), oqpsk_to_sc16(q));
+        }
+      }
+      const oqpsk_table_view v = { spc, len, &t.fc32[0], &t.sc16[0] };
+      t.view = v;
+    }
+
+    bool
+    oqpsk_tables_precomputed(unsigned spc)
+    {
+      for (size_t i = 0; i < NCOMPILED; i++)
+        if (COMPILED[i].spc == spc)
+          return true;
+      return false;
+    }
+
+    const oqpsk_table_view &
+    oqpsk_nibble_tables(unsigned spc)
+    {
+      for (size_t i = 0; i < NCOMPILED; i++)
+        if (COMPILED[i].spc == spc)
+          return COMPILED[i];
+
+      // Entries never move or go away, so the reference stays good
+      static gr::thread::mutex mutex;
+      static std::map<unsigned, built_tables> built;
+      gr::thread::scoped_lock guard(mutex);
+      std::map<unsigned, built_tables>::iterator it = built.find(spc);
+      if (it == built.end()) {
+        it = built.insert(std::make_pair(spc, built_tables())).first;
+        build(spc, it->second);
+      }
+      return it->second.view;
+    }
+
+  } // namespace zluudgbee
+} // namespace gr
@@ -0,0 +1,228 @@
+/* -*- c++ -*- */
+/* 
+ * Copyright 2019 Leon Fernandez (zluudg).
+ * 
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ * 
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_ZLUUDGBEE_OQPSK_TABLES_H
+#define INCLUDED_ZLUUDGBEE_OQPSK_TABLES_H
+
+#include <gnuradio/gr_complex.h>
+#include <complex>
+#include <cstddef>
+#include <stdint.h>
+
+namespace gr {
+  namespace zluudgbee {
+
+    typedef std::complex<int16_t> sc16_t;
+
+    static const size_t OQPSK_CHIPS_PER_NIBBLE = 32;
+
+    // Bit i is chip i, as in the chip table of the standard
+    static constexpr uint32_t OQPSK_CHIP_SEQUENCES[16] = {
+      0x744AC39B, 0x44AC39B7, 0x4AC39B74, 0xAC39B744,
+      0xC39B744A, 0x39B744AC, 0x9B744AC3, 0xB744AC39,
+      0xDEE06931, 0xEE06931D, 0xE06931DE, 0x06931DEE,
+      0x6931DEE0, 0x931DEE06, 0x31DEE069, 0x1DEE0693
+    };
+
+    /*
+     * What zluudg_demapper sees of a nibble. The FPGA works on the sign
+     * of the phase difference, which with half-sine pulses says whether
+     * chip i agrees with chip i-1, flipped on every odd chip because Q
+     * trails I. Chip i lands in bit 31-i, chip 0 has nothing before it
+     * and is left out, same as CORR_MASK does.
+     */
+    constexpr uint32_t
+    oqpsk_demapper_bit(uint32_t chips, unsigned i)
+    {
+      return (((chips >> i) ^ (chips >> (i - 1)) ^ i) & 1u) << (31 - i);
+    }
+
+    constexpr uint32_t
+    oqpsk_demapper_sequence(uint32_t chips, unsigned i = 1)
+    {
+      return i < OQPSK_CHIPS_PER_NIBBLE
+        ? oqpsk_demapper_bit(chips, i) | oqpsk_demapper_sequence(chips, i + 1)
+        : 0;
+    }
+
+    /*
+     * Sine good to about 1e-12 on [0, pi], which is all the pulse needs.
+     * std::sin isn't constexpr, so this is the Taylor series of the
+     * nearer half of the hump.
+     */
+    constexpr double
+    oqpsk_sin_series(double x2, double term, unsigned k)
+    {
+      return k > 21 ? term : term - oqpsk_sin_series(x2, term * x2 / ((k + 1) * (k + 2)), k + 2);
+    }
+
+    constexpr double
+    oqpsk_sin(double x)
+    {
+      return x > 3.14159265358979323846 / 2
+        ? oqpsk_sin(3.14159265358979323846 - x)
+        : oqpsk_sin_series(x * x, x, 1);
+    }
+
+    /*
+     * Sample s of the I (rail 0) or Q (rail 1) part of a nibble. Even
+     * chips go on I and odd chips on Q, every chip is a half-sine two
+     * chips long and Q trails I by one chip, so there is one pulse on
+     * each rail at a time. The last Q pulse runs spc samples into the
+     * next nibble, where Q has nothing else yet.
+     */
+    constexpr double
+    oqpsk_chip_amplitude(uint32_t chips, int i)
+    {
+      return i < 0 || i >= int(OQPSK_CHIPS_PER_NIBBLE) ? 0.0 : ((chips >> i) & 1) ? 1.0 : -1.0;
+    }
+
+    constexpr double
+    oqpsk_rail_at(uint32_t chips, unsigned spc, unsigned s, int chip)
+    {
+      return oqpsk_chip_amplitude(chips, chip)
+        * oqpsk_sin(3.14159265358979323846 * (int(s) - chip * int(spc)) / (2.0 * spc));
+    }
+
+    constexpr double
+    oqpsk_sample(unsigned nibble, unsigned spc, unsigned s, unsigned rail)
+    {
+      return oqpsk_rail_at(OQPSK_CHIP_SEQUENCES[nibble], spc, s,
+                           (s / spc) % 2 == rail ? int(s / spc) : int(s / spc) - 1);
+    }
+
+    // sc16 scale, so that the magnitude stays within full scale
+    static constexpr double OQPSK_SC16_SCALE = 23170.0;
+
+    constexpr int16_t
+    oqpsk_to_sc16(double v)
+    {
+      return v < 0 ? -int16_t(-v * OQPSK_SC16_SCALE + 0.5) : int16_t(v * OQPSK_SC16_SCALE + 0.5);
+    }
+
+    /*
+     * The 16 nibble waveforms at SPC samples per chip, I and Q
+     * interleaved, worked out by the compiler. Each one is a nibble and
+     * the Q pulse that runs over, OVERLAP samples, which get added to the
+     * start of the next nibble. The transmitter is then memcpy and an add
+     * per nibble, and a coherent receiver correlates against the same
+     * samples.
+     */
+    namespace oqpsk_detail {
+      template <unsigned... Is> struct seq { };
+
+      template <class A, class B> struct cat;
+      template <unsigned... A, unsigned... B>
+      struct cat<seq<A...>, seq<B...> >
+      {
+        typedef seq<A..., (sizeof...(A) + B)...> type;
+      };
+
+      // Halves each step, so big tables stay well inside -ftemplate-depth
+      template <unsigned N>
+      struct make_seq
+      {
+        typedef typename cat<typename make_seq<N / 2>::type,
+                             typename make_seq<N - N / 2>::type>::type type;
+      };
+      template <> struct make_seq<0> { typedef seq<> type; };
+      template <> struct make_seq<1> { typedef seq<0> type; };
+
+      template <typename T, size_t N>
+      struct wave
+      {
+        T v[N];
+      };
+
+      template <typename T, size_t N>
+      struct set
+      {
+        wave<T, N> nibble[16];
+      };
+
+      template <unsigned SPC, unsigned... Is>
+      constexpr wave<float, sizeof...(Is)>
+      fc32(unsigned nibble, seq<Is...>)
+      {
+        return wave<float, sizeof...(Is)>{{ float(oqpsk_sample(nibble, SPC, Is / 2, Is % 2))... }};
+      }
+
+      template <unsigned SPC, unsigned... Is>
+      constexpr wave<int16_t, sizeof...(Is)>
+      sc16(unsigned nibble, seq<Is...>)
+      {
+        return wave<int16_t, sizeof...(Is)>{{ oqpsk_to_sc16(oqpsk_sample(nibble, SPC, Is / 2, Is % 2))... }};
+      }
+
+      template <unsigned SPC, size_t N, unsigned... Ns>
+      constexpr set<float, N>
+      fc32_set(seq<Ns...>)
+      {
+        return set<float, N>{{ fc32<SPC>(Ns, typename make_seq<N>::type())... }};
+      }
+
+      template <unsigned SPC, size_t N, unsigned... Ns>
+      constexpr set<int16_t, N>
+      sc16_set(seq<Ns...>)
+      {
+        return set<int16_t, N>{{ sc16<SPC>(Ns, typename make_seq<N>::type())... }};
+      }
+    } // namespace oqpsk_detail
+
+    template <unsigned SPC>
+    struct oqpsk_tables
+    {
+      static const size_t NIBBLE_LEN = OQPSK_CHIPS_PER_NIBBLE * SPC;
+      static const size_t OVERLAP = SPC;
+      static const size_t LEN = NIBBLE_LEN + OVERLAP;
+
+      static constexpr oqpsk_detail::set<float, 2 * LEN> FC32 =
+        oqpsk_detail::fc32_set<SPC, 2 * LEN>(oqpsk_detail::make_seq<16>::type());
+      static constexpr oqpsk_detail::set<int16_t, 2 * LEN> SC16 =
+        oqpsk_detail::sc16_set<SPC, 2 * LEN>(oqpsk_detail::make_seq<16>::type());
+    };
+
+    template <unsigned SPC>
+    constexpr oqpsk_detail::set<float, 2 * oqpsk_tables<SPC>::LEN> oqpsk_tables<SPC>::FC32;
+    template <unsigned SPC>
+    constexpr oqpsk_detail::set<int16_t, 2 * oqpsk_tables<SPC>::LEN> oqpsk_tables<SPC>::SC16;
+
+    /*
+     * The tables of one rate, nibble n at fc32 + n * len. The compiled-in
+     * rates are listed in oqpsk_tables.cc, any other rate is built from
+     * the same functions the first time it's asked for.
+     */
+    struct oqpsk_table_view
+    {
+      unsigned spc;
+      size_t len;                    // nibble plus overlap, in samples
+      const gr_complex *fc32;
+      const sc16_t *sc16;
+    };
+
+    const oqpsk_table_view &oqpsk_nibble_tables(unsigned spc);
+
+    // Whether spc is one of the compiled-in rates
+    bool oqpsk_tables_precomputed(unsigned spc);
+
+  } // namespace zluudgbee
+} // namespace gr
+
+#endif /* INCLUDED_ZLUUDGBEE_OQPSK_TABLES_H */
@@ -0,0 +1,115 @@
+/* -*- c++ -*- */
+/* 
+ * Copyright 2019 Leon Fernandez (zluudg).
+ * 
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ * 
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "oqpsk_waveform.h"
+#include <algorithm>
+#include <cstring>
+
+namespace gr {
+  namespace zluudgbee {
+
+    static const uint8_t SFD = 0xA7;
+
+    oqpsk_waveform::oqpsk_waveform(unsigned samples_per_chip)
+      : d_spc(samples_per_chip ? samples_per_chip : 1),
+        d_nibble_len(CHIPS_PER_NIBBLE * d_spc),
+        d_tables(oqpsk_nibble_tables(d_spc)),
+        d_pos(0),
+        d_len(0)
+    {
+    }
+
+    size_t
+    oqpsk_waveform::burst_len(size_t psdu_len) const
+    {
+      return (SHR_NIBBLES + 2 + 2 * psdu_len) * d_nibble_len + tail_len();
+    }
+
+    void
+    oqpsk_waveform::start(const uint8_t *psdu, size_t psdu_len)
+    {
+      psdu_len = std::min(psdu_len, MAX_PSDU_LEN);
+
+      d_nibbles.assign(SHR_NIBBLES - 2, 0);
+      d_nibbles.push_back(SFD & 0x0F);
+      d_nibbles.push_back(SFD >> 4);
+      d_nibbles.push_back(psdu_len & 0x0F);
+      d_nibbles.push_back(psdu_len >> 4);
+      for (size_t i = 0; i < psdu_len; i++) {
+        d_nibbles.push_back(psdu[i] & 0x0F);
+        d_nibbles.push_back(psdu[i] >> 4);
+      }
+
+      d_pos = 0;
+      d_len = burst_len(psdu_len);
+    }
+
+    template <typename T>
+    size_t
+    oqpsk_waveform::fill(T *out, size_t n, const T *tables)
+    {
+      n = std::min(n, remaining());
+      const size_t body = d_nibbles.size() * d_nibble_len;
+
+      size_t done = 0;
+      while (done < n && d_pos < body) {
+        const size_t k = d_pos / d_nibble_len;
+        const size_t offset = d_pos % d_nibble_len;
+        const size_t m = std::min(n - done, d_nibble_len - offset);
+        std::memcpy(out + done, tables + d_nibbles[k] * d_tables.len + offset, m * sizeof(T));
+
+        // The last Q pulse of the nibble before runs into this one
+        if (k && offset < d_spc) {
+          const T *overlap = tables + d_nibbles[k - 1] * d_tables.len + d_nibble_len;
+          const size_t end = std::min(offset + m, size_t(d_spc));
+          for (size_t s = offset; s < end; s++)
+            out[done + s - offset] += overlap[s];
+        }
+        done += m;
+        d_pos += m;
+      }
+      if (done < n) {
+        const T *overlap = tables + d_nibbles.back() * d_tables.len + d_nibble_len;
+        for (; done < n; done++, d_pos++) {
+          const size_t s = d_pos - body;
+          out[done] = s < d_spc ? overlap[s] : T();
+        }
+      }
+      return n;
+    }
+
+    size_t
+    oqpsk_waveform::generate(gr_complex *out, size_t n)
+    {
+      return fill(out, n, d_tables.fc32);
+    }
+
+    size_t
+    oqpsk_waveform::generate(sc16_t *out, size_t n)
+    {
+      return fill(out, n, d_tables.sc16);
+    }
+
+  } // namespace zluudgbee
+} // namespace gr
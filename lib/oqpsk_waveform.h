@@ -0,0 +1,82 @@
+/* -*- c++ -*- */
+/* 
+ * Copyright 2019 Leon Fernandez (zluudg).
+ * 
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ * 
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_ZLUUDGBEE_OQPSK_WAVEFORM_H
+#define INCLUDED_ZLUUDGBEE_OQPSK_WAVEFORM_H
+
+#include "oqpsk_tables.h"
+#include <cstddef>
+#include <vector>
+#include <stdint.h>
+
+namespace gr {
+  namespace zluudgbee {
+
+    /*
+     * Baseband of one 802.15.4 burst at 2.4 GHz: preamble, SFD, PHR and
+     * PSDU, nibbles low first, spread to 32 chips each. Even chips go on
+     * I and odd chips on Q, every chip is a half-sine two chips long and
+     * Q trails I by one chip. A burst is a copy of the oqpsk_tables
+     * waveform of each nibble, with the overlap of the one before added
+     * on, and ends with the rest of the last pulse and two chips of
+     * silence.
+     */
+    class oqpsk_waveform
+    {
+     public:
+      static const size_t CHIPS_PER_NIBBLE = OQPSK_CHIPS_PER_NIBBLE;
+      static const size_t SHR_NIBBLES = 10;        // preamble and SFD
+      static const size_t MAX_PSDU_LEN = 127;      // aMaxPHYPacketSize
+
+      explicit oqpsk_waveform(unsigned samples_per_chip);
+
+      unsigned samples_per_chip() const { return d_spc; }
+
+      // Samples in the burst of a psdu_len byte PSDU
+      size_t burst_len(size_t psdu_len) const;
+
+      // Starts the burst of a PSDU of at most MAX_PSDU_LEN bytes.
+      void start(const uint8_t *psdu, size_t psdu_len);
+
+      // Writes up to n more samples of the burst, returns how many.
+      size_t generate(gr_complex *out, size_t n);
+      size_t generate(sc16_t *out, size_t n);
+
+      size_t remaining() const { return d_len - d_pos; }
+
+     private:
+      const unsigned d_spc;
+      const size_t d_nibble_len;                   // samples per nibble
+      const oqpsk_table_view &d_tables;
+
+      std::vector<uint8_t> d_nibbles;
+      size_t d_pos;
+      size_t d_len;
+
+      size_t tail_len() const { return 3 * d_spc; }
+
+      template <typename T>
+      size_t fill(T *out, size_t n, const T *tables);
+    };
+
+  } // namespace zluudgbee
+} // namespace gr
+
+#endif /* INCLUDED_ZLUUDGBEE_OQPSK_WAVEFORM_H */
@@ -0,0 +1,149 @@
+/* -*- c++ -*- */
+/* 
+ * Copyright 2019 Leon Fernandez (zluudg).
+ * 
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ * 
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "pfb_channelizer.h"
+#include <cmath>
+#include <stdexcept>
+
+namespace gr {
+  namespace zluudgbee {
+
+    pfb_channelizer::pfb_channelizer(unsigned nchans, const std::vector<float> &taps,
+                                     unsigned nslices)
+      : d_nchans(nchans),
+        d_decim(nchans / 2),
+        d_skip(0),
+        d_time(0),
+        d_pushed(0),
+        d_outputs(0)
+    {
+      if (nchans < 2 || (nchans & 1))
+        throw std::invalid_argument("pfb_channelizer: nchans must be even");
+
+      d_ntaps = (taps.size() + nchans - 1) / nchans * nchans;
+      d_taps.assign(2*d_ntaps, 0.0f);
+      for (size_t m = 0; m < taps.size(); m++) {
+        d_taps[2*(d_ntaps - 1 - m)] = taps[m];
+        d_taps[2*(d_ntaps - 1 - m) + 1] = taps[m];
+      }
+
+      d_hist.assign(2*(d_ntaps - 1), 0.0f);
+
+      d_twiddle.resize(nchans);
+      for (unsigned i = 0; i < nchans; i++)
+        d_twiddle[i] = std::polar(1.0f, float(-2.0 * M_PI * i / nchans));
+
+      for (unsigned i = 0; i < (nslices ? nslices : 1); i++) {
+        d_fft.push_back(new gr::fft::fft_complex(nchans, false));
+        d_acc.push_back(std::vector<float>(2*nchans));
+      }
+    }
+
+    pfb_channelizer::~pfb_channelizer()
+    {
+      for (size_t i = 0; i < d_fft.size(); i++)
+        delete d_fft[i];
+    }
+
+    void
+    pfb_channelizer::process(const int16_t *iq, size_t n,
+                             std::vector<std::vector<gr_complex> > &out)
+    {
+      const size_t nout = push(iq, n);
+      for (size_t k = 0; k < d_nchans; k++)
+        out[k].resize(nout);
+      compute(0, nout, 0, out);
+      pop();
+    }
+
+    size_t
+    pfb_channelizer::push(const int16_t *iq, size_t n)
+    {
+      const size_t keep = d_ntaps - 1;
+      d_hist.resize(2*(keep + n));
+      float *x = &d_hist[2*keep];
+      for (size_t i = 0; i < 2*n; i++)
+        x[i] = iq[i];
+
+      d_pushed = n;
+      d_outputs = d_skip < n ? (n - d_skip + d_decim - 1) / d_decim : 0;
+      return d_outputs;
+    }
+
+    /*
+     * Output n of bin k is
+     *
+     *   y_k(n) = sum_m h(m) x(t-m) e^(-j2pi k (t-m)/M),  t = n*D,
+     *
+     * so the window folds into M partial sums v(r) over m = r mod M, an
+     * inverse DFT over r does the mixing, and what is left is the
+     * e^(-j2pi kt/M) from t, a plain twiddle since M is fixed.
+     */
+    void
+    pfb_channelizer::compute(size_t first, size_t last, unsigned slice,
+                             std::vector<std::vector<gr_complex> > &out)
+    {
+      const size_t M = d_nchans;
+      gr::fft::fft_complex &fft = *d_fft[slice];
+      gr_complex *fft_in = fft.get_inbuf();
+      const gr_complex *fft_out = fft.get_outbuf();
+      const float *h = &d_taps[0];
+      float *acc = &d_acc[slice][0];
+
+      for (size_t o = first; o < last; o++) {
+        // The window ends with sample i, window sample j meets tap L-1-j
+        const size_t i = d_skip + o * d_decim;
+        const float *w = &d_hist[2*i];
+        for (size_t r = 0; r < 2*M; r++)
+          acc[r] = h[r] * w[r];
+        for (size_t l = 2*M; l < 2*d_ntaps; l += 2*M)
+          for (size_t r = 0; r < 2*M; r++)
+            acc[r] += h[l + r] * w[l + r];
+
+        // Window sample j is m = L-1-j, so acc[r] belongs to v(M-1-r)
+        for (size_t r = 0; r < M; r++)
+          fft_in[M - 1 - r] = gr_complex(acc[2*r], acc[2*r + 1]);
+        fft.execute();
+
+        const size_t t = (d_time + i) % M;
+        size_t rot = 0;
+        for (size_t k = 0; k < M; k++) {
+          out[k][o] = fft_out[k] * d_twiddle[rot];
+          rot = (rot + t) % M;
+        }
+      }
+    }
+
+    void
+    pfb_channelizer::pop()
+    {
+      const size_t n = d_pushed;
+      d_skip = d_skip + d_outputs * d_decim - n;
+      d_time += n;
+      d_pushed = d_outputs = 0;
+      d_hist.erase(d_hist.begin(), d_hist.begin() + 2*n);
+    }
+
+  } // namespace zluudgbee
+} // namespace gr
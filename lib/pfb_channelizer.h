@@ -0,0 +1,92 @@
+/* -*- c++ -*- */
+/* 
+ * Copyright 2019 Leon Fernandez (zluudg).
+ * 
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ * 
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_ZLUUDGBEE_PFB_CHANNELIZER_H
+#define INCLUDED_ZLUUDGBEE_PFB_CHANNELIZER_H
+
+#include <gnuradio/gr_complex.h>
+#include <gnuradio/fft/fft.h>
+#include <cstddef>
+#include <vector>
+#include <stdint.h>
+
+namespace gr {
+  namespace zluudgbee {
+
+    /*
+     * Polyphase FFT channelizer for sc16 captures. Splits the input into
+     * nchans bins spaced samp_rate/nchans apart, bin k centred on
+     * k*samp_rate/nchans (negative frequencies from nchans/2 up), and
+     * outputs every bin at twice its spacing. The oversampling keeps a
+     * channel that sits right on a bin clear of the edges, so the taps only
+     * have to stop the neighbouring bin's signal, not the transition.
+     *
+     * The taps are the prototype low-pass at the input rate. Outputs are
+     * in the same units as the input. Each of the nslices FFT workspaces
+     * lets one more thread compute outputs at the same time.
+     */
+    class pfb_channelizer
+    {
+     public:
+      pfb_channelizer(unsigned nchans, const std::vector<float> &taps, unsigned nslices = 1);
+      ~pfb_channelizer();
+
+      unsigned nchans() const { return d_nchans; }
+      unsigned decimation() const { return d_decim; }
+
+      /*
+       * Channelizes n interleaved sc16 samples. out[k] receives bin k, one
+       * sample for every decimation() input samples, and must have
+       * nchans() entries.
+       */
+      void process(const int16_t *iq, size_t n, std::vector<std::vector<gr_complex> > &out);
+
+      /*
+       * process() in three steps, for splitting the outputs between
+       * threads. push() takes the samples and returns how many outputs
+       * they complete, compute() fills out[k][first] to out[k][last-1] of
+       * those, which must already be there, and pop() drops the samples
+       * that are no longer needed. compute() calls with different slices
+       * can run concurrently.
+       */
+      size_t push(const int16_t *iq, size_t n);
+      void compute(size_t first, size_t last, unsigned slice,
+                   std::vector<std::vector<gr_complex> > &out);
+      void pop();
+
+     private:
+      unsigned d_nchans;
+      unsigned d_decim;
+      size_t d_ntaps;                 // prototype length, padded to nchans
+      std::vector<float> d_taps;      // reversed, each tap twice for I and Q
+      std::vector<float> d_hist;      // last d_ntaps-1 samples, then the new ones
+      std::vector<gr_complex> d_twiddle;
+      size_t d_skip;                  // samples to go until the next output
+      uint64_t d_time;                // input samples consumed
+      size_t d_pushed;                // samples of the current push
+      size_t d_outputs;               // outputs they complete
+      std::vector<gr::fft::fft_complex *> d_fft;
+      std::vector<std::vector<float> > d_acc;
+    };
+
+  } // namespace zluudgbee
+} // namespace gr
+
+#endif /* INCLUDED_ZLUUDGBEE_PFB_CHANNELIZER_H */
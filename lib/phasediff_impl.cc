@@ -0,0 +1,86 @@
+/* -*- c++ -*- */
+/* 
+ * Copyright 2019 Leon Fernandez (zluudg).
+ * 
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ * 
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <gnuradio/io_signature.h>
+#include "phasediff_impl.h"
+#include "phasediff_kernel.h"
+
+namespace gr {
+  namespace zluudgbee {
+
+    phasediff::sptr
+    phasediff::make(int decim)
+    {
+      return gnuradio::get_initial_sptr(new phasediff_impl(decim));
+    }
+
+    /*
+     * The private constructor
+     */
+    phasediff_impl::phasediff_impl(int decim)
+      : gr::sync_decimator("phasediff",
+              gr::io_signature::make(1, 1, 2*sizeof(int16_t)),
+              gr::io_signature::make(1, 1, sizeof(int32_t)),
+              decim > 0 ? decim : 1),
+        d_decim(decim > 0 ? decim : 1)
+    {
+      // Same as zluudg_decimator coming out of reset
+      d_prev[0] = d_prev[1] = 0;
+    }
+
+    /*
+     * Our virtual destructor.
+     */
+    phasediff_impl::~phasediff_impl()
+    {
+    }
+
+    int
+    phasediff_impl::work(int noutput_items,
+        gr_vector_const_void_star &input_items,
+        gr_vector_void_star &output_items)
+    {
+      const int16_t *in = (const int16_t *) input_items[0];
+      int32_t *out = (int32_t *) output_items[0];
+
+      const int16_t *syms = in;
+      if (d_decim > 1) {
+        d_syms.resize(2*noutput_items);
+        for (int i = 0; i < noutput_items; i++) {
+          d_syms[2*i] = in[2*i*d_decim];
+          d_syms[2*i+1] = in[2*i*d_decim + 1];
+        }
+        syms = &d_syms[0];
+      }
+
+      phasediff_sc16(syms, d_prev, noutput_items, out);
+      d_prev[0] = syms[2*(noutput_items-1)];
+      d_prev[1] = syms[2*(noutput_items-1) + 1];
+
+      // Tell runtime system how many output items we produced.
+      return noutput_items;
+    }
+
+  } /* namespace zluudgbee */
+} /* namespace gr */
@@ -0,0 +1,49 @@
+/* -*- c++ -*- */
+/* 
+ * Copyright 2019 Leon Fernandez (zluudg).
+ * 
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ * 
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_ZLUUDGBEE_PHASEDIFF_IMPL_H
+#define INCLUDED_ZLUUDGBEE_PHASEDIFF_IMPL_H
+
+#include <zluudgbee/phasediff.h>
+#include <vector>
+
+namespace gr {
+  namespace zluudgbee {
+
+    class phasediff_impl : public phasediff
+    {
+     private:
+      const int d_decim;
+      int16_t d_prev[2];             // last symbol of the previous call
+      std::vector<int16_t> d_syms;   // symbols picked out when decimating
+
+     public:
+      phasediff_impl(int decim);
+      ~phasediff_impl();
+
+      int work(int noutput_items,
+         gr_vector_const_void_star &input_items,
+         gr_vector_void_star &output_items);
+    };
+
+  } // namespace zluudgbee
+} // namespace gr
+
+#endif /* INCLUDED_ZLUUDGBEE_PHASEDIFF_IMPL_H */
@@ -0,0 +1,231 @@
+/* -*- c++ -*- */
+/* 
+ * Copyright 2019 Leon Fernandez (zluudg).
+ * 
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ * 
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "phasediff_kernel.h"
+#include "cpu_features.h"
+#include "rx_model.h"
+
+#ifdef ZLUUDGBEE_X86
+#include <immintrin.h>
+#endif
+#ifdef ZLUUDGBEE_NEON
+#include <arm_neon.h>
+#endif
+
+/*
+ * The VHDL keeps the CORDIC in 33-bit registers, but |sym * conj(oldsym)|
+ * is at most 2^31 and the CORDIC gain is below 1.65, so they never
+ * actually wrap. The same goes for the 20-bit phase, which stays within
+ * pi/2 plus the sum of the angle table. The SIMD paths rely on that and
+ * work on plain 64-bit lanes without wrapping anything.
+ */
+
+namespace gr {
+  namespace zluudgbee {
+
+    static const int N_ROT = rx_atan::N_ITER - 1;
+    static const int64_t HALF_PI = 0x3243F;
+
+    static const int64_t ANGLES[N_ROT] = {
+      0x1921F, 0x0ED63, 0x07D6D, 0x03FAB, 0x01FF5, 0x00FFE, 0x007FF, 0x003FF,
+      0x001FF, 0x000FF, 0x0007F, 0x0003F, 0x0001F, 0x0000F, 0x00007, 0x00003
+    };
+
+    void
+    phasediff_sc16_generic(const int16_t *cur, const int16_t *old, size_t n, int32_t *out)
+    {
+      for (size_t i = 0; i < n; i++) {
+        // zluudg_mult sees the words with I in the upper half and conjugates
+        // the old one by negating its 16-bit I, which wraps for -32768.
+        const int32_t a = cur[2*i+1];
+        const int32_t b = cur[2*i];
+        const int32_t c = old[2*i+1];
+        const int32_t d = int16_t(-old[2*i]);
+        const int32_t re = int32_t(uint32_t(a * c) - uint32_t(b * d));
+        const int32_t im = int32_t(uint32_t(a * d) + uint32_t(b * c));
+        out[i] = rx_atan::phase(re, im);
+      }
+    }
+
+#ifdef ZLUUDGBEE_X86
+    // Arithmetic shift of 64-bit lanes, which AVX2 doesn't have
+    ZLUUDGBEE_TARGET("avx2")
+    static inline __m256i
+    srav64(__m256i x, __m128i count)
+    {
+      const __m256i s = _mm256_cmpgt_epi64(_mm256_setzero_si256(), x);
+      return _mm256_xor_si256(_mm256_srl_epi64(_mm256_xor_si256(x, s), count), s);
+    }
+
+    // x where m is clear, -x where it is set
+    ZLUUDGBEE_TARGET("avx2")
+    static inline __m256i
+    negate_if(__m256i x, __m256i m)
+    {
+      return _mm256_sub_epi64(_mm256_xor_si256(x, m), m);
+    }
+
+    // Sign extends the low half of every 64-bit lane
+    ZLUUDGBEE_TARGET("avx2")
+    static inline __m256i
+    sext32(__m256i x)
+    {
+      const __m256i s = _mm256_srai_epi32(x, 31);
+      return _mm256_blend_epi32(x, _mm256_shuffle_epi32(s, _MM_SHUFFLE(2, 2, 0, 0)), 0xAA);
+    }
+
+    ZLUUDGBEE_TARGET("avx2")
+    static size_t
+    phasediff_avx2(const int16_t *cur, const int16_t *old, size_t n, int32_t *out)
+    {
+      const __m256i zero = _mm256_setzero_si256();
+      const __m256i ones = _mm256_set1_epi64x(-1);
+      const __m256i order = _mm256_setr_epi32(0, 2, 4, 6, 1, 3, 5, 7);
+      size_t i = 0;
+      for (; i + 4 <= n; i += 4) {
+        // Four samples per 64-bit lane pair of I/Q. The conjugate negates I
+        // at 16 bits, like the VHDL does.
+        const __m128i c16 = _mm_loadu_si128((const __m128i *) (cur + 2*i));
+        const __m128i o16 = _mm_loadu_si128((const __m128i *) (old + 2*i));
+        const __m128i oc16 = _mm_blend_epi16(o16, _mm_sub_epi16(_mm_setzero_si128(), o16), 0x55);
+        const __m256i c32 = _mm256_cvtepi16_epi32(c16);    // I, Q
+        const __m256i o32 = _mm256_cvtepi16_epi32(oc16);   // -Io, Qo
+
+        // The products fit in 32 bits and the sums wrap at 32 bits, same
+        // as the VHDL before the result is resized to 33 bits.
+        const __m256i p = _mm256_mullo_epi32(c32, o32);    // I*-Io, Q*Qo
+        const __m256i q = _mm256_mullo_epi32(c32, _mm256_shuffle_epi32(o32, _MM_SHUFFLE(2, 3, 0, 1)));
+        const __m256i re = sext32(_mm256_sub_epi32(_mm256_srli_epi64(p, 32), p));
+        const __m256i im = sext32(_mm256_add_epi32(_mm256_srli_epi64(q, 32), q));
+
+        // Coarse rotation by -pi/2 or pi/2 into the right half-plane
+        const __m256i m = _mm256_cmpgt_epi64(zero, im);
+        __m256i x = negate_if(im, m);
+        __m256i y = negate_if(re, _mm256_xor_si256(m, ones));
+        __m256i ph = _mm256_xor_si256(_mm256_set1_epi64x(HALF_PI), m);
+
+        for (int k = 0; k < N_ROT; k++) {
+          const __m128i count = _mm_cvtsi32_si128(k);
+          const __m256i neg = _mm256_cmpgt_epi64(zero, y);
+          const __m256i x_sh = srav64(x, count);
+          const __m256i y_sh = srav64(y, count);
+          x = _mm256_add_epi64(x, negate_if(y_sh, neg));
+          y = _mm256_sub_epi64(y, negate_if(x_sh, neg));
+          ph = _mm256_add_epi64(ph, negate_if(_mm256_set1_epi64x(ANGLES[k]), neg));
+        }
+
+        ph = _mm256_permutevar8x32_epi32(ph, order);
+        _mm_storeu_si128((__m128i *) (out + i), _mm256_castsi256_si128(ph));
+      }
+      return i;
+    }
+#endif
+
+#ifdef ZLUUDGBEE_NEON
+    static inline int64x2_t
+    negate_if(int64x2_t x, int64x2_t m)
+    {
+      return vsubq_s64(veorq_s64(x, m), m);
+    }
+
+    static inline int32x2_t
+    cordic_neon(int64x2_t re, int64x2_t im)
+    {
+      const int64x2_t m = vshrq_n_s64(im, 63);
+      int64x2_t x = negate_if(im, m);
+      int64x2_t y = negate_if(re, veorq_s64(m, vdupq_n_s64(-1)));
+      int64x2_t ph = veorq_s64(vdupq_n_s64(HALF_PI), m);
+
+      for (int k = 0; k < N_ROT; k++) {
+        const int64x2_t count = vdupq_n_s64(-k);
+        const int64x2_t neg = vshrq_n_s64(y, 63);
+        const int64x2_t x_sh = vshlq_s64(x, count);
+        const int64x2_t y_sh = vshlq_s64(y, count);
+        x = vaddq_s64(x, negate_if(y_sh, neg));
+        y = vsubq_s64(y, negate_if(x_sh, neg));
+        ph = vaddq_s64(ph, negate_if(vdupq_n_s64(ANGLES[k]), neg));
+      }
+      return vmovn_s64(ph);
+    }
+
+    static size_t
+    phasediff_neon(const int16_t *cur, const int16_t *old, size_t n, int32_t *out)
+    {
+      size_t i = 0;
+      for (; i + 4 <= n; i += 4) {
+        // vld2 splits I and Q. vneg doesn't saturate, so -(-32768) wraps
+        // like the VHDL, and so do the multiply-accumulates.
+        const int16x4x2_t c = vld2_s16(cur + 2*i);
+        const int16x4x2_t o = vld2_s16(old + 2*i);
+        const int16x4_t d = vneg_s16(o.val[0]);
+        const int32x4_t re = vmlsl_s16(vmull_s16(c.val[1], o.val[1]), c.val[0], d);
+        const int32x4_t im = vmlal_s16(vmull_s16(c.val[1], d), c.val[0], o.val[1]);
+        const int32x2_t lo = cordic_neon(vmovl_s32(vget_low_s32(re)), vmovl_s32(vget_low_s32(im)));
+        const int32x2_t hi = cordic_neon(vmovl_s32(vget_high_s32(re)), vmovl_s32(vget_high_s32(im)));
+        vst1q_s32(out + i, vcombine_s32(lo, hi));
+      }
+      return i;
+    }
+#endif
+
+    typedef size_t (*phasediff_fn)(const int16_t *, const int16_t *, size_t, int32_t *);
+
+    static size_t
+    phasediff_none(const int16_t *, const int16_t *, size_t, int32_t *)
+    {
+      return 0;
+    }
+
+    static phasediff_fn
+    pick_phasediff()
+    {
+#ifdef ZLUUDGBEE_X86
+      if (cpu_has_avx2())
+        return phasediff_avx2;
+#endif
+#ifdef ZLUUDGBEE_NEON
+      return phasediff_neon;
+#endif
+      return phasediff_none;
+    }
+
+    void
+    phasediff_sc16_pairs(const int16_t *cur, const int16_t *old, size_t n, int32_t *out)
+    {
+      static const phasediff_fn simd = pick_phasediff();
+      size_t done = simd(cur, old, n, out);
+      phasediff_sc16_generic(cur + 2*done, old + 2*done, n - done, out + done);
+    }
+
+    void
+    phasediff_sc16(const int16_t *iq, const int16_t *prev, size_t n, int32_t *out)
+    {
+      if (!n)
+        return;
+      phasediff_sc16_generic(iq, prev, 1, out);
+      phasediff_sc16_pairs(iq + 2, iq, n - 1, out + 1);
+    }
+
+  } // namespace zluudgbee
+} // namespace gr
@@ -0,0 +1,58 @@
+/* -*- c++ -*- */
+/* 
+ * Copyright 2019 Leon Fernandez (zluudg).
+ * 
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ * 
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_ZLUUDGBEE_PHASEDIFF_KERNEL_H
+#define INCLUDED_ZLUUDGBEE_PHASEDIFF_KERNEL_H
+
+#include <cstddef>
+#include <stdint.h>
+
+namespace gr {
+  namespace zluudgbee {
+
+    /*
+     * zluudg_mult followed by zluudg_atan over whole buffers: out[i] is the
+     * phase from iq[i-1] to iq[i], with prev standing in for iq[-1].
+     * Samples are sc16, interleaved I/Q. zluudg_mult takes Q as the real
+     * part, so a counterclockwise turn comes out negative. The phase is
+     * 20 bits wide, Q3.17 radians sign extended to 32 bits, and comes out
+     * bit-exact with the FPGA. The AVX2 and NEON paths take four samples at a time. They run
+     * the CORDIC in 64-bit lanes because x and y outgrow 32 bits, and
+     * negate I at 16 bits so that -32768 wraps like it does in the VHDL.
+     */
+    void phasediff_sc16(const int16_t *iq, const int16_t *prev, size_t n, int32_t *out);
+
+    /*
+     * Same thing for separate buffers: out[i] is the phase of cur[i] *
+     * conj(old[i]). Handy when the symbols have been picked out of the
+     * sample stream first.
+     */
+    void phasediff_sc16_pairs(const int16_t *cur, const int16_t *old, size_t n, int32_t *out);
+
+    /*
+     * One sample at a time through rx_atan::phase(). Also does the first
+     * sample of phasediff_sc16(), the one paired with prev.
+     */
+    void phasediff_sc16_generic(const int16_t *cur, const int16_t *old, size_t n, int32_t *out);
+
+  } // namespace zluudgbee
+} // namespace gr
+
+#endif /* INCLUDED_ZLUUDGBEE_PHASEDIFF_KERNEL_H */
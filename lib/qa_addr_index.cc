@@ -0,0 +1,145 @@
+/* -*- c++ -*- */
+/* 
+ * Copyright 2019 Leon Fernandez (zluudg).
+ * 
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ * 
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include <gnuradio/attributes.h>
+#include <cppunit/TestAssert.h>
+#include "qa_addr_index.h"
+#include "addr_index.h"
+#include <cstdlib>
+#include <map>
+#include <vector>
+
+namespace gr {
+  namespace zluudgbee {
+
+    // The slot a key starts probing at in a table of 2^bits slots
+    static size_t
+    home_slot(uint64_t key, unsigned bits)
+    {
+      return size_t((key * 0x9E3779B97F4A7C15ull) >> (64 - bits));
+    }
+
+    // The first n keys from 1 on whose home is slot in a table of 2^bits
+    static std::vector<uint64_t>
+    keys_at(size_t slot, unsigned bits, size_t n)
+    {
+      std::vector<uint64_t> keys;
+      for (uint64_t key = 1; keys.size() < n; key++)
+        if (home_slot(key, bits) == slot)
+          keys.push_back(key);
+      return keys;
+    }
+
+    void
+    qa_addr_index::t_capacity()
+    {
+      addr_index index(3);
+      CPPUNIT_ASSERT_EQUAL(uint32_t(addr_index::NONE), index.find(0x1234));
+      CPPUNIT_ASSERT(index.insert(0x1234, 0));
+      CPPUNIT_ASSERT(index.insert(0x0102030405060708ull, 1));
+      CPPUNIT_ASSERT(index.insert(0, 2));
+      CPPUNIT_ASSERT(!index.insert(0x5678, 3));
+      CPPUNIT_ASSERT_EQUAL(size_t(3), index.size());
+
+      // Replacing still works when full, and erasing makes room
+      CPPUNIT_ASSERT(index.insert(0x1234, 7));
+      CPPUNIT_ASSERT_EQUAL(uint32_t(7), index.find(0x1234));
+      CPPUNIT_ASSERT_EQUAL(uint32_t(1), index.find(0x0102030405060708ull));
+      CPPUNIT_ASSERT_EQUAL(uint32_t(2), index.find(0));
+      CPPUNIT_ASSERT(!index.erase(0x5678));
+      CPPUNIT_ASSERT(index.erase(0));
+      CPPUNIT_ASSERT(!index.erase(0));
+      CPPUNIT_ASSERT_EQUAL(uint32_t(addr_index::NONE), index.find(0));
+      CPPUNIT_ASSERT(index.insert(0x5678, 3));
+      CPPUNIT_ASSERT_EQUAL(uint32_t(3), index.find(0x5678));
+      CPPUNIT_ASSERT_EQUAL(size_t(3), index.size());
+    }
+
+    void
+    qa_addr_index::t_backward_shift()
+    {
+      // With room for eight the table has 16 slots. Five keys that start
+      // at the last slot and two that start at the first make one run
+      // that wraps around the end, with the keys of slot 0 displaced.
+      const unsigned bits = 4;
+      const std::vector<uint64_t> last = keys_at(15, bits, 5);
+      const std::vector<uint64_t> first = keys_at(0, bits, 2);
+      std::vector<uint64_t> keys(last);
+      keys.insert(keys.end(), first.begin(), first.end());
+
+      // Erase from the front, middle and end of the run in turn, the
+      // others have to stay reachable every time
+      const size_t orders[3][7] = {
+        { 0, 1, 2, 3, 4, 5, 6 },
+        { 3, 5, 0, 6, 2, 4, 1 },
+        { 6, 4, 2, 0, 5, 3, 1 }
+      };
+      for (size_t o = 0; o < 3; o++) {
+        addr_index index(8);
+        for (size_t i = 0; i < keys.size(); i++)
+          CPPUNIT_ASSERT(index.insert(keys[i], i));
+
+        std::vector<bool> present(keys.size(), true);
+        for (size_t e = 0; e < keys.size(); e++) {
+          const size_t gone = orders[o][e];
+          CPPUNIT_ASSERT(index.erase(keys[gone]));
+          present[gone] = false;
+          CPPUNIT_ASSERT_EQUAL(keys.size() - e - 1, index.size());
+          for (size_t i = 0; i < keys.size(); i++)
+            CPPUNIT_ASSERT_EQUAL(present[i] ? uint32_t(i) : uint32_t(addr_index::NONE),
+                                 index.find(keys[i]));
+        }
+      }
+    }
+
+    void
+    qa_addr_index::t_churn()
+    {
+      // Devices coming and going at random, checked against std::map. The
+      // keys are close together, like extended addresses of one vendor.
+      std::srand(3);
+      const size_t max = 500;
+      addr_index index(max);
+      std::map<uint64_t, uint32_t> ref;
+      for (uint32_t step = 0; step < 200000; step++) {
+        const uint64_t key = 0x00124B0000000000ull + std::rand() % 1500;
+        switch (std::rand() % 3) {
+        case 0: {
+          const bool room = ref.count(key) || ref.size() < max;
+          CPPUNIT_ASSERT_EQUAL(room, index.insert(key, step));
+          if (room)
+            ref[key] = step;
+          break;
+        }
+        case 1:
+          CPPUNIT_ASSERT_EQUAL(bool(ref.erase(key)), index.erase(key));
+          break;
+        default: {
+          const std::map<uint64_t, uint32_t>::const_iterator it = ref.find(key);
+          CPPUNIT_ASSERT_EQUAL(it == ref.end() ? uint32_t(addr_index::NONE) : it->second,
+                               index.find(key));
+        }
+        }
+        CPPUNIT_ASSERT_EQUAL(ref.size(), index.size());
+      }
+    }
+
+  } /* namespace zluudgbee */
+} /* namespace gr */
@@ -0,0 +1,295 @@
+/* -*- c++ -*- */
+/* 
+ * Copyright 2019 Leon Fernandez (zluudg).
+ * 
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ * 
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include <gnuradio/attributes.h>
+#include <cppunit/TestAssert.h>
+#include "qa_capture_file.h"
+#include "capture_file.h"
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+#include <unistd.h>
+
+namespace gr {
+  namespace zluudgbee {
+
+    typedef std::pair<uint64_t, capture_file::timestamp> time_mark;
+
+    /*
+     * A capture of n samples under /tmp whose I is the sample number and
+     * Q its negative, plus extra bytes at the end. Removed again along
+     * with its index.
+     */
+    class temp_capture
+    {
+     public:
+      explicit temp_capture(size_t n, size_t extra = 0)
+      {
+        char path[] = "/tmp/qa-zluudgbee-XXXXXX";
+        const int fd = mkstemp(path);
+        CPPUNIT_ASSERT(fd >= 0);
+        close(fd);
+        d_path = path;
+
+        std::vector<int16_t> samples(2 * n);
+        for (size_t i = 0; i < n; i++) {
+          samples[2*i] = int16_t(i);
+          samples[2*i + 1] = -int16_t(i);
+        }
+        samples.resize(samples.size() + (extra + 1) / 2);
+        std::ofstream out(path, std::ios::binary);
+        out.write(reinterpret_cast<const char *>(&samples[0]), 2 * n * sizeof(int16_t) + extra);
+      }
+
+      ~temp_capture()
+      {
+        std::remove(index().c_str());
+        std::remove(d_path.c_str());
+      }
+
+      const std::string &path() const { return d_path; }
+      // Where capture_file looks for the index by default
+      std::string index() const { return d_path + ".idx"; }
+
+      void write_index(const std::string &text) const
+      {
+        std::ofstream out(index().c_str());
+        out << text;
+      }
+
+     private:
+      std::string d_path;
+    };
+
+    static time_mark
+    mark(uint64_t sample, int64_t secs, double frac)
+    {
+      capture_file::timestamp t;
+      t.secs = secs;
+      t.frac = frac;
+      return time_mark(sample, t);
+    }
+
+    static void
+    check_time(int64_t secs, double frac, const capture_file::timestamp &t)
+    {
+      CPPUNIT_ASSERT_EQUAL(secs, t.secs);
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(frac, t.frac, 1e-9);
+    }
+
+    void
+    qa_capture_file::t_no_index()
+    {
+      // A trailing half sample is left out
+      const temp_capture capture(1000, 3);
+      const capture_file file(capture.path(), "", 1000.0);
+      CPPUNIT_ASSERT(!file.has_index());
+      CPPUNIT_ASSERT_EQUAL(uint64_t(1000), file.size());
+      CPPUNIT_ASSERT_EQUAL(1000.0, file.sample_rate());
+      CPPUNIT_ASSERT_EQUAL(int16_t(999), file.samples()[2 * 999]);
+      CPPUNIT_ASSERT_EQUAL(int16_t(-999), file.samples()[2 * 999 + 1]);
+      CPPUNIT_ASSERT(file.frame_starts().empty());
+
+      // Sample zero is at time zero
+      check_time(0, 0.0, file.time_at(0));
+      check_time(1, 0.25, file.time_at(1250));
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(0.25, file.offset_at(250), 1e-12);
+      CPPUNIT_ASSERT_EQUAL(uint64_t(250), file.sample_at(0.25));
+      CPPUNIT_ASSERT_EQUAL(uint64_t(251), file.sample_at(0.2505));
+      CPPUNIT_ASSERT_EQUAL(uint64_t(0), file.sample_at(-1.0));
+      CPPUNIT_ASSERT_EQUAL(file.size(), file.sample_at(5.0));
+      CPPUNIT_ASSERT_EQUAL(file.size(), file.next_timestamp(0));
+
+      CPPUNIT_ASSERT_THROW(capture_file(capture.path(), "", 0.0), std::runtime_error);
+      CPPUNIT_ASSERT_THROW(capture_file(capture.path() + ".missing", "", 1.0),
+                           std::runtime_error);
+    }
+
+    void
+    qa_capture_file::t_index()
+    {
+      // 500 samples at 100 per second from a quarter past an epoch
+      // second, then a gap, then 500 more from 20 s on
+      const temp_capture capture(1000);
+      const int64_t epoch = 1700000000;
+      std::vector<time_mark> times;
+      times.push_back(mark(500, epoch + 20, 0.0));
+      times.push_back(mark(0, epoch, 0.25));
+      std::vector<uint64_t> frames;
+      frames.push_back(420);
+      frames.push_back(100);
+      write_capture_index(capture.index(), 100.0, times, frames);
+
+      // The rate of the index wins, the entries come out sorted
+      const capture_file file(capture.path(), "", 1.0);
+      CPPUNIT_ASSERT(file.has_index());
+      CPPUNIT_ASSERT_EQUAL(100.0, file.sample_rate());
+      CPPUNIT_ASSERT_EQUAL(size_t(2), file.frame_starts().size());
+      CPPUNIT_ASSERT_EQUAL(uint64_t(100), file.frame_starts()[0]);
+      CPPUNIT_ASSERT_EQUAL(uint64_t(420), file.frame_starts()[1]);
+
+      check_time(epoch, 0.25, file.time_at(0));
+      check_time(epoch + 5, 0.24, file.time_at(499));
+      check_time(epoch + 20, 0.0, file.time_at(500));
+      check_time(epoch + 22, 0.5, file.time_at(750));
+
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(4.99, file.offset_at(499), 1e-9);
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(19.75, file.offset_at(500), 1e-9);
+      CPPUNIT_ASSERT_EQUAL(uint64_t(200), file.sample_at(2.0));
+      CPPUNIT_ASSERT_EQUAL(uint64_t(499), file.sample_at(4.99));
+      CPPUNIT_ASSERT_EQUAL(uint64_t(500), file.sample_at(10.0));   // in the gap
+      CPPUNIT_ASSERT_EQUAL(uint64_t(500), file.sample_at(19.75));
+      CPPUNIT_ASSERT_EQUAL(uint64_t(750), file.sample_at(22.25));
+      CPPUNIT_ASSERT_EQUAL(file.size(), file.sample_at(100.0));
+
+      CPPUNIT_ASSERT_EQUAL(uint64_t(500), file.next_timestamp(0));
+      CPPUNIT_ASSERT_EQUAL(uint64_t(500), file.next_timestamp(499));
+      CPPUNIT_ASSERT_EQUAL(file.size(), file.next_timestamp(500));
+    }
+
+    void
+    qa_capture_file::t_index_syntax()
+    {
+      // Comments, blank lines and an index given by path. The first time
+      // entry is late and negative, earlier samples run back from it.
+      const temp_capture capture(100);
+      const std::string index = capture.path() + ".times";
+      {
+        std::ofstream out(index.c_str());
+        out << "# recorded with rx_samples_to_file\n"
+            << "\n"
+            << "rate 2e6   # Hz\n"
+            << "  time 10 -1.25\n"
+            << "frame 5\n";
+      }
+      // An index next to the capture is ignored when one is given
+      capture.write_index("rate 5\n");
+
+      const capture_file file(capture.path(), index, 1.0);
+      std::remove(index.c_str());
+      CPPUNIT_ASSERT_EQUAL(2e6, file.sample_rate());
+      CPPUNIT_ASSERT_EQUAL(size_t(1), file.frame_starts().size());
+      check_time(-2, 0.75, file.time_at(10));
+      check_time(-2, 0.75 - 10 / 2e6, file.time_at(0));
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(10 / 2e6, file.offset_at(10), 1e-12);
+      CPPUNIT_ASSERT_EQUAL(uint64_t(10), file.sample_at(10 / 2e6));
+      CPPUNIT_ASSERT_EQUAL(uint64_t(10), file.next_timestamp(0));
+
+      // Twelve digits of fraction survive at epoch times
+      std::vector<time_mark> times(1, mark(0, 1700000000, 0.123456789012));
+      write_capture_index(capture.index(), 1e6, times, std::vector<uint64_t>());
+      const capture_file precise(capture.path(), "", 1.0);
+      check_time(1700000000, 0.123456789012, precise.time_at(0));
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(0.123456789012, precise.time_at(0).frac, 1e-13);
+    }
+
+    void
+    qa_capture_file::t_bad_index()
+    {
+      const temp_capture capture(10);
+      const char *bad[] = {
+        "rate\n",
+        "rate fast\n",
+        "rate 0\n",
+        "time 5\n",
+        "time 5 1.5.2\n",
+        "time 5 x\n",
+        "frame -\n",
+        "frame 1 2\n",
+        "rate 100\nduration 5\n"
+      };
+      for (size_t i = 0; i < sizeof(bad) / sizeof(bad[0]); i++) {
+        capture.write_index(bad[i]);
+        CPPUNIT_ASSERT_THROW(capture_file(capture.path(), "", 1.0), std::runtime_error);
+      }
+      CPPUNIT_ASSERT_THROW(capture_file(capture.path(), capture.path() + ".none", 1.0),
+                           std::runtime_error);
+    }
+
+    // The chunks own all of the capture between them, in order
+    static void
+    check_cover(const std::vector<capture_file::chunk> &chunks, uint64_t size)
+    {
+      CPPUNIT_ASSERT_EQUAL(uint64_t(0), chunks.front().owned);
+      CPPUNIT_ASSERT_EQUAL(size, chunks.back().end);
+      for (size_t k = 0; k < chunks.size(); k++) {
+        CPPUNIT_ASSERT(chunks[k].begin <= chunks[k].owned);
+        CPPUNIT_ASSERT(chunks[k].owned <= chunks[k].end);
+        if (k)
+          CPPUNIT_ASSERT_EQUAL(chunks[k - 1].end, chunks[k].owned);
+      }
+    }
+
+    void
+    qa_capture_file::t_split()
+    {
+      const temp_capture capture(1000);
+      {
+        const capture_file file(capture.path(), "", 1.0);
+        const std::vector<capture_file::chunk> chunks = file.split(4, 50);
+        CPPUNIT_ASSERT_EQUAL(size_t(4), chunks.size());
+        check_cover(chunks, file.size());
+        for (size_t k = 0; k < chunks.size(); k++) {
+          CPPUNIT_ASSERT_EQUAL(uint64_t(250 * k), chunks[k].owned);
+          CPPUNIT_ASSERT_EQUAL(uint64_t(k ? 250 * k - 50 : 0), chunks[k].begin);
+        }
+
+        // Uneven lengths are spread out, and one chunk is the whole capture
+        const std::vector<capture_file::chunk> thirds = file.split(3, 0);
+        check_cover(thirds, file.size());
+        CPPUNIT_ASSERT_EQUAL(uint64_t(333), thirds[1].owned);
+        CPPUNIT_ASSERT_EQUAL(uint64_t(666), thirds[2].owned);
+        CPPUNIT_ASSERT_EQUAL(uint64_t(333), thirds[1].begin);
+        CPPUNIT_ASSERT_EQUAL(size_t(1), file.split(0, 10).size());
+        check_cover(file.split(0, 10), file.size());
+      }
+
+      // Boundaries move on to the next frame start
+      std::vector<uint64_t> frames;
+      frames.push_back(100);
+      frames.push_back(300);
+      frames.push_back(420);
+      frames.push_back(700);
+      frames.push_back(950);
+      write_capture_index(capture.index(), 1.0, std::vector<time_mark>(), frames);
+      {
+        const capture_file file(capture.path(), "", 1.0);
+        const std::vector<capture_file::chunk> chunks = file.split(3, 20);
+        check_cover(chunks, file.size());
+        CPPUNIT_ASSERT_EQUAL(uint64_t(420), chunks[1].owned);
+        CPPUNIT_ASSERT_EQUAL(uint64_t(400), chunks[1].begin);
+        CPPUNIT_ASSERT_EQUAL(uint64_t(700), chunks[2].owned);
+        CPPUNIT_ASSERT_EQUAL(uint64_t(680), chunks[2].begin);
+      }
+
+      // With no frame start after a boundary the chunks after it are empty
+      write_capture_index(capture.index(), 1.0, std::vector<time_mark>(),
+                          std::vector<uint64_t>(1, 10));
+      {
+        const capture_file file(capture.path(), "", 1.0);
+        const std::vector<capture_file::chunk> chunks = file.split(3, 20);
+        check_cover(chunks, file.size());
+        CPPUNIT_ASSERT_EQUAL(file.size(), chunks[0].end);
+        CPPUNIT_ASSERT_EQUAL(file.size(), chunks[2].owned);
+      }
+    }
+
+  } /* namespace zluudgbee */
+} /* namespace gr */
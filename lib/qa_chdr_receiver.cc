@@ -0,0 +1,418 @@
+/* -*- c++ -*- */
+/* 
+ * Copyright 2019 Leon Fernandez (zluudg).
+ * 
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ * 
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include <gnuradio/attributes.h>
+#include <cppunit/TestAssert.h>
+#include "qa_chdr_receiver.h"
+#include "chdr_receiver.h"
+#include "mock_rx_streamer.h"
+#include <gnuradio/block.h>
+#include <zluudgbee/crc16.h>
+#include <boost/thread/thread_time.hpp>
+#include <vector>
+
+namespace gr {
+  namespace zluudgbee {
+
+    static const size_t MTU = 256;
+    static const size_t RING_DEPTH = 64;
+
+    namespace {
+
+    // The block the receiver publishes from, as chdr2pdu is in a flowgraph
+    class pdu_source : public gr::block
+    {
+     public:
+      typedef boost::shared_ptr<pdu_source> sptr;
+
+      static sptr make()
+      {
+        return gnuradio::get_initial_sptr(new pdu_source());
+      }
+
+      gr::logger_ptr logger() const { return d_logger; }
+
+     private:
+      pdu_source()
+        : gr::block("pdu_source",
+                    gr::io_signature::make(0, 0, 0),
+                    gr::io_signature::make(0, 0, 0))
+      {
+        message_port_register_out(pmt::mp("pdus"));
+      }
+    };
+
+    /*
+     * Keeps the PDUs posted to it. While held, the first one to come in
+     * keeps the publisher thread waiting in _post() until release().
+     */
+    class pdu_collector : public gr::block
+    {
+     public:
+      typedef boost::shared_ptr<pdu_collector> sptr;
+
+      static sptr make()
+      {
+        return gnuradio::get_initial_sptr(new pdu_collector());
+      }
+
+      void _post(pmt::pmt_t which_port, pmt::pmt_t msg)
+      {
+        gr::thread::scoped_lock lock(d_mutex);
+        while (d_held) {
+          d_blocked = true;
+          d_cond.notify_all();
+          d_cond.wait(lock);
+        }
+        d_pdus.push_back(msg);
+        d_cond.notify_all();
+      }
+
+      void hold()
+      {
+        gr::thread::scoped_lock lock(d_mutex);
+        d_held = true;
+      }
+
+      void release()
+      {
+        gr::thread::scoped_lock lock(d_mutex);
+        d_held = false;
+        d_cond.notify_all();
+      }
+
+      // Waits up to seconds for the publisher to get stuck in _post()
+      bool wait_blocked(double seconds)
+      {
+        const boost::system_time deadline = boost::get_system_time() +
+          boost::posix_time::milliseconds(long(seconds * 1000));
+        gr::thread::scoped_lock lock(d_mutex);
+        while (!d_blocked) {
+          if (!d_cond.timed_wait(lock, deadline))
+            break;
+        }
+        return d_blocked;
+      }
+
+      // Waits up to seconds for count PDUs, returns those that came in
+      std::vector<pmt::pmt_t> wait_for(size_t count, double seconds)
+      {
+        const boost::system_time deadline = boost::get_system_time() +
+          boost::posix_time::milliseconds(long(seconds * 1000));
+        gr::thread::scoped_lock lock(d_mutex);
+        while (d_pdus.size() < count) {
+          if (!d_cond.timed_wait(lock, deadline))
+            break;
+        }
+        return d_pdus;
+      }
+
+     private:
+      gr::thread::mutex d_mutex;
+      gr::thread::condition_variable d_cond;
+      bool d_held;
+      bool d_blocked;
+      std::vector<pmt::pmt_t> d_pdus;
+
+      pdu_collector()
+        : gr::block("pdu_collector",
+                    gr::io_signature::make(0, 0, 0),
+                    gr::io_signature::make(0, 0, 0)),
+          d_held(false),
+          d_blocked(false)
+      {
+        message_port_register_in(pmt::mp("pdus"));
+      }
+    };
+
+    /*
+     * A running receiver that publishes into a pdu_collector. The
+     * streamers it plays are kept until the receiver is shut down.
+     */
+    class receiver_harness
+    {
+     public:
+      const pdu_source::sptr source;
+      const pdu_collector::sptr collector;
+      chdr_receiver receiver;
+
+      receiver_harness(bool hw_crc, size_t ring_depth, bool drop_oldest)
+        : source(pdu_source::make()),
+          collector(pdu_collector::make()),
+          receiver(MTU, hw_crc, ring_depth, drop_oldest, "", 0,
+                   metrics::register_stage("qa_chdr_receiver"), source->logger())
+      {
+        const pmt::pmt_t port = pmt::mp("pdus");
+        source->message_port_sub(port, pmt::cons(collector->alias_pmt(), port));
+        receiver.start(source.get(), port);
+      }
+
+      ~receiver_harness()
+      {
+        // A failed check may leave the publisher held
+        collector->release();
+        receiver.shutdown();
+      }
+
+      // Attaches a new streamer that plays bursts
+      mock_rx_streamer::sptr
+      play(const std::vector<std::vector<uint8_t> > &bursts,
+           const mock_rx_streamer::options &opts = mock_rx_streamer::options())
+      {
+        mock_rx_streamer::sptr stream(new mock_rx_streamer(bursts, opts));
+        stream->issue_stream_cmd(
+          ::uhd::stream_cmd_t(::uhd::stream_cmd_t::STREAM_MODE_START_CONTINUOUS));
+        d_streams.push_back(stream);
+        receiver.attach(stream);
+        return stream;
+      }
+
+     private:
+      std::vector<mock_rx_streamer::sptr> d_streams;
+    };
+
+    } // namespace
+
+    // Polls cond for up to two seconds
+    template <typename F>
+    static bool
+    eventually(F cond)
+    {
+      for (int i = 0; i < 200; i++) {
+        if (cond())
+          return true;
+        boost::this_thread::sleep(boost::posix_time::milliseconds(10));
+      }
+      return cond();
+    }
+
+    static std::vector<uint8_t>
+    numbered(size_t len, uint8_t first)
+    {
+      std::vector<uint8_t> psdu(len);
+      for (size_t i = 0; i < len; i++)
+        psdu[i] = uint8_t(first + i);
+      return psdu;
+    }
+
+    // Appends the FCS, low byte first
+    static std::vector<uint8_t>
+    with_fcs(const std::vector<uint8_t> &psdu)
+    {
+      std::vector<uint8_t> frame(psdu);
+      const uint16_t fcs = crc16::compute(&psdu[0], psdu.size());
+      frame.push_back(fcs & 0xFF);
+      frame.push_back(fcs >> 8);
+      return frame;
+    }
+
+    static void
+    pack(const std::vector<uint8_t> &psdu, bool crc_checked, std::vector<uint8_t> &items)
+    {
+      chdr_pack_frame(&psdu[0], psdu.size(), crc_checked, items);
+    }
+
+    static std::vector<uint8_t>
+    payload(const pmt::pmt_t &pdu)
+    {
+      return pmt::u8vector_elements(pmt::cdr(pdu));
+    }
+
+    static pmt::pmt_t
+    meta_ref(const pmt::pmt_t &pdu, const char *key)
+    {
+      return pmt::dict_ref(pmt::car(pdu), pmt::mp(key), pmt::PMT_NIL);
+    }
+
+    void
+    qa_chdr_receiver::t_split()
+    {
+      // Three frames with padding in between in one burst, one in the
+      // next. The second frame has three uncertain nibbles.
+      std::vector<std::vector<uint8_t> > bursts(2);
+      pack(numbered(5, 1), false, bursts[0]);
+      bursts[0].resize(bursts[0].size() + 3 * CHDR_ITEM_SIZE, 0);
+      const size_t second = bursts[0].size();
+      pack(numbered(12, 0x20), false, bursts[0]);
+      bursts[0][second + 3 * CHDR_ITEM_SIZE + CHDR_FLAG_LANE] |= CHDR_FLAG_CRAP1;
+      bursts[0][second + 7 * CHDR_ITEM_SIZE + CHDR_FLAG_LANE] |= CHDR_FLAG_CRAP1 | CHDR_FLAG_CRAP2;
+      pack(numbered(3, 0x40), false, bursts[0]);
+      pack(numbered(20, 0x60), false, bursts[1]);
+
+      receiver_harness h(false, RING_DEPTH, false);
+      h.play(bursts);
+      const std::vector<pmt::pmt_t> pdus = h.collector->wait_for(4, 2.0);
+      CPPUNIT_ASSERT_EQUAL(size_t(4), pdus.size());
+
+      CPPUNIT_ASSERT(payload(pdus[0]) == numbered(5, 1));
+      CPPUNIT_ASSERT(payload(pdus[1]) == numbered(12, 0x20));
+      CPPUNIT_ASSERT(payload(pdus[2]) == numbered(3, 0x40));
+      CPPUNIT_ASSERT(payload(pdus[3]) == numbered(20, 0x60));
+
+      const long crappy[4] = { 0, 3, 0, 0 };
+      for (size_t i = 0; i < pdus.size(); i++) {
+        CPPUNIT_ASSERT_EQUAL(crappy[i], pmt::to_long(meta_ref(pdus[i], "crappy_nibbles")));
+        CPPUNIT_ASSERT(!pmt::dict_has_key(pmt::car(pdus[i]), pmt::mp("crc_ok")));
+      }
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(1.0, pmt::to_double(meta_ref(pdus[0], "confidence")), 1e-12);
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(1.0 - 3.0 / 24, pmt::to_double(meta_ref(pdus[1], "confidence")), 1e-12);
+      CPPUNIT_ASSERT_EQUAL(uint64_t(0), h.receiver.ring_drops());
+    }
+
+    void
+    qa_chdr_receiver::t_hw_crc()
+    {
+      // Frames the FPGA flagged in crc_mode 2, with their FCS, and frames
+      // it didn't flag, which crc_mode 0 has already checked and cut the
+      // FCS off. Those are published as they are, short or not.
+      const std::vector<uint8_t> flagged = with_fcs(numbered(10, 0x10));
+      std::vector<uint8_t> flagged_bad(flagged);
+      flagged_bad[2] ^= 0x01;
+
+      std::vector<std::vector<uint8_t> > bursts(1);
+      pack(flagged_bad, true, bursts[0]);
+      pack(std::vector<uint8_t>(1, 0x55), true, bursts[0]);  // too short for an FCS
+      pack(numbered(7, 0x40), false, bursts[0]);
+      pack(flagged, true, bursts[0]);
+      pack(std::vector<uint8_t>(1, 0x66), false, bursts[0]);
+
+      receiver_harness h(true, RING_DEPTH, false);
+      h.play(bursts);
+      const std::vector<pmt::pmt_t> pdus = h.collector->wait_for(3, 2.0);
+      CPPUNIT_ASSERT_EQUAL(size_t(3), pdus.size());
+
+      CPPUNIT_ASSERT(payload(pdus[0]) == numbered(7, 0x40));
+      CPPUNIT_ASSERT(payload(pdus[1]) == numbered(10, 0x10));
+      CPPUNIT_ASSERT(payload(pdus[2]) == std::vector<uint8_t>(1, 0x66));
+      for (size_t i = 0; i < pdus.size(); i++)
+        CPPUNIT_ASSERT(pmt::eq(pmt::PMT_T, meta_ref(pdus[i], "crc_ok")));
+      CPPUNIT_ASSERT_EQUAL(uint64_t(2), h.receiver.crc_failures());
+    }
+
+    void
+    qa_chdr_receiver::t_rx_errors()
+    {
+      // Calls 3, 6, 9, ... overflow and 5, 10 and 20 time out, so the
+      // twelve bursts take 22 calls. Nothing is lost either way.
+      std::vector<std::vector<uint8_t> > bursts(12);
+      for (size_t b = 0; b < bursts.size(); b++)
+        pack(numbered(4, uint8_t(b * 4)), false, bursts[b]);
+      mock_rx_streamer::options opts;
+      opts.overflow_every = 3;
+      opts.timeout_every = 5;
+
+      receiver_harness h(false, RING_DEPTH, false);
+      const mock_rx_streamer::sptr stream = h.play(bursts, opts);
+      const std::vector<pmt::pmt_t> pdus = h.collector->wait_for(bursts.size(), 2.0);
+      CPPUNIT_ASSERT_EQUAL(bursts.size(), pdus.size());
+      for (size_t b = 0; b < pdus.size(); b++)
+        CPPUNIT_ASSERT(payload(pdus[b]) == numbered(4, uint8_t(b * 4)));
+
+      CPPUNIT_ASSERT_EQUAL(uint64_t(7), stream->overflows());
+      CPPUNIT_ASSERT_EQUAL(uint64_t(3), stream->timeouts());
+      CPPUNIT_ASSERT_EQUAL(uint64_t(7), h.receiver.rx_overflows());
+
+      // Timeouts only count in a blocking recv(), and once the streamer
+      // has played out that's where they happen
+      CPPUNIT_ASSERT(eventually([&] { return h.receiver.rx_timeouts() > 0; }));
+    }
+
+    void
+    qa_chdr_receiver::t_stop_eob()
+    {
+      // A stop is followed by the burst zluudgbeeRX ends its stream with
+      std::vector<std::vector<uint8_t> > bursts(1);
+      pack(numbered(6, 0x30), false, bursts[0]);
+      std::vector<uint8_t> items(MTU * CHDR_ITEM_SIZE);
+      ::uhd::rx_metadata_t md;
+      mock_rx_streamer mock(bursts, mock_rx_streamer::options());
+      mock.issue_stream_cmd(
+        ::uhd::stream_cmd_t(::uhd::stream_cmd_t::STREAM_MODE_START_CONTINUOUS));
+      CPPUNIT_ASSERT_EQUAL(size_t(6), mock.recv(&items[0], MTU, md, 0.0));
+      mock.issue_stream_cmd(
+        ::uhd::stream_cmd_t(::uhd::stream_cmd_t::STREAM_MODE_STOP_CONTINUOUS));
+      CPPUNIT_ASSERT_EQUAL(size_t(1), mock.recv(&items[0], MTU, md, 0.0));
+      CPPUNIT_ASSERT(md.end_of_burst);
+      CPPUNIT_ASSERT_EQUAL(CHDR_FLAG_EOB, items[CHDR_FLAG_LANE]);
+      CPPUNIT_ASSERT_EQUAL(size_t(0), mock.recv(&items[0], MTU, md, 0.0));
+      CPPUNIT_ASSERT_EQUAL(::uhd::rx_metadata_t::ERROR_CODE_TIMEOUT, md.error_code);
+
+      // Stopped the way chdr2pdu::stop() does it, the EOB burst gets the
+      // RX thread out of recv() well before RECV_TIMEOUT, and it carries
+      // no frame
+      receiver_harness h(false, RING_DEPTH, false);
+      const mock_rx_streamer::sptr stream = h.play(bursts);
+      CPPUNIT_ASSERT_EQUAL(size_t(1), h.collector->wait_for(1, 2.0).size());
+      h.receiver.detach();
+      stream->issue_stream_cmd(
+        ::uhd::stream_cmd_t(::uhd::stream_cmd_t::STREAM_MODE_STOP_CONTINUOUS));
+      const boost::system_time start = boost::get_system_time();
+      h.receiver.shutdown();
+      CPPUNIT_ASSERT((boost::get_system_time() - start).total_milliseconds() < 50);
+      CPPUNIT_ASSERT_EQUAL(size_t(1), h.collector->wait_for(2, 0.1).size());
+    }
+
+    /*
+     * Holds the publisher on a first PDU, then sends ten one-byte frames
+     * in one burst at a ring of four. Returns what got through.
+     */
+    static std::vector<pmt::pmt_t>
+    overrun_ring(bool drop_oldest)
+    {
+      receiver_harness h(false, 4, drop_oldest);
+      h.collector->hold();
+      std::vector<std::vector<uint8_t> > plug(1);
+      pack(std::vector<uint8_t>(1, 0xEE), false, plug[0]);
+      h.play(plug);
+      CPPUNIT_ASSERT(h.collector->wait_blocked(2.0));
+
+      std::vector<std::vector<uint8_t> > bursts(1);
+      for (uint8_t i = 0; i < 10; i++)
+        pack(std::vector<uint8_t>(1, i), false, bursts[0]);
+      h.play(bursts);
+      CPPUNIT_ASSERT(eventually([&] { return h.receiver.ring_drops() == 6; }));
+      CPPUNIT_ASSERT_EQUAL(size_t(4), h.receiver.ring_high_water());
+
+      h.collector->release();
+      const std::vector<pmt::pmt_t> pdus = h.collector->wait_for(5, 2.0);
+      CPPUNIT_ASSERT_EQUAL(size_t(5), pdus.size());
+      CPPUNIT_ASSERT(payload(pdus[0]) == std::vector<uint8_t>(1, 0xEE));
+      CPPUNIT_ASSERT_EQUAL(uint64_t(6), h.receiver.ring_drops());
+      return pdus;
+    }
+
+    void
+    qa_chdr_receiver::t_drop_newest()
+    {
+      const std::vector<pmt::pmt_t> pdus = overrun_ring(false);
+      for (size_t i = 1; i < pdus.size(); i++)
+        CPPUNIT_ASSERT(payload(pdus[i]) == std::vector<uint8_t>(1, uint8_t(i - 1)));
+    }
+
+    void
+    qa_chdr_receiver::t_drop_oldest()
+    {
+      const std::vector<pmt::pmt_t> pdus = overrun_ring(true);
+      for (size_t i = 1; i < pdus.size(); i++)
+        CPPUNIT_ASSERT(payload(pdus[i]) == std::vector<uint8_t>(1, uint8_t(i + 5)));
+    }
+
+  } /* namespace zluudgbee */
+} /* namespace gr */
@@ -0,0 +1,54 @@
+/* -*- c++ -*- */
+/* 
+ * Copyright 2019 Leon Fernandez (zluudg).
+ * 
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ * 
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef _QA_CHDR_RECEIVER_H_
+#define _QA_CHDR_RECEIVER_H_
+
+#include <cppunit/extensions/HelperMacros.h>
+#include <cppunit/TestCase.h>
+
+namespace gr {
+  namespace zluudgbee {
+
+    class qa_chdr_receiver : public CppUnit::TestCase
+    {
+    public:
+      CPPUNIT_TEST_SUITE(qa_chdr_receiver);
+      CPPUNIT_TEST(t_split);
+      CPPUNIT_TEST(t_hw_crc);
+      CPPUNIT_TEST(t_rx_errors);
+      CPPUNIT_TEST(t_stop_eob);
+      CPPUNIT_TEST(t_drop_newest);
+      CPPUNIT_TEST(t_drop_oldest);
+      CPPUNIT_TEST_SUITE_END();
+
+    private:
+      void t_split();
+      void t_hw_crc();
+      void t_rx_errors();
+      void t_stop_eob();
+      void t_drop_newest();
+      void t_drop_oldest();
+    };
+
+  } /* namespace zluudgbee */
+} /* namespace gr */
+
+#endif /* _QA_CHDR_RECEIVER_H_ */
@@ -0,0 +1,507 @@
+/* -*- c++ -*- */
+/* 
+ * Copyright 2019 Leon Fernandez (zluudg).
+ * 
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ * 
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include <gnuradio/attributes.h>
+#include <cppunit/TestAssert.h>
+#include "qa_coord_engine.h"
+#include "coord_engine.h"
+#include <zluudgbee/crc16.h>
+#include <vector>
+
+namespace gr {
+  namespace zluudgbee {
+
+    typedef std::vector<uint8_t> bytes;
+
+    // What devices send: commands and data to the coordinator's short
+    // address, association requests without a PAN of their own yet
+    static const uint16_t FC_ASSOC_REQUEST = 0xC823;
+    static const uint16_t FC_EXT_COMMAND = 0xC863;
+    static const uint16_t FC_SHORT_COMMAND = 0x8863;
+    static const uint16_t FC_SHORT_DATA = 0x8861;
+
+    static const uint64_t DEVICE = 0x00124B0001020300ull;
+
+    class recording_output : public coord_engine::output
+    {
+     public:
+      std::vector<bytes> sent;
+      std::vector<bytes> delivered;     // payloads
+
+      void transmit(const uint8_t *frame, size_t len)
+      {
+        sent.push_back(bytes(frame, frame + len));
+      }
+
+      void deliver(const mac_frame_view &frame)
+      {
+        delivered.push_back(bytes(frame.payload(), frame.payload() + frame.payload_len()));
+      }
+
+      // The frames sent since the last call
+      std::vector<bytes> take()
+      {
+        std::vector<bytes> frames;
+        frames.swap(sent);
+        return frames;
+      }
+    };
+
+    static void
+    put_le(bytes &frame, uint64_t x, size_t len)
+    {
+      for (size_t i = 0; i < len; i++)
+        frame.push_back(uint8_t(x >> (8*i)));
+    }
+
+    static bytes
+    from_device(const coord_config &config, uint16_t fc, uint8_t seq, uint64_t src,
+                const bytes &payload)
+    {
+      bytes frame;
+      put_le(frame, fc, 2);
+      frame.push_back(seq);
+      put_le(frame, config.pan_id, 2);
+      put_le(frame, config.short_addr, 2);
+      if (!(fc & 0x0040))
+        put_le(frame, 0xFFFF, 2);
+      put_le(frame, src, (fc >> 14) == mac_frame_view::ADDR_EXTENDED ? 8 : 2);
+      frame.insert(frame.end(), payload.begin(), payload.end());
+      return frame;
+    }
+
+    static bytes
+    command(const coord_config &config, uint16_t fc, uint8_t seq, uint64_t src, uint8_t id)
+    {
+      bytes payload(1, id);
+      if (id == mac_frame_view::CMD_ASSOCIATION_REQUEST)
+        payload.push_back(0x80);        // capability: allocate an address
+      return from_device(config, fc, seq, src, payload);
+    }
+
+    static bytes
+    ack(uint8_t seq)
+    {
+      const uint8_t frame[3] = { mac_frame_view::FRAME_ACK, 0x00, seq };
+      return bytes(frame, frame + 3);
+    }
+
+    static void
+    handle(coord_engine &engine, const bytes &frame, uint64_t now)
+    {
+      engine.handle(mac_frame_view(&frame[0], frame.size()), now);
+    }
+
+    // Checks the FCS of a frame the engine sent and parses the rest
+    static mac_frame_view
+    parse_sent(const bytes &frame)
+    {
+      CPPUNIT_ASSERT_EQUAL(0, int(crc16::compute(&frame[0], frame.size())));
+      const mac_frame_view view(&frame[0], frame.size(), true);
+      CPPUNIT_ASSERT(view.valid());
+      return view;
+    }
+
+    static void
+    check_ack(const bytes &frame, uint8_t seq, bool pending)
+    {
+      const mac_frame_view view = parse_sent(frame);
+      CPPUNIT_ASSERT_EQUAL(int(mac_frame_view::FRAME_ACK), int(view.frame_type()));
+      CPPUNIT_ASSERT_EQUAL(seq, view.sequence_number());
+      CPPUNIT_ASSERT_EQUAL(pending, view.frame_pending());
+    }
+
+    // Status and short address of an association response
+    static void
+    check_assoc_response(const bytes &frame, const coord_config &config, uint64_t device,
+                         uint8_t status, uint16_t &short_addr)
+    {
+      const mac_frame_view view = parse_sent(frame);
+      CPPUNIT_ASSERT_EQUAL(int(mac_frame_view::CMD_ASSOCIATION_RESPONSE), view.command_id());
+      CPPUNIT_ASSERT(view.ack_request());
+      CPPUNIT_ASSERT_EQUAL(config.pan_id, view.dst_pan_id());
+      CPPUNIT_ASSERT_EQUAL(device, view.dst_addr());
+      CPPUNIT_ASSERT_EQUAL(config.ext_addr, view.src_addr());
+      CPPUNIT_ASSERT_EQUAL(size_t(4), view.payload_len());
+      CPPUNIT_ASSERT_EQUAL(status, view.payload()[3]);
+      short_addr = view.payload()[1] | (view.payload()[2] << 8);
+    }
+
+    /*
+     * Takes a device through association: the request at now, the poll
+     * for the response at now + 1 and the ACK for it at now + 2. Returns
+     * the short address it got.
+     */
+    static uint16_t
+    associate(coord_engine &engine, recording_output &out, uint64_t device, uint64_t now)
+    {
+      const coord_config &config = engine.config();
+      handle(engine, command(config, FC_ASSOC_REQUEST, 1, device,
+                             mac_frame_view::CMD_ASSOCIATION_REQUEST), now);
+      std::vector<bytes> sent = out.take();
+      CPPUNIT_ASSERT_EQUAL(size_t(1), sent.size());
+      check_ack(sent[0], 1, false);
+
+      handle(engine, command(config, FC_EXT_COMMAND, 2, device,
+                             mac_frame_view::CMD_DATA_REQUEST), now + 1);
+      sent = out.take();
+      CPPUNIT_ASSERT_EQUAL(size_t(2), sent.size());
+      check_ack(sent[0], 2, true);
+      uint16_t short_addr;
+      check_assoc_response(sent[1], config, device, 0x00, short_addr);
+
+      handle(engine, ack(sent[1][2]), now + 2);
+      CPPUNIT_ASSERT(out.take().empty());
+      return short_addr;
+    }
+
+    static bytes
+    beacon(coord_engine &engine, recording_output &out)
+    {
+      const uint8_t request[8] = { mac_frame_view::FRAME_COMMAND, 0x08, 9, 0xFF, 0xFF, 0xFF, 0xFF,
+                                   mac_frame_view::CMD_BEACON_REQUEST };
+      engine.handle(mac_frame_view(request, sizeof(request)), 0);
+      const std::vector<bytes> sent = out.take();
+      CPPUNIT_ASSERT_EQUAL(size_t(1), sent.size());
+      const mac_frame_view view = parse_sent(sent[0]);
+      CPPUNIT_ASSERT_EQUAL(int(mac_frame_view::FRAME_BEACON), int(view.frame_type()));
+      CPPUNIT_ASSERT_EQUAL(engine.config().pan_id, view.src_pan_id());
+      return sent[0];
+    }
+
+    void
+    qa_coord_engine::t_association()
+    {
+      const coord_config config;
+      recording_output out;
+      coord_engine engine(config, out);
+
+      // The request is ACKed and the response waits for the device to poll
+      const bytes request = command(config, FC_ASSOC_REQUEST, 7, DEVICE,
+                                    mac_frame_view::CMD_ASSOCIATION_REQUEST);
+      handle(engine, request, 0);
+      std::vector<bytes> sent = out.take();
+      CPPUNIT_ASSERT_EQUAL(size_t(1), sent.size());
+      check_ack(sent[0], 7, false);
+      CPPUNIT_ASSERT_EQUAL(size_t(1), engine.devices());
+      CPPUNIT_ASSERT_EQUAL(size_t(0), engine.associated());
+      CPPUNIT_ASSERT_EQUAL(size_t(1), engine.queued_frames());
+
+      // Asking again doesn't queue a second response
+      handle(engine, request, 1);
+      CPPUNIT_ASSERT_EQUAL(size_t(1), out.take().size());
+      CPPUNIT_ASSERT_EQUAL(size_t(1), engine.queued_frames());
+
+      handle(engine, command(config, FC_EXT_COMMAND, 8, DEVICE,
+                             mac_frame_view::CMD_DATA_REQUEST), 2);
+      sent = out.take();
+      CPPUNIT_ASSERT_EQUAL(size_t(2), sent.size());
+      check_ack(sent[0], 8, true);
+      uint16_t short_addr;
+      check_assoc_response(sent[1], config, DEVICE, 0x00, short_addr);
+      CPPUNIT_ASSERT_EQUAL(uint16_t(1), short_addr);
+
+      // Only the right ACK completes it
+      handle(engine, ack(sent[1][2] + 1), 3);
+      CPPUNIT_ASSERT_EQUAL(size_t(0), engine.associated());
+      handle(engine, ack(sent[1][2]), 3);
+      CPPUNIT_ASSERT_EQUAL(size_t(1), engine.associated());
+      CPPUNIT_ASSERT_EQUAL(uint64_t(1), engine.stats().associations);
+      CPPUNIT_ASSERT_EQUAL(size_t(0), engine.queued_frames());
+
+      // The next device gets the next address. Disassociating frees the
+      // first one, which the device can reach by its short address now.
+      CPPUNIT_ASSERT_EQUAL(uint16_t(2), associate(engine, out, DEVICE + 1, 10));
+      CPPUNIT_ASSERT_EQUAL(size_t(2), engine.associated());
+      handle(engine, command(config, FC_SHORT_COMMAND, 9, 1,
+                             mac_frame_view::CMD_DISASSOCIATION), 20);
+      check_ack(out.take().at(0), 9, false);
+      CPPUNIT_ASSERT_EQUAL(size_t(1), engine.devices());
+      CPPUNIT_ASSERT_EQUAL(size_t(1), engine.associated());
+      CPPUNIT_ASSERT_EQUAL(uint64_t(1), engine.stats().disassociations);
+      CPPUNIT_ASSERT(!engine.send_indirect(1, false, 0, 0, 21));
+      CPPUNIT_ASSERT(!engine.send_indirect(DEVICE, true, 0, 0, 21));
+      CPPUNIT_ASSERT(engine.send_indirect(DEVICE + 1, true, 0, 0, 21));
+
+      // Addresses skip the coordinator's own
+      coord_config other(config);
+      other.short_addr = 2;
+      coord_engine engine2(other, out);
+      CPPUNIT_ASSERT_EQUAL(uint16_t(1), associate(engine2, out, DEVICE, 0));
+      CPPUNIT_ASSERT_EQUAL(uint16_t(3), associate(engine2, out, DEVICE + 1, 0));
+    }
+
+    void
+    qa_coord_engine::t_capacity()
+    {
+      coord_config config;
+      config.max_devices = 2;
+      recording_output out;
+      coord_engine engine(config, out);
+
+      // Association permit and router and end device capacity
+      bytes frame = beacon(engine, out);
+      CPPUNIT_ASSERT(frame[8] & 0x80);
+      CPPUNIT_ASSERT_EQUAL(0x84, frame[13] & 0x84);
+
+      associate(engine, out, DEVICE, 0);
+      associate(engine, out, DEVICE + 1, 0);
+      frame = beacon(engine, out);
+      CPPUNIT_ASSERT(!(frame[8] & 0x80));
+      CPPUNIT_ASSERT_EQUAL(0, frame[13] & 0x84);
+
+      // A full PAN answers right away, without waiting for a poll
+      handle(engine, command(config, FC_ASSOC_REQUEST, 5, DEVICE + 2,
+                             mac_frame_view::CMD_ASSOCIATION_REQUEST), 1);
+      const std::vector<bytes> sent = out.take();
+      CPPUNIT_ASSERT_EQUAL(size_t(2), sent.size());
+      check_ack(sent[0], 5, false);
+      uint16_t short_addr;
+      check_assoc_response(sent[1], config, DEVICE + 2, 0x01, short_addr);
+      CPPUNIT_ASSERT_EQUAL(uint16_t(0xFFFF), short_addr);
+      CPPUNIT_ASSERT_EQUAL(uint64_t(1), engine.stats().rejections);
+      CPPUNIT_ASSERT_EQUAL(size_t(2), engine.devices());
+      CPPUNIT_ASSERT_EQUAL(size_t(0), engine.queued_frames());
+
+      handle(engine, command(config, FC_SHORT_COMMAND, 6, 2,
+                             mac_frame_view::CMD_DISASSOCIATION), 2);
+      check_ack(out.take().at(0), 6, false);
+      frame = beacon(engine, out);
+      CPPUNIT_ASSERT(frame[8] & 0x80);
+    }
+
+    void
+    qa_coord_engine::t_polling()
+    {
+      const coord_config config;
+      recording_output out;
+      coord_engine engine(config, out);
+      const uint16_t addr = associate(engine, out, DEVICE, 0);
+
+      const bytes first(3, 'a'), second(2, 'b');
+      const bytes too_long(coord_engine::MAX_DATA_PAYLOAD + 1, 0);
+      CPPUNIT_ASSERT(engine.send_indirect(addr, false, &first[0], first.size(), 10));
+      CPPUNIT_ASSERT(engine.send_indirect(DEVICE, true, &second[0], second.size(), 11));
+      CPPUNIT_ASSERT(!engine.send_indirect(0x7777, false, &first[0], first.size(), 11));
+      CPPUNIT_ASSERT(!engine.send_indirect(addr, false, &too_long[0], too_long.size(), 11));
+      CPPUNIT_ASSERT_EQUAL(uint64_t(1), engine.stats().unknown_device);
+      CPPUNIT_ASSERT_EQUAL(size_t(2), engine.queued_frames());
+      CPPUNIT_ASSERT(out.take().empty());
+
+      // Each poll gets one frame, which says whether more are waiting
+      const bytes poll = command(config, FC_SHORT_COMMAND, 20, addr,
+                                 mac_frame_view::CMD_DATA_REQUEST);
+      handle(engine, poll, 12);
+      std::vector<bytes> sent = out.take();
+      CPPUNIT_ASSERT_EQUAL(size_t(2), sent.size());
+      check_ack(sent[0], 20, true);
+      mac_frame_view view = parse_sent(sent[1]);
+      CPPUNIT_ASSERT_EQUAL(int(mac_frame_view::FRAME_DATA), int(view.frame_type()));
+      CPPUNIT_ASSERT_EQUAL(uint64_t(addr), view.dst_addr());
+      CPPUNIT_ASSERT_EQUAL(uint64_t(config.short_addr), view.src_addr());
+      CPPUNIT_ASSERT(view.frame_pending());
+      CPPUNIT_ASSERT(bytes(view.payload(), view.payload() + view.payload_len()) == first);
+      handle(engine, ack(view.sequence_number()), 13);
+      CPPUNIT_ASSERT_EQUAL(size_t(1), engine.queued_frames());
+
+      handle(engine, poll, 14);
+      sent = out.take();
+      CPPUNIT_ASSERT_EQUAL(size_t(2), sent.size());
+      check_ack(sent[0], 20, true);
+      view = parse_sent(sent[1]);
+      CPPUNIT_ASSERT(!view.frame_pending());
+      CPPUNIT_ASSERT(bytes(view.payload(), view.payload() + view.payload_len()) == second);
+      const uint8_t dsn = view.sequence_number();
+
+      // Polling again while that one is in flight sends nothing new
+      handle(engine, poll, 15);
+      sent = out.take();
+      CPPUNIT_ASSERT_EQUAL(size_t(1), sent.size());
+      check_ack(sent[0], 20, true);
+
+      handle(engine, ack(dsn), 16);
+      CPPUNIT_ASSERT_EQUAL(size_t(0), engine.queued_frames());
+      handle(engine, poll, 17);
+      sent = out.take();
+      CPPUNIT_ASSERT_EQUAL(size_t(1), sent.size());
+      check_ack(sent[0], 20, false);
+      // The association response and its poll count as well
+      CPPUNIT_ASSERT_EQUAL(uint64_t(3), engine.stats().indirect_sent);
+      CPPUNIT_ASSERT_EQUAL(uint64_t(5), engine.stats().data_requests);
+
+      // Data from associated devices is delivered, from others it isn't,
+      // and frames for another PAN aren't even ACKed
+      handle(engine, from_device(config, FC_SHORT_DATA, 30, addr, first), 18);
+      handle(engine, from_device(config, FC_SHORT_DATA, 31, 0x7777, second), 18);
+      coord_config elsewhere(config);
+      elsewhere.pan_id = 0x1111;
+      handle(engine, from_device(elsewhere, FC_SHORT_DATA, 32, addr, second), 18);
+      CPPUNIT_ASSERT_EQUAL(size_t(1), out.delivered.size());
+      CPPUNIT_ASSERT(out.delivered[0] == first);
+      CPPUNIT_ASSERT_EQUAL(uint64_t(1), engine.stats().data_frames);
+      CPPUNIT_ASSERT_EQUAL(uint64_t(2), engine.stats().unknown_device);
+      CPPUNIT_ASSERT_EQUAL(uint64_t(1), engine.stats().not_for_us);
+      CPPUNIT_ASSERT_EQUAL(size_t(2), out.take().size());
+    }
+
+    void
+    qa_coord_engine::t_retransmit()
+    {
+      coord_config config;
+      config.ack_timeout_ms = 10;
+      config.max_retries = 3;
+      recording_output out;
+      coord_engine engine(config, out);
+      const uint16_t addr = associate(engine, out, DEVICE, 0);
+
+      const bytes payload(4, 0x5A);
+      CPPUNIT_ASSERT(engine.send_indirect(addr, false, &payload[0], payload.size(), 10));
+      handle(engine, command(config, FC_SHORT_COMMAND, 40, addr,
+                             mac_frame_view::CMD_DATA_REQUEST), 10);
+      std::vector<bytes> sent = out.take();
+      CPPUNIT_ASSERT_EQUAL(size_t(2), sent.size());
+      const bytes frame = sent[1];
+
+      // The same frame again every ack_timeout_ms, max_retries times
+      engine.advance(19);
+      CPPUNIT_ASSERT(out.take().empty());
+      for (uint64_t now = 20; now <= 40; now += 10) {
+        engine.advance(now);
+        sent = out.take();
+        CPPUNIT_ASSERT_EQUAL(size_t(1), sent.size());
+        CPPUNIT_ASSERT(sent[0] == frame);
+      }
+      engine.advance(50);
+      CPPUNIT_ASSERT(out.take().empty());
+      CPPUNIT_ASSERT_EQUAL(uint64_t(3), engine.stats().retransmissions);
+      CPPUNIT_ASSERT_EQUAL(uint64_t(1), engine.stats().tx_failures);
+      CPPUNIT_ASSERT_EQUAL(size_t(0), engine.queued_frames());
+      CPPUNIT_ASSERT_EQUAL(size_t(1), engine.associated());
+
+      // An ACK that comes in between stops the retransmissions
+      CPPUNIT_ASSERT(engine.send_indirect(addr, false, &payload[0], payload.size(), 60));
+      handle(engine, command(config, FC_SHORT_COMMAND, 41, addr,
+                             mac_frame_view::CMD_DATA_REQUEST), 60);
+      sent = out.take();
+      engine.advance(70);
+      CPPUNIT_ASSERT_EQUAL(size_t(1), out.take().size());
+      handle(engine, ack(sent[1][2]), 75);
+      engine.advance(200);
+      CPPUNIT_ASSERT(out.take().empty());
+      CPPUNIT_ASSERT_EQUAL(uint64_t(4), engine.stats().retransmissions);
+      CPPUNIT_ASSERT_EQUAL(uint64_t(1), engine.stats().tx_failures);
+
+      // A device that never ACKs its association response is forgotten
+      handle(engine, command(config, FC_ASSOC_REQUEST, 42, DEVICE + 1,
+                             mac_frame_view::CMD_ASSOCIATION_REQUEST), 300);
+      handle(engine, command(config, FC_EXT_COMMAND, 43, DEVICE + 1,
+                             mac_frame_view::CMD_DATA_REQUEST), 301);
+      CPPUNIT_ASSERT_EQUAL(size_t(2), engine.devices());
+      for (uint64_t now = 311; now <= 341; now += 10)
+        engine.advance(now);
+      CPPUNIT_ASSERT_EQUAL(uint64_t(2), engine.stats().tx_failures);
+      CPPUNIT_ASSERT_EQUAL(size_t(1), engine.devices());
+      CPPUNIT_ASSERT_EQUAL(size_t(0), engine.queued_frames());
+    }
+
+    void
+    qa_coord_engine::t_expiry()
+    {
+      coord_config config;
+      config.persistence_ms = 100;
+      recording_output out;
+      coord_engine engine(config, out);
+      const uint16_t addr = associate(engine, out, DEVICE, 0);
+      const bytes payload(1, 9);
+
+      // Frames nobody polls for go after persistence_ms, one by one
+      CPPUNIT_ASSERT(engine.send_indirect(addr, false, &payload[0], payload.size(), 10));
+      CPPUNIT_ASSERT(engine.send_indirect(addr, false, &payload[0], payload.size(), 60));
+      engine.advance(109);
+      CPPUNIT_ASSERT_EQUAL(size_t(2), engine.queued_frames());
+      engine.advance(110);
+      CPPUNIT_ASSERT_EQUAL(size_t(1), engine.queued_frames());
+      engine.advance(160);
+      CPPUNIT_ASSERT_EQUAL(size_t(0), engine.queued_frames());
+      CPPUNIT_ASSERT_EQUAL(uint64_t(2), engine.stats().expired);
+      const bytes poll = command(config, FC_SHORT_COMMAND, 50, addr,
+                                 mac_frame_view::CMD_DATA_REQUEST);
+      handle(engine, poll, 170);
+      std::vector<bytes> sent = out.take();
+      CPPUNIT_ASSERT_EQUAL(size_t(1), sent.size());
+      check_ack(sent[0], 50, false);
+
+      // Sending the head of the queue moves the expiry on to the next frame
+      CPPUNIT_ASSERT(engine.send_indirect(addr, false, &payload[0], payload.size(), 200));
+      CPPUNIT_ASSERT(engine.send_indirect(addr, false, &payload[0], payload.size(), 250));
+      handle(engine, poll, 220);
+      sent = out.take();
+      CPPUNIT_ASSERT_EQUAL(size_t(2), sent.size());
+      handle(engine, ack(sent[1][2]), 221);
+      engine.advance(349);
+      CPPUNIT_ASSERT_EQUAL(size_t(1), engine.queued_frames());
+      engine.advance(350);
+      CPPUNIT_ASSERT_EQUAL(size_t(0), engine.queued_frames());
+      CPPUNIT_ASSERT_EQUAL(uint64_t(3), engine.stats().expired);
+
+      // So does a device that never polls for its association response
+      handle(engine, command(config, FC_ASSOC_REQUEST, 51, DEVICE + 1,
+                             mac_frame_view::CMD_ASSOCIATION_REQUEST), 400);
+      CPPUNIT_ASSERT_EQUAL(size_t(2), engine.devices());
+      engine.advance(499);
+      CPPUNIT_ASSERT_EQUAL(size_t(2), engine.devices());
+      engine.advance(500);
+      CPPUNIT_ASSERT_EQUAL(size_t(1), engine.devices());
+      CPPUNIT_ASSERT_EQUAL(size_t(1), engine.associated());
+      CPPUNIT_ASSERT_EQUAL(uint64_t(4), engine.stats().expired);
+    }
+
+    void
+    qa_coord_engine::t_aging()
+    {
+      coord_config config;
+      config.device_timeout_ms = 1000;
+      recording_output out;
+      coord_engine engine(config, out);
+
+      // Heard from last by its poll at 1, then by a data frame at 500
+      const uint16_t addr = associate(engine, out, DEVICE, 0);
+      handle(engine, from_device(config, FC_SHORT_DATA, 60, addr, bytes(1, 0)), 500);
+      check_ack(out.take().at(0), 60, false);
+      const bytes payload(1, 9);
+      CPPUNIT_ASSERT(engine.send_indirect(addr, false, &payload[0], payload.size(), 600));
+
+      engine.advance(1000);
+      CPPUNIT_ASSERT_EQUAL(size_t(1), engine.devices());
+      engine.advance(1499);
+      CPPUNIT_ASSERT_EQUAL(size_t(1), engine.devices());
+      engine.advance(1500);
+      CPPUNIT_ASSERT_EQUAL(size_t(0), engine.devices());
+      CPPUNIT_ASSERT_EQUAL(size_t(0), engine.associated());
+      CPPUNIT_ASSERT_EQUAL(size_t(0), engine.queued_frames());
+      CPPUNIT_ASSERT_EQUAL(uint64_t(1), engine.stats().aged_out);
+      CPPUNIT_ASSERT(!engine.send_indirect(addr, false, &payload[0], payload.size(), 1501));
+
+      // Its address is free for the next device
+      CPPUNIT_ASSERT_EQUAL(addr, associate(engine, out, DEVICE + 1, 2000));
+    }
+
+  } /* namespace zluudgbee */
+} /* namespace gr */
@@ -0,0 +1,123 @@
+/* -*- c++ -*- */
+/* 
+ * Copyright 2019 Leon Fernandez (zluudg).
+ * 
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ * 
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include <gnuradio/attributes.h>
+#include <cppunit/TestAssert.h>
+#include "qa_correlate_kernel.h"
+#include "correlate_kernel.h"
+#include "coherent_demod.h"
+#include "oqpsk_waveform.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+
+namespace gr {
+  namespace zluudgbee {
+
+    static std::vector<gr_complex>
+    random_samples(size_t n, unsigned seed)
+    {
+      std::srand(seed);
+      std::vector<gr_complex> v(n);
+      for (size_t i = 0; i < n; i++)
+        v[i] = gr_complex(float(std::rand()) / RAND_MAX - 0.5f,
+                          float(std::rand()) / RAND_MAX - 0.5f);
+      return v;
+    }
+
+    // The sums come out in a different order, so allow for rounding
+    // relative to the size of the terms
+    static void
+    check_close(const gr_complexd &ref, const gr_complex &out, double magnitude)
+    {
+      const double tol = 1e-5 * (magnitude + 1.0);
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(ref.real(), double(out.real()), tol);
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(ref.imag(), double(out.imag()), tol);
+    }
+
+    void
+    qa_correlate_kernel::t_simd_vs_generic()
+    {
+      // Every tail length and a number of references that isn't a
+      // multiple of four, with the references spaced further apart than
+      // they are long
+      for (size_t len = 0; len < 40; len++) {
+        const size_t stride = len + 3;
+        for (size_t nrefs = 0; nrefs < 10; nrefs++) {
+          const std::vector<gr_complex> in = random_samples(len + 1, 50 + len);
+          const std::vector<gr_complex> refs = random_samples(stride * nrefs + 1, 90 + nrefs);
+          std::vector<gr_complex> fast(nrefs + 1), ref(nrefs + 1);
+          correlate_refs(&in[0], &refs[0], len, stride, nrefs, &fast[0]);
+          correlate_refs_generic(&in[0], &refs[0], len, stride, nrefs, &ref[0]);
+          for (size_t k = 0; k < nrefs; k++)
+            check_close(gr_complexd(ref[k]), fast[k], double(len));
+        }
+      }
+    }
+
+    void
+    qa_correlate_kernel::t_reference()
+    {
+      const size_t len = 130, stride = 133, nrefs = 16;
+      const std::vector<gr_complex> in = random_samples(len, 11);
+      const std::vector<gr_complex> refs = random_samples(stride * nrefs, 12);
+      std::vector<gr_complex> out(nrefs);
+      correlate_refs(&in[0], &refs[0], len, stride, nrefs, &out[0]);
+
+      for (size_t k = 0; k < nrefs; k++) {
+        gr_complexd sum = 0;
+        for (size_t i = 0; i < len; i++)
+          sum += gr_complexd(in[i]) * std::conj(gr_complexd(refs[k*stride + i]));
+        check_close(sum, out[k], double(len));
+      }
+    }
+
+    void
+    qa_correlate_kernel::t_coherent_demod()
+    {
+      // A burst with an unknown carrier phase and a small frequency
+      // offset, cut into odd-sized pieces
+      std::srand(13);
+      std::vector<uint8_t> psdu(30);
+      for (size_t i = 0; i < psdu.size(); i++)
+        psdu[i] = std::rand();
+
+      const unsigned spc = 2;
+      oqpsk_waveform wave(spc);
+      wave.start(&psdu[0], psdu.size());
+      std::vector<gr_complex> in(3000 + wave.remaining() + 3000);
+      wave.generate(&in[3000], wave.remaining());
+      for (size_t i = 0; i < in.size(); i++)
+        in[i] *= std::polar(0.5f, 1.0f + 0.002f * i);
+
+      coherent_demod demod(spc, 0.1f, 0.25f);
+      std::vector<coherent_demod::frame> frames;
+      for (size_t i = 0; i < in.size(); i += 777)
+        demod.work(&in[i], std::min<size_t>(777, in.size() - i), frames);
+
+      CPPUNIT_ASSERT_EQUAL(size_t(1), frames.size());
+      CPPUNIT_ASSERT(frames[0].psdu == psdu);
+      CPPUNIT_ASSERT_EQUAL(2 * psdu.size(), frames[0].confidence.size());
+      CPPUNIT_ASSERT_EQUAL(size_t(0), frames[0].crappy_nibbles);
+    }
+
+  } /* namespace zluudgbee */
+} /* namespace gr */
@@ -0,0 +1,143 @@
+/* -*- c++ -*- */
+/* 
+ * Copyright 2019 Leon Fernandez (zluudg).
+ * 
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ * 
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include <gnuradio/attributes.h>
+#include <cppunit/TestAssert.h>
+#include "qa_crc16.h"
+#include <zluudgbee/crc16.h>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+namespace gr {
+  namespace zluudgbee {
+
+    static const crc16::impl_t IMPLS[] = {
+      crc16::IMPL_AUTO, crc16::IMPL_BITWISE, crc16::IMPL_TABLE,
+      crc16::IMPL_SLICE8, crc16::IMPL_CLMUL
+    };
+    static const size_t NIMPLS = sizeof(IMPLS) / sizeof(IMPLS[0]);
+
+    void
+    qa_crc16::t_check_value()
+    {
+      // The catalogue check value of CRC-16/KERMIT
+      const uint8_t *check = (const uint8_t *) "123456789";
+      for (size_t i = 0; i < NIMPLS; i++) {
+        if (!crc16::supported(IMPLS[i]))
+          continue;
+        CPPUNIT_ASSERT_EQUAL(0x2189, int(crc16::compute(check, 9, 0, IMPLS[i])));
+      }
+      CPPUNIT_ASSERT_EQUAL(0x2189, int(crc16::compute(check, 9)));
+      CPPUNIT_ASSERT_EQUAL(0, int(crc16::compute(check, 0)));
+    }
+
+    void
+    qa_crc16::t_impls_agree()
+    {
+      // Every length around the slice-by-8 and folding block sizes, at
+      // every alignment, with a few initial values
+      std::srand(1);
+      std::vector<uint8_t> buf(4096 + 64);
+      for (size_t i = 0; i < buf.size(); i++)
+        buf[i] = std::rand();
+
+      const uint16_t inits[] = { 0x0000, 0xFFFF, 0x1D0F };
+      for (size_t k = 0; k < sizeof(inits) / sizeof(inits[0]); k++) {
+        for (size_t offset = 0; offset < 16; offset++) {
+          for (size_t len = 0; len < 300; len++) {
+            const uint16_t ref = crc16::compute(&buf[offset], len, inits[k], crc16::IMPL_BITWISE);
+            for (size_t i = 0; i < NIMPLS; i++) {
+              if (crc16::supported(IMPLS[i]))
+                CPPUNIT_ASSERT_EQUAL(ref, crc16::compute(&buf[offset], len, inits[k], IMPLS[i]));
+            }
+          }
+          const size_t len = 4096 + 13;
+          const uint16_t ref = crc16::compute(&buf[offset], len, inits[k], crc16::IMPL_BITWISE);
+          for (size_t i = 0; i < NIMPLS; i++) {
+            if (crc16::supported(IMPLS[i]))
+              CPPUNIT_ASSERT_EQUAL(ref, crc16::compute(&buf[offset], len, inits[k], IMPLS[i]));
+          }
+        }
+      }
+    }
+
+    void
+    qa_crc16::t_incremental()
+    {
+      std::srand(2);
+      std::vector<uint8_t> buf(1000);
+      for (size_t i = 0; i < buf.size(); i++)
+        buf[i] = std::rand();
+      const uint16_t whole = crc16::compute(&buf[0], buf.size());
+
+      for (size_t split = 0; split <= buf.size(); split += 37) {
+        crc16 crc;
+        crc.update(&buf[0], split).update(&buf[split], buf.size() - split);
+        CPPUNIT_ASSERT_EQUAL(whole, crc.value());
+      }
+
+      crc16 bytes;
+      for (size_t i = 0; i < buf.size(); i++)
+        bytes.update(buf[i]);
+      CPPUNIT_ASSERT_EQUAL(whole, bytes.value());
+
+      bytes.reset();
+      CPPUNIT_ASSERT_EQUAL(0, int(bytes.value()));
+    }
+
+    void
+    qa_crc16::t_copy()
+    {
+      std::srand(3);
+      std::vector<uint8_t> buf(300);
+      for (size_t i = 0; i < buf.size(); i++)
+        buf[i] = std::rand();
+
+      // Every length around the 8-byte steps, continuing from a nonzero
+      // CRC, and nothing past len gets written
+      for (size_t len = 0; len <= buf.size(); len++) {
+        std::vector<uint8_t> dst(len + 1, 0xA5);
+        const uint16_t crc = crc16::compute_copy(&dst[0], &buf[0], len, 0x1234);
+        CPPUNIT_ASSERT_EQUAL(crc16::compute(&buf[0], len, 0x1234), crc);
+        CPPUNIT_ASSERT(std::memcmp(&dst[0], &buf[0], len) == 0);
+        CPPUNIT_ASSERT_EQUAL(0xA5, int(dst[len]));
+      }
+    }
+
+    void
+    qa_crc16::t_fcs_residue()
+    {
+      // An ACK frame, FCS low byte first, checks out to zero
+      uint8_t frame[5] = { 0x02, 0x00, 0x2A, 0x00, 0x00 };
+      const uint16_t fcs = crc16::compute(frame, 3);
+      frame[3] = fcs & 0xFF;
+      frame[4] = fcs >> 8;
+      for (size_t i = 0; i < NIMPLS; i++) {
+        if (crc16::supported(IMPLS[i]))
+          CPPUNIT_ASSERT_EQUAL(0, int(crc16::compute(frame, sizeof(frame), 0, IMPLS[i])));
+      }
+
+      frame[1] ^= 0x10;
+      CPPUNIT_ASSERT(crc16::compute(frame, sizeof(frame)) != 0);
+    }
+
+  } /* namespace zluudgbee */
+} /* namespace gr */
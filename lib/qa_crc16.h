@@ -0,0 +1,52 @@
+/* -*- c++ -*- */
+/* 
+ * Copyright 2019 Leon Fernandez (zluudg).
+ * 
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ * 
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef _QA_CRC16_H_
+#define _QA_CRC16_H_
+
+#include <cppunit/extensions/HelperMacros.h>
+#include <cppunit/TestCase.h>
+
+namespace gr {
+  namespace zluudgbee {
+
+    class qa_crc16 : public CppUnit::TestCase
+    {
+    public:
+      CPPUNIT_TEST_SUITE(qa_crc16);
+      CPPUNIT_TEST(t_check_value);
+      CPPUNIT_TEST(t_impls_agree);
+      CPPUNIT_TEST(t_incremental);
+      CPPUNIT_TEST(t_copy);
+      CPPUNIT_TEST(t_fcs_residue);
+      CPPUNIT_TEST_SUITE_END();
+
+    private:
+      void t_check_value();
+      void t_impls_agree();
+      void t_incremental();
+      void t_copy();
+      void t_fcs_residue();
+    };
+
+  } /* namespace zluudgbee */
+} /* namespace gr */
+
+#endif /* _QA_CRC16_H_ */
@@ -0,0 +1,114 @@
+/* -*- c++ -*- */
+/* 
+ * Copyright 2019 Leon Fernandez (zluudg).
+ * 
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ * 
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include <gnuradio/attributes.h>
+#include <cppunit/TestAssert.h>
+#include "qa_demapper_kernel.h"
+#include "demapper_kernel.h"
+#include "rx_model.h"
+#include <cstdlib>
+#include <vector>
+
+namespace gr {
+  namespace zluudgbee {
+
+    // Chip sequences with a few chips flipped, which is where the ties
+    // between sequences are, and some words that are pure noise
+    static std::vector<uint32_t>
+    noisy_chips(size_t n, unsigned seed)
+    {
+      std::srand(seed);
+      std::vector<uint32_t> chips(n);
+      for (size_t i = 0; i < n; i++) {
+        if (std::rand() % 8 == 0) {
+          chips[i] = (uint32_t(std::rand()) << 16) ^ uint32_t(std::rand());
+          continue;
+        }
+        uint32_t w = rx_demapper::CHIP_SEQUENCES[std::rand() % rx_demapper::NSEQ];
+        const int flips = std::rand() % 16;
+        for (int k = 0; k < flips; k++)
+          w ^= 1u << (std::rand() % 32);
+        chips[i] = w;
+      }
+      return chips;
+    }
+
+    // Includes thresholds past 32, which no score can reach
+    static const uint32_t THRESHOLDS[] = { 0, 1, 8, 13, 31, 32, 33, 0xFFFFFFFF };
+    static const size_t NTHRESHOLDS = sizeof(THRESHOLDS) / sizeof(THRESHOLDS[0]);
+
+    void
+    qa_demapper_kernel::t_simd_vs_generic()
+    {
+      for (size_t n = 0; n < 70; n++) {
+        const std::vector<uint32_t> chips = noisy_chips(n + 1, 20 + n);
+        for (size_t t = 0; t < NTHRESHOLDS; t++) {
+          std::vector<uint8_t> fast(n + 1), ref(n + 1);
+          demap_chips(&chips[0], n, THRESHOLDS[t], &fast[0]);
+          demap_chips_generic(&chips[0], n, THRESHOLDS[t], &ref[0]);
+          for (size_t i = 0; i < n; i++)
+            CPPUNIT_ASSERT_EQUAL(int(ref[i]), int(fast[i]));
+        }
+      }
+    }
+
+    void
+    qa_demapper_kernel::t_rx_model()
+    {
+      const size_t n = 2048;
+      const std::vector<uint32_t> chips = noisy_chips(n, 5);
+      for (size_t t = 0; t < NTHRESHOLDS; t++) {
+        std::vector<uint8_t> out(n);
+        demap_chips(&chips[0], n, THRESHOLDS[t], &out[0]);
+
+        rx_demapper demapper;
+        demapper.reset();
+        for (size_t i = 0; i < n; i++) {
+          demapper.clock(true, chips[i]);
+          while (!demapper.settled(chips[i]))
+            demapper.clock(false, chips[i]);
+          CPPUNIT_ASSERT_EQUAL(int(demapper.m_data(THRESHOLDS[t])), int(out[i]));
+        }
+      }
+    }
+
+    void
+    qa_demapper_kernel::t_sequences()
+    {
+      // Chip 31 isn't scored, so it can't make a difference either
+      uint32_t chips[2*rx_demapper::NSEQ];
+      for (int j = 0; j < rx_demapper::NSEQ; j++) {
+        chips[2*j] = rx_demapper::CHIP_SEQUENCES[j];
+        chips[2*j+1] = rx_demapper::CHIP_SEQUENCES[j] ^ 0x80000000;
+      }
+      uint8_t out[2*rx_demapper::NSEQ];
+      demap_chips(chips, 2*rx_demapper::NSEQ, 1, out);
+      for (int j = 0; j < rx_demapper::NSEQ; j++) {
+        CPPUNIT_ASSERT_EQUAL(j, int(out[2*j]));
+        CPPUNIT_ASSERT_EQUAL(j, int(out[2*j+1]));
+      }
+
+      // A score of zero still isn't below a threshold of zero
+      demap_chips(chips, 1, 0, out);
+      CPPUNIT_ASSERT_EQUAL(0xF0, int(out[0]));
+    }
+
+  } /* namespace zluudgbee */
+} /* namespace gr */
@@ -0,0 +1,341 @@
+/* -*- c++ -*- */
+/* 
+ * Copyright 2019 Leon Fernandez (zluudg).
+ * 
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ * 
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include <gnuradio/attributes.h>
+#include <cppunit/TestAssert.h>
+#include "qa_mac_frame_view.h"
+#include <zluudgbee/mac_frame.h>
+#include <zluudgbee/crc16.h>
+#include <vector>
+
+namespace gr {
+  namespace zluudgbee {
+
+    static const uint16_t DST_PAN = 0x1234;
+    static const uint16_t SRC_PAN = 0x4321;
+    static const uint16_t DST_SHORT = 0xBEEF;
+    static const uint16_t SRC_SHORT = 0xCAFE;
+    static const uint64_t DST_EXT = 0x0102030405060708ULL;
+    static const uint64_t SRC_EXT = 0x1112131415161718ULL;
+    static const uint32_t FRAME_COUNTER = 0xA1B2C3D4;
+    static const uint64_t KEY_SOURCE = 0x2122232425262728ULL;
+    static const uint8_t KEY_INDEX = 0x9C;
+    static const uint8_t SEQ = 0x5A;
+
+    static uint16_t
+    frame_control(unsigned type, unsigned dst_mode, unsigned src_mode,
+                  bool compress, unsigned version = 0, bool security = false)
+    {
+      return type | (security << 3) | (compress << 6) | (dst_mode << 10) |
+             (version << 12) | (src_mode << 14);
+    }
+
+    static void
+    put_le(std::vector<uint8_t> &frame, uint64_t x, size_t len)
+    {
+      for (size_t i = 0; i < len; i++)
+        frame.push_back(uint8_t(x >> (8*i)));
+    }
+
+    static void
+    put_addr(std::vector<uint8_t> &frame, unsigned mode, uint16_t short_addr, uint64_t ext_addr)
+    {
+      if (mode == mac_frame_view::ADDR_SHORT)
+        put_le(frame, short_addr, 2);
+      else if (mode == mac_frame_view::ADDR_EXTENDED)
+        put_le(frame, ext_addr, 8);
+    }
+
+    /*
+     * Lays out a frame by the standard: the header fields fc asks for,
+     * with the values above, the auxiliary security header when security
+     * is on, then payload and mic_len bytes of MIC.
+     */
+    static std::vector<uint8_t>
+    build_frame(uint16_t fc, const std::vector<uint8_t> &payload,
+                unsigned level = 0, unsigned key_mode = 0, size_t mic_len = 0)
+    {
+      std::vector<uint8_t> frame;
+      put_le(frame, fc, 2);
+      frame.push_back(SEQ);
+
+      const unsigned dst_mode = (fc >> 10) & 0x03;
+      const unsigned src_mode = (fc >> 14) & 0x03;
+      if (dst_mode) {
+        put_le(frame, DST_PAN, 2);
+        put_addr(frame, dst_mode, DST_SHORT, DST_EXT);
+      }
+      if (src_mode) {
+        if (!(fc & 0x0040))
+          put_le(frame, SRC_PAN, 2);
+        put_addr(frame, src_mode, SRC_SHORT, SRC_EXT);
+      }
+
+      if (fc & 0x0008) {
+        frame.push_back(uint8_t(level | (key_mode << 3)));
+        put_le(frame, FRAME_COUNTER, 4);
+        if (key_mode == 2)
+          put_le(frame, KEY_SOURCE, 4);
+        else if (key_mode == 3)
+          put_le(frame, KEY_SOURCE, 8);
+        if (key_mode)
+          frame.push_back(KEY_INDEX);
+      }
+
+      frame.insert(frame.end(), payload.begin(), payload.end());
+      frame.insert(frame.end(), mic_len, 0xEE);
+      return frame;
+    }
+
+    static std::vector<uint8_t>
+    some_payload()
+    {
+      const uint8_t bytes[] = { mac_frame_view::CMD_BEACON_REQUEST, 0x42, 0x43 };
+      return std::vector<uint8_t>(bytes, bytes + sizeof(bytes));
+    }
+
+    static uint64_t
+    expected_addr(unsigned mode, uint16_t short_addr, uint64_t ext_addr)
+    {
+      return mode == mac_frame_view::ADDR_SHORT ? short_addr
+           : mode == mac_frame_view::ADDR_EXTENDED ? ext_addr : 0;
+    }
+
+    void
+    qa_mac_frame_view::t_addressing()
+    {
+      // Every valid combination of address modes, with and without PAN ID
+      // compression, in 2003 and 2006 frames
+      const unsigned modes[3] = {
+        mac_frame_view::ADDR_NONE, mac_frame_view::ADDR_SHORT, mac_frame_view::ADDR_EXTENDED
+      };
+      const std::vector<uint8_t> payload = some_payload();
+      for (unsigned version = 0; version < 2; version++) {
+        for (size_t d = 0; d < 3; d++) {
+          for (size_t s = 0; s < 3; s++) {
+            for (int compress = 0; compress < 2; compress++) {
+              const unsigned dst = modes[d], src = modes[s];
+              if (compress && !(dst && src))
+                continue;
+              const uint16_t fc = frame_control(mac_frame_view::FRAME_COMMAND, dst, src,
+                                                compress, version);
+              const std::vector<uint8_t> frame = build_frame(fc, payload);
+              const mac_frame_view view(&frame[0], frame.size());
+
+              CPPUNIT_ASSERT_EQUAL(int(mac_frame_view::MAC_OK), int(view.status()));
+              CPPUNIT_ASSERT_EQUAL(fc, view.frame_control());
+              CPPUNIT_ASSERT_EQUAL(version, view.frame_version());
+              CPPUNIT_ASSERT_EQUAL(SEQ, view.sequence_number());
+              CPPUNIT_ASSERT_EQUAL(int(dst), int(view.dst_addr_mode()));
+              CPPUNIT_ASSERT_EQUAL(int(src), int(view.src_addr_mode()));
+              CPPUNIT_ASSERT_EQUAL(bool(dst), view.has_dst());
+              CPPUNIT_ASSERT_EQUAL(bool(src), view.has_src());
+              CPPUNIT_ASSERT_EQUAL(uint16_t(dst ? DST_PAN : 0), view.dst_pan_id());
+              CPPUNIT_ASSERT_EQUAL(expected_addr(dst, DST_SHORT, DST_EXT), view.dst_addr());
+              CPPUNIT_ASSERT_EQUAL(uint16_t(!src ? 0 : compress ? DST_PAN : SRC_PAN),
+                                   view.src_pan_id());
+              CPPUNIT_ASSERT_EQUAL(expected_addr(src, SRC_SHORT, SRC_EXT), view.src_addr());
+
+              CPPUNIT_ASSERT_EQUAL(frame.size() - payload.size(), view.header_len());
+              CPPUNIT_ASSERT_EQUAL(payload.size(), view.payload_len());
+              CPPUNIT_ASSERT(view.payload() == &frame[view.header_len()]);
+              CPPUNIT_ASSERT_EQUAL(int(mac_frame_view::CMD_BEACON_REQUEST), view.command_id());
+              CPPUNIT_ASSERT_EQUAL(size_t(0), view.mic_len());
+              CPPUNIT_ASSERT_EQUAL(0u, view.security_level());
+              CPPUNIT_ASSERT_EQUAL(uint32_t(0), view.frame_counter());
+              CPPUNIT_ASSERT(!view.is_broadcast());
+            }
+          }
+        }
+      }
+
+      // A beacon request goes to the broadcast address and has no source
+      std::vector<uint8_t> frame = build_frame(
+        frame_control(mac_frame_view::FRAME_COMMAND, mac_frame_view::ADDR_SHORT,
+                      mac_frame_view::ADDR_NONE, false),
+        some_payload());
+      frame[5] = frame[6] = 0xFF;
+      mac_frame_view view(&frame[0], frame.size());
+      CPPUNIT_ASSERT(view.valid());
+      CPPUNIT_ASSERT(view.is_broadcast());
+
+      // An ACK is frame control and sequence number only
+      const uint8_t ack[3] = { mac_frame_view::FRAME_ACK, 0x00, SEQ };
+      view.parse(ack, sizeof(ack));
+      CPPUNIT_ASSERT(view.valid());
+      CPPUNIT_ASSERT_EQUAL(int(mac_frame_view::FRAME_ACK), int(view.frame_type()));
+      CPPUNIT_ASSERT_EQUAL(SEQ, view.sequence_number());
+      CPPUNIT_ASSERT_EQUAL(size_t(3), view.header_len());
+      CPPUNIT_ASSERT_EQUAL(size_t(0), view.payload_len());
+      CPPUNIT_ASSERT_EQUAL(-1, view.command_id());
+    }
+
+    void
+    qa_mac_frame_view::t_security()
+    {
+      // Every key identifier mode and every MIC length of a 2006 data frame
+      const size_t key_id_len[4] = { 0, 1, 5, 9 };
+      const size_t mic_len[4] = { 0, 4, 8, 16 };
+      const std::vector<uint8_t> payload = some_payload();
+      for (unsigned level = 0; level < 8; level++) {
+        for (unsigned key_mode = 0; key_mode < 4; key_mode++) {
+          const uint16_t fc = frame_control(mac_frame_view::FRAME_DATA,
+                                            mac_frame_view::ADDR_SHORT,
+                                            mac_frame_view::ADDR_EXTENDED,
+                                            true, 1, true);
+          const std::vector<uint8_t> frame =
+            build_frame(fc, payload, level, key_mode, mic_len[level & 0x03]);
+          const mac_frame_view view(&frame[0], frame.size());
+
+          CPPUNIT_ASSERT_EQUAL(int(mac_frame_view::MAC_OK), int(view.status()));
+          CPPUNIT_ASSERT(view.security_enabled());
+          CPPUNIT_ASSERT_EQUAL(level, view.security_level());
+          CPPUNIT_ASSERT_EQUAL(key_mode, view.key_id_mode());
+          CPPUNIT_ASSERT_EQUAL(FRAME_COUNTER, view.frame_counter());
+          const uint64_t key_source = key_mode == 2 ? KEY_SOURCE & 0xFFFFFFFF
+                                    : key_mode == 3 ? KEY_SOURCE : 0;
+          CPPUNIT_ASSERT_EQUAL(key_source, view.key_source());
+          CPPUNIT_ASSERT_EQUAL(uint8_t(key_mode ? KEY_INDEX : 0), view.key_index());
+
+          // 3 + 2 + 2 + 8 bytes of MAC header before the auxiliary one
+          CPPUNIT_ASSERT_EQUAL(size_t(15 + 5) + key_id_len[key_mode], view.header_len());
+          CPPUNIT_ASSERT_EQUAL(payload.size(), view.payload_len());
+          CPPUNIT_ASSERT_EQUAL(mic_len[level & 0x03], view.mic_len());
+          CPPUNIT_ASSERT(view.mic() == &frame[frame.size() - view.mic_len()]);
+          CPPUNIT_ASSERT_EQUAL(DST_SHORT, uint16_t(view.dst_addr()));
+          CPPUNIT_ASSERT_EQUAL(SRC_EXT, view.src_addr());
+        }
+      }
+    }
+
+    void
+    qa_mac_frame_view::t_rejected()
+    {
+      const std::vector<uint8_t> payload = some_payload();
+      const unsigned SHORT = mac_frame_view::ADDR_SHORT;
+      mac_frame_view view;
+
+      // Reserved address modes, and PAN ID compression without both addresses
+      const uint16_t bad_addressing[4] = {
+        frame_control(mac_frame_view::FRAME_DATA, mac_frame_view::ADDR_RESERVED, SHORT, false),
+        frame_control(mac_frame_view::FRAME_DATA, SHORT, mac_frame_view::ADDR_RESERVED, false),
+        frame_control(mac_frame_view::FRAME_DATA, SHORT, mac_frame_view::ADDR_NONE, true),
+        frame_control(mac_frame_view::FRAME_DATA, mac_frame_view::ADDR_NONE, SHORT, true)
+      };
+      for (size_t i = 0; i < 4; i++) {
+        const std::vector<uint8_t> frame = build_frame(bad_addressing[i], payload);
+        view.parse(&frame[0], frame.size());
+        CPPUNIT_ASSERT_EQUAL(int(mac_frame_view::MAC_BAD_ADDRESSING), int(view.status()));
+        CPPUNIT_ASSERT_EQUAL(bad_addressing[i], view.frame_control());
+      }
+
+      // Frame versions 2 and 3
+      for (unsigned version = 2; version < 4; version++) {
+        const std::vector<uint8_t> frame = build_frame(
+          frame_control(mac_frame_view::FRAME_DATA, SHORT, SHORT, true, version), payload);
+        view.parse(&frame[0], frame.size());
+        CPPUNIT_ASSERT_EQUAL(int(mac_frame_view::MAC_BAD_VERSION), int(view.status()));
+      }
+
+      // Security didn't have an auxiliary header before 2006
+      const std::vector<uint8_t> frame = build_frame(
+        frame_control(mac_frame_view::FRAME_DATA, SHORT, SHORT, true, 0, true), payload, 5, 1, 4);
+      view.parse(&frame[0], frame.size());
+      CPPUNIT_ASSERT_EQUAL(int(mac_frame_view::MAC_BAD_SECURITY), int(view.status()));
+      CPPUNIT_ASSERT(!view.valid());
+      CPPUNIT_ASSERT_EQUAL(SEQ, view.sequence_number());
+      CPPUNIT_ASSERT_EQUAL(0u, view.security_level());
+    }
+
+    void
+    qa_mac_frame_view::t_truncated()
+    {
+      // A secured frame with extended addresses cut short anywhere in the
+      // header or MIC is too short. Without a payload it just fits.
+      const uint16_t fc = frame_control(mac_frame_view::FRAME_DATA,
+                                        mac_frame_view::ADDR_EXTENDED,
+                                        mac_frame_view::ADDR_EXTENDED,
+                                        false, 1, true);
+      const std::vector<uint8_t> empty = build_frame(fc, std::vector<uint8_t>(), 6, 3, 8);
+      std::vector<uint8_t> frame = build_frame(fc, some_payload(), 6, 3, 8);
+      mac_frame_view view;
+      for (size_t len = 0; len < empty.size(); len++) {
+        view.parse(&empty[0], len);
+        CPPUNIT_ASSERT_EQUAL(int(mac_frame_view::MAC_TOO_SHORT), int(view.status()));
+        CPPUNIT_ASSERT_EQUAL(uint64_t(0), view.dst_addr());
+        CPPUNIT_ASSERT_EQUAL(uint32_t(0), view.frame_counter());
+        CPPUNIT_ASSERT_EQUAL(size_t(0), view.payload_len());
+      }
+      view.parse(&empty[0], empty.size());
+      CPPUNIT_ASSERT(view.valid());
+      CPPUNIT_ASSERT_EQUAL(size_t(0), view.payload_len());
+      CPPUNIT_ASSERT_EQUAL(size_t(8), view.mic_len());
+
+      // With an FCS the same lengths are two bytes further on
+      const uint16_t fcs = crc16::compute(&frame[0], frame.size());
+      frame.push_back(fcs & 0xFF);
+      frame.push_back(fcs >> 8);
+      for (size_t len = 0; len < empty.size() + mac_frame_view::FCS_LEN; len++) {
+        view.parse(&frame[0], len, true);
+        CPPUNIT_ASSERT_EQUAL(int(mac_frame_view::MAC_TOO_SHORT), int(view.status()));
+      }
+      view.parse(&frame[0], frame.size(), true);
+      CPPUNIT_ASSERT(view.valid());
+      CPPUNIT_ASSERT_EQUAL(frame.size(), view.size());
+      CPPUNIT_ASSERT_EQUAL(some_payload().size(), view.payload_len());
+      CPPUNIT_ASSERT(view.mic() + view.mic_len() == &frame[frame.size() - mac_frame_view::FCS_LEN]);
+
+      // Nor is an ACK shorter than three bytes anything
+      const uint8_t ack[3] = { mac_frame_view::FRAME_ACK, 0x00, SEQ };
+      view.parse(ack, 2);
+      CPPUNIT_ASSERT_EQUAL(int(mac_frame_view::MAC_TOO_SHORT), int(view.status()));
+      CPPUNIT_ASSERT_EQUAL(uint8_t(0), view.sequence_number());
+      view.parse(ack, 3, true);
+      CPPUNIT_ASSERT_EQUAL(int(mac_frame_view::MAC_TOO_SHORT), int(view.status()));
+    }
+
+    void
+    qa_mac_frame_view::t_pdu()
+    {
+      const std::vector<uint8_t> frame = build_frame(
+        frame_control(mac_frame_view::FRAME_COMMAND, mac_frame_view::ADDR_SHORT,
+                      mac_frame_view::ADDR_SHORT, true),
+        some_payload());
+      const pmt::pmt_t vector = pmt::init_u8vector(frame.size(), &frame[0]);
+
+      pmt::pmt_t pdus[4];
+      pdus[0] = pmt::cons(pmt::make_dict(), vector);
+      pdus[1] = vector;
+      pdus[2] = pmt::cons(pmt::make_dict(), pmt::from_long(3));
+      pdus[3] = pmt::cons(pmt::PMT_NIL, pmt::init_u8vector(2, &frame[0]));
+
+      mac_frame_view views[4];
+      CPPUNIT_ASSERT_EQUAL(size_t(1), parse_mac_frames(pdus, 4, views));
+      CPPUNIT_ASSERT(views[0].valid());
+      CPPUNIT_ASSERT_EQUAL(frame.size(), views[0].size());
+      CPPUNIT_ASSERT_EQUAL(SRC_SHORT, uint16_t(views[0].src_addr()));
+      CPPUNIT_ASSERT_EQUAL(int(mac_frame_view::CMD_BEACON_REQUEST), views[0].command_id());
+      CPPUNIT_ASSERT_EQUAL(int(mac_frame_view::MAC_NOT_A_PDU), int(views[1].status()));
+      CPPUNIT_ASSERT_EQUAL(int(mac_frame_view::MAC_NOT_A_PDU), int(views[2].status()));
+      CPPUNIT_ASSERT_EQUAL(int(mac_frame_view::MAC_TOO_SHORT), int(views[3].status()));
+    }
+
+  } /* namespace zluudgbee */
+} /* namespace gr */
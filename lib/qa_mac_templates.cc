@@ -0,0 +1,87 @@
+/* -*- c++ -*- */
+/* 
+ * Copyright 2019 Leon Fernandez (zluudg).
+ * 
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ * 
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include <gnuradio/attributes.h>
+#include <cppunit/TestAssert.h>
+#include "qa_mac_templates.h"
+#include "mac_templates.h"
+#include <zluudgbee/crc16.h>
+#include <zluudgbee/mac_frame.h>
+#include <algorithm>
+#include <cstring>
+
+namespace gr {
+  namespace zluudgbee {
+
+    // FCS as sent, low byte first
+    static uint16_t
+    fcs_of(const uint8_t *frame, size_t len)
+    {
+      return frame[len - 2] | (frame[len - 1] << 8);
+    }
+
+    void
+    qa_mac_templates::t_patched_frame()
+    {
+      // A beacon as dummycoord sends it with a long address, BSN at two,
+      // and the same patched elsewhere, down to the very first byte
+      std::vector<uint8_t> mpdu(32);
+      for (size_t i = 0; i < mpdu.size(); i++)
+        mpdu[i] = uint8_t(0x3D * i + 0x11);
+      const size_t offsets[3] = { 2, 0, 31 };
+
+      for (size_t o = 0; o < 3; o++) {
+        const patched_frame beacon(mpdu, offsets[o]);
+        CPPUNIT_ASSERT_EQUAL(mpdu.size() + 2, beacon.size());
+        CPPUNIT_ASSERT_EQUAL(uint8_t(0), beacon.frame()[offsets[o]]);
+
+        std::vector<uint8_t> expected(mpdu);
+        std::vector<uint8_t> frame(beacon.size());
+        for (int value = 0; value < 256; value++) {
+          std::memcpy(&frame[0], beacon.frame(), beacon.size());
+          beacon.patch(&frame[0], uint8_t(value));
+
+          expected[offsets[o]] = uint8_t(value);
+          CPPUNIT_ASSERT(std::equal(expected.begin(), expected.end(), frame.begin()));
+          CPPUNIT_ASSERT_EQUAL(crc16::compute(&expected[0], expected.size()),
+                               fcs_of(&frame[0], frame.size()));
+          CPPUNIT_ASSERT_EQUAL(uint16_t(0), crc16::compute(&frame[0], frame.size()));
+        }
+      }
+    }
+
+    void
+    qa_mac_templates::t_immediate_ack()
+    {
+      for (int seq = 0; seq < 256; seq++) {
+        const uint8_t *ack = immediate_ack(uint8_t(seq));
+        const uint8_t mpdu[3] = { mac_frame_view::FRAME_ACK, 0x00, uint8_t(seq) };
+        CPPUNIT_ASSERT(std::equal(mpdu, mpdu + 3, ack));
+        CPPUNIT_ASSERT_EQUAL(crc16::compute(mpdu, 3), fcs_of(ack, IMM_ACK_LEN));
+        CPPUNIT_ASSERT_EQUAL(uint16_t(0), crc16::compute(ack, IMM_ACK_LEN));
+
+        const mac_frame_view view(ack, IMM_ACK_LEN, true);
+        CPPUNIT_ASSERT_EQUAL(int(mac_frame_view::FRAME_ACK), int(view.frame_type()));
+        CPPUNIT_ASSERT_EQUAL(uint8_t(seq), view.sequence_number());
+      }
+    }
+
+  } /* namespace zluudgbee */
+} /* namespace gr */
@@ -0,0 +1,198 @@
+/* -*- c++ -*- */
+/* 
+ * Copyright 2019 Leon Fernandez (zluudg).
+ * 
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ * 
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include <gnuradio/attributes.h>
+#include <cppunit/TestAssert.h>
+#include "qa_metrics.h"
+#include <zluudgbee/metrics.h>
+#include <limits>
+
+namespace gr {
+  namespace zluudgbee {
+
+    typedef latency_histogram hist;
+
+    // Names of the stages still around that start with prefix, in order
+    static std::vector<std::string>
+    stage_names(const std::string &prefix)
+    {
+      const std::vector<stage_metrics_sptr> live = metrics::stages();
+      std::vector<std::string> names;
+      for (size_t i = 0; i < live.size(); i++)
+        if (live[i]->name.compare(0, prefix.size(), prefix) == 0)
+          names.push_back(live[i]->name);
+      return names;
+    }
+
+    void
+    qa_metrics::t_bucket_boundaries()
+    {
+      CPPUNIT_ASSERT_EQUAL(320, int(hist::NBUCKETS));
+
+      // One bucket per value below SUB_BUCKETS
+      for (int ns = 0; ns < 8; ns++) {
+        CPPUNIT_ASSERT_EQUAL(ns, hist::bucket(ns));
+        CPPUNIT_ASSERT_EQUAL(uint64_t(ns), hist::lower_bound(ns));
+      }
+
+      // From 8 to 16 still one value per bucket, the first power of two
+      // split into SUB_BUCKETS
+      CPPUNIT_ASSERT_EQUAL(8, hist::bucket(8));
+      CPPUNIT_ASSERT_EQUAL(uint64_t(8), hist::lower_bound(8));
+      CPPUNIT_ASSERT_EQUAL(15, hist::bucket(15));
+      CPPUNIT_ASSERT_EQUAL(uint64_t(15), hist::lower_bound(15));
+
+      // From 16 on the buckets are two wide, then four, ...
+      CPPUNIT_ASSERT_EQUAL(16, hist::bucket(16));
+      CPPUNIT_ASSERT_EQUAL(16, hist::bucket(17));
+      CPPUNIT_ASSERT_EQUAL(17, hist::bucket(18));
+      CPPUNIT_ASSERT_EQUAL(uint64_t(16), hist::lower_bound(16));
+      CPPUNIT_ASSERT_EQUAL(uint64_t(18), hist::lower_bound(17));
+      CPPUNIT_ASSERT_EQUAL(23, hist::bucket(31));
+      CPPUNIT_ASSERT_EQUAL(24, hist::bucket(32));
+      CPPUNIT_ASSERT_EQUAL(24, hist::bucket(35));
+      CPPUNIT_ASSERT_EQUAL(25, hist::bucket(36));
+
+      // 2^41 opens the last power of two kept
+      const uint64_t top = uint64_t(1) << 41;
+      CPPUNIT_ASSERT_EQUAL(311, hist::bucket(top - 1));
+      CPPUNIT_ASSERT_EQUAL(312, hist::bucket(top));
+      CPPUNIT_ASSERT_EQUAL(top, hist::lower_bound(312));
+      CPPUNIT_ASSERT_EQUAL(top / 16 * 15, hist::lower_bound(311));
+      CPPUNIT_ASSERT_EQUAL(313, hist::bucket(top + top / 8));
+      CPPUNIT_ASSERT_EQUAL(312, hist::bucket(top + top / 8 - 1));
+    }
+
+    void
+    qa_metrics::t_bucket_roundtrip()
+    {
+      // Every bucket holds exactly [lower_bound(i), lower_bound(i + 1))
+      for (int i = 0; i < hist::NBUCKETS; i++) {
+        const uint64_t lo = hist::lower_bound(i);
+        CPPUNIT_ASSERT_EQUAL(i, hist::bucket(lo));
+        if (i > 0) {
+          CPPUNIT_ASSERT(lo > hist::lower_bound(i - 1));
+          CPPUNIT_ASSERT_EQUAL(i - 1, hist::bucket(lo - 1));
+        }
+      }
+    }
+
+    void
+    qa_metrics::t_overflow()
+    {
+      // The last bucket takes the top of 2^41 and everything above
+      const int last = hist::NBUCKETS - 1;
+      const uint64_t top = uint64_t(1) << 41;
+      CPPUNIT_ASSERT_EQUAL(319, last);
+      CPPUNIT_ASSERT_EQUAL(top / 8 * 15, hist::lower_bound(last));
+      CPPUNIT_ASSERT_EQUAL(last, hist::bucket(2 * top - 1));
+      CPPUNIT_ASSERT_EQUAL(last, hist::bucket(2 * top));
+      CPPUNIT_ASSERT_EQUAL(last, hist::bucket(uint64_t(1) << 63));
+      CPPUNIT_ASSERT_EQUAL(last, hist::bucket(std::numeric_limits<uint64_t>::max()));
+
+      hist h;
+      h.record(std::numeric_limits<uint64_t>::max());
+      h.record(5);
+      CPPUNIT_ASSERT_EQUAL(uint64_t(1), h.buckets()[last]);
+      CPPUNIT_ASSERT_EQUAL(uint64_t(1), h.buckets()[5]);
+      CPPUNIT_ASSERT_EQUAL(std::numeric_limits<uint64_t>::max(), h.max());
+      CPPUNIT_ASSERT_EQUAL(hist::lower_bound(last), h.percentile(1.0));
+    }
+
+    void
+    qa_metrics::t_percentile()
+    {
+      hist h;
+      CPPUNIT_ASSERT_EQUAL(uint64_t(0), h.percentile(0.0));
+      CPPUNIT_ASSERT_EQUAL(uint64_t(0), h.percentile(0.5));
+      CPPUNIT_ASSERT_EQUAL(uint64_t(0), h.percentile(1.0));
+
+      // A single sample answers every p with its bucket
+      h.record(1000);
+      const uint64_t b1000 = hist::lower_bound(hist::bucket(1000));
+      CPPUNIT_ASSERT_EQUAL(uint64_t(960), b1000);
+      CPPUNIT_ASSERT_EQUAL(b1000, h.percentile(0.0));
+      CPPUNIT_ASSERT_EQUAL(b1000, h.percentile(0.5));
+      CPPUNIT_ASSERT_EQUAL(b1000, h.percentile(1.0));
+
+      // p = 0 is the smallest sample, not bucket 0, p = 1 the largest
+      h.record(3);
+      h.record(40);
+      h.record(40);
+      CPPUNIT_ASSERT_EQUAL(uint64_t(4), h.count());
+      CPPUNIT_ASSERT_EQUAL(uint64_t(3), h.percentile(0.0));
+      CPPUNIT_ASSERT_EQUAL(b1000, h.percentile(1.0));
+
+      // The wanted rank is p * count rounded to nearest, at least one
+      CPPUNIT_ASSERT_EQUAL(uint64_t(3), h.percentile(0.1));    // rank 0
+      CPPUNIT_ASSERT_EQUAL(uint64_t(3), h.percentile(0.3));    // rank 1
+      CPPUNIT_ASSERT_EQUAL(uint64_t(40), h.percentile(0.375)); // rank 2, 1.5 rounds up
+      CPPUNIT_ASSERT_EQUAL(uint64_t(40), h.percentile(0.75));  // rank 3
+      CPPUNIT_ASSERT_EQUAL(uint64_t(40), h.percentile(0.85));  // rank 3
+      CPPUNIT_ASSERT_EQUAL(b1000, h.percentile(0.875));        // rank 4, 3.5 rounds up
+    }
+
+    void
+    qa_metrics::t_register_stage()
+    {
+      const std::string name = "qa_metrics_stage";
+      CPPUNIT_ASSERT(stage_names(name).empty());
+
+      stage_metrics_sptr a = metrics::register_stage(name);
+      stage_metrics_sptr b = metrics::register_stage(name);
+      stage_metrics_sptr c = metrics::register_stage(name);
+      CPPUNIT_ASSERT_EQUAL(name, a->name);
+      CPPUNIT_ASSERT_EQUAL(name + "_1", b->name);
+      CPPUNIT_ASSERT_EQUAL(name + "_2", c->name);
+
+      std::vector<std::string> names = stage_names(name);
+      CPPUNIT_ASSERT_EQUAL(size_t(3), names.size());
+      CPPUNIT_ASSERT_EQUAL(name, names[0]);
+      CPPUNIT_ASSERT_EQUAL(name + "_1", names[1]);
+      CPPUNIT_ASSERT_EQUAL(name + "_2", names[2]);
+
+      // A destroyed stage drops out and its name is free again, the
+      // re-registered one goes to the back
+      b.reset();
+      names = stage_names(name);
+      CPPUNIT_ASSERT_EQUAL(size_t(2), names.size());
+      CPPUNIT_ASSERT_EQUAL(name, names[0]);
+      CPPUNIT_ASSERT_EQUAL(name + "_2", names[1]);
+
+      b = metrics::register_stage(name);
+      CPPUNIT_ASSERT_EQUAL(name + "_1", b->name);
+      names = stage_names(name);
+      CPPUNIT_ASSERT_EQUAL(size_t(3), names.size());
+      CPPUNIT_ASSERT_EQUAL(name + "_2", names[1]);
+      CPPUNIT_ASSERT_EQUAL(name + "_1", names[2]);
+
+      // With the first one gone, the next one takes its plain name
+      a.reset();
+      a = metrics::register_stage(name);
+      CPPUNIT_ASSERT_EQUAL(name, a->name);
+
+      a.reset();
+      b.reset();
+      c.reset();
+      CPPUNIT_ASSERT(stage_names(name).empty());
+    }
+
+  } /* namespace zluudgbee */
+} /* namespace gr */
@@ -0,0 +1,52 @@
+/* -*- c++ -*- */
+/* 
+ * Copyright 2019 Leon Fernandez (zluudg).
+ * 
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ * 
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef _QA_METRICS_H_
+#define _QA_METRICS_H_
+
+#include <cppunit/extensions/HelperMacros.h>
+#include <cppunit/TestCase.h>
+
+namespace gr {
+  namespace zluudgbee {
+
+    class qa_metrics : public CppUnit::TestCase
+    {
+    public:
+      CPPUNIT_TEST_SUITE(qa_metrics);
+      CPPUNIT_TEST(t_bucket_boundaries);
+      CPPUNIT_TEST(t_bucket_roundtrip);
+      CPPUNIT_TEST(t_overflow);
+      CPPUNIT_TEST(t_percentile);
+      CPPUNIT_TEST(t_register_stage);
+      CPPUNIT_TEST_SUITE_END();
+
+    private:
+      void t_bucket_boundaries();
+      void t_bucket_roundtrip();
+      void t_overflow();
+      void t_percentile();
+      void t_register_stage();
+    };
+
+  } /* namespace zluudgbee */
+} /* namespace gr */
+
+#endif /* _QA_METRICS_H_ */
@@ -0,0 +1,185 @@
+/* -*- c++ -*- */
+/* 
+ * Copyright 2019 Leon Fernandez (zluudg).
+ * 
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ * 
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include <gnuradio/attributes.h>
+#include <cppunit/TestAssert.h>
+#include "qa_oqpsk_waveform.h"
+#include "oqpsk_waveform.h"
+#include "chdr_unpack.h"
+#include "rx_model.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+
+namespace gr {
+  namespace zluudgbee {
+
+    static std::vector<uint8_t>
+    random_psdu(size_t len, unsigned seed)
+    {
+      std::srand(seed);
+      std::vector<uint8_t> psdu(len);
+      for (size_t i = 0; i < len; i++)
+        psdu[i] = std::rand();
+      return psdu;
+    }
+
+    // 1, 2 and 8 are compiled in, 3 gets built at runtime
+    static const unsigned RATES[] = { 1, 2, 3, 8 };
+    static const size_t NRATES = sizeof(RATES) / sizeof(RATES[0]);
+
+    // Straight from the standard, one half-sine per chip with std::sin
+    static std::vector<gr_complex>
+    reference_burst(const std::vector<uint8_t> &psdu, unsigned spc)
+    {
+      std::vector<uint8_t> octets(4, 0x00);
+      octets.push_back(0xA7);
+      octets.push_back(psdu.size());
+      octets.insert(octets.end(), psdu.begin(), psdu.end());
+
+      const size_t nchips = 2 * octets.size() * OQPSK_CHIPS_PER_NIBBLE;
+      std::vector<double> rail[2];
+      rail[0].assign((nchips + 3) * spc, 0.0);
+      rail[1].assign((nchips + 3) * spc, 0.0);
+      for (size_t c = 0; c < nchips; c++) {
+        const uint8_t octet = octets[c / (2 * OQPSK_CHIPS_PER_NIBBLE)];
+        const unsigned nibble = (c / OQPSK_CHIPS_PER_NIBBLE) % 2 ? octet >> 4 : octet & 0x0F;
+        const bool chip = (OQPSK_CHIP_SEQUENCES[nibble] >> (c % OQPSK_CHIPS_PER_NIBBLE)) & 1;
+        for (unsigned s = 0; s < 2 * spc; s++)
+          rail[c % 2][c * spc + s] += (chip ? 1.0 : -1.0) * std::sin(M_PI * s / (2.0 * spc));
+      }
+
+      std::vector<gr_complex> burst(rail[0].size());
+      for (size_t s = 0; s < burst.size(); s++)
+        burst[s] = gr_complex(rail[0][s], rail[1][s]);
+      return burst;
+    }
+
+    void
+    qa_oqpsk_waveform::t_reference()
+    {
+      const size_t lens[] = { 0, 1, 20, 127, 200 };
+      for (size_t r = 0; r < NRATES; r++) {
+        oqpsk_waveform wave(RATES[r]);
+        for (size_t l = 0; l < sizeof(lens) / sizeof(lens[0]); l++) {
+          // Longer PSDUs are cut down to aMaxPHYPacketSize
+          std::vector<uint8_t> psdu = random_psdu(lens[l], 40 + l);
+          wave.start(psdu.empty() ? NULL : &psdu[0], psdu.size());
+          psdu.resize(std::min(psdu.size(), oqpsk_waveform::MAX_PSDU_LEN));
+
+          const std::vector<gr_complex> ref = reference_burst(psdu, RATES[r]);
+          CPPUNIT_ASSERT_EQUAL(ref.size(), wave.remaining());
+          CPPUNIT_ASSERT_EQUAL(ref.size(), wave.burst_len(psdu.size()));
+          std::vector<gr_complex> out(ref.size());
+          CPPUNIT_ASSERT_EQUAL(ref.size(), wave.generate(&out[0], out.size()));
+          for (size_t s = 0; s < ref.size(); s++) {
+            CPPUNIT_ASSERT_DOUBLES_EQUAL(ref[s].real(), out[s].real(), 1e-5);
+            CPPUNIT_ASSERT_DOUBLES_EQUAL(ref[s].imag(), out[s].imag(), 1e-5);
+          }
+        }
+      }
+    }
+
+    void
+    qa_oqpsk_waveform::t_sc16()
+    {
+      // The overlaps are added after rounding, hence one LSB of slack
+      const std::vector<uint8_t> psdu = random_psdu(50, 6);
+      for (size_t r = 0; r < NRATES; r++) {
+        oqpsk_waveform wave(RATES[r]);
+        wave.start(&psdu[0], psdu.size());
+        std::vector<gr_complex> fc32(wave.remaining());
+        wave.generate(&fc32[0], fc32.size());
+        wave.start(&psdu[0], psdu.size());
+        std::vector<sc16_t> sc16(wave.remaining());
+        wave.generate(&sc16[0], sc16.size());
+
+        for (size_t s = 0; s < fc32.size(); s++) {
+          CPPUNIT_ASSERT_DOUBLES_EQUAL(fc32[s].real() * OQPSK_SC16_SCALE, sc16[s].real(), 1.0);
+          CPPUNIT_ASSERT_DOUBLES_EQUAL(fc32[s].imag() * OQPSK_SC16_SCALE, sc16[s].imag(), 1.0);
+        }
+      }
+    }
+
+    void
+    qa_oqpsk_waveform::t_chunked()
+    {
+      // Chunks that start and end anywhere in a nibble or its overlap
+      const std::vector<uint8_t> psdu = random_psdu(30, 7);
+      oqpsk_waveform wave(4);
+      wave.start(&psdu[0], psdu.size());
+      std::vector<gr_complex> whole(wave.remaining());
+      wave.generate(&whole[0], whole.size());
+      CPPUNIT_ASSERT_EQUAL(size_t(0), wave.remaining());
+
+      std::srand(8);
+      wave.start(&psdu[0], psdu.size());
+      std::vector<gr_complex> pieces(whole.size() + 1000);
+      size_t done = 0;
+      while (wave.remaining()) {
+        const size_t left = wave.remaining();
+        const size_t n = wave.generate(&pieces[done], std::rand() % 300);
+        CPPUNIT_ASSERT_EQUAL(left - n, wave.remaining());
+        done += n;
+      }
+      CPPUNIT_ASSERT_EQUAL(whole.size(), done);
+      CPPUNIT_ASSERT_EQUAL(size_t(0), wave.generate(&pieces[0], 10));
+      for (size_t s = 0; s < whole.size(); s++)
+        CPPUNIT_ASSERT(whole[s] == pieces[s]);
+    }
+
+    void
+    qa_oqpsk_waveform::t_rx_model()
+    {
+      // Through the FPGA receiver and back, with I and Q swapped the way
+      // zluudg_mult wants them and enough silence around the burst
+      const std::vector<uint8_t> psdu = random_psdu(40, 9);
+      oqpsk_waveform wave(20);
+      wave.start(&psdu[0], psdu.size());
+      std::vector<gr_complex> burst(wave.remaining());
+      wave.generate(&burst[0], burst.size());
+
+      std::vector<int16_t> iq(2 * 10000, 0);
+      for (size_t s = 0; s < burst.size(); s++) {
+        iq.push_back(int16_t(std::floor(burst[s].imag() * 8000.0f + 0.5f)));
+        iq.push_back(int16_t(std::floor(burst[s].real() * 8000.0f + 0.5f)));
+      }
+      iq.resize(iq.size() + 2 * 20000, 0);
+
+      rx_model model;
+      model.set_register(SR_DECIM_RATE, 20);
+      model.set_register(SR_SHIFT_THRESHOLD, 1 << 14);
+      model.work(&iq[0], iq.size() / 2);
+      std::vector<uint32_t> words;
+      std::vector<size_t> ends;
+      CPPUNIT_ASSERT_EQUAL(size_t(1), model.take_bursts(words, ends));
+      CPPUNIT_ASSERT_EQUAL(psdu.size(), words.size());
+      for (size_t i = 0; i < psdu.size(); i++) {
+        const uint8_t flags = words[i] >> 8;
+        CPPUNIT_ASSERT_EQUAL(int(psdu[i]), int(words[i] & 0xFF));
+        CPPUNIT_ASSERT(flags & CHDR_FLAG_ACTIVE);
+        CPPUNIT_ASSERT(!(flags & (CHDR_FLAG_CRAP1 | CHDR_FLAG_CRAP2)));
+        CPPUNIT_ASSERT_EQUAL(i + 1 == psdu.size(), bool(flags & CHDR_FLAG_ENDFRAME));
+      }
+    }
+
+  } /* namespace zluudgbee */
+} /* namespace gr */
@@ -0,0 +1,50 @@
+/* -*- c++ -*- */
+/* 
+ * Copyright 2019 Leon Fernandez (zluudg).
+ * 
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ * 
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef _QA_OQPSK_WAVEFORM_H_
+#define _QA_OQPSK_WAVEFORM_H_
+
+#include <cppunit/extensions/HelperMacros.h>
+#include <cppunit/TestCase.h>
+
+namespace gr {
+  namespace zluudgbee {
+
+    class qa_oqpsk_waveform : public CppUnit::TestCase
+    {
+    public:
+      CPPUNIT_TEST_SUITE(qa_oqpsk_waveform);
+      CPPUNIT_TEST(t_reference);
+      CPPUNIT_TEST(t_sc16);
+      CPPUNIT_TEST(t_chunked);
+      CPPUNIT_TEST(t_rx_model);
+      CPPUNIT_TEST_SUITE_END();
+
+    private:
+      void t_reference();
+      void t_sc16();
+      void t_chunked();
+      void t_rx_model();
+    };
+
+  } /* namespace zluudgbee */
+} /* namespace gr */
+
+#endif /* _QA_OQPSK_WAVEFORM_H_ */
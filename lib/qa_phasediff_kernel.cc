@@ -0,0 +1,126 @@
+/* -*- c++ -*- */
+/* 
+ * Copyright 2019 Leon Fernandez (zluudg).
+ * 
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ * 
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include <gnuradio/attributes.h>
+#include <cppunit/TestAssert.h>
+#include "qa_phasediff_kernel.h"
+#include "phasediff_kernel.h"
+#include "rx_model.h"
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+
+namespace gr {
+  namespace zluudgbee {
+
+    // Random sc16 samples with the full-scale corner cases mixed in,
+    // -32768 being the one whose negation wraps.
+    static std::vector<int16_t>
+    random_sc16(size_t n, unsigned seed)
+    {
+      static const int16_t corners[] = { -32768, -32767, -1, 0, 1, 32767 };
+      std::srand(seed);
+      std::vector<int16_t> iq(2*n);
+      for (size_t i = 0; i < iq.size(); i++) {
+        if (std::rand() % 4 == 0)
+          iq[i] = corners[std::rand() % 6];
+        else
+          iq[i] = int16_t(std::rand());
+      }
+      return iq;
+    }
+
+    void
+    qa_phasediff_kernel::t_simd_vs_generic()
+    {
+      // Every length up to a few vectors, so the tail gets tried at each
+      // position
+      for (size_t n = 0; n < 70; n++) {
+        const std::vector<int16_t> cur = random_sc16(n + 1, 10 + n);
+        const std::vector<int16_t> old = random_sc16(n + 1, 100 + n);
+        std::vector<int32_t> fast(n + 1), ref(n + 1);
+        phasediff_sc16_pairs(&cur[0], &old[0], n, &fast[0]);
+        phasediff_sc16_generic(&cur[0], &old[0], n, &ref[0]);
+        for (size_t i = 0; i < n; i++)
+          CPPUNIT_ASSERT_EQUAL(ref[i], fast[i]);
+      }
+    }
+
+    void
+    qa_phasediff_kernel::t_rx_model()
+    {
+      // zluudg_mult takes the words with I in the upper half and the old
+      // symbol already conjugated, zluudg_atan the 33-bit products.
+      const size_t n = 4096;
+      const std::vector<int16_t> cur = random_sc16(n, 3);
+      const std::vector<int16_t> old = random_sc16(n, 4);
+      std::vector<int32_t> out(n);
+      phasediff_sc16_pairs(&cur[0], &old[0], n, &out[0]);
+
+      rx_mult mult;
+      for (size_t i = 0; i < n; i++) {
+        const uint32_t fact1 = (uint32_t(uint16_t(cur[2*i])) << 16) | uint16_t(cur[2*i+1]);
+        const uint32_t fact2 = (uint32_t(uint16_t(-old[2*i])) << 16) | uint16_t(old[2*i+1]);
+        mult.reset();
+        mult.clock(true, fact1, fact2);
+        mult.clock(false, fact1, fact2);
+        CPPUNIT_ASSERT(mult.m_valid);
+        CPPUNIT_ASSERT_EQUAL(rx_atan::phase(mult.m_real, mult.m_imag), out[i]);
+      }
+    }
+
+    void
+    qa_phasediff_kernel::t_stream()
+    {
+      // Each sample against the one before it, the first against prev
+      const size_t n = 37;
+      const std::vector<int16_t> iq = random_sc16(n, 5);
+      const int16_t prev[2] = { 1000, -2000 };
+      std::vector<int32_t> out(n), ref(n);
+      phasediff_sc16(&iq[0], prev, n, &out[0]);
+
+      phasediff_sc16_generic(&iq[0], prev, 1, &ref[0]);
+      phasediff_sc16_generic(&iq[2], &iq[0], n - 1, &ref[1]);
+      for (size_t i = 0; i < n; i++)
+        CPPUNIT_ASSERT_EQUAL(ref[i], out[i]);
+
+      phasediff_sc16(&iq[0], prev, 0, &out[0]);
+    }
+
+    void
+    qa_phasediff_kernel::t_angles()
+    {
+      // The phase is Q3.17 radians and, Q being the real part for
+      // zluudg_mult, turns the other way. Steps of 1/64 of a turn around
+      // the unit circle from a fixed reference.
+      const double scale = 1 << 17;
+      const int16_t old[2] = { 20000, 0 };
+      for (int k = -31; k <= 31; k++) {
+        const double a = k * M_PI / 32;
+        const int16_t cur[2] = { int16_t(std::lround(20000 * std::cos(a))),
+                                 int16_t(std::lround(20000 * std::sin(a))) };
+        int32_t ph;
+        phasediff_sc16_pairs(cur, old, 1, &ph);
+        CPPUNIT_ASSERT_DOUBLES_EQUAL(-a * scale, double(ph), 16.0);
+      }
+    }
+
+  } /* namespace zluudgbee */
+} /* namespace gr */
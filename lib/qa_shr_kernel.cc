@@ -0,0 +1,156 @@
+/* -*- c++ -*- */
+/* 
+ * Copyright 2019 Leon Fernandez (zluudg).
+ * 
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ * 
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include <gnuradio/attributes.h>
+#include <cppunit/TestAssert.h>
+#include "qa_shr_kernel.h"
+#include "shr_kernel.h"
+#include "rx_model.h"
+#include <cstdlib>
+#include <vector>
+
+namespace gr {
+  namespace zluudgbee {
+
+    static std::vector<int32_t>
+    random_phases(size_t n, unsigned seed)
+    {
+      static const int32_t corners[] = { INT32_MIN, -1, 0, 1, INT32_MAX };
+      std::srand(seed);
+      std::vector<int32_t> in(n);
+      for (size_t i = 0; i < n; i++) {
+        if (std::rand() % 8 == 0)
+          in[i] = corners[std::rand() % 5];
+        else
+          in[i] = std::rand() - RAND_MAX / 2;
+      }
+      return in;
+    }
+
+    // Phase differences that spell out the synchronization header from
+    // chip start on, oldest chip first, with the given chips flipped
+    static void
+    plant_header(std::vector<int32_t> &in, size_t start, const std::vector<size_t> &flips)
+    {
+      for (size_t k = 0; k < SHR_CHIPS; k++) {
+        const size_t pos = SHR_CHIPS - 1 - k;
+        bool chip = (rx_detector::SYNCH_HEADER[pos / 64] >> (pos % 64)) & 1;
+        for (size_t f = 0; f < flips.size(); f++)
+          chip ^= flips[f] == k;
+        in[start + k] = chip ? 1000 : -1000;
+      }
+    }
+
+    void
+    qa_shr_kernel::t_pack()
+    {
+      for (size_t n = 0; n < 300; n += 7) {
+        const std::vector<int32_t> in = random_phases(n + 1, 30 + n);
+        const size_t nwords = (n + 63) / 64;
+        std::vector<uint64_t> fast(nwords + 1, 0), ref(nwords + 1, 0);
+        shr_pack_chips(&in[0], n, &fast[0]);
+        shr_pack_chips_generic(&in[0], n, &ref[0]);
+        for (size_t w = 0; w < nwords; w++)
+          CPPUNIT_ASSERT_EQUAL(ref[w], fast[w]);
+        for (size_t i = 0; i < n; i++)
+          CPPUNIT_ASSERT_EQUAL(in[i] >= 0, bool((fast[i / 64] >> (i % 64)) & 1));
+      }
+    }
+
+    void
+    qa_shr_kernel::t_rx_model()
+    {
+      // The detector's score of its shift register after every chip
+      const size_t n = 1024;
+      std::vector<int32_t> in = random_phases(n, 7);
+      std::vector<size_t> flips;
+      flips.push_back(3);
+      plant_header(in, 500, flips);
+      std::vector<uint64_t> words((n + 63) / 64 + 1, 0);
+      shr_pack_chips(&in[0], n, &words[0]);
+
+      rx_detector detector;
+      detector.reset();
+      for (size_t t = 0; t < n; t++) {
+        detector.clock(false, true, in[t], 0);
+        if (t >= SHR_CHIPS - 1)
+          CPPUNIT_ASSERT_EQUAL(detector.shreg_score, shr_score(&words[0], t));
+      }
+    }
+
+    void
+    qa_shr_kernel::t_scan()
+    {
+      // Against shr_score() at every chip, with matches planted so that
+      // more than the early-out path gets exercised
+      const size_t n = 2000;
+      std::vector<int32_t> in = random_phases(n, 8);
+      std::vector<size_t> flips;
+      plant_header(in, 100, flips);
+      flips.push_back(0);
+      flips.push_back(100);
+      flips.push_back(190);
+      plant_header(in, 900, flips);
+      std::vector<uint64_t> words((n + 63) / 64 + 1, 0);
+      shr_pack_chips(&in[0], n, &words[0]);
+
+      const unsigned sensitivities[] = { 0, 3, 20, 70, 200 };
+      for (size_t k = 0; k < sizeof(sensitivities) / sizeof(sensitivities[0]); k++) {
+        const unsigned sens = sensitivities[k];
+        std::vector<shr_match> matches;
+        shr_scan(&words[0], SHR_CHIPS - 1, n, sens, matches);
+
+        size_t m = 0;
+        for (size_t t = SHR_CHIPS - 1; t < n; t++) {
+          const unsigned score = shr_score(&words[0], t);
+          if (score > sens)
+            continue;
+          CPPUNIT_ASSERT(m < matches.size());
+          CPPUNIT_ASSERT_EQUAL(t, matches[m].chip);
+          CPPUNIT_ASSERT_EQUAL(score, matches[m].score);
+          m++;
+        }
+        CPPUNIT_ASSERT_EQUAL(m, matches.size());
+      }
+    }
+
+    void
+    qa_shr_kernel::t_header()
+    {
+      // Chips 0, 32, 64 and so on, counted from the oldest, are masked out
+      const size_t n = 600;
+      std::vector<int32_t> in(n, -1000);
+      std::vector<size_t> flips;
+      flips.push_back(0);
+      flips.push_back(5);
+      flips.push_back(150);
+      plant_header(in, 300, flips);
+      std::vector<uint64_t> words((n + 63) / 64 + 1, 0);
+      shr_pack_chips(&in[0], n, &words[0]);
+
+      std::vector<shr_match> matches;
+      shr_scan(&words[0], SHR_CHIPS - 1, n, 2, matches);
+      CPPUNIT_ASSERT_EQUAL(size_t(1), matches.size());
+      CPPUNIT_ASSERT_EQUAL(size_t(300 + SHR_CHIPS - 1), matches[0].chip);
+      CPPUNIT_ASSERT_EQUAL(2u, matches[0].score);
+    }
+
+  } /* namespace zluudgbee */
+} /* namespace gr */
@@ -0,0 +1,50 @@
+/* -*- c++ -*- */
+/* 
+ * Copyright 2019 Leon Fernandez (zluudg).
+ * 
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ * 
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef _QA_SHR_KERNEL_H_
+#define _QA_SHR_KERNEL_H_
+
+#include <cppunit/extensions/HelperMacros.h>
+#include <cppunit/TestCase.h>
+
+namespace gr {
+  namespace zluudgbee {
+
+    class qa_shr_kernel : public CppUnit::TestCase
+    {
+    public:
+      CPPUNIT_TEST_SUITE(qa_shr_kernel);
+      CPPUNIT_TEST(t_pack);
+      CPPUNIT_TEST(t_rx_model);
+      CPPUNIT_TEST(t_scan);
+      CPPUNIT_TEST(t_header);
+      CPPUNIT_TEST_SUITE_END();
+
+    private:
+      void t_pack();
+      void t_rx_model();
+      void t_scan();
+      void t_header();
+    };
+
+  } /* namespace zluudgbee */
+} /* namespace gr */
+
+#endif /* _QA_SHR_KERNEL_H_ */
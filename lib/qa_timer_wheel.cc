@@ -0,0 +1,208 @@
+/* -*- c++ -*- */
+/* 
+ * Copyright 2019 Leon Fernandez (zluudg).
+ * 
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ * 
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include <gnuradio/attributes.h>
+#include <cppunit/TestAssert.h>
+#include "qa_timer_wheel.h"
+#include "timer_wheel.h"
+#include <algorithm>
+#include <cstdlib>
+#include <vector>
+
+namespace gr {
+  namespace zluudgbee {
+
+    // Notes the tick each timer fires on, which is the one before now()
+    struct fire_log
+    {
+      timer_wheel &wheel;
+      std::vector<uint64_t> tick;       // by owner
+      std::vector<uint32_t> order;
+
+      fire_log(timer_wheel &w, size_t timers)
+        : wheel(w), tick(timers, ~uint64_t(0))
+      {
+      }
+
+      void operator()(timer_wheel::timer &t)
+      {
+        CPPUNIT_ASSERT(!t.pending());
+        tick[t.owner] = wheel.now() - 1;
+        order.push_back(t.owner);
+      }
+    };
+
+    static uint64_t
+    random_delay()
+    {
+      // Spread over all four levels, and a few beyond
+      const int bits = std::rand() % 26;
+      return uint64_t(std::rand()) & ((uint64_t(1) << bits) - 1);
+    }
+
+    void
+    qa_timer_wheel::t_levels()
+    {
+      // Every timer fires on its deadline, however far off, with the
+      // wheel advanced in uneven steps from an odd starting point
+      std::srand(1);
+      const uint64_t start = 1000003;
+      timer_wheel wheel(start);
+      std::vector<timer_wheel::timer> timers(3000);
+      std::vector<uint64_t> due(timers.size());
+      for (size_t i = 0; i < timers.size(); i++) {
+        const uint64_t delay = random_delay();
+        timers[i].owner = i;
+        wheel.schedule(timers[i], start + delay);
+        due[i] = start + std::min(delay, uint64_t(timer_wheel::MAX_DELAY));
+      }
+      CPPUNIT_ASSERT_EQUAL(timers.size(), wheel.size());
+
+      fire_log fired(wheel, timers.size());
+      uint64_t now = start;
+      while (wheel.size()) {
+        now += std::rand() % 50000;
+        wheel.advance(now, fired);
+        CPPUNIT_ASSERT_EQUAL(now + 1, wheel.now());
+        for (size_t i = 0; i < timers.size(); i++)
+          CPPUNIT_ASSERT_EQUAL(due[i] > now, timers[i].pending());
+      }
+      for (size_t i = 0; i < timers.size(); i++)
+        CPPUNIT_ASSERT_EQUAL(due[i], fired.tick[i]);
+      CPPUNIT_ASSERT_EQUAL(timers.size(), fired.order.size());
+    }
+
+    void
+    qa_timer_wheel::t_cascade_order()
+    {
+      // Deadlines on both sides of each level boundary, armed from a tick
+      // that isn't aligned to any of them, fire in deadline order
+      const uint64_t start = 100;
+      const uint64_t offsets[] = {
+        0, 1, 62, 63, 64, 65, 4094, 4095, 4096, 4097,
+        262143, 262144, 262145, 16777214, 16777215
+      };
+      const size_t n = sizeof(offsets) / sizeof(offsets[0]);
+      timer_wheel wheel(start);
+      std::vector<timer_wheel::timer> timers(n + 1);
+      for (size_t i = n; i-- > 0; ) {
+        timers[i].owner = i;
+        wheel.schedule(timers[i], start + offsets[i]);
+      }
+
+      // Already overdue fires on the first tick processed
+      timers[n].owner = n;
+      wheel.schedule(timers[n], start - 50);
+
+      fire_log fired(wheel, timers.size());
+      wheel.advance(start, fired);
+      CPPUNIT_ASSERT_EQUAL(size_t(2), fired.order.size());
+      CPPUNIT_ASSERT_EQUAL(start, fired.tick[n]);
+      CPPUNIT_ASSERT_EQUAL(start, fired.tick[0]);
+
+      wheel.advance(start + timer_wheel::MAX_DELAY, fired);
+      CPPUNIT_ASSERT_EQUAL(size_t(0), wheel.size());
+      CPPUNIT_ASSERT_EQUAL(n + 1, fired.order.size());
+      for (size_t k = 2; k < fired.order.size(); k++)
+        CPPUNIT_ASSERT_EQUAL(uint32_t(k - 1), fired.order[k]);
+      for (size_t i = 0; i < n; i++)
+        CPPUNIT_ASSERT_EQUAL(start + offsets[i], fired.tick[i]);
+
+      // Beyond the last level the deadline is clamped
+      timer_wheel::timer far;
+      wheel.schedule(far, wheel.now() + timer_wheel::MAX_DELAY + 12345);
+      CPPUNIT_ASSERT_EQUAL(wheel.now() + timer_wheel::MAX_DELAY, far.expires);
+      wheel.cancel(far);
+    }
+
+    void
+    qa_timer_wheel::t_cancel()
+    {
+      timer_wheel wheel;
+      std::vector<timer_wheel::timer> timers(4);
+      for (size_t i = 0; i < timers.size(); i++) {
+        timers[i].owner = i;
+        wheel.schedule(timers[i], 5000 * (i + 1));
+      }
+
+      // Cancelling twice or a timer that isn't armed does nothing,
+      // rearming moves a timer rather than adding it again
+      wheel.cancel(timers[1]);
+      wheel.cancel(timers[1]);
+      CPPUNIT_ASSERT(!timers[1].pending());
+      CPPUNIT_ASSERT_EQUAL(size_t(3), wheel.size());
+      wheel.schedule(timers[3], 10);
+      CPPUNIT_ASSERT_EQUAL(size_t(3), wheel.size());
+
+      fire_log fired(wheel, timers.size());
+      wheel.advance(20000, fired);
+      CPPUNIT_ASSERT_EQUAL(size_t(3), fired.order.size());
+      CPPUNIT_ASSERT_EQUAL(uint32_t(3), fired.order[0]);
+      CPPUNIT_ASSERT_EQUAL(uint32_t(0), fired.order[1]);
+      CPPUNIT_ASSERT_EQUAL(uint32_t(2), fired.order[2]);
+      CPPUNIT_ASSERT_EQUAL(uint64_t(10), fired.tick[3]);
+      CPPUNIT_ASSERT_EQUAL(~uint64_t(0), fired.tick[1]);
+      CPPUNIT_ASSERT_EQUAL(size_t(0), wheel.size());
+    }
+
+    // Rearms timer 0 every period ticks and cancels timer 1 on the way
+    struct periodic
+    {
+      timer_wheel &wheel;
+      timer_wheel::timer &other;
+      const uint64_t period;
+      std::vector<uint64_t> ticks;
+
+      periodic(timer_wheel &w, timer_wheel::timer &o, uint64_t p)
+        : wheel(w), other(o), period(p)
+      {
+      }
+
+      void operator()(timer_wheel::timer &t)
+      {
+        CPPUNIT_ASSERT_EQUAL(uint32_t(0), t.owner);
+        ticks.push_back(wheel.now() - 1);
+        wheel.schedule(t, t.expires + period);
+        if (ticks.size() == 3)
+          wheel.cancel(other);
+      }
+    };
+
+    void
+    qa_timer_wheel::t_fire_reschedules()
+    {
+      timer_wheel wheel;
+      timer_wheel::timer timer, other;
+      other.owner = 1;
+      wheel.schedule(timer, 63);
+      wheel.schedule(other, 4000);
+
+      periodic fire(wheel, other, 1000);
+      wheel.advance(5000, fire);
+      CPPUNIT_ASSERT_EQUAL(size_t(5), fire.ticks.size());
+      for (size_t k = 0; k < fire.ticks.size(); k++)
+        CPPUNIT_ASSERT_EQUAL(uint64_t(63 + 1000 * k), fire.ticks[k]);
+      CPPUNIT_ASSERT(timer.pending());
+      CPPUNIT_ASSERT(!other.pending());
+      CPPUNIT_ASSERT_EQUAL(size_t(1), wheel.size());
+    }
+
+  } /* namespace zluudgbee */
+} /* namespace gr */
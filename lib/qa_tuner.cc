@@ -0,0 +1,228 @@
+/* -*- c++ -*- */
+/* 
+ * Copyright 2019 Leon Fernandez (zluudg).
+ * 
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ * 
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include <gnuradio/attributes.h>
+#include <cppunit/TestAssert.h>
+#include "qa_tuner.h"
+#include <zluudgbee/tuner.h>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <stdexcept>
+#include <unistd.h>
+
+namespace gr {
+  namespace zluudgbee {
+
+    // Good frames per period at settings some steps off the optimum.
+    // Every setting costs on its own, so the climb has a single peak.
+    static uint64_t
+    score(int dshr, int dcrappy, int dshift)
+    {
+      return 1000 - 5 * std::abs(dshr) - 7 * std::abs(dcrappy) - 9 * std::abs(dshift);
+    }
+
+    /*
+     * Records every point of the grid within span steps of start, scored
+     * by their distance in steps from the point optimum steps away. Each
+     * gets 10 bad frames, so only the good frames decide.
+     */
+    static void
+    record_grid(replay_backend &backend, const tuner_settings &start,
+                const tuner_settings &step, int span, const int *optimum)
+    {
+      for (int i = -span; i <= span; i++)
+        for (int j = -span; j <= span; j++)
+          for (int k = -span; k <= span; k++) {
+            const tuner_settings s(start.shr_sens + i * step.shr_sens,
+                                   start.crappy_threshold + j * step.crappy_threshold,
+                                   start.shift_threshold + k * step.shift_threshold);
+            backend.add(s, score(i - optimum[0], j - optimum[1], k - optimum[2]), 10);
+          }
+    }
+
+    // Runs the climb for one-second periods, the way autotuner does
+    static void
+    climb(hill_climber &climber, tuner_backend &backend, int periods)
+    {
+      for (int p = 0; p < periods; p++) {
+        backend.apply(climber.current());
+        uint64_t good, bad;
+        backend.take_outcomes(good, bad);
+        climber.report(good, bad, 1.0);
+      }
+    }
+
+    static void
+    check_outcomes(replay_backend &backend, uint64_t good, uint64_t bad)
+    {
+      uint64_t g, b;
+      backend.take_outcomes(g, b);
+      CPPUNIT_ASSERT_EQUAL(good, g);
+      CPPUNIT_ASSERT_EQUAL(bad, b);
+    }
+
+    void
+    qa_tuner::t_replay_bookkeeping()
+    {
+      // Nothing recorded gives nothing
+      replay_backend empty;
+      empty.apply(tuner_settings());
+      check_outcomes(empty, 0, 0);
+      CPPUNIT_ASSERT(empty.replayed() == tuner_settings());
+
+      // Periods of the same settings are kept together and in order
+      const tuner_settings a(20, 8, 0.125), b(60, 4, 0.5);
+      replay_backend backend;
+      backend.add(a, 100, 1);
+      backend.add(b, 300, 3);
+      backend.add(a, 200, 2);
+
+      backend.apply(a);
+      CPPUNIT_ASSERT(backend.replayed() == a);
+      check_outcomes(backend, 100, 1);
+      check_outcomes(backend, 200, 2);
+      check_outcomes(backend, 100, 1);    // played in a loop
+
+      // Settings that weren't recorded get the closest ones that were.
+      // Each setting keeps its own place in its loop.
+      backend.apply(tuner_settings(56, 5, 0.5));
+      CPPUNIT_ASSERT(backend.replayed() == b);
+      check_outcomes(backend, 300, 3);
+      check_outcomes(backend, 300, 3);
+      backend.apply(tuner_settings(24, 8, 0.25));
+      CPPUNIT_ASSERT(backend.replayed() == a);
+      check_outcomes(backend, 200, 2);
+    }
+
+    void
+    qa_tuner::t_replay_file()
+    {
+      char path[] = "/tmp/qa-zluudgbee-XXXXXX";
+      const int fd = mkstemp(path);
+      CPPUNIT_ASSERT(fd >= 0);
+      close(fd);
+
+      {
+        std::ofstream out(path);
+        out << "# shr_sens crappy_threshold shift_threshold good bad\n"
+            << "20 8 0.125 143 12\n"
+            << "\n"
+            << "   # a comment after blanks\n"
+            << "24 8 0.125 150 9\n"
+            << "20\t8\t0.125\t141\t13\r\n";
+      }
+      replay_backend backend(path);
+      backend.apply(tuner_settings(20, 8, 0.125));
+      check_outcomes(backend, 143, 12);
+      check_outcomes(backend, 141, 13);
+      backend.apply(tuner_settings(24, 8, 0.125));
+      CPPUNIT_ASSERT(backend.replayed() == tuner_settings(24, 8, 0.125));
+      check_outcomes(backend, 150, 9);
+
+      // A field missing
+      {
+        std::ofstream out(path);
+        out << "20 8 0.125 143 12\n"
+            << "24 8 0.125 150\n";
+      }
+      CPPUNIT_ASSERT_THROW(replay_backend bad(path), std::runtime_error);
+      std::remove(path);
+      CPPUNIT_ASSERT_THROW(replay_backend bad(path), std::runtime_error);
+    }
+
+    void
+    qa_tuner::t_converges()
+    {
+      // The optimum is three steps off in every setting, within reach
+      const tuner_settings start(60, 8, 0.5), step(4, 1, 0.125);
+      const int optimum[3] = { 3, -3, 2 };
+      replay_backend backend;
+      record_grid(backend, start, step, 6, optimum);
+
+      hill_climber climber(start, step, 6);
+      climb(climber, backend, 200);
+      CPPUNIT_ASSERT(climber.best() == tuner_settings(72, 5, 0.75));
+
+      // The centre gets measured again between rounds, but it stays put
+      climb(climber, backend, 50);
+      CPPUNIT_ASSERT(climber.best() == tuner_settings(72, 5, 0.75));
+    }
+
+    void
+    qa_tuner::t_bounds()
+    {
+      // The optimum is eight steps out in every setting, further than
+      // the climber may go. shr_sens runs into what the FPGA accepts
+      // after two.
+      const tuner_settings start(184, 8, 0.5), step(4, 1, 0.125);
+      const int optimum[3] = { 8, 8, -8 };
+      replay_backend backend;
+      record_grid(backend, start, step, 10, optimum);
+
+      hill_climber climber(start, step, 3);
+      for (int p = 0; p < 200; p++) {
+        const tuner_settings &s = climber.current();
+        CPPUNIT_ASSERT(s.shr_sens >= 172 && s.shr_sens <= 192);
+        CPPUNIT_ASSERT(s.crappy_threshold >= 5 && s.crappy_threshold <= 11);
+        CPPUNIT_ASSERT(s.shift_threshold >= 0.125 && s.shift_threshold <= 0.875);
+        climb(climber, backend, 1);
+      }
+      CPPUNIT_ASSERT(climber.best() == tuner_settings(192, 11, 0.125));
+
+      // Nor below zero
+      hill_climber low(tuner_settings(2, 1, 0.125), step, 3);
+      for (int p = 0; p < 50; p++) {
+        const tuner_settings &s = low.current();
+        CPPUNIT_ASSERT(s.shr_sens >= 0 && s.crappy_threshold >= 0 && s.shift_threshold >= 0);
+        low.report(1000 - 10 * (s.shr_sens + s.crappy_threshold), 0, 1.0);
+      }
+      CPPUNIT_ASSERT(low.best() == tuner_settings(0, 0, 0.125));
+    }
+
+    void
+    qa_tuner::t_step_size()
+    {
+      // Every probe is one step away from the centre in one setting, and
+      // a setting without a step is left alone
+      const tuner_settings start(60, 8, 0.5), step(4, 2, 0.0);
+      const int optimum[3] = { -2, 2, 0 };
+      replay_backend backend;
+      record_grid(backend, start, tuner_settings(4, 2, 0.125), 6, optimum);
+
+      hill_climber climber(start, step, 6);
+      for (int p = 0; p < 100; p++) {
+        const tuner_settings &s = climber.current();
+        const tuner_settings &center = climber.best();
+        const int dshr = std::abs(s.shr_sens - center.shr_sens);
+        const int dcrappy = std::abs(s.crappy_threshold - center.crappy_threshold);
+        CPPUNIT_ASSERT_EQUAL(0.5, s.shift_threshold);
+        CPPUNIT_ASSERT((dshr == 0 && dcrappy == 0)
+                       || (dshr == 4 && dcrappy == 0)
+                       || (dshr == 0 && dcrappy == 2));
+        CPPUNIT_ASSERT_EQUAL(0, (s.shr_sens - start.shr_sens) % 4);
+        CPPUNIT_ASSERT_EQUAL(0, (s.crappy_threshold - start.crappy_threshold) % 2);
+        climb(climber, backend, 1);
+      }
+      CPPUNIT_ASSERT(climber.best() == tuner_settings(52, 12, 0.5));
+    }
+
+  } /* namespace zluudgbee */
+} /* namespace gr */
@@ -0,0 +1,52 @@
+/* -*- c++ -*- */
+/* 
+ * Copyright 2019 Leon Fernandez (zluudg).
+ * 
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ * 
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef _QA_TUNER_H_
+#define _QA_TUNER_H_
+
+#include <cppunit/extensions/HelperMacros.h>
+#include <cppunit/TestCase.h>
+
+namespace gr {
+  namespace zluudgbee {
+
+    class qa_tuner : public CppUnit::TestCase
+    {
+    public:
+      CPPUNIT_TEST_SUITE(qa_tuner);
+      CPPUNIT_TEST(t_replay_bookkeeping);
+      CPPUNIT_TEST(t_replay_file);
+      CPPUNIT_TEST(t_converges);
+      CPPUNIT_TEST(t_bounds);
+      CPPUNIT_TEST(t_step_size);
+      CPPUNIT_TEST_SUITE_END();
+
+    private:
+      void t_replay_bookkeeping();
+      void t_replay_file();
+      void t_converges();
+      void t_bounds();
+      void t_step_size();
+    };
+
+  } /* namespace zluudgbee */
+} /* namespace gr */
+
+#endif /* _QA_TUNER_H_ */
@@ -26,11 +26,41 @@
  */
 
 #include "qa_zluudgbee.h"
+#include "qa_addr_index.h"
+#include "qa_capture_file.h"
+#include "qa_chdr_receiver.h"
+#include "qa_coord_engine.h"
+#include "qa_correlate_kernel.h"
+#include "qa_crc16.h"
+#include "qa_demapper_kernel.h"
+#include "qa_mac_templates.h"
+#include "qa_metrics.h"
+#include "qa_mac_frame_view.h"
+#include "qa_oqpsk_waveform.h"
+#include "qa_phasediff_kernel.h"
+#include "qa_shr_kernel.h"
+#include "qa_timer_wheel.h"
+#include "qa_tuner.h"
 
 CppUnit::TestSuite *
 qa_zluudgbee::suite()
 {
   CppUnit::TestSuite *s = new CppUnit::TestSuite("zluudgbee");
+  s->addTest(gr::zluudgbee::qa_crc16::suite());
+  s->addTest(gr::zluudgbee::qa_phasediff_kernel::suite());
+  s->addTest(gr::zluudgbee::qa_demapper_kernel::suite());
+  s->addTest(gr::zluudgbee::qa_shr_kernel::suite());
+  s->addTest(gr::zluudgbee::qa_oqpsk_waveform::suite());
+  s->addTest(gr::zluudgbee::qa_correlate_kernel::suite());
+  s->addTest(gr::zluudgbee::qa_chdr_receiver::suite());
+  s->addTest(gr::zluudgbee::qa_mac_frame_view::suite());
+  s->addTest(gr::zluudgbee::qa_timer_wheel::suite());
+  s->addTest(gr::zluudgbee::qa_addr_index::suite());
+  s->addTest(gr::zluudgbee::qa_coord_engine::suite());
+  s->addTest(gr::zluudgbee::qa_capture_file::suite());
+  s->addTest(gr::zluudgbee::qa_tuner::suite());
+  s->addTest(gr::zluudgbee::qa_mac_templates::suite());
+  s->addTest(gr::zluudgbee::qa_metrics::suite());
 
   return s;
 }
@@ -0,0 +1,1124 @@
+/* -*- c++ -*- */
+/* 
+ * Copyright 2019 Leon Fernandez (zluudg).
+ * 
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ * 
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "rx_model.h"
+#include <cstring>
+
+namespace gr {
+  namespace zluudgbee {
+
+    // Sign extends the low bits of v, which is what wrapping a VHDL signed
+    // of that width amounts to.
+    static inline int64_t
+    wrap(int64_t v, int bits)
+    {
+      return int64_t(uint64_t(v) << (64 - bits)) >> (64 - bits);
+    }
+
+    static const int SAMPLEW = 16;
+    static const int PRODW = 2*SAMPLEW + 1;
+    static const int PHASEW = 20;
+    static const int CHIPW = 20;
+
+    static inline int32_t wrap_chip(int64_t v) { return int32_t(wrap(v, CHIPW)); }
+    static inline int32_t wrap_phase(int64_t v) { return int32_t(wrap(v, PHASEW)); }
+    static inline int64_t wrap_prod(int64_t v) { return wrap(v, PRODW); }
+
+    static inline int32_t
+    abs_chip(int32_t v)
+    {
+      // abs() of the most negative value wraps back onto itself
+      return wrap_chip(v < 0 ? -int64_t(v) : v);
+    }
+
+    /*
+     * zluudg_decimator
+     */
+    void
+    rx_decimator::reset()
+    {
+      tdata_d = 0;
+      prev_symbol = 0;
+      counter = 0;
+      en_decim = false;
+      tvalid_d = false;
+    }
+
+    uint32_t
+    rx_decimator::m_oldsym() const
+    {
+      const uint16_t imag = uint16_t(0 - (prev_symbol >> SAMPLEW));
+      return (uint32_t(imag) << SAMPLEW) | (prev_symbol & 0xFFFF);
+    }
+
+    void
+    rx_decimator::clock(bool s_tvalid, uint32_t s_tdata, unsigned shift, uint32_t sr_decim_rate)
+    {
+      if (tvalid_d)
+        prev_symbol = tdata_d;
+      if (s_tvalid && en_decim)
+        tdata_d = s_tdata;
+      tvalid_d = en_decim && s_tvalid;
+
+      if (s_tvalid) {
+        // Compared as numbers, so a rate of zero never matches
+        const uint32_t decim_counter = uint16_t(counter + shift);
+        if (decim_counter == sr_decim_rate - 1) {
+          en_decim = true;
+          counter++;
+        }
+        else if (decim_counter == sr_decim_rate) {
+          en_decim = false;
+          counter = 1;
+        }
+        else {
+          counter++;
+        }
+      }
+    }
+
+    /*
+     * zluudg_mult
+     */
+    void
+    rx_mult::reset()
+    {
+      re_prod1 = re_prod2 = im_prod1 = im_prod2 = 0;
+      m_real = m_imag = 0;
+      tvalid_d = false;
+      m_valid = false;
+    }
+
+    void
+    rx_mult::clock(bool s_tvalid, uint32_t fact1, uint32_t fact2)
+    {
+      // The differences are 32 bits wide before being resized to 33
+      m_real = wrap(int64_t(re_prod1) - re_prod2, 2*SAMPLEW);
+      m_imag = wrap(int64_t(im_prod1) + im_prod2, 2*SAMPLEW);
+
+      const int32_t a = int16_t(fact1 & 0xFFFF);
+      const int32_t b = int16_t(fact1 >> SAMPLEW);
+      const int32_t c = int16_t(fact2 & 0xFFFF);
+      const int32_t d = int16_t(fact2 >> SAMPLEW);
+      re_prod1 = a * c;
+      re_prod2 = b * d;
+      im_prod1 = a * d;
+      im_prod2 = b * c;
+
+      m_valid = tvalid_d;
+      tvalid_d = s_tvalid;
+    }
+
+    bool
+    rx_mult::settled(uint32_t fact1, uint32_t fact2) const
+    {
+      if (m_valid || tvalid_d)
+        return false;
+      const int32_t a = int16_t(fact1 & 0xFFFF);
+      const int32_t b = int16_t(fact1 >> SAMPLEW);
+      const int32_t c = int16_t(fact2 & 0xFFFF);
+      const int32_t d = int16_t(fact2 >> SAMPLEW);
+      return re_prod1 == a * c && re_prod2 == b * d &&
+             im_prod1 == a * d && im_prod2 == b * c &&
+             m_real == wrap(int64_t(re_prod1) - re_prod2, 2*SAMPLEW) &&
+             m_imag == wrap(int64_t(im_prod1) + im_prod2, 2*SAMPLEW);
+    }
+
+    /*
+     * zluudg_atan
+     */
+    static const int32_t ANGLE_LUT[rx_atan::N_ITER] = {
+      0x1921F, 0x0ED63, 0x07D6D, 0x03FAB, 0x01FF5, 0x00FFE, 0x007FF, 0x003FF,
+      0x001FF, 0x000FF, 0x0007F, 0x0003F, 0x0001F, 0x0000F, 0x00007, 0x00003,
+      0x00001
+    };
+
+    int32_t
+    rx_atan::rotate(int64_t re, int64_t im, int32_t ph, int first)
+    {
+      // The output is taken from ph_pipe(n_iter-1), so only the first
+      // n_iter-1 micro-rotations ever make it out.
+      for (int i = first; i < N_ITER - 1; i++) {
+        const int64_t re_sh = re >> i;
+        const int64_t im_sh = im >> i;
+        if (im < 0) {
+          re = wrap_prod(re - im_sh);
+          im = wrap_prod(im + re_sh);
+          ph = wrap_phase(ph - ANGLE_LUT[i]);
+        }
+        else {
+          re = wrap_prod(re + im_sh);
+          im = wrap_prod(im - re_sh);
+          ph = wrap_phase(ph + ANGLE_LUT[i]);
+        }
+      }
+      return ph;
+    }
+
+    void
+    rx_atan::reset()
+    {
+      coarse_result = rotate(0, 0, 0, 0);
+      tvalid_dly = 0;
+      edges = 0;
+      for (int i = 0; i < 32; i++)
+        history[i] = coarse_result;
+    }
+
+    int32_t
+    rx_atan::m_phase() const
+    {
+      if (edges >= uint64_t(N_ITER))
+        return history[(edges - N_ITER) & 31];
+      // Right after reset the pipeline still holds zeros that have only
+      // been through the last few stages.
+      return rotate(0, 0, 0, N_ITER - 1 - int(edges));
+    }
+
+    int32_t
+    rx_atan::phase(int64_t s_real, int64_t s_imag)
+    {
+      if (s_imag < 0)
+        return rotate(wrap_prod(-s_imag), s_real, wrap_phase(0xCDBC0), 0);  // -pi/2
+      else
+        return rotate(s_imag, wrap_prod(-s_real), 0x3243F, 0);              // pi/2
+    }
+
+    void
+    rx_atan::clock(bool s_tvalid, int64_t s_real, int64_t s_imag)
+    {
+      if (s_tvalid)
+        coarse_result = phase(s_real, s_imag);
+
+      edges++;
+      history[edges & 31] = coarse_result;
+      tvalid_dly = ((tvalid_dly << 1) | s_tvalid) & ((1u << (N_ITER + 1)) - 1);
+    }
+
+    /*
+     * zluudg_iir
+     */
+    void
+    rx_iir::reset()
+    {
+      y_reg = 0;
+      x_d = 0;
+      m_z = 0;
+      tvalid_d = false;
+      m_valid = false;
+    }
+
+    void
+    rx_iir::clock(bool s_tvalid, int32_t x, uint32_t sr_symsync_mode)
+    {
+      switch (sr_symsync_mode & 3) {
+        case 1:  m_z = wrap_chip(int64_t(x_d) - y_reg); break;
+        case 2:  m_z = y_reg; break;
+        default: m_z = x_d; break;
+      }
+
+      // Runs every clock, valid or not
+      const int32_t v = wrap_chip(int64_t(x) - y_reg) >> ALPHA;
+      y_reg = wrap_chip(int64_t(v) + y_reg);
+
+      if (s_tvalid)
+        x_d = x;
+
+      m_valid = tvalid_d;
+      tvalid_d = s_tvalid;
+    }
+
+    /*
+     * zluudg_shifter
+     */
+    static const int32_t SYMBOL_REF = 0x3243F;   // pi/2
+
+    void
+    rx_shifter::reset()
+    {
+      int_shift = 0;
+      for (int i = 0; i < MA_LINE_MAX; i++)
+        ma_line[i] = 0;
+      err1 = err2 = err3 = err4 = err12 = err34 = 0;
+      err_sig_unscaled = err_sig = 0;
+      // Forces the cached register decodes to be refreshed
+      last_depth = ~0u;
+      last_threshold = ~0u;
+      threshold = threshold_hi = threshold_lo = 0;
+      fakediv_shift = 0;
+      busy = SETTLE_CLOCKS;
+    }
+
+    void
+    rx_shifter::clock(bool en, int32_t data, uint32_t sr_ma_line_depth, uint32_t sr_shift_threshold)
+    {
+      // Once the error pipeline has caught up with the MA line nothing
+      // changes until the next chip, so most clocks end right here.
+      const bool changed = en || sr_ma_line_depth != last_depth ||
+                           sr_shift_threshold != last_threshold;
+      if (!changed && !busy)
+        return;
+      busy = changed ? SETTLE_CLOCKS : busy - 1;
+
+      if (sr_shift_threshold != last_threshold) {
+        // abs() at 32 bits, then resize() to 20 bits, which keeps the
+        // sign bit and the low 19 bits.
+        const int32_t sr = int32_t(sr_shift_threshold);
+        const uint32_t abs_sr = sr < 0 ? 0u - uint32_t(sr) : uint32_t(sr);
+        threshold = wrap_chip(((abs_sr >> 31) << (CHIPW - 1)) | (abs_sr & 0x7FFFF));
+        threshold_hi = wrap_chip(int64_t(threshold) + (threshold >> 1));
+        threshold_lo = wrap_chip(int64_t(threshold) + (threshold >> 2));
+        last_threshold = sr_shift_threshold;
+      }
+
+      if (sr_ma_line_depth != last_depth) {
+        switch (sr_ma_line_depth) {
+          case 2:  fakediv_shift = 1; break;
+          case 4:  fakediv_shift = 2; break;
+          case 8:  fakediv_shift = 3; break;
+          case 16: fakediv_shift = 4; break;
+          default: fakediv_shift = 0; break;
+        }
+        last_depth = sr_ma_line_depth;
+      }
+
+      const unsigned next_shift = (err_sig >= threshold_hi) ? 3 :
+                                  (err_sig >= threshold_lo) ? 2 :
+                                  (err_sig >= threshold) ? 1 : 0;
+
+      err_sig = err_sig_unscaled >> fakediv_shift;
+      err_sig_unscaled = wrap_chip(int64_t(err12) + err34);
+      err12 = wrap_chip(int64_t(err1) + err2);
+      err34 = wrap_chip(int64_t(err3) + err4);
+
+      int32_t *err[4] = { &err1, &err2, &err3, &err4 };
+      const int32_t depth = int32_t(sr_ma_line_depth);
+      for (int q = 0; q < 4; q++) {
+        int32_t sum = 0;
+        for (int i = q*MA_LINE_MAX/4; i < (q+1)*MA_LINE_MAX/4; i++)
+          if (i < depth)
+            sum = wrap_chip(int64_t(sum) + ma_line[i]);
+        *err[q] = sum;
+      }
+
+      if (en) {
+        if (int_shift == 0)
+          std::memmove(&ma_line[1], &ma_line[0], (MA_LINE_MAX - 1) * sizeof(ma_line[0]));
+        else
+          std::memset(&ma_line[1], 0, (MA_LINE_MAX - 1) * sizeof(ma_line[0]));
+        ma_line[0] = abs_chip(wrap_chip(int64_t(SYMBOL_REF) - abs_chip(data)));
+      }
+
+      int_shift = next_shift;
+    }
+
+    /*
+     * zluudg_detector
+     */
+    const uint64_t rx_detector::SYNCH_HEADER[rx_detector::SHR_WORDS] = {
+      0x077AE6CE131F8851ULL, 0x6077AE6C6077AE6CULL, 0x6077AE6C6077AE6CULL
+    };
+    static const unsigned CORR_SCORE_ONES = 0x1FF;
+    static const unsigned CHIPS_PER_SEQ = 32;
+
+    unsigned
+    rx_detector::score(const uint64_t *shreg)
+    {
+      unsigned sum = 0;
+      for (int i = 0; i < SHR_WORDS; i++)
+        sum += __builtin_popcountll((shreg[i] ^ SYNCH_HEADER[i]) & BAD_CHIP_MASK);
+      return sum;
+    }
+
+    void
+    rx_detector::reset()
+    {
+      for (int i = 0; i < SHR_WORDS; i++)
+        shreg[i] = 0;
+      data_reg = 0;
+      corr_score = CORR_SCORE_ONES;
+      found = false;
+      frame_found = false;
+      chip_counter = 0;
+      tvalid_d = tvalid_dd = false;
+      shreg_score = score(shreg);
+    }
+
+    void
+    rx_detector::clock(bool clr_frame, bool s_tvalid, int32_t s_tdata, uint32_t sr_shr_sens)
+    {
+      data_reg = uint32_t(shreg[0]);
+
+      if (clr_frame) {
+        chip_counter = 0;
+        found = false;
+        frame_found = false;
+        corr_score = CORR_SCORE_ONES;
+        tvalid_dd = tvalid_d = false;
+      }
+      else {
+        if (found && s_tvalid)
+          chip_counter = (chip_counter == CHIPS_PER_SEQ - 1) ? 0 : chip_counter + 1;
+        else if (!found)
+          chip_counter = 0;
+        frame_found = !found && corr_score <= sr_shr_sens;
+        found = found || corr_score <= sr_shr_sens;
+        corr_score = shreg_score;
+        tvalid_dd = tvalid_d;
+        tvalid_d = s_tvalid;
+      }
+
+      if (s_tvalid) {
+        // Chips are the inverted sign of the phase difference
+        shreg[2] = (shreg[2] << 1) | (shreg[1] >> 63);
+        shreg[1] = (shreg[1] << 1) | (shreg[0] >> 63);
+        shreg[0] = (shreg[0] << 1) | (s_tdata >= 0);
+        shreg_score = score(shreg);
+      }
+    }
+
+    bool
+    rx_detector::settled(uint32_t sr_shr_sens) const
+    {
+      return !tvalid_d && !tvalid_dd && !frame_found &&
+             data_reg == uint32_t(shreg[0]) &&
+             corr_score == shreg_score &&
+             (found || (corr_score > sr_shr_sens && chip_counter == 0));
+    }
+
+    /*
+     * zluudg_demapper
+     */
+    constexpr uint32_t rx_demapper::CHIP_SEQUENCES[rx_demapper::NSEQ];
+    static const unsigned SCORE_ONES = 0x7F;
+
+    void
+    rx_demapper::reset()
+    {
+      for (int i = 0; i < NSEQ; i++)
+        hamming_scores[i] = 0;
+      for (int g = 0; g < 4; g++) {
+        score[g] = SCORE_ONES;
+        nibble[g] = 0;
+      }
+      tvalid_d = tvalid_dd = false;
+      busy = SETTLE_CLOCKS;
+      last_data = 0;
+      for (int i = 0; i < NSEQ; i++)
+        next_scores[i] = __builtin_popcount((last_data ^ CHIP_SEQUENCES[i]) & CORR_MASK);
+    }
+
+    uint8_t
+    rx_demapper::m_data(uint32_t sr_crappy_threshold) const
+    {
+      // Ties go to the earlier group
+      const bool first12 = score[0] <= score[1];
+      const unsigned score12 = first12 ? score[0] : score[1];
+      const unsigned nibble12 = first12 ? nibble[0] : nibble[1];
+      const bool first34 = score[2] <= score[3];
+      const unsigned score34 = first34 ? score[2] : score[3];
+      const unsigned nibble34 = first34 ? nibble[2] : nibble[3];
+      const bool first = score12 <= score34;
+      const unsigned lowest_score = first ? score12 : score34;
+      const unsigned decoded_nibble = first ? nibble12 : nibble34;
+
+      return decoded_nibble | (lowest_score < sr_crappy_threshold ? 0x00 : 0xF0);
+    }
+
+    void
+    rx_demapper::clock(bool s_tvalid, uint32_t s_tdata)
+    {
+      if (!s_tvalid && !busy && s_tdata == last_data)
+        return;
+      busy = (s_tvalid || s_tdata != last_data) ? SETTLE_CLOCKS : busy - 1;
+
+      // Within a group ties go to the later sequence, the comparison is <=
+      for (int g = 0; g < 4; g++) {
+        unsigned s = SCORE_ONES;
+        for (int i = g*NSEQ/4; i < (g+1)*NSEQ/4; i++) {
+          if (hamming_scores[i] <= s) {
+            s = hamming_scores[i];
+            nibble[g] = i;
+          }
+        }
+        score[g] = s;
+      }
+
+      // The scores are registered every clock, but the input only changes
+      // when the detector shifts in a chip.
+      if (s_tdata != last_data) {
+        last_data = s_tdata;
+        for (int i = 0; i < NSEQ; i++)
+          next_scores[i] = __builtin_popcount((s_tdata ^ CHIP_SEQUENCES[i]) & CORR_MASK);
+      }
+      std::memcpy(hamming_scores, next_scores, sizeof(hamming_scores));
+
+      tvalid_dd = tvalid_d;
+      tvalid_d = s_tvalid;
+    }
+
+    /*
+     * zluudg_packager
+     */
+    static const int NIBBLEW = 4;
+    static const uint32_t FLAG_ACTIVE    = 1u << 8;
+    static const uint32_t FLAG_CRAP1     = 1u << 9;
+    static const uint32_t FLAG_CRAP2     = 1u << 10;
+    static const uint32_t FLAG_ENDFRAME  = 1u << 11;
+    static const unsigned BYTECOUNTER_MASK = 0x7F;
+
+    void
+    rx_packager::reset()
+    {
+      state = S_IDLE;
+      byte_counter = 0;
+      crappy_phr = false;
+      phr_reject = false;
+      nibble_tdata = 0;
+      // The output registers have no reset
+      m_tdata = 0;
+      m_tvalid = m_tlast = false;
+      frame_done = false;
+    }
+
+    void
+    rx_packager::clock(bool s_tvalid, uint8_t s_tdata, bool m_tready)
+    {
+      const bool nibble_crappy = (nibble_tdata >> NIBBLEW) & 1;
+
+      // P_FSM_DECODE
+      switch (state) {
+        case S_PHR_DONE:
+          m_tvalid = false;
+          m_tlast = false;
+          frame_done = (byte_counter == 0);
+          break;
+
+        case S_PL_PART:
+          m_tvalid = false;
+          m_tlast = false;
+          frame_done = false;
+          m_tdata = (m_tdata & ~(0xFu | FLAG_CRAP1)) | (nibble_tdata & 0xF) |
+                    (nibble_crappy ? FLAG_CRAP1 : 0);
+          break;
+
+        case S_PL_DONE:
+          m_tvalid = true;
+          m_tlast = (byte_counter == 0);
+          frame_done = (byte_counter == 0);
+          m_tdata = (m_tdata & ~(0xF0u | FLAG_CRAP2 | FLAG_ENDFRAME)) |
+                    ((nibble_tdata & 0xF) << NIBBLEW) |
+                    (nibble_crappy ? FLAG_CRAP2 : 0) |
+                    (byte_counter == 0 ? FLAG_ENDFRAME : 0) |
+                    FLAG_ACTIVE;
+          break;
+
+        default:
+          m_tvalid = false;
+          m_tlast = false;
+          frame_done = false;
+          break;
+      }
+
+      // P_FSM
+      const bool s_crappy = (s_tdata >> NIBBLEW) & 1;
+      phr_reject = false;
+      switch (state) {
+        case S_IDLE:
+          if (s_tvalid) {
+            state = S_PHR_PART;
+            crappy_phr = s_crappy;
+            byte_counter = (byte_counter & 0x70) | (s_tdata & 0xF);
+          }
+          break;
+
+        case S_PHR_PART:
+          if (s_tvalid) {
+            state = S_PHR_DONE;
+            if (crappy_phr || s_crappy) {
+              byte_counter = 0;
+              phr_reject = true;
+            }
+            else
+              byte_counter = (byte_counter & 0x0F) | ((s_tdata & 0x7) << 4);
+          }
+          break;
+
+        case S_PHR_DONE:
+          if (byte_counter == 0)  // Degenerate case when payload has zero length
+            state = s_tvalid ? S_PHR_PART : S_IDLE;
+          else if (s_tvalid)
+            state = S_PL_PART;
+          break;
+
+        case S_PL_IDLE:
+          if (s_tvalid)
+            state = S_PL_PART;
+          break;
+
+        case S_PL_PART:
+          if (s_tvalid) {
+            state = S_PL_DONE;
+            byte_counter = (byte_counter - 1) & BYTECOUNTER_MASK;
+          }
+          break;
+
+        case S_PL_DONE:
+          if (m_tready) {
+            if (!s_tvalid)
+              state = (byte_counter == 0) ? S_IDLE : S_PL_IDLE;
+            else
+              state = (byte_counter == 0) ? S_PHR_PART : S_PL_PART;
+          }
+          break;
+      }
+
+      // P_INPUT_REG
+      if (s_tvalid)
+        nibble_tdata = s_tdata;
+    }
+
+    bool
+    rx_packager::settled() const
+    {
+      if (m_tvalid || m_tlast || frame_done || phr_reject)
+        return false;
+      switch (state) {
+        case S_IDLE:
+        case S_PHR_PART:
+        case S_PL_IDLE:
+          return true;
+        case S_PHR_DONE:
+          return byte_counter != 0;
+        case S_PL_PART:
+          return (m_tdata & (0xFu | FLAG_CRAP1)) ==
+                 ((nibble_tdata & 0xFu) | (((nibble_tdata >> NIBBLEW) & 1) ? FLAG_CRAP1 : 0));
+        default:
+          return false;
+      }
+    }
+
+    /*
+     * zluudg_ppfifo
+     */
+    void
+    rx_ppfifo::reset()
+    {
+      state = S_MA;
+      w1_ptr = r1_ptr = w2_ptr = r2_ptr = 0;
+      skip_fifo1 = skip_fifo2 = false;
+      initialized = false;
+      burst_skipped = false;
+      m_tvalid = m_tlast = false;
+      s_tready = false;
+      almost_full = false;
+      sel_fifo = false;
+      // The RAMs and their output registers have no reset
+    }
+
+    void
+    rx_ppfifo::clock(bool s_tvalid, uint32_t s_tdata, bool s_tlast, bool m_tready, bool skip_burst)
+    {
+      // zluudg_ram, read first
+      dob1 = ram1[r1_ptr];
+      dob2 = ram2[r2_ptr];
+      if (s_tvalid && (state == S_MA || state == S_MA_R))
+        ram1[w1_ptr] = s_tdata;
+      if (s_tvalid && (state == S_MB || state == S_MB_R))
+        ram2[w2_ptr] = s_tdata;
+
+      // P_STATE_DECODE
+      const bool mode_a = (state == S_MA || state == S_MA_R || state == S_MA_W);
+      const unsigned w_ptr = mode_a ? w1_ptr : w2_ptr;
+      almost_full = (w_ptr >= END - WATERMARK_LIM);
+      sel_fifo = !mode_a;
+      switch (state) {
+        case S_MA:
+          m_tvalid = initialized;
+          m_tlast = (r2_ptr == w2_ptr) && initialized;
+          s_tready = true;
+          break;
+        case S_MA_R:
+        case S_MB_R:
+          m_tvalid = false;
+          m_tlast = false;
+          s_tready = true;
+          break;
+        case S_MA_W:
+          m_tvalid = true;
+          m_tlast = (r2_ptr == w2_ptr);
+          s_tready = false;
+          break;
+        case S_MB:
+          m_tvalid = true;
+          m_tlast = (r1_ptr == w1_ptr);
+          s_tready = true;
+          break;
+        case S_MB_W:
+          m_tvalid = true;
+          m_tlast = (r1_ptr == w1_ptr);
+          s_tready = false;
+          break;
+      }
+
+      // P_PPFIFO
+      burst_skipped = false;
+      switch (state) {
+        case S_MA:
+          if (m_tready && s_tvalid) {
+            if ((w1_ptr == END || s_tlast) && r2_ptr == w2_ptr) {
+              if (skip_fifo1 || skip_burst) {
+                state = S_MB_R;
+                burst_skipped = true;
+                r1_ptr = w1_ptr = r2_ptr = w2_ptr = 0;
+              }
+              else {
+                state = S_MB;
+                r1_ptr = r2_ptr = w2_ptr = 0;
+              }
+              skip_fifo1 = false;
+              initialized = true;
+            }
+            else if (w1_ptr == END || s_tlast) {
+              state = S_MA_W;
+              r2_ptr++;
+              skip_fifo1 = skip_fifo1 || skip_burst;
+            }
+            else if (r2_ptr == w2_ptr) {
+              state = S_MA_R;
+              w1_ptr++;
+              skip_fifo1 = skip_fifo1 || skip_burst;
+            }
+            else {
+              r2_ptr++;
+              w1_ptr++;
+              skip_fifo1 = skip_fifo1 || skip_burst;
+            }
+          }
+          else if (m_tready && !s_tvalid) {
+            if (r2_ptr == w2_ptr)
+              state = S_MA_R;
+            else
+              r2_ptr++;
+          }
+          else if (!m_tready && s_tvalid) {
+            skip_fifo1 = skip_fifo1 || skip_burst;
+            if (w1_ptr == END || s_tlast)
+              state = S_MA_W;
+            else
+              w1_ptr++;
+          }
+          break;
+
+        case S_MA_R:
+          if (s_tvalid) {
+            const bool skip = skip_burst || skip_fifo1;
+            skip_fifo1 = skip;
+            if (w1_ptr == END || s_tlast) {
+              if (skip) {
+                state = S_MB_R;
+                burst_skipped = true;
+                r1_ptr = w1_ptr = r2_ptr = w2_ptr = 0;
+              }
+              else {
+                state = S_MB;
+                r1_ptr = r2_ptr = w2_ptr = 0;
+              }
+              skip_fifo1 = false;
+              initialized = true;
+            }
+            else {
+              w1_ptr++;
+            }
+          }
+          break;
+
+        case S_MA_W:
+          if (m_tready) {
+            if (r1_ptr == w1_ptr) {
+              // Looks at skip_fifo2 even though fifo1 was just written,
+              // kept as in the VHDL.
+              if (skip_fifo2) {
+                state = S_MB_R;
+                burst_skipped = true;
+                r1_ptr = w1_ptr = r2_ptr = w2_ptr = 0;
+              }
+              else {
+                state = S_MB;
+                r1_ptr = r2_ptr = w2_ptr = 0;
+              }
+              skip_fifo1 = false;
+              initialized = true;
+            }
+            else {
+              r1_ptr++;
+            }
+          }
+          break;
+
+        case S_MB:
+          if (m_tready && s_tvalid) {
+            if ((w2_ptr == END || s_tlast) && r1_ptr == w1_ptr) {
+              if (skip_fifo2 || skip_burst) {
+                state = S_MA_R;
+                burst_skipped = true;
+                r1_ptr = w1_ptr = r2_ptr = w2_ptr = 0;
+              }
+              else {
+                state = S_MA;
+                r1_ptr = w1_ptr = r2_ptr = 0;
+              }
+              skip_fifo2 = false;
+            }
+            else if (w2_ptr == END || s_tlast) {
+              state = S_MB_W;
+              r1_ptr++;
+              skip_fifo2 = skip_fifo2 || skip_burst;
+            }
+            else if (r1_ptr == w1_ptr) {
+              state = S_MB_R;
+              w2_ptr++;
+              skip_fifo2 = skip_fifo2 || skip_burst;
+            }
+            else {
+              r1_ptr++;
+              w2_ptr++;
+              skip_fifo2 = skip_fifo2 || skip_burst;
+            }
+          }
+          else if (m_tready && !s_tvalid) {
+            if (r1_ptr == w1_ptr)
+              state = S_MB_R;
+            else
+              r1_ptr++;
+          }
+          else if (!m_tready && s_tvalid) {
+            skip_fifo2 = skip_fifo2 || skip_burst;
+            if (w2_ptr == END || s_tlast)
+              state = S_MB_W;
+            else
+              w2_ptr++;
+          }
+          break;
+
+        case S_MB_R:
+          if (s_tvalid) {
+            const bool skip = skip_burst || skip_fifo2;
+            skip_fifo2 = skip;
+            if (w2_ptr == END || s_tlast) {
+              if (skip) {
+                state = S_MA_R;
+                burst_skipped = true;
+                r1_ptr = w1_ptr = r2_ptr = w2_ptr = 0;
+              }
+              else {
+                state = S_MA;
+                r1_ptr = w1_ptr = r2_ptr = 0;
+              }
+              skip_fifo2 = false;
+            }
+            else {
+              w2_ptr++;
+            }
+          }
+          break;
+
+        case S_MB_W:
+          if (m_tready) {
+            if (r1_ptr == w1_ptr) {
+              if (skip_fifo2) {
+                state = S_MA_R;
+                burst_skipped = true;
+                r1_ptr = w1_ptr = r2_ptr = w2_ptr = 0;
+              }
+              else {
+                state = S_MA;
+                r1_ptr = w1_ptr = r2_ptr = 0;
+              }
+              skip_fifo2 = false;
+            }
+            else {
+              r1_ptr++;
+            }
+          }
+          break;
+      }
+    }
+
+    bool
+    rx_ppfifo::settled() const
+    {
+      if (state != S_MA_R && state != S_MB_R)
+        return false;
+      const unsigned w_ptr = (state == S_MA_R) ? w1_ptr : w2_ptr;
+      return !m_tvalid && !m_tlast && s_tready && !burst_skipped &&
+             almost_full == (w_ptr >= END - WATERMARK_LIM) &&
+             sel_fifo == (state == S_MB_R) &&
+             dob1 == ram1[r1_ptr] && dob2 == ram2[r2_ptr];
+    }
+
+    /*
+     * zluudg_receiver
+     */
+    rx_model::rx_model()
+      : d_sr_symsync_mode(SR_SYMSYNC_MODE_RESET),
+        d_sr_shift_threshold(SR_SHIFT_THRESHOLD_RESET),
+        d_sr_decim_rate(SR_DECIM_RATE_RESET),
+        d_sr_ma_line_depth(SR_MA_LINE_DEPTH_RESET),
+        d_sr_shr_sens(SR_SHR_SENS_RESET),
+        d_sr_crappy_threshold(SR_CRAPPY_THRESHOLD_RESET),
+        d_quiet(false),
+        d_clocks_per_sample(1),
+        d_input_gap(0),
+        d_clocks(0)
+    {
+      std::memset(d_ppfifo.ram1, 0, sizeof(d_ppfifo.ram1));
+      std::memset(d_ppfifo.ram2, 0, sizeof(d_ppfifo.ram2));
+      d_ppfifo.dob1 = d_ppfifo.dob2 = 0;
+      reset();
+    }
+
+    void
+    rx_model::reset()
+    {
+      d_decimator.reset();
+      d_mult.reset();
+      d_atan.reset();
+      d_iir.reset();
+      d_shifter.reset();
+      d_detector.reset();
+      d_demapper.reset();
+      d_packager.reset();
+      d_ppfifo.reset();
+      d_almost_full_d = false;
+      d_frames_detected = d_phr_rejects = d_skipped_bursts = d_almost_full_events = 0;
+      d_quiet = false;
+      d_input_gap = 0;
+      d_words.clear();
+      d_ends.clear();
+      d_end_clocks.clear();
+    }
+
+    void
+    rx_model::set_register(int addr, uint32_t value)
+    {
+      switch (addr) {
+        case SR_SYMSYNC_MODE:     d_sr_symsync_mode = value; break;
+        case SR_SHIFT_THRESHOLD:  d_sr_shift_threshold = value; break;
+        case SR_DECIM_RATE:       d_sr_decim_rate = value; break;
+        case SR_MA_LINE_DEPTH:    d_sr_ma_line_depth = value; break;
+        case SR_SHR_SENS:         d_sr_shr_sens = value; break;
+        case SR_CRAPPY_THRESHOLD: d_sr_crappy_threshold = value; break;
+        default: break;           // Nobody listens on other addresses
+      }
+      d_quiet = false;
+    }
+
+    uint32_t
+    rx_model::get_register(int addr) const
+    {
+      switch (addr) {
+        case SR_SYMSYNC_MODE:     return d_sr_symsync_mode;
+        case SR_SHIFT_THRESHOLD:  return d_sr_shift_threshold;
+        case SR_DECIM_RATE:       return d_sr_decim_rate;
+        case SR_MA_LINE_DEPTH:    return d_sr_ma_line_depth;
+        case SR_SHR_SENS:         return d_sr_shr_sens;
+        case SR_CRAPPY_THRESHOLD: return d_sr_crappy_threshold;
+        default:                  return 0;
+      }
+    }
+
+    uint32_t
+    rx_model::get_readback(int addr) const
+    {
+      switch (addr) {
+        case RB_FRAMES_DETECTED:    return d_frames_detected;
+        case RB_PHR_REJECTS:        return d_phr_rejects;
+        case RB_SKIPPED_BURSTS:     return d_skipped_bursts;
+        case RB_ALMOST_FULL_EVENTS: return d_almost_full_events;
+        default:                    return 0;
+      }
+    }
+
+    bool
+    rx_model::clock(bool s_tvalid, uint32_t s_tdata)
+    {
+      // Everything a stage sees during this cycle comes from registers,
+      // so sample all of it before anything is clocked.
+      const bool almost_full = d_ppfifo.almost_full;
+      const bool chain_tready = d_ppfifo.s_tready;
+      const bool iq_tvalid = s_tvalid && !almost_full;
+      const bool iq_tready = chain_tready && !almost_full;
+
+      const unsigned shift = d_shifter.int_shift;
+      const bool dec_tvalid = d_decimator.m_tvalid();
+      const uint32_t sym = d_decimator.m_sym();
+      const uint32_t oldsym = d_decimator.m_oldsym();
+      const bool mult_tvalid = d_mult.m_valid;
+      const int64_t real = d_mult.m_real;
+      const int64_t imag = d_mult.m_imag;
+      const bool phase_tvalid = d_atan.m_valid();
+      const int32_t phase = d_atan.m_phase();
+      const bool chip_tvalid = d_iir.m_valid;
+      const int32_t chip = d_iir.m_z;
+      const bool chipseq_tvalid = d_detector.m_valid();
+      const uint32_t chipseq = d_detector.m_data();
+      const bool nibble_tvalid = d_demapper.m_valid();
+      const uint8_t nibble = d_demapper.m_data(d_sr_crappy_threshold);
+      const bool outbyte_tvalid = d_packager.m_tvalid;
+      const uint32_t outbyte = d_packager.m_tdata;
+      const bool outbyte_tlast = d_packager.m_tlast;
+      const bool frame_done = d_packager.frame_done;
+      const bool frame_found = d_detector.frame_found;
+      const bool phr_reject = d_packager.phr_reject;
+      const bool burst_skipped = d_ppfifo.burst_skipped;
+
+      // The block output is always ready, CHDR framing is left to the host
+      if (d_ppfifo.m_tvalid) {
+        d_words.push_back(d_ppfifo.m_tdata());
+        if (d_ppfifo.m_tlast) {
+          d_ends.push_back(d_words.size());
+          d_end_clocks.push_back(d_clocks);
+        }
+      }
+
+      d_decimator.clock(iq_tvalid, s_tdata, shift, d_sr_decim_rate);
+      d_mult.clock(dec_tvalid, sym, oldsym);
+      d_atan.clock(mult_tvalid, real, imag);
+      d_iir.clock(phase_tvalid, phase, d_sr_symsync_mode);
+      d_shifter.clock(chip_tvalid, chip, d_sr_ma_line_depth, d_sr_shift_threshold);
+      d_detector.clock(frame_done, chip_tvalid, chip, d_sr_shr_sens);
+      d_demapper.clock(chipseq_tvalid, chipseq);
+      d_packager.clock(nibble_tvalid, nibble, chain_tready);
+      d_ppfifo.clock(outbyte_tvalid, outbyte, outbyte_tlast, true, false);
+
+      // P_RB_COUNTERS, counting the pulses the stages held during this cycle
+      d_frames_detected += frame_found;
+      d_phr_rejects += phr_reject;
+      d_skipped_bursts += burst_skipped;
+      d_almost_full_events += almost_full && !d_almost_full_d;
+      d_almost_full_d = almost_full;
+
+      d_clocks++;
+      return s_tvalid && iq_tready;
+    }
+
+    bool
+    rx_model::quiet() const
+    {
+      return !d_decimator.en_decim && !d_decimator.tvalid_d &&
+             d_mult.settled(d_decimator.m_sym(), d_decimator.m_oldsym()) &&
+             d_atan.settled() &&
+             !d_iir.tvalid_d && !d_iir.m_valid &&
+             d_shifter.settled(d_sr_ma_line_depth, d_sr_shift_threshold) &&
+             d_detector.settled(d_sr_shr_sens) &&
+             d_demapper.settled(d_detector.m_data()) &&
+             d_packager.settled() &&
+             d_ppfifo.settled() &&
+             d_almost_full_d == d_ppfifo.almost_full;
+    }
+
+    bool
+    rx_model::quiet_clock(bool s_tvalid, uint32_t s_tdata)
+    {
+      // clock() without the stages that would keep their values
+      const bool iq_tvalid = s_tvalid && !d_ppfifo.almost_full;
+      const bool iq_tready = d_ppfifo.s_tready && !d_ppfifo.almost_full;
+
+      d_decimator.clock(iq_tvalid, s_tdata, d_shifter.int_shift, d_sr_decim_rate);
+      d_iir.clock(false, d_atan.m_phase(), d_sr_symsync_mode);
+      d_atan.edges++;
+      d_atan.history[d_atan.edges & 31] = d_atan.coarse_result;
+
+      d_clocks++;
+      return s_tvalid && iq_tready;
+    }
+
+    bool
+    rx_model::step(bool s_tvalid, uint32_t s_tdata)
+    {
+      if (!d_quiet)
+        d_quiet = quiet();
+      if (!d_quiet)
+        return clock(s_tvalid, s_tdata);
+
+      const bool accepted = quiet_clock(s_tvalid, s_tdata);
+      // The next symbol leaves the decimator on the following clock
+      d_quiet = !d_decimator.en_decim;
+      return accepted;
+    }
+
+    void
+    rx_model::work(const int16_t *iq, size_t n)
+    {
+      for (size_t i = 0; i < n; i++) {
+        // CHDR sc16 words carry I in the upper half
+        const uint32_t word = (uint32_t(uint16_t(iq[2*i])) << SAMPLEW) | uint16_t(iq[2*i+1]);
+        for (;;) {
+          if (d_input_gap) {
+            step(false, 0);
+            d_input_gap--;
+          }
+          else if (step(true, word)) {
+            d_input_gap = d_clocks_per_sample - 1;
+            break;
+          }
+        }
+      }
+    }
+
+    void
+    rx_model::idle(uint64_t n)
+    {
+      for (uint64_t i = 0; i < n; i++)
+        step(false, 0);
+    }
+
+    size_t
+    rx_model::take_bursts(std::vector<uint32_t> &words, std::vector<size_t> &ends)
+    {
+      words.clear();
+      ends.clear();
+      if (d_ends.empty())
+        return 0;
+
+      const size_t n = d_ends.back();
+      words.assign(d_words.begin(), d_words.begin() + n);
+      d_words.erase(d_words.begin(), d_words.begin() + n);
+      ends.swap(d_ends);
+      d_end_clocks.clear();
+      return ends.size();
+    }
+
+    size_t
+    rx_model::take_bursts(std::vector<uint32_t> &words, std::vector<size_t> &ends,
+                          std::vector<uint64_t> &end_clocks)
+    {
+      end_clocks.clear();
+      end_clocks.swap(d_end_clocks);
+      return take_bursts(words, ends);
+    }
+
+  } // namespace zluudgbee
+} // namespace gr
@@ -0,0 +1,373 @@
+/* -*- c++ -*- */
+/* 
+ * Copyright 2019 Leon Fernandez (zluudg).
+ * 
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ * 
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_ZLUUDGBEE_RX_MODEL_H
+#define INCLUDED_ZLUUDGBEE_RX_MODEL_H
+
+#include <cstddef>
+#include <vector>
+#include <stdint.h>
+
+namespace gr {
+  namespace zluudgbee {
+
+    /*
+     * Setting register addresses of noc_block_zluudgbeeRX, and the values
+     * the setting_regs come out of reset with.
+     */
+    static const int SR_SYMSYNC_MODE     = 130;
+    static const int SR_SHIFT_THRESHOLD  = 131;
+    static const int SR_DECIM_RATE       = 132;
+    static const int SR_MA_LINE_DEPTH    = 133;
+    static const int SR_SHR_SENS         = 134;
+    static const int SR_CRAPPY_THRESHOLD = 135;
+
+    static const uint32_t SR_SYMSYNC_MODE_RESET     = 0x2ccccccc;
+    static const uint32_t SR_SHIFT_THRESHOLD_RESET  = 0x2ccccccc;
+    static const uint32_t SR_DECIM_RATE_RESET       = 0x00000032;
+    static const uint32_t SR_MA_LINE_DEPTH_RESET    = 0x00000008;
+    static const uint32_t SR_SHR_SENS_RESET         = 0x00000014;
+    static const uint32_t SR_CRAPPY_THRESHOLD_RESET = 0x00000008;
+
+    /*
+     * Readback addresses of the event counters in zluudg_receiver. The
+     * counters are 32 bits wide, wrap around and clear on areset.
+     */
+    static const int RB_FRAMES_DETECTED    = 0;
+    static const int RB_PHR_REJECTS        = 1;
+    static const int RB_SKIPPED_BURSTS     = 2;
+    static const int RB_ALMOST_FULL_EVENTS = 3;
+
+    /*
+     * Register transfer level models of the stages in zluudg_receiver.vhd.
+     *
+     * Every stage holds the same registers as its VHDL counterpart, with
+     * the same widths and wrap-around. Outputs are functions of the
+     * registers only, and clock() computes the registers after the next
+     * rising edge from the current registers and the inputs seen during
+     * the cycle. Clocking all stages with inputs sampled before any of
+     * them was clocked is what makes the composition cycle accurate.
+     *
+     * Signed values are kept sign extended in plain integers.
+     */
+
+    // zluudg_decimator.vhd
+    struct rx_decimator
+    {
+      uint32_t tdata_d;
+      uint32_t prev_symbol;
+      uint16_t counter;
+      bool en_decim;
+      bool tvalid_d;
+
+      void reset();
+      bool m_tvalid() const { return tvalid_d; }
+      uint32_t m_sym() const { return tdata_d; }
+      // Previous symbol with the upper half (I) negated, i.e. conjugated
+      uint32_t m_oldsym() const;
+      void clock(bool s_tvalid, uint32_t s_tdata, unsigned shift, uint32_t sr_decim_rate);
+    };
+
+    // zluudg_mult.vhd, sym * conj(oldsym) with 33-bit outputs
+    struct rx_mult
+    {
+      int32_t re_prod1, re_prod2, im_prod1, im_prod2;
+      int64_t m_real, m_imag;
+      bool tvalid_d;
+      bool m_valid;
+
+      void reset();
+      void clock(bool s_tvalid, uint32_t fact1, uint32_t fact2);
+      // Nothing in flight and the products belong to the inputs
+      bool settled(uint32_t fact1, uint32_t fact2) const;
+    };
+
+    /*
+     * zluudg_atan.vhd, coarse rotation followed by 16 pipelined CORDIC
+     * micro-rotations. The pipeline isn't gated by tvalid, but the coarse
+     * stage only loads on valid inputs, so the output at any edge is the
+     * CORDIC of whatever the coarse registers held 17 edges earlier. That
+     * is tracked with a short history instead of shifting 17 stages of
+     * registers every clock.
+     */
+    struct rx_atan
+    {
+      static const int N_ITER = 17;
+
+      int32_t coarse_result;     // CORDIC of the coarse stage registers
+      uint32_t tvalid_dly;
+      uint64_t edges;            // since reset
+      int32_t history[32];
+
+      void reset();
+      bool m_valid() const { return (tvalid_dly >> N_ITER) & 1; }
+      // Nothing in flight, so m_phase() stays put
+      bool settled() const { return tvalid_dly == 0 && edges >= uint64_t(N_ITER); }
+      int32_t m_phase() const;
+      void clock(bool s_tvalid, int64_t s_real, int64_t s_imag);
+
+      // Runs micro-rotations first..15 on the given pipeline contents.
+      static int32_t rotate(int64_t re, int64_t im, int32_t ph, int first);
+      // What comes out 17 edges after s_real/s_imag were loaded
+      static int32_t phase(int64_t s_real, int64_t s_imag);
+    };
+
+    // zluudg_iir.vhd
+    struct rx_iir
+    {
+      static const int ALPHA = 13;
+
+      int32_t y_reg;
+      int32_t x_d;
+      int32_t m_z;
+      bool tvalid_d;
+      bool m_valid;
+
+      void reset();
+      void clock(bool s_tvalid, int32_t x, uint32_t sr_symsync_mode);
+    };
+
+    // zluudg_shifter.vhd
+    struct rx_shifter
+    {
+      static const int MA_LINE_MAX = 16;
+
+      unsigned int_shift;
+      int32_t ma_line[MA_LINE_MAX];
+      int32_t err1, err2, err3, err4, err12, err34;
+      int32_t err_sig_unscaled, err_sig;
+
+      // Decoded setting registers and how long until the pipeline settles
+      static const unsigned SETTLE_CLOCKS = 6;
+      uint32_t last_depth, last_threshold;
+      int32_t threshold, threshold_hi, threshold_lo;
+      unsigned fakediv_shift;
+      unsigned busy;
+
+      void reset();
+      void clock(bool en, int32_t data, uint32_t sr_ma_line_depth, uint32_t sr_shift_threshold);
+      bool settled(uint32_t sr_ma_line_depth, uint32_t sr_shift_threshold) const
+      {
+        return !busy && sr_ma_line_depth == last_depth && sr_shift_threshold == last_threshold;
+      }
+    };
+
+    // zluudg_detector.vhd
+    struct rx_detector
+    {
+      static const int SHR_WORDS = 3;   // 192 bits as three 64-bit words
+      static const uint64_t SYNCH_HEADER[SHR_WORDS];
+      static const uint64_t BAD_CHIP_MASK = 0x7FFFFFFF7FFFFFFFULL;
+
+      uint64_t shreg[SHR_WORDS];        // [0] holds bits 63:0
+      uint32_t data_reg;
+      unsigned corr_score;
+      bool found;
+      bool frame_found;                 // pulse, found just went up
+      unsigned chip_counter;
+      bool tvalid_d, tvalid_dd;
+      unsigned shreg_score;             // score of shreg, cached
+
+      void reset();
+      bool m_valid() const { return tvalid_dd && found && chip_counter == 0; }
+      uint32_t m_data() const { return data_reg; }
+      void clock(bool clr_frame, bool s_tvalid, int32_t s_tdata, uint32_t sr_shr_sens);
+      bool settled(uint32_t sr_shr_sens) const;
+
+      static unsigned score(const uint64_t *shreg);
+    };
+
+    // zluudg_demapper.vhd
+    struct rx_demapper
+    {
+      static const int NSEQ = 16;
+      static constexpr uint32_t CHIP_SEQUENCES[NSEQ] = {
+        0x6077AE6C, 0x4E077AE6, 0x6CE077AE, 0x66CE077A,
+        0x2E6CE077, 0x7AE6CE07, 0x77AE6CE0, 0x077AE6CE,
+        0x1F885193, 0x31F88519, 0x131F8851, 0x1931F885,
+        0x51931F88, 0x051931F8, 0x0851931F, 0x78851931
+      };
+      static const uint32_t CORR_MASK = 0x7FFFFFFF;
+
+      unsigned hamming_scores[NSEQ];
+      unsigned score[4];
+      unsigned nibble[4];
+      bool tvalid_d, tvalid_dd;
+      uint32_t last_data;               // input the cached scores belong to
+      unsigned next_scores[NSEQ];
+      static const unsigned SETTLE_CLOCKS = 3;
+      unsigned busy;
+
+      void reset();
+      bool m_valid() const { return tvalid_dd; }
+      uint8_t m_data(uint32_t sr_crappy_threshold) const;
+      void clock(bool s_tvalid, uint32_t s_tdata);
+      bool settled(uint32_t s_tdata) const
+      {
+        return !busy && !tvalid_d && !tvalid_dd && s_tdata == last_data;
+      }
+    };
+
+    // zluudg_packager.vhd
+    struct rx_packager
+    {
+      enum state_t { S_IDLE, S_PHR_PART, S_PHR_DONE, S_PL_IDLE, S_PL_PART, S_PL_DONE };
+
+      state_t state;
+      unsigned byte_counter;
+      bool crappy_phr;
+      bool phr_reject;                  // pulse, frame dropped for a crappy PHR
+      uint8_t nibble_tdata;
+      uint32_t m_tdata;
+      bool m_tvalid, m_tlast;
+      bool frame_done;
+
+      void reset();
+      void clock(bool s_tvalid, uint8_t s_tdata, bool m_tready);
+      // Stays in its state without input and the decoded outputs are idle
+      bool settled() const;
+    };
+
+    // zluudg_ppfifo.vhd with its two zluudg_ram instances
+    struct rx_ppfifo
+    {
+      enum state_t { S_MA, S_MA_R, S_MA_W, S_MB, S_MB_R, S_MB_W };
+      static const unsigned DEPTH = 256;
+      static const unsigned END = DEPTH - 1;
+      static const unsigned WATERMARK_LIM = 2;
+
+      state_t state;
+      unsigned w1_ptr, r1_ptr, w2_ptr, r2_ptr;
+      bool skip_fifo1, skip_fifo2;
+      bool initialized;
+      bool burst_skipped;               // pulse, a written burst was dropped
+      uint32_t ram1[DEPTH], ram2[DEPTH];
+      uint32_t dob1, dob2;
+      bool m_tvalid, m_tlast;
+      bool s_tready;
+      bool almost_full;
+      bool sel_fifo;
+
+      void reset();
+      uint32_t m_tdata() const { return sel_fifo ? dob1 : dob2; }
+      void clock(bool s_tvalid, uint32_t s_tdata, bool s_tlast, bool m_tready, bool skip_burst);
+      // Waiting for input with nothing to read out
+      bool settled() const;
+    };
+
+    /*
+     * The whole of zluudg_receiver.vhd, including the setting registers of
+     * noc_block_zluudgbeeRX. One call to clock() is one rising edge of
+     * aclk. Input samples are presented on consecutive clocks unless
+     * clocks_per_sample is larger than one, and are held while the chain
+     * isn't ready, like the AXI stream in front of it would. The output
+     * is collected into bursts at tlast, which is where the noc_block
+     * ends its CHDR packets.
+     */
+    class rx_model
+    {
+     public:
+      rx_model();
+
+      // Same as asserting areset, registers go back to their reset values.
+      void reset();
+
+      void set_register(int addr, uint32_t value);
+      uint32_t get_register(int addr) const;
+
+      // Event counters at the RB_ addresses, 0 for anything else.
+      uint32_t get_readback(int addr) const;
+
+      void set_clocks_per_sample(unsigned n) { d_clocks_per_sample = n ? n : 1; }
+
+      /*
+       * Feeds n sc16 samples, interleaved I/Q as GNU Radio and UHD store
+       * them, and clocks the model until all of them have been accepted.
+       */
+      void work(const int16_t *iq, size_t n);
+
+      // Runs n clocks with no input.
+      void idle(uint64_t n);
+
+      // One rising edge. Returns true if the sample was accepted.
+      bool clock(bool s_tvalid, uint32_t s_tdata);
+
+      /*
+       * Moves complete output bursts into words, as 32-bit output words
+       * with the payload byte in bits 7:0 and the flags in bits 15:8. ends
+       * receives the end index of every burst. Returns the number of
+       * bursts.
+       */
+      size_t take_bursts(std::vector<uint32_t> &words, std::vector<size_t> &ends);
+
+      // Same, and end_clocks gets the clock on which each burst's tlast left.
+      size_t take_bursts(std::vector<uint32_t> &words, std::vector<size_t> &ends,
+                         std::vector<uint64_t> &end_clocks);
+
+      uint64_t clocks() const { return d_clocks; }
+
+     private:
+      /*
+       * Between chips most clocks only advance the decimator counter and
+       * the IIR, which runs whether there is data or not. When nothing
+       * else is in flight those clocks leave every other register alone,
+       * so they take a shortcut that only touches the ones that change.
+       */
+      bool quiet() const;
+      bool quiet_clock(bool s_tvalid, uint32_t s_tdata);
+      bool step(bool s_tvalid, uint32_t s_tdata);
+
+      uint32_t d_sr_symsync_mode;
+      uint32_t d_sr_shift_threshold;
+      uint32_t d_sr_decim_rate;
+      uint32_t d_sr_ma_line_depth;
+      uint32_t d_sr_shr_sens;
+      uint32_t d_sr_crappy_threshold;
+
+      rx_decimator d_decimator;
+      rx_mult d_mult;
+      rx_atan d_atan;
+      rx_iir d_iir;
+      rx_shifter d_shifter;
+      rx_detector d_detector;
+      rx_demapper d_demapper;
+      rx_packager d_packager;
+      rx_ppfifo d_ppfifo;
+
+      bool d_almost_full_d;
+      uint32_t d_frames_detected;
+      uint32_t d_phr_rejects;
+      uint32_t d_skipped_bursts;
+      uint32_t d_almost_full_events;
+
+      bool d_quiet;
+      unsigned d_clocks_per_sample;
+      unsigned d_input_gap;
+      uint64_t d_clocks;
+
+      std::vector<uint32_t> d_words;
+      std::vector<size_t> d_ends;
+      std::vector<uint64_t> d_end_clocks;
+    };
+
+  } // namespace zluudgbee
+} // namespace gr
+
+#endif /* INCLUDED_ZLUUDGBEE_RX_MODEL_H */
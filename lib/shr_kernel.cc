@@ -0,0 +1,211 @@
+/* -*- c++ -*- */
+/* 
+ * Copyright 2019 Leon Fernandez (zluudg).
+ * 
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ * 
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "shr_kernel.h"
+#include "cpu_features.h"
+#include "rx_model.h"
+
+#ifdef ZLUUDGBEE_X86
+#include <immintrin.h>
+#endif
+
+namespace gr {
+  namespace zluudgbee {
+
+    /*
+     * The detector shifts new chips in at bit 0, so its header constant
+     * has the newest chip in the LSB. The packed stream is the other way
+     * around, hence the header and mask get bit-reversed once, oldest
+     * word first.
+     */
+    struct shr_pattern
+    {
+      uint64_t bits[rx_detector::SHR_WORDS];
+      uint64_t mask;
+    };
+
+    static uint64_t
+    reverse_bits(uint64_t x)
+    {
+      uint64_t r = 0;
+      for (int i = 0; i < 64; i++, x >>= 1)
+        r = (r << 1) | (x & 1);
+      return r;
+    }
+
+    static shr_pattern
+    make_pattern()
+    {
+      shr_pattern p;
+      for (int i = 0; i < rx_detector::SHR_WORDS; i++)
+        p.bits[i] = reverse_bits(rx_detector::SYNCH_HEADER[rx_detector::SHR_WORDS - 1 - i]);
+      p.mask = reverse_bits(rx_detector::BAD_CHIP_MASK);
+      return p;
+    }
+
+    static const shr_pattern &
+    pattern()
+    {
+      static const shr_pattern p = make_pattern();
+      return p;
+    }
+
+    // The 64 chips starting at chip s
+    static inline uint64_t
+    chips_at(const uint64_t *words, size_t s)
+    {
+      const size_t i = s >> 6;
+      const unsigned b = s & 63;
+      return b ? (words[i] >> b) | (words[i+1] << (64 - b)) : words[i];
+    }
+
+    void
+    shr_pack_chips_generic(const int32_t *in, size_t n, uint64_t *words)
+    {
+      for (size_t i = 0; i < n; i += 64) {
+        const size_t m = (n - i < 64) ? n - i : 64;
+        uint64_t w = 0;
+        for (size_t k = 0; k < m; k++)
+          w |= uint64_t(in[i + k] >= 0) << k;
+        words[i >> 6] = w;
+      }
+    }
+
+#ifdef ZLUUDGBEE_X86
+    ZLUUDGBEE_TARGET("sse2")
+    static size_t
+    pack_sse2(const int32_t *in, size_t n, uint64_t *words)
+    {
+      // movmskps picks up four sign bits at once
+      size_t i = 0;
+      for (; i + 64 <= n; i += 64) {
+        uint64_t w = 0;
+        for (int k = 0; k < 16; k++) {
+          const __m128 v = _mm_castsi128_ps(_mm_loadu_si128((const __m128i *) (in + i + 4*k)));
+          w |= uint64_t(_mm_movemask_ps(v)) << (4*k);
+        }
+        words[i >> 6] = ~w;
+      }
+      return i;
+    }
+#endif
+
+    typedef size_t (*pack_fn)(const int32_t *, size_t, uint64_t *);
+
+    static size_t
+    pack_none(const int32_t *, size_t, uint64_t *)
+    {
+      return 0;
+    }
+
+    static pack_fn
+    pick_pack()
+    {
+#ifdef ZLUUDGBEE_X86
+      if (cpu_has_sse2())
+        return pack_sse2;
+#endif
+      return pack_none;
+    }
+
+    void
+    shr_pack_chips(const int32_t *in, size_t n, uint64_t *words)
+    {
+      static const pack_fn simd = pick_pack();
+      size_t done = simd(in, n, words);
+      shr_pack_chips_generic(in + done, n - done, words + done/64);
+    }
+
+    unsigned
+    shr_score(const uint64_t *words, size_t t)
+    {
+      const shr_pattern &p = pattern();
+      const size_t s = t + 1 - SHR_CHIPS;
+      unsigned score = 0;
+      for (int i = 0; i < rx_detector::SHR_WORDS; i++)
+        score += __builtin_popcountll((chips_at(words, s + 64*i) ^ p.bits[i]) & p.mask);
+      return score;
+    }
+
+    static inline __attribute__((always_inline)) void
+    scan(const uint64_t *words, size_t first, size_t last, unsigned sens,
+         std::vector<shr_match> &matches)
+    {
+      const shr_pattern &p = pattern();
+      for (size_t t = first; t < last; t++) {
+        // The SFD is in the newest word and rejects most windows by itself
+        const size_t s = t + 1 - SHR_CHIPS;
+        unsigned score = __builtin_popcountll((chips_at(words, s + 128) ^ p.bits[2]) & p.mask);
+        if (score > sens)
+          continue;
+        score += __builtin_popcountll((chips_at(words, s + 64) ^ p.bits[1]) & p.mask);
+        if (score > sens)
+          continue;
+        score += __builtin_popcountll((chips_at(words, s) ^ p.bits[0]) & p.mask);
+        if (score > sens)
+          continue;
+        shr_match m = {t, score};
+        matches.push_back(m);
+      }
+    }
+
+#ifdef ZLUUDGBEE_X86
+    ZLUUDGBEE_TARGET("popcnt")
+    static void
+    scan_popcnt(const uint64_t *words, size_t first, size_t last, unsigned sens,
+                std::vector<shr_match> &matches)
+    {
+      scan(words, first, last, sens, matches);
+    }
+#endif
+
+    static void
+    scan_generic(const uint64_t *words, size_t first, size_t last, unsigned sens,
+                 std::vector<shr_match> &matches)
+    {
+      scan(words, first, last, sens, matches);
+    }
+
+    typedef void (*scan_fn)(const uint64_t *, size_t, size_t, unsigned, std::vector<shr_match> &);
+
+    static scan_fn
+    pick_scan()
+    {
+#ifdef ZLUUDGBEE_X86
+      if (cpu_has_popcnt())
+        return scan_popcnt;
+#endif
+      return scan_generic;
+    }
+
+    void
+    shr_scan(const uint64_t *words, size_t first, size_t last, unsigned sens,
+             std::vector<shr_match> &matches)
+    {
+      static const scan_fn impl = pick_scan();
+      impl(words, first, last, sens, matches);
+    }
+
+  } // namespace zluudgbee
+} // namespace gr
@@ -0,0 +1,77 @@
+/* -*- c++ -*- */
+/* 
+ * Copyright 2019 Leon Fernandez (zluudg).
+ * 
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ * 
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_ZLUUDGBEE_SHR_KERNEL_H
+#define INCLUDED_ZLUUDGBEE_SHR_KERNEL_H
+
+#include <cstddef>
+#include <vector>
+#include <stdint.h>
+
+namespace gr {
+  namespace zluudgbee {
+
+    /*
+     * Host side of zluudg_detector. Chips are packed 64 to a word, LSB
+     * first, so bit j of words[w] is chip 64*w + j. A chip is one when the
+     * phase difference it came from is non-negative.
+     */
+    static const size_t SHR_CHIPS = 192;   // C_CHIPS_PER_BYTE * 3
+
+    struct shr_match
+    {
+      size_t chip;        // last chip of the SFD
+      unsigned score;     // chips that differ from the header
+    };
+
+    /*
+     * Packs the chips of n phase differences into words, which must hold
+     * (n + 63) / 64 entries. Only the sign bit is looked at, so float
+     * input works too, except that -0.0 counts as negative.
+     */
+    void shr_pack_chips(const int32_t *in, size_t n, uint64_t *words);
+
+    /*
+     * Tests in[i] >= 0 chip by chip. On the integer view of a float that
+     * is the same sign-bit test as the SSE2 path's movmskps, so the two
+     * agree on -0.0 as well.
+     */
+    void shr_pack_chips_generic(const int32_t *in, size_t n, uint64_t *words);
+
+    /*
+     * Number of chips that differ from the synchronization header,
+     * bad_chip_mask applied, in the 192 chips ending at chip t. Same as
+     * corr_score in the VHDL. t must be at least 191.
+     */
+    unsigned shr_score(const uint64_t *words, size_t t);
+
+    /*
+     * Appends every chip t in [first, last) where the header ends with a
+     * score of at most sens, which is when the FPGA sets found. first must
+     * be at least 191. Windows are compared 64 chips at a time, newest
+     * first, and dropped as soon as they are over sens.
+     */
+    void shr_scan(const uint64_t *words, size_t first, size_t last, unsigned sens,
+                  std::vector<shr_match> &matches);
+
+  } // namespace zluudgbee
+} // namespace gr
+
+#endif /* INCLUDED_ZLUUDGBEE_SHR_KERNEL_H */
@@ -0,0 +1,98 @@
+/* -*- c++ -*- */
+/* 
+ * Copyright 2019 Leon Fernandez (zluudg).
+ * 
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ * 
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <gnuradio/io_signature.h>
+#include <cstring>
+#include "shrdetector_impl.h"
+
+namespace gr {
+  namespace zluudgbee {
+
+    shrdetector::sptr
+    shrdetector::make(int sens, int holdoff)
+    {
+      return gnuradio::get_initial_sptr(new shrdetector_impl(sens, holdoff));
+    }
+
+    /*
+     * The private constructor
+     */
+    shrdetector_impl::shrdetector_impl(int sens, int holdoff)
+      : gr::sync_block("shrdetector",
+              gr::io_signature::make(1, 1, sizeof(int32_t)),
+              gr::io_signature::make(1, 1, sizeof(int32_t))),
+        d_next_allowed(0),
+        d_detections(0),
+        d_key(pmt::mp("shr"))
+    {
+      set_sens(sens);
+      set_holdoff(holdoff);
+      // A header ends on the newest chip, the 191 before it come from the
+      // history.
+      set_history(SHR_CHIPS);
+    }
+
+    /*
+     * Our virtual destructor.
+     */
+    shrdetector_impl::~shrdetector_impl()
+    {
+    }
+
+    int
+    shrdetector_impl::work(int noutput_items,
+        gr_vector_const_void_star &input_items,
+        gr_vector_void_star &output_items)
+    {
+      const int32_t *in = (const int32_t *) input_items[0];
+      int32_t *out = (int32_t *) output_items[0];
+
+      // Chip SHR_CHIPS - 1 of the packed buffer is output item 0
+      const size_t first = SHR_CHIPS - 1;
+      const size_t nchips = first + noutput_items;
+      d_words.resize((nchips + 63) / 64);
+      shr_pack_chips(in, nchips, &d_words[0]);
+
+      d_matches.clear();
+      shr_scan(&d_words[0], first, nchips, d_sens, d_matches);
+
+      const uint64_t base = nitems_read(0);
+      for (size_t i = 0; i < d_matches.size(); i++) {
+        const uint64_t item = base + (d_matches[i].chip - first);
+        if (item < d_next_allowed)
+          continue;
+        add_item_tag(0, nitems_written(0) + (d_matches[i].chip - first),
+                     d_key, pmt::from_long(d_matches[i].score), alias_pmt());
+        d_next_allowed = item + 1 + d_holdoff;
+        d_detections++;
+      }
+
+      std::memcpy(out, in + first, noutput_items * sizeof(int32_t));
+
+      // Tell runtime system how many output items we produced.
+      return noutput_items;
+    }
+
+  } /* namespace zluudgbee */
+} /* namespace gr */
@@ -0,0 +1,58 @@
+/* -*- c++ -*- */
+/* 
+ * Copyright 2019 Leon Fernandez (zluudg).
+ * 
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ * 
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_ZLUUDGBEE_SHRDETECTOR_IMPL_H
+#define INCLUDED_ZLUUDGBEE_SHRDETECTOR_IMPL_H
+
+#include <zluudgbee/shrdetector.h>
+#include "shr_kernel.h"
+
+namespace gr {
+  namespace zluudgbee {
+
+    class shrdetector_impl : public shrdetector
+    {
+     private:
+      unsigned d_sens;
+      uint64_t d_holdoff;
+      uint64_t d_next_allowed;         // first item that may be tagged again
+      uint64_t d_detections;
+
+      std::vector<uint64_t> d_words;   // packed chips, history included
+      std::vector<shr_match> d_matches;
+      const pmt::pmt_t d_key;
+
+     public:
+      shrdetector_impl(int sens, int holdoff);
+      ~shrdetector_impl();
+
+      void set_sens(int sens) { d_sens = sens > 0 ? sens : 0; }
+      void set_holdoff(int holdoff) { d_holdoff = holdoff > 0 ? holdoff : 0; }
+      uint64_t detections() const { return d_detections; }
+
+      int work(int noutput_items,
+         gr_vector_const_void_star &input_items,
+         gr_vector_void_star &output_items);
+    };
+
+  } // namespace zluudgbee
+} // namespace gr
+
+#endif /* INCLUDED_ZLUUDGBEE_SHRDETECTOR_IMPL_H */
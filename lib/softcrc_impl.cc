@@ -25,7 +25,11 @@
 #include <zluudgbee/softcrc.h>
 #include <gnuradio/io_signature.h>
 #include <gnuradio/block_detail.h>
+#include <zluudgbee/crc16.h>
+#include <zluudgbee/metrics.h>
+#include <boost/format.hpp>
 
+#include <atomic>
 #include <iostream>
 #include <iomanip>
 
@@ -38,12 +42,15 @@ public:
 
     softcrc_impl(bool rx_mode) :
       gr::block("softcrc", gr::io_signature::make(0, 0, 0), gr::io_signature::make(0, 0, 0)),
-      _rx_mode(rx_mode) {
+      _rx_mode(rx_mode),
+      _oversized_frames(0) {
 
 	    message_port_register_in(pmt::mp("pdu in"));
 	    set_msg_handler(pmt::mp("pdu in"), boost::bind(&softcrc_impl::handle_pdu, this, _1));
 
     	message_port_register_out(pmt::mp("pdu out"));
+
+      _metrics = metrics::register_stage(str(boost::format("softcrc%d") % unique_id()));
     }
 
   ~softcrc_impl() {
@@ -60,54 +67,76 @@ public:
 	  }
 
     size_t pdu_len = pmt::blob_length(blob);
-    uint8_t *pdu_ptr = (uint8_t *) pmt::blob_data(blob);
-    uint16_t crc = crc16(pdu_ptr, pdu_len);
+    const uint8_t *pdu_ptr = (const uint8_t *) pmt::blob_data(blob);
+
+    scoped_latency timer(_metrics->handler_latency);
+    const bool counting = metrics::enabled();
+    if (counting) {
+      _metrics->add(_metrics->frames_in);
+      _metrics->add(_metrics->bytes_in, pdu_len);
+    }
 
     if (_rx_mode) {
 
-      if (!crc) {
-        pmt::pmt_t vector = pmt::make_blob((uint8_t *) pmt::blob_data(blob), pdu_len-2);
+      // Needs at least the FCS, and a good frame checks out to zero
+      // including it. The trimmed payload is copied exactly once.
+      if (pdu_len >= FCS_LEN && !crc16::compute(pdu_ptr, pdu_len)) {
+        pmt::pmt_t vector = pmt::init_u8vector(pdu_len - FCS_LEN, pdu_ptr);
         pmt::pmt_t pdu = pmt::cons(pmt::make_dict(), vector);
         message_port_pub(pmt::mp("pdu out"), pdu);
+        if (counting) {
+          _metrics->add(_metrics->frames_out);
+          _metrics->add(_metrics->bytes_out, pdu_len - FCS_LEN);
+        }
       }
+      else if (counting)
+        _metrics->add(_metrics->crc_failures);
     }
     else { // tx mode
-      for (int i=0; i<pdu_len; i++)
-        outgoing[i] = pdu_ptr[i];
+      if (pdu_len + FCS_LEN > MAX_PSDU_LEN) {
+        _oversized_frames.fetch_add(1, std::memory_order_relaxed);
+        if (counting)
+          _metrics->add(_metrics->drops);
+        std::cout << "softcrc: dropping " << pdu_len << " byte frame, "
+                  << "it won't fit in a PSDU with the FCS" << std::endl;
+        return;
+      }
 
-      outgoing[pdu_len] = (uint8_t) crc & 0xFF;
-      outgoing[pdu_len+1] = (uint8_t) (crc >> 1) & 0xFF;
+      // Copy the MPDU into the vector that gets published and compute the
+      // FCS in the same pass. make_u8vector still zero-fills the vector
+      // first; pmt has no way to allocate one without filling it.
+      pmt::pmt_t vector = pmt::make_u8vector(pdu_len + FCS_LEN, 0);
+      size_t out_len;
+      uint8_t *outgoing = pmt::u8vector_writable_elements(vector, out_len);
+
+      const uint16_t fcs = crc16::compute_copy(outgoing, pdu_ptr, pdu_len);
+
+      outgoing[pdu_len] = fcs & 0xFF;
+      outgoing[pdu_len+1] = (fcs >> 8) & 0xFF;
 
-      pmt::pmt_t vector = pmt::make_blob(outgoing, pdu_len+2);
       pmt::pmt_t pdu = pmt::cons(pmt::make_dict(), vector);
       message_port_pub(pmt::mp("pdu out"), pdu);
+      if (counting) {
+        _metrics->add(_metrics->frames_out);
+        _metrics->add(_metrics->bytes_out, pdu_len + FCS_LEN);
+      }
     }
 
   }
 
+  uint64_t oversized_frames() const {
+    return _oversized_frames.load(std::memory_order_relaxed);
+  }
+
 
 private:
-  bool _rx_mode;
-  uint8_t outgoing[256];
-
-  uint16_t crc16(uint8_t *buf, int len) {
-
-	  uint16_t crc = 0;
-
-	  for(int i = 0; i < len; i++) {
-		  for(int k = 0; k < 8; k++) {
-			  int input_bit = (!!(buf[i] & (1 << k)) ^ (crc & 1));
-			  crc = crc >> 1;
-			  if(input_bit) {
-				  crc ^= (1 << 15);
-				  crc ^= (1 << 10);
-				  crc ^= (1 <<  3);
-			  }
-		  }
-	  }
+  // aMaxPHYPacketSize, 802.15.4 PSDUs (including the FCS) are at most this long
+  static const size_t MAX_PSDU_LEN = 127;
+  static const size_t FCS_LEN = 2;
 
-	  return crc;
-  }
+  bool _rx_mode;
+  std::atomic<uint64_t> _oversized_frames;
+  stage_metrics_sptr _metrics;
 
 };
 
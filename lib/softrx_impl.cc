@@ -0,0 +1,207 @@
+/* -*- c++ -*- */
+/* 
+ * Copyright 2019 Leon Fernandez (zluudg).
+ * 
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ * 
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <gnuradio/io_signature.h>
+#include <boost/bind.hpp>
+#include <cmath>
+#include "softrx_impl.h"
+#include "tuner_ctrl.h"
+
+namespace gr {
+  namespace zluudgbee {
+
+    softrx::sptr
+    softrx::make(int symsync_mode, double shift_threshold, int decim_rate,
+                 int ma_line_depth, int shr_sens, int crappy_threshold,
+                 int clocks_per_sample)
+    {
+      return gnuradio::get_initial_sptr(
+        new softrx_impl(symsync_mode, shift_threshold, decim_rate,
+                        ma_line_depth, shr_sens, crappy_threshold,
+                        clocks_per_sample)
+      );
+    }
+
+    /*
+     * The private constructor
+     */
+    softrx_impl::softrx_impl(int symsync_mode, double shift_threshold, int decim_rate,
+                             int ma_line_depth, int shr_sens, int crappy_threshold,
+                             int clocks_per_sample)
+      : gr::sync_block("softrx",
+              gr::io_signature::make(1, 1, 2*sizeof(int16_t)),
+              gr::io_signature::make(0, 0, 0)),
+        d_port(pmt::mp("data")),
+        d_confidence_key(pmt::mp("confidence")),
+        d_crappy_key(pmt::mp("crappy_nibbles"))
+    {
+      set_symsync_mode(symsync_mode);
+      set_shift_threshold(shift_threshold);
+      set_decim_rate(decim_rate);
+      set_ma_line_depth(ma_line_depth);
+      set_shr_sens(shr_sens);
+      set_crappy_threshold(crappy_threshold);
+      set_clocks_per_sample(clocks_per_sample);
+
+      message_port_register_out(d_port);
+      message_port_register_in(pmt::mp("ctrl"));
+      set_msg_handler(pmt::mp("ctrl"), boost::bind(&softrx_impl::handle_ctrl, this, _1));
+    }
+
+    /*
+     * Our virtual destructor.
+     */
+    softrx_impl::~softrx_impl()
+    {
+    }
+
+    void
+    softrx_impl::set_symsync_mode(int mode)
+    {
+      set_register(SR_SYMSYNC_MODE, mode);
+    }
+
+    void
+    softrx_impl::set_shift_threshold(double threshold)
+    {
+      // Q2.17, rounded like IROUND in the block description
+      set_register(SR_SHIFT_THRESHOLD, uint32_t(int32_t(std::floor(threshold * 131072.0 + 0.5))));
+    }
+
+    void
+    softrx_impl::set_decim_rate(int rate)
+    {
+      set_register(SR_DECIM_RATE, rate);
+    }
+
+    void
+    softrx_impl::set_ma_line_depth(int depth)
+    {
+      set_register(SR_MA_LINE_DEPTH, depth);
+    }
+
+    void
+    softrx_impl::set_shr_sens(int sens)
+    {
+      set_register(SR_SHR_SENS, sens);
+    }
+
+    void
+    softrx_impl::set_crappy_threshold(int threshold)
+    {
+      set_register(SR_CRAPPY_THRESHOLD, threshold);
+    }
+
+    void
+    softrx_impl::set_clocks_per_sample(int clocks)
+    {
+      gr::thread::scoped_lock guard(d_setlock);
+      d_model.set_clocks_per_sample(clocks > 0 ? clocks : 1);
+    }
+
+    void
+    softrx_impl::set_register(int addr, uint32_t value)
+    {
+      gr::thread::scoped_lock guard(d_setlock);
+      d_model.set_register(addr, value);
+    }
+
+    uint32_t
+    softrx_impl::get_register(int addr) const
+    {
+      return d_model.get_register(addr);
+    }
+
+    uint32_t
+    softrx_impl::get_readback(int addr) const
+    {
+      return d_model.get_readback(addr);
+    }
+
+    void
+    softrx_impl::handle_ctrl(pmt::pmt_t msg)
+    {
+      handle_tuner_ctrl(*this, msg);
+    }
+
+    uint64_t
+    softrx_impl::clocks() const
+    {
+      return d_model.clocks();
+    }
+
+    void
+    softrx_impl::publish_bursts()
+    {
+      if (!d_model.take_bursts(d_words, d_ends))
+        return;
+
+      // Same lanes as the CHDR words that chdr2pdu receives
+      const size_t n = d_words.size();
+      d_bytes.resize(n);
+      d_flags.resize(n);
+      for (size_t i = 0; i < n; i++) {
+        d_bytes[i] = d_words[i] & 0xFF;
+        d_flags[i] = (d_words[i] >> 8) & 0xFF;
+      }
+
+      d_frames.clear();
+      size_t start = 0;
+      for (size_t b = 0; b < d_ends.size(); b++) {
+        const size_t first = d_frames.size();
+        chdr_split_frames(&d_flags[start], d_ends[b] - start, d_frames);
+        for (size_t f = first; f < d_frames.size(); f++)
+          d_frames[f].offset += start;
+        start = d_ends[b];
+      }
+
+      for (size_t f = 0; f < d_frames.size(); f++) {
+        const chdr_frame &frame = d_frames[f];
+        pmt::pmt_t meta = pmt::make_dict();
+        meta = pmt::dict_add(meta, d_confidence_key, pmt::from_double(frame.confidence()));
+        meta = pmt::dict_add(meta, d_crappy_key, pmt::from_long(frame.crappy_nibbles));
+        pmt::pmt_t vector = pmt::init_u8vector(frame.len, &d_bytes[frame.offset]);
+        message_port_pub(d_port, pmt::cons(meta, vector));
+      }
+    }
+
+    int
+    softrx_impl::work(int noutput_items,
+        gr_vector_const_void_star &input_items,
+        gr_vector_void_star &output_items)
+    {
+      const int16_t *in = (const int16_t *) input_items[0];
+
+      {
+        gr::thread::scoped_lock guard(d_setlock);
+        d_model.work(in, noutput_items);
+      }
+      publish_bursts();
+
+      // Tell runtime system how many output items we produced.
+      return noutput_items;
+    }
+
+  } /* namespace zluudgbee */
+} /* namespace gr */
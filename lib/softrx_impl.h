@@ -0,0 +1,76 @@
+/* -*- c++ -*- */
+/* 
+ * Copyright 2019 Leon Fernandez (zluudg).
+ * 
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ * 
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_ZLUUDGBEE_SOFTRX_IMPL_H
+#define INCLUDED_ZLUUDGBEE_SOFTRX_IMPL_H
+
+#include <zluudgbee/softrx.h>
+#include "chdr_unpack.h"
+#include "rx_model.h"
+
+namespace gr {
+  namespace zluudgbee {
+
+    class softrx_impl : public softrx
+    {
+     private:
+      rx_model d_model;
+
+      std::vector<uint32_t> d_words;     // bursts taken from the model
+      std::vector<size_t> d_ends;
+      std::vector<uint8_t> d_bytes;      // payload and flag lanes of d_words
+      std::vector<uint8_t> d_flags;
+      std::vector<chdr_frame> d_frames;
+
+      const pmt::pmt_t d_port;
+      const pmt::pmt_t d_confidence_key;
+      const pmt::pmt_t d_crappy_key;
+
+      void publish_bursts();
+      void handle_ctrl(pmt::pmt_t msg);
+
+     public:
+      softrx_impl(int symsync_mode, double shift_threshold, int decim_rate,
+                  int ma_line_depth, int shr_sens, int crappy_threshold,
+                  int clocks_per_sample);
+      ~softrx_impl();
+
+      void set_symsync_mode(int mode);
+      void set_shift_threshold(double threshold);
+      void set_decim_rate(int rate);
+      void set_ma_line_depth(int depth);
+      void set_shr_sens(int sens);
+      void set_crappy_threshold(int threshold);
+      void set_clocks_per_sample(int clocks);
+
+      void set_register(int addr, uint32_t value);
+      uint32_t get_register(int addr) const;
+      uint32_t get_readback(int addr) const;
+      uint64_t clocks() const;
+
+      int work(int noutput_items,
+         gr_vector_const_void_star &input_items,
+         gr_vector_void_star &output_items);
+    };
+
+  } // namespace zluudgbee
+} // namespace gr
+
+#endif /* INCLUDED_ZLUUDGBEE_SOFTRX_IMPL_H */
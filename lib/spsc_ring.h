@@ -0,0 +1,178 @@
+/* -*- c++ -*- */
+/* 
+ * Copyright 2019 Leon Fernandez (zluudg).
+ * 
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ * 
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_ZLUUDGBEE_SPSC_RING_H
+#define INCLUDED_ZLUUDGBEE_SPSC_RING_H
+
+#include <atomic>
+#include <cstddef>
+#include <stdexcept>
+#include <vector>
+#include <stdint.h>
+
+namespace gr {
+  namespace zluudgbee {
+
+    /*
+     * Bounded lock-free ring between one producer and one consumer thread.
+     *
+     * Every slot carries a sequence number (as in Vyukov's bounded queue),
+     * so a slot is only reused once whoever popped it is done moving the
+     * element out. That is what allows the producer to reclaim the oldest
+     * element itself when the ring is full and the policy is DROP_OLDEST,
+     * without ever racing the consumer on a slot.
+     *
+     * The depth is rounded up to the next power of two. Throws
+     * std::length_error if that doesn't fit a size_t.
+     */
+    template <typename T>
+    class spsc_ring
+    {
+     public:
+      enum policy_t { DROP_NEWEST = 0, DROP_OLDEST = 1 };
+
+      spsc_ring(size_t depth, policy_t policy)
+        : d_mask(round_up(depth) - 1),
+          d_cells(d_mask + 1),
+          d_policy(policy),
+          d_head(0),
+          d_tail(0),
+          d_high_water(0),
+          d_drops(0)
+      {
+        for (size_t i = 0; i <= d_mask; i++)
+          d_cells[i].seq.store(i, std::memory_order_relaxed);
+      }
+
+      /*
+       * Producer side. Never blocks: when the ring is full either the new
+       * element or the oldest queued one is dropped, depending on the
+       * policy. Returns false if item was dropped.
+       */
+      bool push(const T &item)
+      {
+        while (!try_push(item)) {
+          if (d_policy == DROP_NEWEST) {
+            d_drops.fetch_add(1, std::memory_order_relaxed);
+            return false;
+          }
+          T oldest;
+          if (pop(oldest))
+            d_drops.fetch_add(1, std::memory_order_relaxed);
+        }
+        return true;
+      }
+
+      // Consumer side. Returns false if the ring is empty.
+      bool pop(T &item)
+      {
+        size_t pos = d_head.load(std::memory_order_relaxed);
+        for (;;) {
+          cell &c = d_cells[pos & d_mask];
+          const size_t seq = c.seq.load(std::memory_order_acquire);
+          const intptr_t dif = intptr_t(seq) - intptr_t(pos + 1);
+          if (dif == 0) {
+            if (d_head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+              item = c.data;
+              c.data = T();
+              c.seq.store(pos + d_mask + 1, std::memory_order_release);
+              return true;
+            }
+          }
+          else if (dif < 0) {
+            return false;
+          }
+          else {
+            pos = d_head.load(std::memory_order_relaxed);
+          }
+        }
+      }
+
+      bool empty() const
+      {
+        return d_head.load(std::memory_order_acquire) == d_tail.load(std::memory_order_acquire);
+      }
+
+      size_t capacity() const { return d_mask + 1; }
+
+      // Largest number of elements that were queued at the same time.
+      size_t high_water() const { return d_high_water.load(std::memory_order_relaxed); }
+
+      // Number of elements dropped because the ring was full.
+      uint64_t drops() const { return d_drops.load(std::memory_order_relaxed); }
+
+     private:
+      struct cell
+      {
+        std::atomic<size_t> seq;
+        T data;
+      };
+
+      static size_t round_up(size_t n)
+      {
+        size_t p = 1;
+        while (p < n) {
+          if (!(p << 1))
+            throw std::length_error("spsc_ring: depth too large");
+          p <<= 1;
+        }
+        return p;
+      }
+
+      bool try_push(const T &item)
+      {
+        const size_t pos = d_tail.load(std::memory_order_relaxed);
+        cell &c = d_cells[pos & d_mask];
+        const size_t seq = c.seq.load(std::memory_order_acquire);
+        if (seq != pos)
+          return false;
+
+        c.data = item;
+        c.seq.store(pos + 1, std::memory_order_release);
+        d_tail.store(pos + 1, std::memory_order_release);
+
+        const size_t level = pos + 1 - d_head.load(std::memory_order_relaxed);
+        if (level > d_high_water.load(std::memory_order_relaxed))
+          d_high_water.store(level, std::memory_order_relaxed);
+        return true;
+      }
+
+      const size_t d_mask;
+      std::vector<cell> d_cells;
+      const policy_t d_policy;
+
+      // Kept on separate cache lines, the two threads hammer on these.
+      // Padded rather than alignas(), so the ring can live inside blocks
+      // allocated with plain operator new.
+      static const size_t CACHE_LINE = 64;
+      char d_pad0[CACHE_LINE];
+      std::atomic<size_t> d_head;
+      char d_pad1[CACHE_LINE - sizeof(size_t)];
+      std::atomic<size_t> d_tail;
+      char d_pad2[CACHE_LINE - sizeof(size_t)];
+      std::atomic<size_t> d_high_water;
+      std::atomic<uint64_t> d_drops;
+    };
+
+  } // namespace zluudgbee
+} // namespace gr
+
+#endif /* INCLUDED_ZLUUDGBEE_SPSC_RING_H */
+
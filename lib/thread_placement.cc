@@ -0,0 +1,178 @@
+/* -*- c++ -*- */
+/* 
+ * Copyright 2019 Leon Fernandez (zluudg).
+ * 
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ * 
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "thread_placement.h"
+#include <gnuradio/thread/thread.h>
+#include <boost/format.hpp>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace gr {
+  namespace zluudgbee {
+
+    static int
+    parse_cpu(const std::string &list, const std::string &s)
+    {
+      char *end;
+      const long cpu = std::strtol(s.c_str(), &end, 10);
+      if (s.empty() || *end || cpu < 0 || cpu > 4095)
+        throw std::invalid_argument("bad CPU list: " + list);
+      return int(cpu);
+    }
+
+    std::vector<int>
+    parse_cpu_list(const std::string &list)
+    {
+      std::vector<int> cpus;
+      size_t start = 0;
+      while (start < list.size()) {
+        size_t comma = list.find(',', start);
+        if (comma == std::string::npos)
+          comma = list.size();
+        const std::string item = list.substr(start, comma - start);
+        const size_t dash = item.find('-');
+        if (dash == std::string::npos)
+          cpus.push_back(parse_cpu(list, item));
+        else {
+          const int first = parse_cpu(list, item.substr(0, dash));
+          const int last = parse_cpu(list, item.substr(dash + 1));
+          if (last < first)
+            throw std::invalid_argument("bad CPU list: " + list);
+          for (int cpu = first; cpu <= last; cpu++)
+            cpus.push_back(cpu);
+        }
+        start = comma + 1;
+      }
+      return cpus;
+    }
+
+    static void
+    add_problem(std::string &problems, const std::string &problem)
+    {
+      if (!problems.empty())
+        problems += "; ";
+      problems += problem;
+    }
+
+    std::string
+    place_current_thread(const std::vector<int> &cpus, int rt_priority)
+    {
+      std::string problems;
+
+      if (!cpus.empty()) {
+        try {
+          gr::thread::thread_bind_to_processor(cpus);
+        }
+        catch (std::exception &e) {
+          add_problem(problems, str(boost::format("can't pin to the CPUs asked for (%s)") % e.what()));
+        }
+      }
+
+      if (rt_priority > 0) {
+#ifdef __linux__
+        // set_thread_priority() would make it SCHED_RR
+        sched_param param;
+        std::memset(&param, 0, sizeof(param));
+        param.sched_priority = rt_priority;
+        const int err = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+        if (err)
+          add_problem(problems, str(boost::format("can't switch to SCHED_FIFO %d (%s), "
+                                                  "see RLIMIT_RTPRIO or CAP_SYS_NICE")
+                                    % rt_priority % std::strerror(err)));
+#else
+        add_problem(problems, "SCHED_FIFO is only supported on Linux");
+#endif
+      }
+
+      return problems;
+    }
+
+    thread_sched_stats
+    current_thread_sched_stats()
+    {
+      thread_sched_stats stats = { 0, -1 };
+#ifdef __linux__
+      rusage usage;
+      if (!getrusage(RUSAGE_THREAD, &usage))
+        stats.involuntary_switches = usage.ru_nivcsw;
+      stats.cpu = sched_getcpu();
+#endif
+      return stats;
+    }
+
+    run_delay_clock::run_delay_clock()
+      : d_fd(-1)
+    {
+#ifdef __linux__
+      d_fd = open("/proc/thread-self/schedstat", O_RDONLY | O_CLOEXEC);
+      if (d_fd < 0) {
+        // Before Linux 3.17
+        const std::string path =
+            str(boost::format("/proc/self/task/%d/schedstat") % syscall(SYS_gettid));
+        d_fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+      }
+#endif
+    }
+
+    run_delay_clock::~run_delay_clock()
+    {
+#ifdef __linux__
+      if (d_fd >= 0)
+        close(d_fd);
+#endif
+    }
+
+    uint64_t
+    run_delay_clock::now() const
+    {
+#ifdef __linux__
+      // "<time on CPU> <time waiting for one> <timeslices>", all in ns
+      char buf[64];
+      if (d_fd < 0)
+        return 0;
+      const ssize_t n = pread(d_fd, buf, sizeof(buf) - 1, 0);
+      if (n <= 0)
+        return 0;
+      buf[n] = '\0';
+      char *end;
+      std::strtoull(buf, &end, 10);
+      return std::strtoull(end, NULL, 10);
+#else
+      return 0;
+#endif
+    }
+
+  } // namespace zluudgbee
+} // namespace gr
@@ -0,0 +1,83 @@
+/* -*- c++ -*- */
+/* 
+ * Copyright 2019 Leon Fernandez (zluudg).
+ * 
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ * 
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_ZLUUDGBEE_THREAD_PLACEMENT_H
+#define INCLUDED_ZLUUDGBEE_THREAD_PLACEMENT_H
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+namespace gr {
+  namespace zluudgbee {
+
+    /*
+     * Pinning and realtime scheduling for the threads blocks start on
+     * their own, which the flowgraph's thread affinity settings never
+     * reach.
+     */
+
+    /*
+     * Parses a CPU list like "2,3,8-11", as taskset -c takes it. An
+     * empty list is no pinning. Throws std::invalid_argument.
+     */
+    std::vector<int> parse_cpu_list(const std::string &list);
+
+    /*
+     * Pins the calling thread to cpus, unless empty, and runs it
+     * SCHED_FIFO at rt_priority, unless zero. Returns what didn't work,
+     * e.g. for lack of CAP_SYS_NICE, or an empty string.
+     */
+    std::string place_current_thread(const std::vector<int> &cpus, int rt_priority);
+
+    struct thread_sched_stats
+    {
+      uint64_t involuntary_switches;   // times the thread was preempted
+      int cpu;                         // where it is running now, -1 if unknown
+    };
+
+    // Of the calling thread. Only Linux keeps these, elsewhere they stay zero.
+    thread_sched_stats current_thread_sched_stats();
+
+    /*
+     * Total time the calling thread has been runnable but waiting for a
+     * CPU, in ns, as /proc/thread-self/schedstat has it. The file stays
+     * open, so create and read it on the thread it is about. Reads zero
+     * where the kernel keeps no schedstats.
+     */
+    class run_delay_clock
+    {
+     public:
+      run_delay_clock();
+      ~run_delay_clock();
+
+      uint64_t now() const;
+
+     private:
+      int d_fd;
+
+      run_delay_clock(const run_delay_clock &) = delete;
+      run_delay_clock &operator=(const run_delay_clock &) = delete;
+    };
+
+  } // namespace zluudgbee
+} // namespace gr
+
+#endif /* INCLUDED_ZLUUDGBEE_THREAD_PLACEMENT_H */
@@ -0,0 +1,94 @@
+/* -*- c++ -*- */
+/* 
+ * Copyright 2019 Leon Fernandez (zluudg).
+ * 
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ * 
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "timer_wheel.h"
+
+namespace gr {
+  namespace zluudgbee {
+
+    timer_wheel::timer_wheel(uint64_t now)
+      : d_now(now), d_count(0)
+    {
+      for (int level = 0; level < LEVELS; level++)
+        for (size_t i = 0; i < SLOTS; i++)
+          d_slots[level][i].prev = d_slots[level][i].next = &d_slots[level][i];
+    }
+
+    void
+    timer_wheel::schedule(timer &t, uint64_t expires)
+    {
+      if (t.pending())
+        cancel(t);
+      t.expires = expires;
+      insert(t);
+      d_count++;
+    }
+
+    void
+    timer_wheel::cancel(timer &t)
+    {
+      if (!t.pending())
+        return;
+      unlink(t);
+      d_count--;
+    }
+
+    void
+    timer_wheel::insert(timer &t)
+    {
+      if (t.expires < d_now) {
+        link(d_slots[0][d_now & (SLOTS - 1)], t);
+        return;
+      }
+      if (t.expires - d_now > MAX_DELAY)
+        t.expires = d_now + MAX_DELAY;
+
+      // The level is the highest group of bits the delay reaches into
+      const uint64_t delay = t.expires - d_now;
+      int level = 0;
+      while (level < LEVELS - 1 && delay >= (uint64_t(1) << (LEVEL_BITS * (level + 1))))
+        level++;
+      link(d_slots[level][(t.expires >> (LEVEL_BITS * level)) & (SLOTS - 1)], t);
+    }
+
+    /*
+     * Spreads the slot of the given level that d_now has just reached
+     * over the levels below. Returns the slot number, which is zero when
+     * the level above is due as well.
+     */
+    size_t
+    timer_wheel::cascade(int level)
+    {
+      const size_t slot = (d_now >> (LEVEL_BITS * level)) & (SLOTS - 1);
+      timer &head = d_slots[level][slot];
+      while (head.next != &head) {
+        timer &t = *head.next;
+        unlink(t);
+        insert(t);
+      }
+      return slot;
+    }
+
+  } // namespace zluudgbee
+} // namespace gr
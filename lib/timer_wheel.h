@@ -0,0 +1,133 @@
+/* -*- c++ -*- */
+/* 
+ * Copyright 2019 Leon Fernandez (zluudg).
+ * 
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ * 
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_ZLUUDGBEE_TIMER_WHEEL_H
+#define INCLUDED_ZLUUDGBEE_TIMER_WHEEL_H
+
+#include <cstddef>
+#include <stdint.h>
+
+namespace gr {
+  namespace zluudgbee {
+
+    /*
+     * Hierarchical timer wheel with a tick of whatever unit the caller
+     * counts time in. Four levels of 64 slots cover 2^24 ticks, later
+     * deadlines are clamped to that. Timers are intrusive, so arming
+     * and cancelling are O(1) and never allocate. A timer in an upper
+     * level moves down one level each time the level below wraps, and
+     * fires once the wheel has been advanced to its deadline.
+     */
+    class timer_wheel
+    {
+     public:
+      static const int LEVEL_BITS = 6;
+      static const int LEVELS = 4;
+      static const size_t SLOTS = size_t(1) << LEVEL_BITS;
+      static const uint64_t MAX_DELAY = (uint64_t(1) << (LEVEL_BITS * LEVELS)) - 1;
+
+      struct timer
+      {
+        timer *prev;
+        timer *next;
+        uint64_t expires;
+        uint32_t owner;          // for the caller, e.g. a table index
+        uint8_t kind;            // same
+
+        timer() : prev(0), next(0), expires(0), owner(0), kind(0) {}
+        bool pending() const { return next != 0; }
+      };
+
+      explicit timer_wheel(uint64_t now = 0);
+
+      // Arms t to fire at expires, disarming it first if it was pending.
+      void schedule(timer &t, uint64_t expires);
+      void cancel(timer &t);
+
+      /*
+       * Moves the wheel to now, calling fire(timer &) for every timer that
+       * is due, in deadline order apart from timers due on the same tick.
+       * fire may schedule and cancel timers, including the one it got.
+       */
+      template <typename F>
+      void advance(uint64_t now, F &fire);
+
+      // The first tick that hasn't been processed yet
+      uint64_t now() const { return d_now; }
+      size_t size() const { return d_count; }
+
+     private:
+      timer d_slots[LEVELS][SLOTS];     // list heads
+      uint64_t d_now;
+      size_t d_count;
+
+      void insert(timer &t);
+      size_t cascade(int level);
+
+      static void link(timer &head, timer &t)
+      {
+        t.prev = head.prev;
+        t.next = &head;
+        head.prev->next = &t;
+        head.prev = &t;
+      }
+
+      static void unlink(timer &t)
+      {
+        t.prev->next = t.next;
+        t.next->prev = t.prev;
+        t.prev = t.next = 0;
+      }
+
+      timer_wheel(const timer_wheel &);
+      timer_wheel &operator=(const timer_wheel &);
+    };
+
+    template <typename F>
+    void
+    timer_wheel::advance(uint64_t now, F &fire)
+    {
+      while (d_now <= now) {
+        if (!d_count) {
+          d_now = now + 1;
+          return;
+        }
+
+        const size_t slot = d_now & (SLOTS - 1);
+        if (!slot)
+          for (int level = 1; level < LEVELS && !cascade(level); level++)
+            ;
+        d_now++;
+
+        // Whatever fire arms lands in a later slot, so this one drains
+        timer &head = d_slots[0][slot];
+        while (head.next != &head) {
+          timer &t = *head.next;
+          unlink(t);
+          d_count--;
+          fire(t);
+        }
+      }
+    }
+
+  } // namespace zluudgbee
+} // namespace gr
+
+#endif /* INCLUDED_ZLUUDGBEE_TIMER_WHEEL_H */
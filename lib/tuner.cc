@@ -0,0 +1,201 @@
+/* -*- c++ -*- */
+/* 
+ * Copyright 2019 Leon Fernandez (zluudg).
+ * 
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ * 
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <zluudgbee/tuner.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+namespace gr {
+  namespace zluudgbee {
+
+    // Same ranges as the checks in the zluudgbeeRX block description
+    static const int MAX_SHR_SENS = 192;
+    static const int MAX_CRAPPY_THRESHOLD = 32;
+    static const double MAX_SHIFT_THRESHOLD = 1.6;
+
+    tuner_settings
+    tuner_settings::clamped() const
+    {
+      return tuner_settings(std::min(std::max(shr_sens, 0), MAX_SHR_SENS),
+                            std::min(std::max(crappy_threshold, 0), MAX_CRAPPY_THRESHOLD),
+                            std::min(std::max(shift_threshold, 0.0), MAX_SHIFT_THRESHOLD));
+    }
+
+    bool
+    tuner_settings::operator==(const tuner_settings &other) const
+    {
+      return shr_sens == other.shr_sens
+        && crappy_threshold == other.crappy_threshold
+        && shift_threshold == other.shift_threshold;
+    }
+
+    hill_climber::hill_climber(const tuner_settings &start, const tuner_settings &step,
+                               int max_steps)
+      : d_start(start.clamped()),
+        d_step(step),
+        d_max_steps(std::max(max_steps, 0)),
+        d_move(NMOVES),
+        d_good_rate(0),
+        d_bad_rate(0)
+    {
+      for (int i = 0; i < 3; i++)
+        d_center[i] = d_probe[i] = 0;
+      d_best = d_current = at(d_center);
+    }
+
+    tuner_settings
+    hill_climber::at(const int *pos) const
+    {
+      return tuner_settings(d_start.shr_sens + pos[0] * d_step.shr_sens,
+                            d_start.crappy_threshold + pos[1] * d_step.crappy_threshold,
+                            d_start.shift_threshold + pos[2] * d_step.shift_threshold).clamped();
+    }
+
+    void
+    hill_climber::next_probe()
+    {
+      const tuner_settings center = at(d_center);
+      for (; d_move < NMOVES; d_move++) {
+        std::copy(d_center, d_center + 3, d_probe);
+        d_probe[d_move / 2] += (d_move & 1) ? -1 : 1;
+        if (std::abs(d_probe[d_move / 2]) > d_max_steps)
+          continue;
+        // Steps of zero and steps into a clamp lead nowhere new
+        d_current = at(d_probe);
+        if (d_current != center)
+          return;
+      }
+      d_current = center;
+    }
+
+    void
+    hill_climber::report(uint64_t good, uint64_t bad, double seconds)
+    {
+      if (seconds <= 0)
+        seconds = 1;
+      const double good_rate = good / seconds;
+      const double bad_rate = bad / seconds;
+      const double margin = 1 / seconds;
+
+      if (d_move == NMOVES) {
+        d_good_rate = good_rate;
+        d_bad_rate = bad_rate;
+        d_move = 0;
+      }
+      else if (good_rate > d_good_rate + margin
+               || (good_rate >= d_good_rate - margin && bad_rate < d_bad_rate - margin)) {
+        // Take the step and try the same direction again next
+        std::copy(d_probe, d_probe + 3, d_center);
+        d_good_rate = good_rate;
+        d_bad_rate = bad_rate;
+        d_best = d_current;
+      }
+      else {
+        d_move++;
+      }
+      next_probe();
+    }
+
+    replay_backend::replay_backend(const std::string &filename)
+      : d_active(0)
+    {
+      std::ifstream in(filename.c_str());
+      if (!in)
+        throw std::runtime_error("replay_backend: can't open " + filename);
+
+      std::string line;
+      for (int n = 1; std::getline(in, line); n++) {
+        const size_t start = line.find_first_not_of(" \t\r");
+        if (start == std::string::npos || line[start] == '#')
+          continue;
+
+        std::istringstream fields(line);
+        tuner_settings s;
+        uint64_t good, bad;
+        if (!(fields >> s.shr_sens >> s.crappy_threshold >> s.shift_threshold >> good >> bad)) {
+          std::ostringstream msg;
+          msg << "replay_backend: bad line " << n << " in " << filename;
+          throw std::runtime_error(msg.str());
+        }
+        add(s, good, bad);
+      }
+    }
+
+    void
+    replay_backend::add(const tuner_settings &s, uint64_t good, uint64_t bad)
+    {
+      size_t i = 0;
+      while (i < d_recordings.size() && d_recordings[i].settings != s)
+        i++;
+      if (i == d_recordings.size()) {
+        d_recordings.push_back(recording());
+        d_recordings[i].settings = s;
+        d_recordings[i].next = 0;
+      }
+      d_recordings[i].periods.push_back(std::make_pair(good, bad));
+    }
+
+    void
+    replay_backend::apply(const tuner_settings &s)
+    {
+      // Distance in units of the full range of each setting
+      double closest = HUGE_VAL;
+      for (size_t i = 0; i < d_recordings.size(); i++) {
+        const tuner_settings &r = d_recordings[i].settings;
+        const double d = std::abs(r.shr_sens - s.shr_sens) / double(MAX_SHR_SENS)
+          + std::abs(r.crappy_threshold - s.crappy_threshold) / double(MAX_CRAPPY_THRESHOLD)
+          + std::fabs(r.shift_threshold - s.shift_threshold) / MAX_SHIFT_THRESHOLD;
+        if (d < closest) {
+          closest = d;
+          d_active = i;
+        }
+      }
+    }
+
+    void
+    replay_backend::take_outcomes(uint64_t &good, uint64_t &bad)
+    {
+      good = bad = 0;
+      if (d_recordings.empty())
+        return;
+
+      recording &r = d_recordings[d_active];
+      good = r.periods[r.next].first;
+      bad = r.periods[r.next].second;
+      r.next = (r.next + 1) % r.periods.size();
+    }
+
+    const tuner_settings &
+    replay_backend::replayed() const
+    {
+      static const tuner_settings none;
+      return d_recordings.empty() ? none : d_recordings[d_active].settings;
+    }
+
+  } // namespace zluudgbee
+} // namespace gr
@@ -0,0 +1,67 @@
+/* -*- c++ -*- */
+/* 
+ * Copyright 2019 Leon Fernandez (zluudg).
+ * 
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ * 
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_ZLUUDGBEE_TUNER_CTRL_H
+#define INCLUDED_ZLUUDGBEE_TUNER_CTRL_H
+
+#include <zluudgbee/tuner.h>
+#include <pmt/pmt.h>
+
+namespace gr {
+  namespace zluudgbee {
+
+    /*
+     * The "ctrl" messages autotuner sends to the receivers are dicts with
+     * any of these keys. Settings that aren't in a message are left alone.
+     */
+    inline pmt::pmt_t
+    make_tuner_ctrl(const tuner_settings &s)
+    {
+      pmt::pmt_t msg = pmt::make_dict();
+      msg = pmt::dict_add(msg, pmt::mp("shr_sens"), pmt::from_long(s.shr_sens));
+      msg = pmt::dict_add(msg, pmt::mp("crappy_threshold"), pmt::from_long(s.crappy_threshold));
+      msg = pmt::dict_add(msg, pmt::mp("shift_threshold"), pmt::from_double(s.shift_threshold));
+      return msg;
+    }
+
+    template <typename RX>
+    void
+    handle_tuner_ctrl(RX &rx, const pmt::pmt_t &msg)
+    {
+      if (!pmt::is_dict(msg))
+        return;
+
+      const pmt::pmt_t sens = pmt::dict_ref(msg, pmt::mp("shr_sens"), pmt::PMT_NIL);
+      if (pmt::is_integer(sens))
+        rx.set_shr_sens(int(pmt::to_long(sens)));
+
+      const pmt::pmt_t crappy = pmt::dict_ref(msg, pmt::mp("crappy_threshold"), pmt::PMT_NIL);
+      if (pmt::is_integer(crappy))
+        rx.set_crappy_threshold(int(pmt::to_long(crappy)));
+
+      const pmt::pmt_t shift = pmt::dict_ref(msg, pmt::mp("shift_threshold"), pmt::PMT_NIL);
+      if (pmt::is_real(shift) || pmt::is_integer(shift))
+        rx.set_shift_threshold(pmt::to_double(shift));
+    }
+
+  } // namespace zluudgbee
+} // namespace gr
+
+#endif /* INCLUDED_ZLUUDGBEE_TUNER_CTRL_H */
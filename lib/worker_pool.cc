@@ -0,0 +1,123 @@
+/* -*- c++ -*- */
+/* 
+ * Copyright 2019 Leon Fernandez (zluudg).
+ * 
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ * 
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "worker_pool.h"
+#include <boost/bind.hpp>
+
+namespace gr {
+  namespace zluudgbee {
+
+    worker_pool::worker_pool(int nthreads)
+      : d_task(0),
+        d_ntasks(0),
+        d_next(0),
+        d_pending(0),
+        d_generation(0),
+        d_stop(false)
+    {
+      if (nthreads <= 0)
+        nthreads = gr::thread::thread::hardware_concurrency();
+      for (int i = 1; i < nthreads; i++)
+        d_threads.push_back(new gr::thread::thread(boost::bind(&worker_pool::worker, this)));
+    }
+
+    worker_pool::~worker_pool()
+    {
+      {
+        gr::thread::scoped_lock lock(d_mutex);
+        d_stop = true;
+      }
+      d_wake.notify_all();
+      for (size_t i = 0; i < d_threads.size(); i++) {
+        d_threads[i]->join();
+        delete d_threads[i];
+      }
+    }
+
+    void
+    worker_pool::run(size_t ntasks, const task_t &task)
+    {
+      unsigned long generation;
+      {
+        gr::thread::scoped_lock lock(d_mutex);
+        d_task = &task;
+        d_ntasks = ntasks;
+        d_next = 0;
+        d_pending = ntasks;
+        generation = ++d_generation;
+      }
+      d_wake.notify_all();
+
+      drain(generation);
+
+      gr::thread::scoped_lock lock(d_mutex);
+      while (d_pending)
+        d_done.wait(lock);
+    }
+
+    void
+    worker_pool::worker()
+    {
+      unsigned long seen = 0;
+      for (;;) {
+        {
+          gr::thread::scoped_lock lock(d_mutex);
+          while (!d_stop && d_generation == seen)
+            d_wake.wait(lock);
+          if (d_stop)
+            return;
+          seen = d_generation;
+        }
+        drain(seen);
+      }
+    }
+
+    /*
+     * Tasks are claimed under the lock. They are coarse, a channel or a
+     * slice of one, so that costs nothing, and a thread that wakes up
+     * after its round is over sees the generation change and backs off
+     * instead of picking up indices of the next one.
+     */
+    void
+    worker_pool::drain(unsigned long generation)
+    {
+      for (;;) {
+        size_t i;
+        {
+          gr::thread::scoped_lock lock(d_mutex);
+          if (d_generation != generation || d_next >= d_ntasks)
+            return;
+          i = d_next++;
+        }
+
+        (*d_task)(i);
+
+        gr::thread::scoped_lock lock(d_mutex);
+        if (--d_pending == 0)
+          d_done.notify_all();
+      }
+    }
+
+  } // namespace zluudgbee
+} // namespace gr
@@ -0,0 +1,72 @@
+/* -*- c++ -*- */
+/* 
+ * Copyright 2019 Leon Fernandez (zluudg).
+ * 
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ * 
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_ZLUUDGBEE_WORKER_POOL_H
+#define INCLUDED_ZLUUDGBEE_WORKER_POOL_H
+
+#include <gnuradio/thread/thread.h>
+#include <boost/function.hpp>
+#include <cstddef>
+#include <vector>
+
+namespace gr {
+  namespace zluudgbee {
+
+    /*
+     * A fixed set of threads for splitting a work() call into independent
+     * tasks. run() hands out the tasks one at a time, works on them from
+     * the calling thread as well and returns when all are done, so a pool
+     * of size() threads counts the caller as one of them.
+     */
+    class worker_pool
+    {
+     public:
+      typedef boost::function<void (size_t)> task_t;
+
+      // nthreads <= 0 picks one per core.
+      explicit worker_pool(int nthreads);
+      ~worker_pool();
+
+      // Calls task(i) for every i in [0, ntasks).
+      void run(size_t ntasks, const task_t &task);
+
+      size_t size() const { return d_threads.size() + 1; }
+
+     private:
+      void worker();
+      void drain(unsigned long generation);
+
+      gr::thread::mutex d_mutex;
+      gr::thread::condition_variable d_wake;
+      gr::thread::condition_variable d_done;
+      std::vector<gr::thread::thread *> d_threads;
+
+      const task_t *d_task;
+      size_t d_ntasks;
+      size_t d_next;
+      size_t d_pending;
+      unsigned long d_generation;
+      bool d_stop;
+    };
+
+  } // namespace zluudgbee
+} // namespace gr
+
+#endif /* INCLUDED_ZLUUDGBEE_WORKER_POOL_H */
@@ -21,6 +21,9 @@
 
 #include <zluudgbee/zluudgbeeRX_block_ctrl.hpp>
 #include <uhd/convert.hpp>
+#include <boost/thread/mutex.hpp>
+#include <set>
+#include <string>
 
 using namespace uhd::rfnoc;
 
@@ -32,8 +35,109 @@ public:
     {
 
     }
+
+    void set_symsync_mode(const int mode)
+    {
+        _write_arg<int>("symsync_mode", mode);
+    }
+
+    int get_symsync_mode()
+    {
+        return get_arg<int>("symsync_mode");
+    }
+
+    void set_shift_threshold(const double threshold)
+    {
+        _write_arg<double>("shift_threshold", threshold);
+    }
+
+    double get_shift_threshold()
+    {
+        return get_arg<double>("shift_threshold");
+    }
+
+    void set_decim_rate(const int rate)
+    {
+        _write_arg<int>("decim_rate", rate);
+    }
+
+    int get_decim_rate()
+    {
+        return get_arg<int>("decim_rate");
+    }
+
+    void set_ma_line_depth(const int depth)
+    {
+        _write_arg<int>("ma_line_depth", depth);
+    }
+
+    int get_ma_line_depth()
+    {
+        return get_arg<int>("ma_line_depth");
+    }
+
+    void set_shr_sens(const int sens)
+    {
+        _write_arg<int>("shr_sens", sens);
+    }
+
+    int get_shr_sens()
+    {
+        return get_arg<int>("shr_sens");
+    }
+
+    void set_crappy_threshold(const int threshold)
+    {
+        _write_arg<int>("crappy_threshold", threshold);
+    }
+
+    int get_crappy_threshold()
+    {
+        return get_arg<int>("crappy_threshold");
+    }
+
+    uint32_t get_frames_detected()
+    {
+        return uint32_t(user_reg_read64("RB_FRAMES_DETECTED"));
+    }
+
+    uint32_t get_phr_rejects()
+    {
+        return uint32_t(user_reg_read64("RB_PHR_REJECTS"));
+    }
+
+    uint32_t get_skipped_bursts()
+    {
+        return uint32_t(user_reg_read64("RB_SKIPPED_BURSTS"));
+    }
+
+    uint32_t get_almost_full_events()
+    {
+        return uint32_t(user_reg_read64("RB_ALMOST_FULL_EVENTS"));
+    }
+
 private:
+    /*
+     * The XML defaults are only in the property tree until something
+     * writes them, so the first write of every argument always goes
+     * out. After that, writing the value that is already set is a no-op
+     * instead of a register write over the bus. The setters get called
+     * from GRC callbacks and message handlers alike, so the check and
+     * the write happen under one lock.
+     */
+    template <typename T>
+    void _write_arg(const std::string &key, const T &val)
+    {
+        boost::mutex::scoped_lock lock(_written_mutex);
+        if (_written.count(key) && get_arg<T>(key) == val) {
+            return;
+        }
+        set_arg<T>(key, val);
+        _written.insert(key);
+    }
 
+    boost::mutex _written_mutex;
+    std::set<std::string> _written;
 };
 
 UHD_RFNOC_BLOCK_REGISTER(zluudgbeeRX_block_ctrl,"zluudgbeeRX");
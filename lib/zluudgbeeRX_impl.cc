@@ -24,6 +24,9 @@
 
 #include <gnuradio/io_signature.h>
 #include "zluudgbeeRX_impl.h"
+#include "tuner_ctrl.h"
+#include <boost/bind.hpp>
+#include <stdexcept>
 namespace gr {
   namespace zluudgbee {
     zluudgbeeRX::sptr
@@ -65,7 +68,15 @@ namespace gr {
             gr::ettus::rfnoc_block_impl::make_block_id("zluudgbeeRX",  block_select, device_select),
             tx_stream_args, rx_stream_args, enable_eob_on_stop
             )
-    {}
+    {
+      d_ctrl = boost::dynamic_pointer_cast< ::uhd::rfnoc::zluudgbeeRX_block_ctrl >(_blk_ctrl);
+      if (!d_ctrl) {
+        throw std::runtime_error("Not a zluudgbeeRX_block_ctrl: " + _blk_ctrl->unique_id());
+      }
+
+      message_port_register_in(pmt::mp("ctrl"));
+      set_msg_handler(pmt::mp("ctrl"), boost::bind(&zluudgbeeRX_impl::handle_ctrl, this, _1));
+    }
 
     /*
      * Our virtual destructor.
@@ -74,6 +85,72 @@ namespace gr {
     {
     }
 
+    void
+    zluudgbeeRX_impl::set_symsync_mode(int mode)
+    {
+      d_ctrl->set_symsync_mode(mode);
+    }
+
+    void
+    zluudgbeeRX_impl::set_shift_threshold(double threshold)
+    {
+      d_ctrl->set_shift_threshold(threshold);
+    }
+
+    void
+    zluudgbeeRX_impl::set_decim_rate(int rate)
+    {
+      d_ctrl->set_decim_rate(rate);
+    }
+
+    void
+    zluudgbeeRX_impl::set_ma_line_depth(int depth)
+    {
+      d_ctrl->set_ma_line_depth(depth);
+    }
+
+    void
+    zluudgbeeRX_impl::set_shr_sens(int sens)
+    {
+      d_ctrl->set_shr_sens(sens);
+    }
+
+    void
+    zluudgbeeRX_impl::set_crappy_threshold(int threshold)
+    {
+      d_ctrl->set_crappy_threshold(threshold);
+    }
+
+    void
+    zluudgbeeRX_impl::handle_ctrl(pmt::pmt_t msg)
+    {
+      handle_tuner_ctrl(*this, msg);
+    }
+
+    uint32_t
+    zluudgbeeRX_impl::frames_detected()
+    {
+      return d_ctrl->get_frames_detected();
+    }
+
+    uint32_t
+    zluudgbeeRX_impl::phr_rejects()
+    {
+      return d_ctrl->get_phr_rejects();
+    }
+
+    uint32_t
+    zluudgbeeRX_impl::skipped_bursts()
+    {
+      return d_ctrl->get_skipped_bursts();
+    }
+
+    uint32_t
+    zluudgbeeRX_impl::almost_full_events()
+    {
+      return d_ctrl->get_almost_full_events();
+    }
+
   } /* namespace zluudgbee */
 } /* namespace gr */
 
@@ -31,7 +31,9 @@ namespace gr {
     class zluudgbeeRX_impl : public zluudgbeeRX, public gr::ettus::rfnoc_block_impl
     {
      private:
-      // Nothing to declare in this block.
+      ::uhd::rfnoc::zluudgbeeRX_block_ctrl::sptr d_ctrl;
+
+      void handle_ctrl(pmt::pmt_t msg);
 
      public:
       zluudgbeeRX_impl(
@@ -44,7 +46,17 @@ namespace gr {
       );
       ~zluudgbeeRX_impl();
 
-      // Where all the action really happens
+      void set_symsync_mode(int mode);
+      void set_shift_threshold(double threshold);
+      void set_decim_rate(int rate);
+      void set_ma_line_depth(int depth);
+      void set_shr_sens(int sens);
+      void set_crappy_threshold(int threshold);
+
+      uint32_t frames_detected();
+      uint32_t phr_rejects();
+      uint32_t skipped_bursts();
+      uint32_t almost_full_events();
     };
 
   } // namespace zluudgbee
@@ -149,10 +149,12 @@ module noc_block_zluudgbeeCRC #(
     .clk(ce_clk), .rst(ce_rst),
     .strobe(set_stb), .addr(set_addr), .in(set_data), .out(crc_mode), .changed());
 
+  // The EOB word zluudgbeeRX sends after the end of its input stream is
+  // passed on in a packet of its own, with EOB set
   assign s_axis_data_tuser = {
     2'b00,        // Data Packet type
     1'b0,         // No time
-    1'b0,      // Don't use EOB
+    s_axis_data_tdata[14], // EOB, from C_FLAG_EOB
     12'd0,        // Sequence number, don't care handled by AXI wrapper
     16'd0,    // Don't care, AXI wrapper fills this in based on tlast
     src_sid,      // SRC SID
@@ -147,6 +147,11 @@ module noc_block_zluudgbeeRX #(
   localparam [7:0] SR_SHR_SENS         = 134;
   localparam [7:0] SR_CRAPPY_THRESHOLD = 135;
 
+  localparam [7:0] RB_FRAMES_DETECTED    = 0;
+  localparam [7:0] RB_PHR_REJECTS        = 1;
+  localparam [7:0] RB_SKIPPED_BURSTS     = 2;
+  localparam [7:0] RB_ALMOST_FULL_EVENTS = 3;
+
   wire [31:0] symsync_mode;
   setting_reg #(
     .my_addr(SR_SYMSYNC_MODE), .awidth(8), .width(32), .at_reset(32'h2ccccccc))
@@ -189,10 +194,25 @@ module noc_block_zluudgbeeRX #(
     .clk(ce_clk), .rst(ce_rst),
     .strobe(set_stb), .addr(set_addr), .in(set_data), .out(crappy_threshold), .changed());
 
+  // Event counters of the receiver, cleared along with it
+  wire [31:0] frames_detected, phr_rejects, skipped_bursts, almost_full_events;
+
+  always @(*) begin
+    case (rb_addr)
+      RB_FRAMES_DETECTED    : rb_data <= {32'd0, frames_detected};
+      RB_PHR_REJECTS        : rb_data <= {32'd0, phr_rejects};
+      RB_SKIPPED_BURSTS     : rb_data <= {32'd0, skipped_bursts};
+      RB_ALMOST_FULL_EVENTS : rb_data <= {32'd0, almost_full_events};
+      default               : rb_data <= 64'h0BADC0DE0BADC0DE;
+    endcase
+  end
+
+  // The EOB word sent after the end of the input stream goes out in a
+  // packet of its own, with EOB set
   assign s_axis_data_tuser = {
     2'b00,        // Data Packet type
     1'b0,         // No time
-    1'b0,      // Don't use EOB
+    s_axis_data_tdata[14], // EOB, from C_FLAG_EOB
     12'd0,        // Sequence number, don't care handled by AXI wrapper
     16'd0,    // Don't care, AXI wrapper fills this in based on tlast
     src_sid,      // SRC SID
@@ -208,10 +228,15 @@ module noc_block_zluudgbeeRX #(
     .sr_ma_line_depth(ma_line_depth),
     .sr_shr_sens(shr_sens),
     .sr_crappy_threshold(crappy_threshold),
+    .rb_frames_detected(frames_detected),
+    .rb_phr_rejects(phr_rejects),
+    .rb_skipped_bursts(skipped_bursts),
+    .rb_almost_full_events(almost_full_events),
     .s_iqsample_tready(m_axis_data_tready),
     .s_iqsample_tdata({m_axis_data_tdata[15:0],m_axis_data_tdata[31:16]}), // Swap I/Q order
     .s_iqsample_tvalid(m_axis_data_tvalid),
     .s_iqsample_tlast(m_axis_data_tlast),
+    .s_iqsample_teob(m_axis_data_tuser[124]), // EOB of the incoming packet
     .m_outbyte_tready(s_axis_data_tready),
     .m_outbyte_tdata(s_axis_data_tdata),
     .m_outbyte_tvalid(s_axis_data_tvalid),
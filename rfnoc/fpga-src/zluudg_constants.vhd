@@ -61,6 +61,27 @@ package zluudg_constants is
     -- The width of the component output. |Data|Crap1|Crap2|EOF|
     constant C_OUTW : integer := 32;
 
+    -- Positions of the status flags in every output word, above the data byte in bits 7:0.
+    -- ACTIVE marks a word that belongs to a frame (as opposed to burst padding), CRAP1 and
+    -- CRAP2 mark a lower/upper nibble that was decoded without confidence, ENDFRAME marks
+    -- the last word of a frame and CORRUPTED marks a word belonging to a frame that failed
+    -- the CRC check. CRC_CHECKED is set on the last word of a frame whose checksum has been
+    -- verified by zluudg_crc16ccitt, in which case CORRUPTED on that word is the verdict.
+    -- EOB marks the word zluudg_packager sends on its own once the input stream has ended.
+    -- It belongs to no frame and goes out with EOB set in its CHDR header.
+    constant C_FLAG_ACTIVE    : integer := 8;
+    constant C_FLAG_CRAP1     : integer := 9;
+    constant C_FLAG_CRAP2     : integer := 10;
+    constant C_FLAG_ENDFRAME  : integer := 11;
+    constant C_FLAG_CORRUPTED : integer := 12;
+    constant C_FLAG_CRC_CHECKED : integer := 13;
+    constant C_FLAG_EOB       : integer := 14;
+
+    -- Clock cycles without a nibble after the input stream has ended before zluudg_packager
+    -- sends its EOB word, so that whatever is still in the pipeline gets out first.
+    constant C_EOB_HOLDOFF : integer := 1023;
+    constant C_EOB_HOLDOFFW : integer := clogb2(C_EOB_HOLDOFF);
+
     -- The width of the PRNG generator
     constant C_PRNGW : integer := 32;
 
@@ -11,6 +11,8 @@
 -- CRAP2-flag indicates whether the upper nibble was decoded with confidence
 -- ENDFRAME-flag is upper half of the CRC in the incoming word, last payload byte in the outgoing
 -- CORRPUTED-flag is asserted to tell the subsequent ping-pong buffer to ignore the entire PDU
+-- CRC_CHECKED-flag marks the last word of a PDU that was checked in flag mode (see flag_mode)
+-- EOB-flag marks a burst of a single word that ends the stream, it goes through as it is
 ----------------------------------------------------------------------------------------------------
 
 library ieee;
@@ -39,6 +41,7 @@ architecture Mixed of zluudg_crc16ccitt is
                areset        : in std_logic;
                almost_full   : out std_logic;
                skip_burst    : in std_logic;
+               burst_skipped : out std_logic;
                s_axis_tready : out std_logic;
                s_axis_tdata  : in std_logic_vector (C_OUTW - 1 downto 0);
                s_axis_tvalid : in std_logic;
@@ -77,6 +80,28 @@ architecture Mixed of zluudg_crc16ccitt is
     -- there is a match, we output the first N-2 bytes of the input. 
     signal tx_mode : std_logic;
 
+    -- If '1' (crc_mode 2), we are in RX flag mode. Every burst is output as is, checksum
+    -- included, and the verdict goes into the flags of its last word: CRC_CHECKED is set,
+    -- along with CORRUPTED if the checksum did not match. Nothing gets dropped, so the
+    -- host can strip the checksum itself and still tell the frames apart.
+    signal flag_mode : std_logic;
+
+    -- Either TX or flag mode, the two modes where the checksum words are output.
+    signal keep_crc : std_logic;
+
+    -- The EOB word in each stage of the delay line. It is a burst of its own with no
+    -- checksum, so it is neither checked, nor dropped, nor has anything cut off.
+    signal eob_d   : std_logic;
+    signal eob_dd  : std_logic;
+    signal eob_ddd : std_logic;
+
+    -- bad_crc delayed until the upper checksum byte is in tdata_ddd
+    signal bad_crc_d  : std_logic := '0';
+    signal bad_crc_dd : std_logic := '0';
+
+    -- Tells the output buffer to drop the burst, only done in RX mode
+    signal skip_burst : std_logic;
+
     -- Signal that is high while either of the last two input bytes is stored in
     -- the last stage of the input delay line.
     -- In TX mode this signal is used to mux in the CRC results into the last
@@ -110,6 +135,7 @@ architecture Mixed of zluudg_crc16ccitt is
     signal int_almost_full : std_logic;
     signal tready : std_logic;
     signal fifo_tlast : std_logic;
+    signal fifo_tdata : std_logic_vector(C_OUTW - 1 downto 0);
 
     -- Thanks to http://automationwiki.com/index.php/CRC-16-CCITT for this LUT
     type t_lut is array (0 to 2**C_BYTEW - 1) of std_logic_vector(C_CRCW - 1 downto 0);
@@ -174,17 +200,47 @@ begin
     next_crc <= lut_out xor std_logic_vector(shift_left(unsigned(crc_reg), 8));
 
     crc_result <= flipped_crc xor (tdata_d(C_BYTEW-1 downto 0) & tdata_dd(C_BYTEW-1 downto 0));
-    bad_crc <= or_reduction(crc_result) and tlast_d and (not tx_mode);
+    eob_d <= tdata_d(C_FLAG_EOB) and tlast_d;
+    eob_dd <= tdata_dd(C_FLAG_EOB) and tlast_dd;
+    eob_ddd <= tdata_ddd(C_FLAG_EOB) and tlast_ddd;
+
+    bad_crc <= or_reduction(crc_result) and tlast_d and (not tx_mode) and (not eob_d);
 
     -- Since we don't want to write the last two bytes of the PHY payload (the CRC) to the
     -- output buffer, we can't use a purely delayed version of the tvalid signal. Luckily,
     -- the delayed versions of tlast can be used to suppres the enable signal to the output
     -- buffer.
     tx_mode <= sr_crc_mode(0);
-    sel_crc <= tlast_d; -- when tlast_dd=1, it is time to load the CRC sum into the last two bytes
-    skip_crc <= (tlast_dd or tlast_ddd) and (not tx_mode);
+    flag_mode <= sr_crc_mode(1) and (not sr_crc_mode(0));
+    keep_crc <= tx_mode or flag_mode;
+    -- when tlast_dd=1, it is time to load the CRC sum into the last two bytes. Only
+    -- TX mode outputs them, in flag mode the received checksum has to go through.
+    sel_crc <= tlast_d and tx_mode and (not eob_d);
+    skip_crc <= ((tlast_dd and not eob_dd) or (tlast_ddd and not eob_ddd)) and (not keep_crc);
     en_fifo <= tvalid_ddd and (not skip_crc);
-    fifo_tlast <= tlast_ddd when (tx_mode = '1') else tlast_d;
+    skip_burst <= bad_crc and (not flag_mode);
+    fifo_tlast <= tlast_ddd when (keep_crc = '1' or eob_ddd = '1') else (tlast_d and not eob_d);
+
+    -- In RX mode the checksum gets dropped, so the ENDFRAME flag has to move from the
+    -- upper checksum byte to the last byte of the MAC payload.
+    fifo_tdata(C_OUTW - 1 downto C_FLAG_CRC_CHECKED + 1) <= tdata_ddd(C_OUTW - 1 downto C_FLAG_CRC_CHECKED + 1);
+    fifo_tdata(C_FLAG_CRC_CHECKED) <= tdata_ddd(C_FLAG_CRC_CHECKED) or (tlast_ddd and flag_mode and not eob_ddd);
+    fifo_tdata(C_FLAG_CORRUPTED) <= tdata_ddd(C_FLAG_CORRUPTED) or (bad_crc_dd and flag_mode);
+    fifo_tdata(C_FLAG_ENDFRAME) <= tdata_ddd(C_FLAG_ENDFRAME) when (keep_crc = '1' or eob_ddd = '1') else fifo_tlast;
+    fifo_tdata(C_FLAG_ENDFRAME - 1 downto 0) <= tdata_ddd(C_FLAG_ENDFRAME - 1 downto 0);
+
+    P_BAD_CRC: process (aclk)
+    begin
+        if rising_edge(aclk) then
+            if (areset = '1') then
+                bad_crc_d <= '0';
+                bad_crc_dd <= '0';
+            else
+                bad_crc_d <= bad_crc;
+                bad_crc_dd <= bad_crc_d;
+            end if;
+        end if;
+    end process P_BAD_CRC;
 
     P_INPUT: process (aclk)
     begin
@@ -198,8 +254,9 @@ begin
                     tdata_d <= s_in_tdata;
                 end if;
                 if (sel_crc = '1') then -- replace last two bytes with results of CRC calculations
-                    tdata_dd <= X"000000" & flipped_crc(C_CRCW - 1 downto C_CRCW/2); 
-                    tdata_ddd <= X"000000" & flipped_crc(C_CRCW/2 - 1 downto 0);
+                    -- The checksum words are part of the frame, the upper one ends it
+                    tdata_dd <= X"0000" & X"09" & flipped_crc(C_CRCW - 1 downto C_CRCW/2); 
+                    tdata_ddd <= X"0000" & X"01" & flipped_crc(C_CRCW/2 - 1 downto 0);
                 else -- regular delay line
                     tdata_dd <= tdata_d;
                     tdata_ddd <= tdata_dd;
@@ -261,9 +318,10 @@ begin
         port map( aclk          => aclk,
                   areset        => areset,
                   almost_full   => int_almost_full,
-                  skip_burst    => bad_crc,
+                  skip_burst    => skip_burst,
+                  burst_skipped => open,
                   s_axis_tready => tready,
-                  s_axis_tdata  => tdata_ddd,
+                  s_axis_tdata  => fifo_tdata,
                   s_axis_tvalid => en_fifo,
                   -- When the last MAC payload byte is in tdata_ddd, tdata_d and tdata_dd
                   -- will hold the last byte of the PHY payload (the CRC). Since we don't
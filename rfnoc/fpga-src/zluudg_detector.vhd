@@ -19,6 +19,7 @@ entity zluudg_detector is
            areset              : in std_logic;
            sr_shr_sens         : in std_logic_vector(C_SETREGW - 1 downto 0);
            clr_frame           : in std_logic; -- used to clear a frame and start detection anew
+           frame_found         : out std_logic; -- pulses once for every detected SHR
            s_chip_tready       : out std_logic;
            s_chip_tdata        : in std_logic_vector(C_CHIPW - 1 downto 0);
            s_chip_tvalid       : in std_logic;
@@ -62,6 +63,7 @@ architecture Behavioral of zluudg_detector is
     -- It will only be deasserted upon reset or when an external component assers
     -- the "clear_frame" signal.
     signal synch_header_found : std_logic := '0';
+    signal int_frame_found : std_logic := '0';
 
     -- Counter for keeping track of how many new chips have been shifted in and is
     -- currently driving the output.
@@ -155,13 +157,17 @@ begin
         if rising_edge(aclk) then
             if (areset = '1' or clr_frame = '1') then
                 synch_header_found <= '0';
+                int_frame_found <= '0';
             else
+                int_frame_found <= '0';
                 if (corr_score <= unsigned(sr_shr_sens)) then
                     synch_header_found <= '1';
+                    int_frame_found <= not synch_header_found;
                 end if;
             end if;
         end if;
     end process P_SYNCH_HEADER_FOUND;
+    frame_found <= int_frame_found;
 
     -- Process that starts a counter once the synchronization header has been found.
     -- With every new input a bit gets shifted into the output register. The purpose
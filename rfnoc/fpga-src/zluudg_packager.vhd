@@ -5,6 +5,8 @@
 -- Description: Takes a stream of input nibbles and packages them into a stream of
 -- bytes representing the payload. When the payload has been output, the last payload byte is
 -- marked with "tlast" and the detector is cleared, meaning a new frame is being scanned for.
+-- Once the input stream has ended and no more nibbles come, a single word flagged EOB is
+-- sent as a burst of its own, after dropping the burst of a frame that was cut short.
 ----------------------------------------------------------------------------------------------------
 
 library ieee;
@@ -17,6 +19,9 @@ entity zluudg_packager is
 	port ( aclk             : in std_logic;
 	       areset           : in std_logic;
            frame_done       : out std_logic;
+           phr_reject       : out std_logic;
+           s_eob            : in std_logic;
+           skip_burst       : out std_logic;
 		   s_nibble_tready	: out std_logic;
 		   s_nibble_tdata	: in std_logic_vector(C_BYTEW - 1 downto 0);
 		   s_nibble_tvalid	: in std_logic;
@@ -31,7 +36,9 @@ architecture Behavioral of zluudg_packager is
     -- State type + signal that keeps track of where we are in the frame processing. That is, if we
     -- are reading from the PHR or from the actual payload, how much is left to read
     -- of the payload and if we can accept a decoded chipsequence from upstream.
-    type t_state is (s_IDLE, s_PHR_PART, s_PHR_DONE, s_PL_IDLE, s_PL_PART, s_PL_DONE);
+    -- s_ABORT and s_EOB are only used after the end of the input stream.
+    type t_state is (s_IDLE, s_PHR_PART, s_PHR_DONE, s_PL_IDLE, s_PL_PART, s_PL_DONE,
+                     s_ABORT, s_EOB);
     signal state : t_state := s_IDLE;
 
     -- Signal for keeping track of how many bytes we've left to output before the
@@ -50,6 +57,17 @@ architecture Behavioral of zluudg_packager is
     -- don't want to continue decoding and we therefore reset the detector.
     signal crappy_phr : std_logic := '0';
 
+    -- Pulses when a frame is dropped because of a crappy PHR, for the readback counters.
+    signal int_phr_reject : std_logic := '0';
+
+    -- Set by s_eob when the last sample of the input stream has gone in, cleared once the
+    -- EOB word is out. quiet_counter counts the cycles since the last nibble.
+    signal eob_pending : std_logic := '0';
+    signal quiet_counter : unsigned(C_EOB_HOLDOFFW - 1 downto 0) := (others => '0');
+
+    -- Tells the output buffer to drop the burst being written, see s_ABORT.
+    signal int_skip_burst : std_logic := '0';
+
 begin
 
     s_nibble_tready <= m_outbyte_tready and (not areset);
@@ -58,6 +76,8 @@ begin
     m_outbyte_tvalid <= int_m_outbyte_tvalid;
     m_outbyte_tlast <= int_m_outbyte_tlast;
     frame_done <= int_frame_done;
+    phr_reject <= int_phr_reject;
+    skip_burst <= int_skip_burst;
 
     P_INPUT_REG: process (aclk)
     begin
@@ -79,7 +99,32 @@ begin
                 state <= s_IDLE;
                 byte_counter <= (others => '0');
                 crappy_phr <= '0';
+                int_phr_reject <= '0';
+                eob_pending <= '0';
+                quiet_counter <= (others => '0');
             else
+                int_phr_reject <= '0';
+
+                if (s_eob = '1') then
+                    eob_pending <= '1';
+                end if;
+                if (s_nibble_tvalid = '1') then
+                    quiet_counter <= (others => '0');
+                elsif (quiet_counter /= C_EOB_HOLDOFF) then
+                    quiet_counter <= quiet_counter + 1;
+                end if;
+
+                if (eob_pending = '1' and quiet_counter = C_EOB_HOLDOFF and s_nibble_tvalid = '0'
+                    and state /= s_PL_DONE and state /= s_ABORT and state /= s_EOB) then
+                    -- Nothing more is coming in, so a frame whose payload has started is
+                    -- never going to end. Its burst is dropped before the EOB word goes out.
+                    if (state = s_PL_IDLE or state = s_PL_PART) then
+                        state <= s_ABORT;
+                    else
+                        state <= s_EOB;
+                    end if;
+                    byte_counter <= (others => '0');
+                else
                 case state is
 
                     when s_IDLE =>
@@ -99,6 +144,7 @@ begin
                                 -- the value in our byte counter. We therefore set the byte counter
                                 -- length to zero to treat the frame as degenerate.
                                 byte_counter <= (others => '0');
+                                int_phr_reject <= '1';
                             else
                                 byte_counter(6 downto 4) <= unsigned(s_nibble_tdata(2 downto 0));
                             end if;
@@ -153,10 +199,26 @@ begin
                             end if;
                         end if;
 
+                    when s_ABORT =>
+                        if (m_outbyte_tready = '1') then
+                            state <= s_EOB;
+                        else
+                            state <= s_ABORT;
+                        end if;
+
+                    when s_EOB =>
+                        if (m_outbyte_tready = '1') then
+                            state <= s_IDLE;
+                            eob_pending <= '0';
+                        else
+                            state <= s_EOB;
+                        end if;
+
                     when others =>
                         state <= s_IDLE;
 
                 end case;
+                end if;
             end if;
         end if;
     end process P_FSM;
@@ -171,15 +233,20 @@ begin
                     int_m_outbyte_tvalid <= '0';
                     int_m_outbyte_tlast <= '0';
                     int_frame_done <= '0';
+                    int_skip_burst <= '0';
+                    -- Clears the EOB flag of the last word out, no other state touches it
+                    int_m_outbyte_tdata <= (others => '0');
 
                 when s_PHR_PART =>
                     int_m_outbyte_tvalid <= '0';
                     int_m_outbyte_tlast <= '0';
-                    int_frame_done <= '0';    
+                    int_frame_done <= '0';
+                    int_skip_burst <= '0';    
     
                 when s_PHR_DONE =>
                     int_m_outbyte_tvalid <= '0';
                     int_m_outbyte_tlast <= '0';
+                    int_skip_burst <= '0';
                     if (byte_counter = 0) then
                         int_frame_done <= '1';
                     else
@@ -190,31 +257,56 @@ begin
                     int_m_outbyte_tvalid <= '0';
                     int_m_outbyte_tlast <= '0';
                     int_frame_done <= '0';
+                    int_skip_burst <= '0';
         
                 when s_PL_PART =>
                     int_m_outbyte_tvalid <= '0';
                     int_m_outbyte_tlast <= '0';
                     int_frame_done <= '0';
+                    int_skip_burst <= '0';
                     int_m_outbyte_tdata(C_NIBBLEW - 1 downto 0) <=
                         int_nibble_tdata(C_NIBBLEW - 1 downto 0);
+                    int_m_outbyte_tdata(C_FLAG_CRAP1) <= int_nibble_tdata(C_NIBBLEW);
     
                 when s_PL_DONE =>
                     int_m_outbyte_tvalid <= '1';
+                    int_skip_burst <= '0';
                     if (byte_counter = 0) then
                         int_m_outbyte_tlast <= '1';
                         int_frame_done <= '1';
+                        int_m_outbyte_tdata(C_FLAG_ENDFRAME) <= '1';
                     else
                         int_m_outbyte_tlast <= '0';
                         int_frame_done <= '0';
+                        int_m_outbyte_tdata(C_FLAG_ENDFRAME) <= '0';
                     end if;
 
                     int_m_outbyte_tdata(C_BYTEW - 1 downto C_NIBBLEW) <=
                         int_nibble_tdata(C_NIBBLEW - 1 downto 0);
+                    int_m_outbyte_tdata(C_FLAG_CRAP2) <= int_nibble_tdata(C_NIBBLEW);
+                    int_m_outbyte_tdata(C_FLAG_ACTIVE) <= '1';
     
+                when s_ABORT =>
+                    -- Ends the burst of the frame that was cut short, which the output
+                    -- buffer then drops along with this padding word
+                    int_m_outbyte_tvalid <= '1';
+                    int_m_outbyte_tlast <= '1';
+                    int_frame_done <= '1';
+                    int_skip_burst <= '1';
+                    int_m_outbyte_tdata <= (others => '0');
+
+                when s_EOB =>
+                    int_m_outbyte_tvalid <= '1';
+                    int_m_outbyte_tlast <= '1';
+                    int_frame_done <= '1';
+                    int_skip_burst <= '0';
+                    int_m_outbyte_tdata <= (C_FLAG_EOB => '1', others => '0');
+
                 when others =>
                     int_m_outbyte_tvalid <= '0';
                     int_m_outbyte_tlast <= '1';
                     int_frame_done <= '0';
+                    int_skip_burst <= '0';
                     int_m_outbyte_tdata <= (others => '0');
 
             end case;
@@ -17,6 +17,7 @@ entity zluudg_ppfifo is
            areset        : in std_logic;
            almost_full   : out std_logic;
            skip_burst    : in std_logic;
+           burst_skipped : out std_logic; -- pulses when a written burst is dropped
            s_axis_tready : out std_logic;
            s_axis_tdata  : in std_logic_vector (C_OUTW - 1 downto 0);
            s_axis_tvalid : in std_logic;
@@ -59,6 +60,7 @@ architecture Mixed of zluudg_ppfifo is
     -- process the word has a '1' in the 12th position (counting from 0).
     signal skip_fifo1 : std_logic := '0';
     signal skip_fifo2 : std_logic := '0';
+    signal int_burst_skipped : std_logic := '0';
 
     signal fifo1_ena    : std_logic := '0';
     signal fifo1_addra  : std_logic_vector(C_FIFO_ADDRW - 1 downto 0) := (others => '0');
@@ -77,6 +79,8 @@ architecture Mixed of zluudg_ppfifo is
     signal initialized : std_logic := '0';
 begin
 
+    burst_skipped <= int_burst_skipped;
+
     with sel_fifo select m_axis_tdata <=
         fifo1_out when '1',
         fifo2_out when others;
@@ -120,8 +124,10 @@ begin
                 skip_fifo1 <= '0';
                 skip_fifo2 <= '0';
                 initialized <= '0';
+                int_burst_skipped <= '0';
 
             else
+                int_burst_skipped <= '0';
                 case state is
 
                     when s_MA =>
@@ -129,6 +135,7 @@ begin
                             if ((w1_ptr = C_FIFO_END or s_axis_tlast = '1') and r2_ptr = w2_ptr) then
                                 if (skip_fifo1 = '1'  or skip_burst = '1') then
                                     state <= s_MB_R; -- Change mode
+                                    int_burst_skipped <= '1';
                                     r1_ptr <= 0;
                                     w1_ptr <= 0;
                                     r2_ptr <= 0;
@@ -207,6 +214,7 @@ begin
                             if (w1_ptr = C_FIFO_END or s_axis_tlast = '1') then
                                 if (skip_burst = '1' or skip_fifo1 = '1') then
                                     state <= s_MB_R; -- Change mode
+                                    int_burst_skipped <= '1';
                                     r1_ptr <= 0;
                                     w1_ptr <= 0;
                                     r2_ptr <= 0;
@@ -233,6 +241,7 @@ begin
                             if (r1_ptr = w1_ptr) then
                                 if (skip_fifo2 = '1') then
                                     state <= s_MB_R; -- Change mode
+                                    int_burst_skipped <= '1';
                                     r1_ptr <= 0;
                                     w1_ptr <= 0;
                                     r2_ptr <= 0;
@@ -258,6 +267,7 @@ begin
                             if ((w2_ptr = C_FIFO_END or s_axis_tlast = '1') and r1_ptr = w1_ptr) then
                                 if (skip_fifo2 = '1'  or skip_burst = '1') then
                                     state <= s_MA_R; -- Change mode
+                                    int_burst_skipped <= '1';
                                     r1_ptr <= 0;
                                     w1_ptr <= 0;
                                     r2_ptr <= 0;
@@ -334,6 +344,7 @@ begin
                             if (w2_ptr = C_FIFO_END or s_axis_tlast = '1') then
                                 if (skip_burst = '1' or skip_fifo2 = '1') then
                                     state <= s_MA_R; -- Change mode
+                                    int_burst_skipped <= '1';
                                     r1_ptr <= 0;
                                     w1_ptr <= 0;
                                     r2_ptr <= 0;
@@ -359,6 +370,7 @@ begin
                             if (r1_ptr = w1_ptr) then
                                 if (skip_fifo2 = '1') then
                                     state <= s_MA_R; -- Change mode
+                                    int_burst_skipped <= '1';
                                     r1_ptr <= 0;
                                     w1_ptr <= 0;
                                     r2_ptr <= 0;
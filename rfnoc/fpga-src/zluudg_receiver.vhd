@@ -7,6 +7,7 @@
 
 library ieee;
 use ieee.std_logic_1164.all;
+use ieee.numeric_std.all;
 
 use work.zluudg_constants.all;
 
@@ -19,10 +20,15 @@ entity zluudg_receiver is
            sr_ma_line_depth    : in std_logic_vector(C_SETREGW - 1 downto 0);
            sr_shr_sens         : in std_logic_vector(C_SETREGW - 1 downto 0);
            sr_crappy_threshold : in std_logic_vector(C_SETREGW - 1 downto 0);
+           rb_frames_detected    : out std_logic_vector(C_SETREGW - 1 downto 0);
+           rb_phr_rejects        : out std_logic_vector(C_SETREGW - 1 downto 0);
+           rb_skipped_bursts     : out std_logic_vector(C_SETREGW - 1 downto 0);
+           rb_almost_full_events : out std_logic_vector(C_SETREGW - 1 downto 0);
            s_iqsample_tready   : out std_logic;
            s_iqsample_tdata	   : in std_logic_vector(C_IQSAMPLEW - 1 downto 0);
            s_iqsample_tvalid   : in std_logic;
            s_iqsample_tlast    : in std_logic;
+           s_iqsample_teob     : in std_logic;
 		       m_outbyte_tready    : in std_logic;
 		       m_outbyte_tdata     : out std_logic_vector(C_OUTW - 1 downto 0);
 		       m_outbyte_tvalid    : out std_logic;
@@ -52,6 +58,7 @@ architecture Structural of zluudg_receiver is
                areset           : in std_logic;
                sr_shr_sens      : in std_logic_vector(C_SETREGW - 1 downto 0);
                clr_frame        : in std_logic; -- used to clear a frame and start detection anew
+               frame_found      : out std_logic;
                s_chip_tready    : out std_logic;
                s_chip_tdata     : in std_logic_vector(C_CHIPW - 1 downto 0);
                s_chip_tvalid    : in std_logic;
@@ -76,6 +83,9 @@ architecture Structural of zluudg_receiver is
         port ( aclk             : in std_logic;
                areset           : in std_logic;
                frame_done       : out std_logic;
+               phr_reject       : out std_logic;
+               s_eob            : in std_logic;
+               skip_burst       : out std_logic;
                s_nibble_tready	: out std_logic;
                s_nibble_tdata	: in std_logic_vector(C_BYTEW - 1 downto 0);
                s_nibble_tvalid	: in std_logic;
@@ -90,6 +100,7 @@ architecture Structural of zluudg_receiver is
                areset        : in std_logic;
                almost_full   : out std_logic;
                skip_burst    : in std_logic;
+               burst_skipped : out std_logic;
                s_axis_tready : out std_logic;
                s_axis_tdata  : in std_logic_vector (C_OUTW - 1 downto 0);
                s_axis_tvalid : in std_logic;
@@ -125,6 +136,22 @@ architecture Structural of zluudg_receiver is
     -- Used to clear the detection of a frame once it's done
     signal int_clr_frame : std_logic;
 
+    -- Pulses as the last sample of a burst with EOB set goes in, and lets the packager
+    -- drop the burst of a frame the end of the stream cut short
+    signal int_eob : std_logic;
+    signal int_skip_burst : std_logic;
+
+    -- Event pulses and the counters behind the readback registers. They
+    -- wrap around and are cleared by areset.
+    signal int_frame_found   : std_logic;
+    signal int_phr_reject    : std_logic;
+    signal int_burst_skipped : std_logic;
+    signal almost_full_d     : std_logic := '0';
+    signal frames_detected    : unsigned(C_SETREGW - 1 downto 0) := (others => '0');
+    signal phr_rejects        : unsigned(C_SETREGW - 1 downto 0) := (others => '0');
+    signal skipped_bursts     : unsigned(C_SETREGW - 1 downto 0) := (others => '0');
+    signal almost_full_events : unsigned(C_SETREGW - 1 downto 0) := (others => '0');
+
 begin
 
     -- Main input is ready to accept data if the output fifo is not full
@@ -132,6 +159,39 @@ begin
     -- entirely full)
     s_iqsample_tready <= int_s_iqsample_tready and (not almost_full);
     int_s_iqsample_tvalid <= s_iqsample_tvalid and (not almost_full);
+    int_eob <= s_iqsample_teob and s_iqsample_tlast and int_s_iqsample_tvalid and int_s_iqsample_tready;
+
+    P_RB_COUNTERS: process (aclk)
+    begin
+        if rising_edge(aclk) then
+            if (areset = '1') then
+                almost_full_d <= '0';
+                frames_detected <= (others => '0');
+                phr_rejects <= (others => '0');
+                skipped_bursts <= (others => '0');
+                almost_full_events <= (others => '0');
+            else
+                almost_full_d <= almost_full;
+                if (int_frame_found = '1') then
+                    frames_detected <= frames_detected + 1;
+                end if;
+                if (int_phr_reject = '1') then
+                    phr_rejects <= phr_rejects + 1;
+                end if;
+                if (int_burst_skipped = '1') then
+                    skipped_bursts <= skipped_bursts + 1;
+                end if;
+                if (almost_full = '1' and almost_full_d = '0') then
+                    almost_full_events <= almost_full_events + 1;
+                end if;
+            end if;
+        end if;
+    end process P_RB_COUNTERS;
+
+    rb_frames_detected <= std_logic_vector(frames_detected);
+    rb_phr_rejects <= std_logic_vector(phr_rejects);
+    rb_skipped_bursts <= std_logic_vector(skipped_bursts);
+    rb_almost_full_events <= std_logic_vector(almost_full_events);
 
     z_symsync: zluudg_symsync
         port map (
@@ -155,6 +215,7 @@ begin
             areset            => areset,
             sr_shr_sens       => sr_shr_sens,
             clr_frame         => int_clr_frame,
+            frame_found       => int_frame_found,
             s_chip_tready     => int_chip_tready,
             s_chip_tdata      => int_chip_tdata,
             s_chip_tvalid     => int_chip_tvalid,
@@ -179,6 +240,9 @@ begin
             aclk             => aclk,
             areset           => areset,
             frame_done       => int_clr_frame,
+            phr_reject       => int_phr_reject,
+            s_eob            => int_eob,
+            skip_burst       => int_skip_burst,
             s_nibble_tready  => int_nibble_tready,
             s_nibble_tdata   => int_nibble_tdata,
             s_nibble_tvalid  => int_nibble_tvalid,
@@ -192,7 +256,8 @@ begin
             aclk             => aclk,
             areset           => areset,
             almost_full      => almost_full,
-            skip_burst       => '0',
+            skip_burst       => int_skip_burst,
+            burst_skipped    => int_burst_skipped,
             s_axis_tready => int_outbyte_tready,
             s_axis_tdata  => int_outbyte_tdata,
             s_axis_tvalid => int_outbyte_tvalid,
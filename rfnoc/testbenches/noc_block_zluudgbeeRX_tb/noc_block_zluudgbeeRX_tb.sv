@@ -19,7 +19,7 @@
 
 `timescale 1ns/1ps
 `define NS_PER_TICK 1
-`define NUM_TEST_CASES 3
+`define NUM_TEST_CASES 4
 
 `include "sim_exec_report.vh"
 `include "sim_clks_rsts.vh"
@@ -69,6 +69,21 @@ module noc_block_zluudgbeeRX_tb();
     `RFNOC_CONNECT(noc_block_tb,noc_block_zluudgbeeRX,SC16,SPP);
     `RFNOC_CONNECT(noc_block_zluudgbeeRX,noc_block_tb,SC16,SPP);
     `TEST_CASE_DONE(1);
+
+    /********************************************************
+    ** Test 4 -- Readback counters
+    ********************************************************/
+    `TEST_CASE_START("Readback counters");
+    // Nothing has been received yet, so every counter reads zero
+    for (int addr = 0; addr < 4; addr++) begin
+      tb_streamer.read_user_reg(sid_noc_block_zluudgbeeRX, addr, readback);
+      $sformat(s, "Counter %0d is %0d after reset", addr, readback);
+      `ASSERT_ERROR(readback == 64'd0, s);
+    end
+    tb_streamer.read_user_reg(sid_noc_block_zluudgbeeRX, 4, readback);
+    `ASSERT_ERROR(readback == 64'h0BADC0DE0BADC0DE, "Unused readback address not flagged");
+    `TEST_CASE_DONE(1);
+
     `TEST_BENCH_DONE;
 
   end
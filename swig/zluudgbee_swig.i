@@ -20,6 +20,19 @@
 #include "zluudgbee/chdr2pdu.h"
 #include "zluudgbee/dummycoord.h"
 #include "zluudgbee/softcrc.h"
+#include "zluudgbee/softrx.h"
+#include "zluudgbee/phasediff.h"
+#include "zluudgbee/demapper.h"
+#include "zluudgbee/shrdetector.h"
+#include "zluudgbee/multirx.h"
+#include "zluudgbee/autotuner.h"
+#include "zluudgbee/oqpsk_mod.h"
+#include "zluudgbee/coherentrx.h"
+#include "zluudgbee/metrics_probe.h"
+#include "zluudgbee/coordinator.h"
+#include "zluudgbee/device_population.h"
+#include "zluudgbee/chdr_replay.h"
+#include "zluudgbee/capture_source.h"
 %}
 
 %include "zluudgbee/zluudgbeeRX.h"
@@ -32,3 +45,29 @@ GR_SWIG_BLOCK_MAGIC2(zluudgbee, chdr2pdu);
 GR_SWIG_BLOCK_MAGIC2(zluudgbee, dummycoord);
 %include "zluudgbee/softcrc.h"
 GR_SWIG_BLOCK_MAGIC2(zluudgbee, softcrc);
+%include "zluudgbee/softrx.h"
+GR_SWIG_BLOCK_MAGIC2(zluudgbee, softrx);
+%include "zluudgbee/phasediff.h"
+GR_SWIG_BLOCK_MAGIC2(zluudgbee, phasediff);
+%include "zluudgbee/demapper.h"
+GR_SWIG_BLOCK_MAGIC2(zluudgbee, demapper);
+%include "zluudgbee/shrdetector.h"
+GR_SWIG_BLOCK_MAGIC2(zluudgbee, shrdetector);
+%include "zluudgbee/multirx.h"
+GR_SWIG_BLOCK_MAGIC2(zluudgbee, multirx);
+%include "zluudgbee/autotuner.h"
+GR_SWIG_BLOCK_MAGIC2(zluudgbee, autotuner);
+%include "zluudgbee/oqpsk_mod.h"
+GR_SWIG_BLOCK_MAGIC2(zluudgbee, oqpsk_mod);
+%include "zluudgbee/coherentrx.h"
+GR_SWIG_BLOCK_MAGIC2(zluudgbee, coherentrx);
+%include "zluudgbee/metrics_probe.h"
+GR_SWIG_BLOCK_MAGIC2(zluudgbee, metrics_probe);
+%include "zluudgbee/coordinator.h"
+GR_SWIG_BLOCK_MAGIC2(zluudgbee, coordinator);
+%include "zluudgbee/device_population.h"
+GR_SWIG_BLOCK_MAGIC2(zluudgbee, device_population);
+%include "zluudgbee/chdr_replay.h"
+GR_SWIG_BLOCK_MAGIC2(zluudgbee, chdr_replay);
+%include "zluudgbee/capture_source.h"
+GR_SWIG_BLOCK_MAGIC2(zluudgbee, capture_source);